@@ -0,0 +1,445 @@
+/*
+  libheif development tool "heif-bench-colorconv".
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// Measures the throughput of the color conversion operations and of the planned conversion pipelines
+// on synthetic images. The results are written as CSV to stdout.
+//
+// This tool uses internal libheif classes. It can only be built with full symbol visibility.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+#include <libheif/heif.h>
+
+#include "color-conversion/colorconversion.h"
+#include "color-conversion/cpu_features.h"
+#include "color-conversion/synthetic_images.h"
+#include "common_utils.h"
+#include "image/pixelimage.h"
+
+
+static option long_options[] = {
+    {(char* const) "width",       required_argument, 0, 'W'},
+    {(char* const) "height",      required_argument, 0, 'H'},
+    {(char* const) "threads",     required_argument, 0, 't'},
+    {(char* const) "iterations",  required_argument, 0, 'n'},
+    {(char* const) "filter",      required_argument, 0, 'f'},
+    {(char* const) "operations",  no_argument,       0, 'o'},
+    {(char* const) "pipelines",   no_argument,       0, 'p'},
+    {(char* const) "help",        no_argument,       0, 'h'},
+    {nullptr, no_argument, nullptr, 0}
+};
+
+
+static void show_help(const char* argv0)
+{
+  std::filesystem::path p(argv0);
+  std::string filename = p.filename().string();
+
+  std::stringstream sstr;
+  sstr << " " << filename << "  libheif version: " << heif_get_version();
+
+  std::string title = sstr.str();
+
+  std::cerr << title << "\n"
+            << std::string(title.length() + 1, '-') << "\n"
+            << "Usage: " << filename << " [options]\n"
+            << "\n"
+               "Times the color conversion operations and pipelines on synthetic images and writes the\n"
+               "throughput as CSV to stdout. Set LIBHEIF_DISABLE_SIMD to measure without vectorized kernels.\n"
+               "\n"
+               "options:\n"
+               "  -W, --width #        image width (default: 1920)\n"
+               "  -H, --height #       image height (default: 1080)\n"
+               "  -t, --threads #      number of threads for the pipelines (default: 1)\n"
+               "  -n, --iterations #   number of timed runs, the fastest is reported (default: 5)\n"
+               "  -f, --filter TEXT    only measure rows that contain TEXT in a state or operation name\n"
+               "  -o, --operations     only measure the single operations\n"
+               "  -p, --pipelines      only measure the conversion pipelines\n"
+               "  -h, --help           show help\n";
+}
+
+
+static std::string demangle(const char* name)
+{
+#if defined(__GNUG__)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    std::string result = demangled;
+    free(demangled);
+    return result;
+  }
+#endif
+
+  return name;
+}
+
+
+static std::string operation_name(const ColorConversionOperation& op)
+{
+  return demangle(typeid(op).name());
+}
+
+
+// Short state names, e.g. "YCbCr420-10+alpha" or "RGB-RRGGBB_LE-12".
+static std::string state_name(const ColorState& state)
+{
+  std::stringstream sstr;
+
+  switch (state.colorspace) {
+    case heif_colorspace_YCbCr:
+      sstr << "YCbCr";
+      break;
+    case heif_colorspace_RGB:
+      sstr << "RGB";
+      break;
+    case heif_colorspace_monochrome:
+      sstr << "mono";
+      break;
+    default:
+      sstr << "colorspace" << state.colorspace;
+  }
+
+  switch (state.chroma) {
+    case heif_chroma_monochrome:
+      break;
+    case heif_chroma_420:
+      sstr << "420";
+      break;
+    case heif_chroma_422:
+      sstr << "422";
+      break;
+    case heif_chroma_444:
+      sstr << "444";
+      break;
+    case heif_chroma_interleaved_RGB:
+      sstr << "-RGB";
+      break;
+    case heif_chroma_interleaved_RGBA:
+      sstr << "-RGBA";
+      break;
+    case heif_chroma_interleaved_RRGGBB_LE:
+      sstr << "-RRGGBB_LE";
+      break;
+    case heif_chroma_interleaved_RRGGBB_BE:
+      sstr << "-RRGGBB_BE";
+      break;
+    case heif_chroma_interleaved_RRGGBBAA_LE:
+      sstr << "-RRGGBBAA_LE";
+      break;
+    case heif_chroma_interleaved_RRGGBBAA_BE:
+      sstr << "-RRGGBBAA_BE";
+      break;
+    default:
+      sstr << "-chroma" << state.chroma;
+  }
+
+  sstr << "-" << state.bits_per_pixel;
+
+  if (state.has_alpha && num_interleaved_components_per_plane(state.chroma) == 1) {
+    sstr << "+alpha";
+  }
+
+  if (state.has_alpha && state.premultiplied_alpha) {
+    sstr << "-premultiplied";
+  }
+
+  return sstr.str();
+}
+
+
+// Returns the fastest of 'iterations' runs in seconds, or a negative value if the conversion failed.
+template<class F>
+static double measure(int iterations, const F& convert)
+{
+  double best = std::numeric_limits<double>::max();
+
+  // The first run is not timed. It allocates the memory and initializes the tables.
+  if (!convert()) {
+    return -1;
+  }
+
+  for (int i = 0; i < iterations; i++) {
+    auto start = std::chrono::steady_clock::now();
+    if (!convert()) {
+      return -1;
+    }
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    best = std::min(best, duration.count());
+  }
+
+  return best;
+}
+
+
+static std::string csv_field(const std::string& s)
+{
+  if (s.find_first_of(",\"") == std::string::npos) {
+    return s;
+  }
+
+  std::string quoted = "\"";
+  for (char c : s) {
+    if (c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+
+// The demangled operation names of the pipeline, separated by " > ".
+static std::string pipeline_steps(const ColorConversionPipeline& pipeline)
+{
+  std::istringstream dump(pipeline.debug_dump_pipeline());
+  std::string line;
+  std::string steps;
+
+  while (std::getline(dump, line)) {
+    if (line.rfind("> ", 0) == 0) {
+      if (!steps.empty()) {
+        steps += " > ";
+      }
+      steps += demangle(line.substr(2).c_str());
+    }
+  }
+
+  return steps;
+}
+
+
+static bool matches_filter(const std::string& filter, std::initializer_list<std::string> names)
+{
+  return filter.empty() || std::any_of(names.begin(), names.end(),
+                                       [&filter](const std::string& name) { return name.find(filter) != std::string::npos; });
+}
+
+
+int main(int argc, char* argv[])
+{
+  uint32_t width = 1920;
+  uint32_t height = 1080;
+  int num_threads = 1;
+  int iterations = 5;
+  std::string filter;
+  bool measure_operations = true;
+  bool measure_pipelines = true;
+
+  while (true) {
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "W:H:t:n:f:oph", long_options, &option_index);
+    if (c == -1)
+      break;
+
+    switch (c) {
+      case 'W':
+        width = static_cast<uint32_t>(std::max(1, std::atoi(optarg)));
+        break;
+      case 'H':
+        height = static_cast<uint32_t>(std::max(1, std::atoi(optarg)));
+        break;
+      case 't':
+        num_threads = std::max(1, std::atoi(optarg));
+        break;
+      case 'n':
+        iterations = std::max(1, std::atoi(optarg));
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'o':
+        measure_pipelines = false;
+        break;
+      case 'p':
+        measure_operations = false;
+        break;
+      case 'h':
+      default:
+        show_help(argv[0]);
+        return (c == 'h') ? 0 : 1;
+    }
+  }
+
+  heif_init(nullptr);
+
+  const CpuFeatures& cpu = get_cpu_features();
+  std::cerr << "image size: " << width << "x" << height << ", threads: " << num_threads
+            << ", SIMD: " << (cpu.avx2 ? "AVX2 " : "") << (cpu.sse41 ? "SSE4.1 " : "") << (cpu.neon ? "NEON " : "")
+            << ((cpu.avx2 || cpu.sse41 || cpu.neon) ? "" : "none") << "\n";
+
+  heif_color_conversion_options options;
+  heif_color_conversion_options_set_defaults(&options);
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  const heif_security_limits* limits = heif_get_disabled_security_limits();
+  const double megapixels = width * double(height) / 1e6;
+
+  std::vector<std::pair<ColorState, ColorState>> conversions = get_common_color_conversions();
+
+  std::cout << "kind,input,output,operation,instance,cost,threads,width,height,mpix_per_s,pipeline\n";
+
+  // --- single operations on all input states of the common conversions
+  // The 'instance' column counts the registrations of the same operation class: 0 is the scalar reference,
+  // higher numbers are the vectorized variants.
+
+  if (measure_operations) {
+    const auto& ops = ColorConversionPipeline::get_operations();
+
+    std::vector<ColorState> input_states;
+    for (const auto& conversion : conversions) {
+      if (std::find(input_states.begin(), input_states.end(), conversion.first) == input_states.end()) {
+        input_states.push_back(conversion.first);
+      }
+    }
+
+    for (size_t op_idx = 0; op_idx < ops.size(); op_idx++) {
+      const auto& op = ops[op_idx];
+      std::string name = operation_name(*op);
+
+      int instance = 0;
+      for (size_t i = 0; i < op_idx; i++) {
+        if (typeid(*ops[i]) == typeid(*op)) {
+          instance++;
+        }
+      }
+
+      for (const auto& input_state : input_states) {
+        // Each distinct output state that the operation can produce for any of the common targets.
+        std::vector<ColorStateWithCost> output_states;
+        for (const auto& conversion : conversions) {
+          for (const auto& out : op->state_after_conversion(input_state, conversion.second, options, *options_ext)) {
+            bool known = std::any_of(output_states.begin(), output_states.end(),
+                                     [&out](const ColorStateWithCost& s) { return s.color_state == out.color_state; });
+            if (!known && !(out.color_state == input_state)) {
+              output_states.push_back(out);
+            }
+          }
+        }
+
+        if (output_states.empty()) {
+          continue;
+        }
+
+        auto input = create_synthetic_image(input_state, width, height);
+        if (!input) {
+          std::cerr << "cannot create image: " << state_name(input_state) << "\n";
+          return 1;
+        }
+
+        for (const auto& output_state : output_states) {
+          std::string input_name = state_name(input_state);
+          std::string output_name = state_name(output_state.color_state);
+          if (!matches_filter(filter, {input_name, output_name, name})) {
+            continue;
+          }
+
+          double seconds = measure(iterations, [&]() {
+            auto result = op->convert_colorspace(input, input_state, output_state.color_state, options, *options_ext, limits);
+            return !!result;
+          });
+
+          std::cout << "operation," << input_name << "," << output_name << "," << csv_field(name) << ","
+                    << instance << "," << output_state.speed_costs << ",1," << width << "," << height << ",";
+          if (seconds < 0) {
+            std::cout << "failed,";
+          }
+          else {
+            std::cout << std::fixed << std::setprecision(2) << megapixels / seconds << ",";
+          }
+          std::cout << "\n" << std::flush;
+        }
+      }
+    }
+  }
+
+  // --- complete pipelines as planned by ColorConversionPipeline
+
+  if (measure_pipelines) {
+    for (const auto& [input_state, output_state] : conversions) {
+      std::string input_name = state_name(input_state);
+      std::string output_name = state_name(output_state);
+
+      ColorConversionPipeline pipeline;
+      if (!pipeline.construct_pipeline(input_state, output_state, options, *options_ext)) {
+        if (matches_filter(filter, {input_name, output_name})) {
+          std::cout << "pipeline," << input_name << "," << output_name << ",,,," << num_threads << ","
+                    << width << "," << height << ",unsupported,\n";
+        }
+        continue;
+      }
+
+      std::string steps = pipeline_steps(pipeline);
+      if (!matches_filter(filter, {input_name, output_name, steps})) {
+        continue;
+      }
+
+      auto input = create_synthetic_image(input_state, width, height);
+      if (!input) {
+        std::cerr << "cannot create image: " << input_name << "\n";
+        return 1;
+      }
+
+      double seconds = measure(iterations, [&]() {
+        auto result = pipeline.convert_image(input, limits, nullptr, nullptr, num_threads);
+        return !!result;
+      });
+
+      std::cout << "pipeline," << input_name << "," << output_name << ",,,," << num_threads << ","
+                << width << "," << height << ",";
+      if (seconds < 0) {
+        std::cout << "failed,";
+      }
+      else {
+        std::cout << std::fixed << std::setprecision(2) << megapixels / seconds << ",";
+      }
+      std::cout << csv_field(steps) << "\n" << std::flush;
+    }
+  }
+
+  heif_deinit();
+
+  return 0;
+}
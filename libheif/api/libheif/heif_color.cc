@@ -26,8 +26,11 @@
 #include "image/pixelimage.h"
 #include "api_structs.h"
 #include "error.h"
+#include "color-conversion/colorconversion.h"
 #include <set>
 #include <limits>
+#include <cstring>
+#include <string>
 
 #include <algorithm>
 #include <iostream>
@@ -56,11 +59,15 @@ void heif_color_conversion_options_set_defaults(heif_color_conversion_options* o
 
 static void fill_default_color_conversion_options_ext(heif_color_conversion_options_ext& options)
 {
-  options.version = 1;
+  options.version = 5;
   options.alpha_composition_mode = heif_alpha_composition_mode_none;
   options.background_red = options.background_green = options.background_blue = 0xFFFF;
   options.secondary_background_red = options.secondary_background_green = options.secondary_background_blue = 0xCCCC;
   options.checkerboard_square_size = 16;
+  options.use_float_arithmetic = false;
+  options.alpha_premultiplication = heif_alpha_premultiplication_keep;
+  options.convert_transfer_and_primaries = false;
+  options.max_sharp_yuv_threads = 0;
 }
 
 
@@ -84,6 +91,18 @@ void heif_color_conversion_options_ext_copy(heif_color_conversion_options_ext* d
   int min_version = std::min(dst->version, src->version);
 
   switch (min_version) {
+    case 5:
+      dst->max_sharp_yuv_threads = src->max_sharp_yuv_threads;
+      [[fallthrough]];
+    case 4:
+      dst->convert_transfer_and_primaries = src->convert_transfer_and_primaries;
+      [[fallthrough]];
+    case 3:
+      dst->alpha_premultiplication = src->alpha_premultiplication;
+      [[fallthrough]];
+    case 2:
+      dst->use_float_arithmetic = src->use_float_arithmetic;
+      [[fallthrough]];
     case 1:
       dst->alpha_composition_mode = src->alpha_composition_mode;
       dst->background_red = src->background_red;
@@ -103,6 +122,38 @@ void heif_color_conversion_options_ext_free(heif_color_conversion_options_ext* o
 }
 
 
+void heif_color_conversion_calibrate_costs()
+{
+  ColorConversionPipeline::calibrate_costs();
+}
+
+
+const char* heif_color_conversion_export_cost_calibration()
+{
+  std::string table = ColorConversionPipeline::export_cost_calibration();
+
+  char* table_string = new char[table.size() + 1];
+  strcpy(table_string, table.c_str());
+  return table_string;
+}
+
+
+heif_error heif_color_conversion_import_cost_calibration(const char* table)
+{
+  if (table == nullptr) {
+    return Error(heif_error_Usage_error, heif_suberror_Null_pointer_argument).error_struct(nullptr);
+  }
+
+  return ColorConversionPipeline::import_cost_calibration(table).error_struct(nullptr);
+}
+
+
+void heif_color_conversion_reset_cost_calibration()
+{
+  ColorConversionPipeline::reset_cost_calibration();
+}
+
+
 heif_color_profile_type heif_image_handle_get_color_profile_type(const heif_image_handle* handle)
 {
   auto profile_icc = handle->image->get_color_profile_icc();
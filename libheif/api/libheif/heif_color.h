@@ -79,6 +79,19 @@ typedef enum heif_alpha_composition_mode
 } heif_alpha_composition_mode;
 
 
+typedef enum heif_alpha_premultiplication
+{
+  // Keep the alpha premultiplication of the input image.
+  heif_alpha_premultiplication_keep = 0,
+
+  // Output color values that are not multiplied with alpha.
+  heif_alpha_premultiplication_straight = 1,
+
+  // Output color values that are multiplied with alpha.
+  heif_alpha_premultiplication_premultiplied = 2
+} heif_alpha_premultiplication;
+
+
 typedef struct heif_color_conversion_options_ext
 {
   uint8_t version;
@@ -91,6 +104,40 @@ typedef struct heif_color_conversion_options_ext
   uint16_t background_red, background_green, background_blue;
   uint16_t secondary_background_red, secondary_background_green, secondary_background_blue;
   uint16_t checkerboard_square_size;
+
+  // --- version 2 options
+
+  // By default, YCbCr to RGB conversions of up to 14 bits per pixel use fixed-point arithmetic,
+  // which deviates by at most 1 from the float computation. Set this to use float arithmetic instead.
+  // Default: false.
+  uint8_t use_float_arithmetic;
+
+  // --- version 3 options
+
+  // Converts between straight and premultiplied alpha when the output is interleaved RGBA or RRGGBBAA.
+  // Other output formats keep the alpha premultiplication of the input.
+  // Use heif_image_is_premultiplied_alpha() to check the result.
+  // Default: heif_alpha_premultiplication_keep.
+  heif_alpha_premultiplication alpha_premultiplication;
+
+  // --- version 4 options
+
+  // Converts the pixel values when the output nclx profile has other transfer characteristics or colour primaries
+  // than the input, e.g. from BT.2100 PQ or HLG with BT.2020 primaries to sRGB. HDR input is tone mapped to SDR output.
+  // Otherwise, the pixel values are kept and only tagged with the output nclx profile.
+  // heif_decode_image() sets this when heif_decoding_options::output_image_nclx_profile is given.
+  // Default: false.
+  uint8_t convert_transfer_and_primaries;
+
+  // --- version 5 options
+
+  // Allows to split the sharp YUV chroma downsampling into overlapping stripes of rows that are converted in
+  // parallel, with up to this many of the threads that libheif may use for the color conversion.
+  // The output does not depend on the number of threads, but it may differ slightly from the output of the
+  // default conversion of the whole image at once.
+  // 0 or 1 = convert the whole image at once in a single thread.
+  // Default: 0.
+  uint16_t max_sharp_yuv_threads;
 } heif_color_conversion_options_ext;
 
 
@@ -109,6 +156,29 @@ LIBHEIF_API
 void heif_color_conversion_options_ext_free(heif_color_conversion_options_ext*);
 
 
+// --- cost calibration of the color conversions
+
+// Measures the speed of the color conversion operations on this CPU. The measured costs are then used to
+// choose the fastest color conversion pipelines instead of the built-in estimates. This takes some tens of
+// milliseconds. heif_init() does this when heif_init_params::calibrate_color_conversion is set.
+LIBHEIF_API
+void heif_color_conversion_calibrate_costs(void);
+
+// Returns the current calibration as text, so that it can be imported at the next start instead of measuring again.
+// The table is only valid for the same libheif version on the same CPU.
+// The returned string must be freed with heif_string_release().
+LIBHEIF_API
+const char* heif_color_conversion_export_cost_calibration(void);
+
+// Returns heif_error_Usage_error if the table was not exported by this libheif version.
+LIBHEIF_API
+heif_error heif_color_conversion_import_cost_calibration(const char* table);
+
+// Goes back to the built-in cost estimates.
+LIBHEIF_API
+void heif_color_conversion_reset_cost_calibration(void);
+
+
 // ------------------------- color profiles -------------------------
 
 typedef enum heif_color_profile_type
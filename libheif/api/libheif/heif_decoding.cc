@@ -21,8 +21,11 @@
 #include "heif_decoding.h"
 #include "api_structs.h"
 #include "plugin_registry.h"
+#include "parallel.h"
+#include "deadline.h"
 
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -52,7 +55,7 @@ int heif_have_decoder_for_format(heif_compression_format format)
 
 static void fill_default_decoding_options(heif_decoding_options& options)
 {
-  options.version = 10;
+  options.version = 11;
 
   options.ignore_transformations = false;
 
@@ -102,6 +105,17 @@ static void fill_default_decoding_options(heif_decoding_options& options)
   // version 10
 
   options.output_image_nclx_profile_passthrough = false;
+
+  // version 11
+
+  options.decoding_deadline_ms = 0;
+  options.return_thumbnail_on_deadline = false;
+}
+
+
+uint64_t heif_get_monotonic_time_ms()
+{
+  return get_monotonic_time_ms();
 }
 
 
@@ -126,6 +140,10 @@ void heif_decoding_options_copy(heif_decoding_options* dst,
   int min_version = std::min(dst->version, src->version);
 
   switch (min_version) {
+    case 11:
+      dst->decoding_deadline_ms = src->decoding_deadline_ms;
+      dst->return_thumbnail_on_deadline = src->return_thumbnail_on_deadline;
+      [[fallthrough]];
     case 10:
       dst->output_image_nclx_profile_passthrough = src->output_image_nclx_profile_passthrough;
       [[fallthrough]];
@@ -261,6 +279,20 @@ heif_error heif_decode_image(const heif_image_handle* in_handle,
                                                                                              dec_options,
                                                                                              false, 0, 0, {});
 
+  // When the deadline was exceeded, fall back to the thumbnail if requested.
+
+  if (!decodingResult &&
+      decodingResult.error().error_code == heif_error_Canceled &&
+      dec_options.return_thumbnail_on_deadline &&
+      decoding_deadline_exceeded(dec_options) &&
+      !in_handle->image->get_thumbnails().empty()) {
+    dec_options.decoding_deadline_ms = 0;
+
+    heif_item_id thumbnail_id = in_handle->image->get_thumbnails()[0]->get_id();
+    decodingResult = in_handle->context->decode_image(thumbnail_id, colorspace, chroma, dec_options,
+                                                      false, 0, 0, {});
+  }
+
   if (!decodingResult) {
     return decodingResult.error_struct(in_handle->image.get());
   }
@@ -272,3 +304,117 @@ heif_error heif_decode_image(const heif_image_handle* in_handle,
 
   return Error::Ok.error_struct(in_handle->image.get());
 }
+
+
+heif_error heif_decode_image_into(const heif_image_handle* in_handle,
+                                  heif_colorspace colorspace,
+                                  heif_chroma chroma,
+                                  const heif_decoding_options* input_options,
+                                  const heif_image_buffer_desc* planes,
+                                  int num_planes)
+{
+  if (in_handle == nullptr || planes == nullptr) {
+    return heif_error_null_pointer_argument;
+  }
+
+  if (num_planes <= 0) {
+    return {heif_error_Usage_error, heif_suberror_Invalid_parameter_value, "No output planes given"};
+  }
+
+  std::vector<ExternalPlaneBuffer> buffers;
+  for (int i = 0; i < num_planes; i++) {
+    if (planes[i].data == nullptr) {
+      return heif_error_null_pointer_argument;
+    }
+
+    if (planes[i].stride == 0 || planes[i].size == 0) {
+      return {heif_error_Usage_error, heif_suberror_Invalid_parameter_value, "Output buffer has zero stride or size"};
+    }
+
+    ExternalPlaneBuffer buffer;
+    buffer.channel = planes[i].channel;
+    buffer.data = planes[i].data;
+    buffer.stride = planes[i].stride;
+    buffer.size = planes[i].size;
+    buffers.push_back(buffer);
+  }
+
+  heif_item_id id = in_handle->image->get_id();
+
+  heif_decoding_options dec_options;
+  fill_default_decoding_options(dec_options);
+  heif_decoding_options_copy(&dec_options, input_options);
+
+  auto decodingResult = in_handle->context->decode_image(id, colorspace, chroma, dec_options,
+                                                         false, 0, 0, {}, &buffers);
+  if (!decodingResult) {
+    return decodingResult.error_struct(in_handle->image.get());
+  }
+
+  std::shared_ptr<HeifPixelImage> img = *decodingResult;
+
+  // --- copy planes that were not decoded into the output buffers directly
+
+  for (const auto& buffer : buffers) {
+    if (!img->has_channel(buffer.channel)) {
+      return {heif_error_Usage_error, heif_suberror_Invalid_parameter_value,
+              "Decoded image has no plane for an output buffer"};
+    }
+
+    size_t src_stride;
+    const uint8_t* src = img->get_channel_memory(buffer.channel, &src_stride);
+    if (src == buffer.data) {
+      continue;
+    }
+
+    uint32_t w = img->get_width(buffer.channel);
+    uint32_t h = img->get_height(buffer.channel);
+    uint64_t row_size = static_cast<uint64_t>(w) * img->get_storage_bits_per_pixel(buffer.channel) / 8;
+
+    if (!buffer.can_hold(row_size, h)) {
+      return {heif_error_Usage_error, heif_suberror_Invalid_parameter_value,
+              "Output buffer is too small for the decoded image"};
+    }
+
+    for (uint32_t y = 0; y < h; y++) {
+      memcpy(buffer.data + y * buffer.stride, src + y * src_stride, static_cast<size_t>(row_size));
+    }
+  }
+
+  return heif_error_success;
+}
+
+
+heif_error heif_decode_images_batch(const heif_decode_job* jobs,
+                                    int num_jobs,
+                                    int max_threads,
+                                    heif_decode_job_callback callback,
+                                    void* user_data)
+{
+  if (num_jobs < 0) {
+    return {heif_error_Usage_error, heif_suberror_Invalid_parameter_value, "Negative number of jobs"};
+  }
+
+  if (num_jobs == 0) {
+    return heif_error_success;
+  }
+
+  if (jobs == nullptr || callback == nullptr) {
+    return heif_error_null_pointer_argument;
+  }
+
+  if (max_threads <= 0) {
+    max_threads = get_default_number_of_worker_threads();
+  }
+
+  parallel_for(static_cast<uint32_t>(num_jobs), max_threads, [jobs, callback, user_data](uint32_t idx) {
+    const heif_decode_job& job = jobs[idx];
+
+    heif_image* img = nullptr;
+    heif_error err = heif_decode_image(job.handle, &img, job.colorspace, job.chroma, job.options);
+
+    callback(static_cast<int>(idx), img, err, user_data);
+  });
+
+  return heif_error_success;
+}
@@ -102,6 +102,10 @@ typedef struct heif_decoding_options
 
   // version 6 options
 
+  // Return non-zero to abort decoding with heif_error_Canceled.
+  // libheif itself only calls this from the thread that called the decoding function, also while
+  // it decodes grid tiles or overlay layers in parallel. Decoder plugins that support cancellation
+  // may call it from their own threads.
   int (* cancel_decoding)(void* progress_user_data);
 
   // version 7 options
@@ -116,8 +120,9 @@ typedef struct heif_decoding_options
 
   // Requested NCLX color profile of the decoded output image. If the input
   // image's NCLX differs, libheif will color-convert the pixels accordingly
-  // (e.g. YCbCr matrix, primaries, range) so the result matches what is
-  // requested here.
+  // (e.g. YCbCr matrix, primaries, transfer characteristics, range) so the result
+  // matches what is requested here. HDR images (PQ, HLG) are tone mapped when an
+  // SDR transfer characteristic is requested.
   //
   // When set to NULL, the behavior depends on the flag
   // output_image_nclx_profile_passthrough below: by default NULL means
@@ -125,7 +130,7 @@ typedef struct heif_decoding_options
   // "keep the input image's NCLX".
   heif_color_profile_nclx* output_image_nclx_profile;
 
-  int num_library_threads; // 0 = let libheif decide (TODO, currently ignored)
+  int num_library_threads; // 0 = use the context's maximum number of threads (see heif_context_set_max_decoding_threads())
   int num_codec_threads; // 0 = use decoder default
 
   // version 9 options
@@ -155,9 +160,33 @@ typedef struct heif_decoding_options
   // code that wants to preserve HDR through decode should generally enable it.
   // Setting output_image_nclx_profile to a non-NULL value overrides this flag.
   uint8_t output_image_nclx_profile_passthrough;
+
+  // version 11 options
+
+  // Point in time at which decoding should be aborted, in milliseconds of the clock returned
+  // by heif_get_monotonic_time_ms(). 0 (default) means no deadline.
+  //
+  // The deadline is checked between grid tiles and overlay layers, between color conversion
+  // steps, and inside decoder plugins that support cancellation. It is not a hard real-time
+  // limit: the currently running step is always finished.
+  // When the deadline is exceeded, heif_error_Canceled is returned.
+  uint64_t decoding_deadline_ms;
+
+  // If enabled and the decoding deadline is exceeded, heif_decode_image() decodes and returns
+  // the first thumbnail of the image instead of failing (without applying the deadline to the
+  // thumbnail). When the image has no thumbnail, heif_error_Canceled is returned.
+  // Default: false.
+  uint8_t return_thumbnail_on_deadline;
 } heif_decoding_options;
 
 
+// Current time of the monotonic clock in milliseconds that is used for
+// heif_decoding_options::decoding_deadline_ms.
+// Example: options->decoding_deadline_ms = heif_get_monotonic_time_ms() + 50;
+LIBHEIF_API
+uint64_t heif_get_monotonic_time_ms(void);
+
+
 // Allocate decoding options and fill with default values.
 // Note: you should always get the decoding options through this function since the
 // option structure may grow in size in future versions.
@@ -212,6 +241,83 @@ heif_error heif_decode_image(const heif_image_handle* in_handle,
                              heif_chroma chroma,
                              const heif_decoding_options* options);
 
+
+// --- decoding into caller-provided memory
+
+// Memory for one plane of the decoded image.
+// For interleaved chroma formats, use heif_channel_interleaved.
+typedef struct heif_image_buffer_desc
+{
+  heif_channel channel;
+
+  uint8_t* data;
+  size_t stride; // bytes per row
+  size_t size; // total number of bytes available at 'data'
+} heif_image_buffer_desc;
+
+// Decode an image directly into memory provided by the caller (e.g. a mapped GPU staging buffer).
+// The parameters are the same as for heif_decode_image(). There has to be one buffer for each
+// plane of the decoded image. Planes of the decoded image for which no buffer is given are discarded.
+// The size of each plane can be computed from the size of the image handle and the chroma format.
+//
+// When the image has to be color converted, the last conversion step writes directly into the buffers.
+// Otherwise, the decoded planes are copied into them.
+//
+// If a buffer has a zero stride or size, is too small for its plane, or the decoded image has no
+// plane for a buffer, heif_error_Usage_error is returned.
+// Note: 'return_thumbnail_on_deadline' of the decoding options is ignored.
+LIBHEIF_API
+heif_error heif_decode_image_into(const heif_image_handle* in_handle,
+                                  heif_colorspace colorspace,
+                                  heif_chroma chroma,
+                                  const heif_decoding_options* options,
+                                  const heif_image_buffer_desc* planes,
+                                  int num_planes);
+
+
+// --- batch decoding
+
+// One image to be decoded by heif_decode_images_batch().
+// The parameters have the same meaning as in heif_decode_image().
+typedef struct heif_decode_job
+{
+  const heif_image_handle* handle;
+  heif_colorspace colorspace;
+  heif_chroma chroma;
+
+  // May be NULL to use the default options.
+  const heif_decoding_options* options;
+} heif_decode_job;
+
+// Called for each job as soon as it has been decoded.
+// If decoding was successful, 'img' contains the decoded image and 'err' is heif_error_Ok. You take the
+// ownership of the image and have to free it with heif_image_release().
+// If decoding failed, 'img' is NULL and 'err' describes the error.
+// The callback may be called from background threads, in any order, and concurrently for different jobs.
+typedef void (*heif_decode_job_callback)(int job_index, heif_image* img, heif_error err, void* user_data);
+
+// Decode many images with one call.
+// This is a convenience wrapper that calls heif_decode_image() for each job in parallel. The threads are started
+// for this call and each thread takes the next pending job when it has finished its previous one.
+// Each job is decoded exactly as by heif_decode_image(). No decoders or color conversions are shared between
+// the jobs, beyond what heif_decode_image() already reuses for repeated decoding of the same image.
+//
+// 'max_threads' limits the number of threads working on the batch (including the calling thread).
+// Use 0 to let libheif decide (usually the number of CPU cores).
+// Note that the codecs may use additional threads and that grids may use tile decoding threads as configured
+// with heif_context_set_max_decoding_threads(). When decoding large batches of grid images, you may want to
+// set the latter to 0.
+//
+// The function returns when all jobs have been processed. An error is only returned for invalid arguments.
+// Errors of the individual jobs are passed to the callback.
+// The handles of different jobs may belong to the same or different contexts.
+LIBHEIF_API
+heif_error heif_decode_images_batch(const heif_decode_job* jobs,
+                                    int num_jobs,
+                                    int max_threads,
+                                    heif_decode_job_callback callback,
+                                    void* user_data);
+
 #ifdef __cplusplus
 }
 #endif
@@ -602,7 +602,7 @@ heif_orientation heif_orientation_concat(heif_orientation first, heif_orientatio
 
 static void set_default_encoding_options(heif_encoding_options& options)
 {
-  options.version = 8;
+  options.version = 10;
 
   options.save_alpha_channel = true;
   options.macOS_compatibility_workaround = false;
@@ -619,6 +619,10 @@ static void set_default_encoding_options(heif_encoding_options& options)
   options.prefer_uncC_short_form = true;
 
   options.unci_parameters = nullptr;
+
+  options.num_library_threads = 0;
+
+  options.color_conversion_options_ext = nullptr;
 }
 
 
@@ -641,6 +645,12 @@ void heif_encoding_options_copy(heif_encoding_options* dst, const heif_encoding_
   int min_version = std::min(dst->version, src->version);
 
   switch (min_version) {
+    case 10:
+      dst->color_conversion_options_ext = src->color_conversion_options_ext;
+      [[fallthrough]];
+    case 9:
+      dst->num_library_threads = src->num_library_threads;
+      [[fallthrough]];
     case 8:
       dst->unci_parameters = src->unci_parameters;
       [[fallthrough]];
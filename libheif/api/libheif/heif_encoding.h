@@ -325,6 +325,19 @@ typedef struct heif_encoding_options
   // Default: nullptr
   const heif_unci_image_parameters* unci_parameters;
 
+  // version 9 options
+
+  // Maximum number of threads that libheif uses for its own processing, e.g. the color conversion
+  // of the input image. This does not influence the threads used by the encoder plugin.
+  // 0 = use the context's maximum number of threads (see heif_context_set_max_decoding_threads()).
+  int num_library_threads;
+
+  // version 10 options
+
+  // Options for the color conversion of the input image, e.g. the thread limit of the sharp YUV conversion.
+  // When set to NULL, default options will be used.
+  heif_color_conversion_options_ext* color_conversion_options_ext;
+
   // TODO: we should add a flag to force MIAF compatible outputs. E.g. this will put restrictions on grid tile sizes and
   //       might add a clap box when the grid output size does not match the color subsampling factors.
   //       Since some of these constraints have to be known before actually encoding the image, "forcing MIAF compatibility"
@@ -22,6 +22,7 @@
 #include "heif_plugin.h"
 #include "api_structs.h"
 #include "plugin_registry.h"
+#include "image/plane_allocator.h"
 
 #ifdef _WIN32
 // for _write
@@ -100,6 +101,29 @@ void heif_string_release(const char* str)
 }
 
 
+heif_error heif_set_allocator(const heif_allocator* allocator)
+{
+  if (allocator) {
+    if (allocator->version < 1) {
+      return {heif_error_Usage_error, heif_suberror_Unsupported_parameter, "Unsupported heif_allocator version"};
+    }
+
+    if (allocator->alloc == nullptr || allocator->free == nullptr) {
+      return heif_error_null_pointer_argument;
+    }
+  }
+
+  set_plane_allocator(allocator);
+  return heif_error_success;
+}
+
+
+void heif_set_plane_buffer_pool_size(size_t max_pooled_bytes)
+{
+  set_plane_buffer_pool_size(max_pooled_bytes);
+}
+
+
 // DEPRECATED
 heif_error heif_register_decoder(heif_context* heif, const heif_decoder_plugin* decoder_plugin)
 {
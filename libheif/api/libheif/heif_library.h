@@ -106,7 +106,12 @@ typedef struct heif_init_params
 {
   int version;
 
-  // currently no parameters
+  // version 1 has no parameters
+
+  // --- version 2
+
+  // Measure the speed of the color conversion operations (see heif_color_conversion_calibrate_costs()).
+  uint8_t calibrate_color_conversion;
 } heif_init_params;
 
 
@@ -148,6 +153,50 @@ LIBHEIF_API
 void heif_deinit(void);
 
 
+// ========================= memory allocation ======================
+
+// Allocator for the pixel data of images. This covers all image planes allocated by libheif:
+// decoded images, intermediate images of the color conversion, grid tiles, alpha planes, and images
+// created with heif_image_create().
+typedef struct heif_allocator
+{
+  // version 1
+
+  int version;
+
+  // Allocate 'size' bytes. The memory does not have to be aligned or initialized.
+  // Return NULL if the memory cannot be allocated.
+  void* (*alloc)(void* user_data, size_t size);
+
+  // Free memory returned by alloc(). 'size' is the size that was passed to alloc().
+  void (*free)(void* user_data, void* mem, size_t size);
+
+  void* user_data;
+} heif_allocator;
+
+/**
+ * Set the allocator for the pixel data of all images. Pass NULL to go back to the default allocator.
+ *
+ * The allocator must be set before any images are allocated (e.g. right after heif_init()) and it must not
+ * be changed while images exist, since their memory is released through the allocator that is set at that time.
+ * All memory allocated through the allocator is still counted against the heif_security_limits.
+ */
+LIBHEIF_API
+heif_error heif_set_allocator(const heif_allocator* allocator);
+
+/**
+ * Keep released image memory in a pool and reuse it for new images instead of returning it to the allocator.
+ * This reduces the time spent in memory allocation and page faults when many images of similar sizes are decoded.
+ *
+ * The memory is pooled in size classes, which may increase the size of an allocation by up to 25%.
+ * 'max_pooled_bytes' limits the amount of unused memory that is kept in the pool.
+ * Setting it to 0 disables the pool (this is the default). Changing the size releases all pooled memory.
+ * The pool is also released by heif_deinit().
+ */
+LIBHEIF_API
+void heif_set_plane_buffer_pool_size(size_t max_pooled_bytes);
+
+
 // --- Codec plugins ---
 
 // --- Plugins are currently only supported on Unix platforms.
@@ -46,8 +46,9 @@ extern "C" {
 //  1.20         4         3          2
 //  1.21         5         4          2
 //  1.22         6         4          2
+//  1.24         7         4          2
 
-#define heif_decoder_plugin_latest_version 6
+#define heif_decoder_plugin_latest_version 7
 #define heif_encoder_plugin_latest_version 4
 
 // The minimum plugin versions that can be used with this libheif version.
@@ -165,6 +166,14 @@ typedef struct heif_decoder_plugin
                                     uintptr_t* out_user_data,
                                     const heif_security_limits* limits);
 
+  // --- version 7 functions ---
+
+  // Set a function that the plugin should poll regularly during long-running decoding operations
+  // (e.g. once per slice or tile). When it returns non-zero, the plugin should stop decoding as soon
+  // as possible and return heif_error_Canceled. The function may be called from any thread.
+  // May be NULL if the plugin does not support cancellation.
+  void (* set_cancel_callback)(void* decoder, int (* is_canceled)(void* cancel_user_data), void* cancel_user_data);
+
   // --- Note: when adding new versions, also update `heif_decoder_plugin_latest_version`.
 } heif_decoder_plugin;
 
@@ -197,6 +197,8 @@ heif_error heif_track_decode_next_image(heif_track* track_ptr,
     };
   }
 
+  MemoryUsageScope memory_usage_scope(track_ptr->context->get_security_limits(), track_ptr->context->get_memory_usage());
+
   auto decodingResult = visual_track->decode_next_image_sample(*opts);
   if (!decodingResult) {
     return decodingResult.error_struct(track_ptr->context.get());
@@ -256,6 +258,28 @@ heif_error heif_track_get_urim_sample_entry_uri_of_first_cluster(const heif_trac
 }
 
 
+heif_error heif_track_seek_to_sample(heif_track* track_ptr, uint32_t sample_index)
+{
+  auto error = track_ptr->track->seek_to_sample(sample_index);
+  if (error) {
+    return error.error_struct(track_ptr->context.get());
+  }
+
+  return heif_error_success;
+}
+
+
+heif_error heif_track_seek_to_time(heif_track* track_ptr, uint64_t time)
+{
+  auto error = track_ptr->track->seek_to_time(time);
+  if (error) {
+    return error.error_struct(track_ptr->context.get());
+  }
+
+  return heif_error_success;
+}
+
+
 heif_error heif_track_get_next_raw_sequence_sample(heif_track* track_ptr,
                                                    heif_raw_sequence_sample** out_sample)
 {
@@ -221,6 +221,37 @@ heif_error heif_track_decode_next_image(heif_track* track,
                                         heif_chroma chroma,
                                         const heif_decoding_options* options);
 
+/**
+ * Seek to the given output sample of the track.
+ * The sample index counts through all edit-list repetitions, i.e. it is the number of images
+ * that would have been returned by `heif_track_decode_next_image()` before reaching this sample.
+ *
+ * Decoding restarts at the nearest sync sample (keyframe) preceding the target. The next call to
+ * `heif_track_decode_next_image()` decodes forward from there and returns the target image.
+ * The sync sample lookup is a binary search, so seeking is fast even in very long tracks.
+ *
+ * For `heif_track_get_next_raw_sequence_sample()`, reading continues at the preceding sync sample,
+ * because all samples from there on are required to reconstruct the target sample.
+ *
+ * If the index is beyond the end of the sequence, `heif_error_Usage_error` is returned.
+ */
+LIBHEIF_API
+heif_error heif_track_seek_to_sample(heif_track* track, uint32_t sample_index);
+
+/**
+ * Seek to the sample whose decoding time span contains the given time.
+ * The time is specified in clock ticks of the track timescale (see `heif_track_get_timescale()`)
+ * and counts through all edit-list repetitions.
+ *
+ * Note that this is the decoding time. Composition time offsets ('ctts' box) are not applied.
+ * For tracks with reordered frames (e.g. B-frames), the sample found may thus differ from the
+ * sample that is displayed at that time.
+ *
+ * Otherwise, this works like `heif_track_seek_to_sample()`.
+ */
+LIBHEIF_API
+heif_error heif_track_seek_to_time(heif_track* track, uint64_t time);
+
 /**
  * Get the image display duration in clock ticks of this track.
  * Make sure to use the timescale of the track and not the timescale of the total sequence.
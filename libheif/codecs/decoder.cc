@@ -26,6 +26,7 @@
 #include "plugin_registry.h"
 #include "api_structs.h"
 #include "security_limits.h"
+#include "deadline.h"
 
 #include "codecs/hevc_dec.h"
 #include "codecs/avif_dec.h"
@@ -324,6 +325,32 @@ void Decoder::release_decoder()
 }
 
 
+int Decoder::plugin_cancel_callback(void* decoder)
+{
+  auto* self = static_cast<Decoder*>(decoder);
+
+  const heif_decoding_options* options = self->m_active_options;
+  return options && is_decoding_canceled(*options);
+}
+
+
+// Makes the decoding options available to the plugin's cancel callback while a plugin function is running.
+class ActiveOptionsScope
+{
+public:
+  ActiveOptionsScope(std::atomic<const heif_decoding_options*>& active, const heif_decoding_options& options)
+      : m_active(active)
+  {
+    m_active = &options;
+  }
+
+  ~ActiveOptionsScope() { m_active = nullptr; }
+
+private:
+  std::atomic<const heif_decoding_options*>& m_active;
+};
+
+
 Error Decoder::require_decoder_plugin(const heif_decoding_options& options)
 {
   if (!m_decoder_plugin) {
@@ -362,6 +389,10 @@ Error Decoder::decode_sequence_frame_from_compressed_data(bool upload_configurat
     return pluginErr;
   }
 
+  if (is_decoding_canceled(options)) {
+    return decoding_canceled_error(options);
+  }
+
   // Reject memory-bomb inputs whose codec configuration record (SPS) declares
   // a coded picture size beyond libheif's security limits, before handing any
   // bytes to the decoder plugin. Codecs whose configuration record does not
@@ -402,6 +433,10 @@ Error Decoder::decode_sequence_frame_from_compressed_data(bool upload_configurat
       if (err.code != heif_error_Ok) {
         return Error(err.code, err.subcode, err.message);
       }
+
+      if (m_decoder_plugin->plugin_api_version >= 7 && m_decoder_plugin->set_cancel_callback) {
+        m_decoder_plugin->set_cancel_callback(m_decoder, plugin_cancel_callback, this);
+      }
     }
     else {
       err = m_decoder_plugin->new_decoder(&m_decoder);
@@ -438,6 +473,8 @@ Error Decoder::decode_sequence_frame_from_compressed_data(bool upload_configurat
   }
 
   //std::cout << "Decoder::decode_sequence_frame_from_compressed_data push " << dataResult->size() << "\n";
+  ActiveOptionsScope activeOptions(m_active_options, options);
+
   if (m_decoder_plugin->plugin_api_version >= 5 && m_decoder_plugin->push_data2) {
     err = m_decoder_plugin->push_data2(m_decoder, dataResult->data(), dataResult->size(), user_data);
   }
@@ -484,6 +521,8 @@ Result<std::shared_ptr<HeifPixelImage> > Decoder::get_decoded_frame(const heif_d
 
   heif_error err;
 
+  ActiveOptionsScope activeOptions(m_active_options, options);
+
   if (m_decoder_plugin->plugin_api_version >= 5 &&
       m_decoder_plugin->decode_next_image2 != nullptr) {
 
@@ -538,6 +577,11 @@ Decoder::decode_single_frame_from_compressed_data(const heif_decoding_options& o
   const int max_decoding_tries = 50; // hardcoded value, should be large enough
 
   for (int i = 0; i < max_decoding_tries; i++) {
+    if (is_decoding_canceled(options)) {
+      release_decoder();
+      return decoding_canceled_error(options);
+    }
+
     Result<std::shared_ptr<HeifPixelImage>> imgResult;
     imgResult = get_decoded_frame(options, nullptr, limits);
     if (imgResult.error()) {
@@ -27,7 +27,9 @@
 #include "file.h"
 #include "security_limits.h"
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <utility>
@@ -93,6 +95,10 @@ public:
 
   const DataExtent& get_data_extent() const { return m_data_extent; }
 
+  // The data extent and the decoder plugin instance are shared by all users of this decoder.
+  // Lock this mutex while setting the data extent and decoding from it.
+  std::mutex& get_decoding_mutex() const { return m_decoding_mutex; }
+
   // --- information about the image format
 
   [[nodiscard]] virtual int get_luma_bits_per_pixel() const = 0;
@@ -155,9 +161,16 @@ public:
 private:
   DataExtent m_data_extent;
 
+  mutable std::mutex m_decoding_mutex;
+
   const heif_decoder_plugin* m_decoder_plugin = nullptr;
   void* m_decoder = nullptr;
 
+  // Decoding options of the plugin call that is currently running. Read by the plugin's cancel callback.
+  std::atomic<const heif_decoding_options*> m_active_options{nullptr};
+
+  static int plugin_cancel_callback(void* decoder);
+
   // get the decoder plugin if it is not set already
   Error require_decoder_plugin(const heif_decoding_options& options);
 };
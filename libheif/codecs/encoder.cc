@@ -117,7 +117,9 @@ Result<std::shared_ptr<HeifPixelImage>> Encoder::convert_colorspace_for_encoding
                                                                                  heif_encoder* encoder,
                                                                                  const heif_color_profile_nclx* user_requested_output_nclx,
                                                                                  const heif_color_conversion_options* color_conversion_options,
-                                                                                 const heif_security_limits* security_limits)
+                                                                                 const heif_color_conversion_options_ext* color_conversion_options_ext,
+                                                                                 const heif_security_limits* security_limits,
+                                                                                 int num_threads)
 {
   const heif_color_profile_nclx* output_nclx_profile;
 
@@ -163,6 +165,6 @@ Result<std::shared_ptr<HeifPixelImage>> Encoder::convert_colorspace_for_encoding
   //target_nclx->set_from_heif_color_profile_nclx(target_heif_nclx);
 
   return convert_colorspace(image, colorspace, chroma, target_nclx_profile,
-                            output_bpp, *color_conversion_options, nullptr,
-                            security_limits);
+                            output_bpp, *color_conversion_options, color_conversion_options_ext,
+                            security_limits, nullptr, nullptr, num_threads);
 }
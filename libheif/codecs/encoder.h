@@ -64,7 +64,9 @@ public:
                                                                           heif_encoder* encoder,
                                                                           const heif_color_profile_nclx* user_requested_output_nclx,
                                                                           const heif_color_conversion_options* color_conversion_options,
-                                                                          const heif_security_limits* security_limits);
+                                                                          const heif_color_conversion_options_ext* color_conversion_options_ext,
+                                                                          const heif_security_limits* security_limits,
+                                                                          int num_threads = 1);
 
   virtual Result<CodedImageData> encode(const std::shared_ptr<HeifPixelImage>& image,
                                         heif_encoder* encoder,
@@ -23,6 +23,7 @@
 #include "codecs/uncompressed/unc_codec.h"
 #include "error.h"
 #include "context.h"
+#include "deadline.h"
 
 #include <string>
 #include <algorithm>
@@ -177,6 +178,10 @@ Result<std::shared_ptr<HeifPixelImage>>
 Decoder_uncompressed::decode_single_frame_from_compressed_data(const struct heif_decoding_options& options,
                                                                const struct heif_security_limits* limits)
 {
+  if (is_decoding_canceled(options)) {
+    return decoding_canceled_error(options);
+  }
+
   UncompressedImageCodec::unci_properties properties;
   properties.uncC = m_uncC;
   properties.cmpd = m_cmpd;
@@ -90,6 +90,20 @@ Op_drop_alpha_plane::convert_colorspace(const std::shared_ptr<const HeifPixelIma
 }
 
 
+Error
+Op_drop_alpha_plane::convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                                                const ColorState& input_state,
+                                                const ColorState& target_state,
+                                                const heif_color_conversion_options& options,
+                                                const heif_color_conversion_options_ext& options_ext,
+                                                const heif_security_limits* limits) const
+{
+  image->remove_channel(heif_channel_Alpha);
+
+  return Error::Ok;
+}
+
+
 template<class Pixel>
 std::vector<ColorStateWithCost>
 Op_flatten_alpha_plane<Pixel>::state_after_conversion(const ColorState& input_state,
@@ -322,39 +336,16 @@ Op_adjust_alpha_bit_depth::state_after_conversion(const ColorState& input_state,
 }
 
 
-Result<std::shared_ptr<HeifPixelImage>>
-Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                              const ColorState& input_state,
-                                              const ColorState& target_state,
-                                              const heif_color_conversion_options& options,
-                                              const heif_color_conversion_options_ext& options_ext,
-                                              const heif_security_limits* limits) const
+// Adds the alpha plane of 'input', converted to 'target_bpp', to 'out'.
+static Error add_alpha_plane_with_bit_depth(const HeifPixelImage& input, HeifPixelImage& out, int target_bpp,
+                                            const heif_security_limits* limits)
 {
-  uint32_t width = input->get_width();
-  uint32_t height = input->get_height();
+  int input_alpha_bpp = input.get_bits_per_pixel(heif_channel_Alpha);
 
-  auto outimg = std::make_shared<HeifPixelImage>();
-  outimg->create(width, height, input->get_colorspace(), input->get_chroma_format());
+  uint32_t alpha_width = input.get_width(heif_channel_Alpha);
+  uint32_t alpha_height = input.get_height(heif_channel_Alpha);
 
-  // Copy all non-alpha channels unchanged
-  for (heif_channel channel : {heif_channel_Y, heif_channel_Cb, heif_channel_Cr,
-                                heif_channel_R, heif_channel_G, heif_channel_B}) {
-    if (input->has_channel(channel)) {
-      outimg->copy_new_channel_from(input, channel, channel, limits);
-    }
-  }
-
-  if (!input->has_channel(heif_channel_Alpha)) {
-    return outimg;
-  }
-
-  int input_alpha_bpp = input->get_bits_per_pixel(heif_channel_Alpha);
-  int target_bpp = input_state.bits_per_pixel;
-
-  uint32_t alpha_width = input->get_width(heif_channel_Alpha);
-  uint32_t alpha_height = input->get_height(heif_channel_Alpha);
-
-  if (auto err = outimg->add_channel(heif_channel_Alpha, alpha_width, alpha_height, target_bpp, limits)) {
+  if (auto err = out.add_channel(heif_channel_Alpha, alpha_width, alpha_height, target_bpp, limits)) {
     return err;
   }
 
@@ -362,11 +353,11 @@ Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPi
     // Upscale: 8-bit alpha -> HDR using pattern replication
     const uint8_t* p_in;
     size_t stride_in;
-    p_in = input->get_channel_memory(heif_channel_Alpha, &stride_in);
+    p_in = input.get_channel_memory(heif_channel_Alpha, &stride_in);
 
     uint16_t* p_out;
     size_t stride_out;
-    p_out = (uint16_t*) outimg->get_channel_memory(heif_channel_Alpha, &stride_out);
+    p_out = (uint16_t*) out.get_channel_memory(heif_channel_Alpha, &stride_out);
     stride_out /= 2;
 
     int shift1 = target_bpp - input_alpha_bpp;
@@ -382,12 +373,12 @@ Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPi
     // Downscale: HDR alpha -> 8-bit
     const uint16_t* p_in;
     size_t stride_in;
-    p_in = (const uint16_t*) input->get_channel_memory(heif_channel_Alpha, &stride_in);
+    p_in = (const uint16_t*) input.get_channel_memory(heif_channel_Alpha, &stride_in);
     stride_in /= 2;
 
     uint8_t* p_out;
     size_t stride_out;
-    p_out = outimg->get_channel_memory(heif_channel_Alpha, &stride_out);
+    p_out = out.get_channel_memory(heif_channel_Alpha, &stride_out);
 
     int shift = input_alpha_bpp - 8;
 
@@ -400,12 +391,12 @@ Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPi
     // HDR alpha -> different HDR: rescale within uint16_t
     const uint16_t* p_in;
     size_t stride_in;
-    p_in = (const uint16_t*) input->get_channel_memory(heif_channel_Alpha, &stride_in);
+    p_in = (const uint16_t*) input.get_channel_memory(heif_channel_Alpha, &stride_in);
     stride_in /= 2;
 
     uint16_t* p_out;
     size_t stride_out;
-    p_out = (uint16_t*) outimg->get_channel_memory(heif_channel_Alpha, &stride_out);
+    p_out = (uint16_t*) out.get_channel_memory(heif_channel_Alpha, &stride_out);
     stride_out /= 2;
 
     if (target_bpp > input_alpha_bpp) {
@@ -429,11 +420,11 @@ Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPi
     // SDR alpha -> different SDR (both <= 8)
     const uint8_t* p_in;
     size_t stride_in;
-    p_in = input->get_channel_memory(heif_channel_Alpha, &stride_in);
+    p_in = input.get_channel_memory(heif_channel_Alpha, &stride_in);
 
     uint8_t* p_out;
     size_t stride_out;
-    p_out = outimg->get_channel_memory(heif_channel_Alpha, &stride_out);
+    p_out = out.get_channel_memory(heif_channel_Alpha, &stride_out);
 
     if (target_bpp > input_alpha_bpp) {
       int shift1 = target_bpp - input_alpha_bpp;
@@ -453,5 +444,177 @@ Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPi
     }
   }
 
+  return Error::Ok;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage>>
+Op_adjust_alpha_bit_depth::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
+                                              const ColorState& input_state,
+                                              const ColorState& target_state,
+                                              const heif_color_conversion_options& options,
+                                              const heif_color_conversion_options_ext& options_ext,
+                                              const heif_security_limits* limits) const
+{
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+
+  auto outimg = std::make_shared<HeifPixelImage>();
+  outimg->create(width, height, input->get_colorspace(), input->get_chroma_format());
+
+  // Copy all non-alpha channels unchanged
+  for (heif_channel channel : {heif_channel_Y, heif_channel_Cb, heif_channel_Cr,
+                                heif_channel_R, heif_channel_G, heif_channel_B}) {
+    if (input->has_channel(channel)) {
+      outimg->copy_new_channel_from(input, channel, channel, limits);
+    }
+  }
+
+  if (!input->has_channel(heif_channel_Alpha)) {
+    return outimg;
+  }
+
+  if (auto err = add_alpha_plane_with_bit_depth(*input, *outimg, input_state.bits_per_pixel, limits)) {
+    return err;
+  }
+
+  return outimg;
+}
+
+
+Error
+Op_adjust_alpha_bit_depth::convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                                                      const ColorState& input_state,
+                                                      const ColorState& target_state,
+                                                      const heif_color_conversion_options& options,
+                                                      const heif_color_conversion_options_ext& options_ext,
+                                                      const heif_security_limits* limits) const
+{
+  if (!image->has_channel(heif_channel_Alpha)) {
+    return Error::Ok;
+  }
+
+  // Only the alpha plane is replaced. The color planes are kept.
+  auto alpha = std::make_shared<HeifPixelImage>();
+  alpha->create(image->get_width(), image->get_height(), image->get_colorspace(), image->get_chroma_format());
+
+  if (auto err = add_alpha_plane_with_bit_depth(*image, *alpha, input_state.bits_per_pixel, limits)) {
+    return err;
+  }
+
+  image->remove_channel(heif_channel_Alpha);
+  image->transfer_channel_from_image_as(alpha, heif_channel_Alpha, heif_channel_Alpha);
+
+  return Error::Ok;
+}
+
+
+std::vector<ColorStateWithCost>
+Op_alpha_premultiplication::state_after_conversion(const ColorState& input_state,
+                                                   const ColorState& target_state,
+                                                   const heif_color_conversion_options& options,
+                                                   const heif_color_conversion_options_ext& options_ext) const
+{
+  if (input_state.colorspace != heif_colorspace_RGB ||
+      (input_state.chroma != heif_chroma_interleaved_RGBA &&
+       input_state.chroma != heif_chroma_interleaved_RRGGBBAA_LE &&
+       input_state.chroma != heif_chroma_interleaved_RRGGBBAA_BE) ||
+      !input_state.has_alpha ||
+      !target_state.has_alpha) {
+    return {};
+  }
+
+  if (input_state.premultiplied_alpha == m_premultiply ||
+      target_state.premultiplied_alpha != m_premultiply) {
+    return {};
+  }
+
+  std::vector<ColorStateWithCost> states;
+
+  ColorState output_state = input_state;
+  output_state.premultiplied_alpha = m_premultiply;
+
+  states.emplace_back(output_state, m_kernels->speed_costs);
+
+  return states;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage>>
+Op_alpha_premultiplication::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                const ColorState& input_state,
+                                                const ColorState& target_state,
+                                                const heif_color_conversion_options& options,
+                                                const heif_color_conversion_options_ext& options_ext,
+                                                const heif_security_limits* limits) const
+{
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+  int bpp = input->get_bits_per_pixel(heif_channel_interleaved);
+
+  if (input->get_chroma_format() == heif_chroma_interleaved_RGBA) {
+    if (bpp != 8) {
+      return Error::InternalError;
+    }
+  }
+  else if (bpp <= 8 || bpp > 16) {
+    return Error::InternalError;
+  }
+
+  auto outimg = std::make_shared<HeifPixelImage>();
+
+  outimg->create(width, height, heif_colorspace_RGB, input->get_chroma_format());
+
+  if (auto err = outimg->add_channel(heif_channel_interleaved, width, height, bpp, limits)) {
+    return err;
+  }
+
   return outimg;
 }
+
+
+Error
+Op_alpha_premultiplication::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                           const std::shared_ptr<HeifPixelImage>& outimg,
+                                           const ColorState& input_state,
+                                           const ColorState& target_state,
+                                           const heif_color_conversion_options& options,
+                                           const heif_color_conversion_options_ext& options_ext,
+                                           uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+  int bpp = input->get_bits_per_pixel(heif_channel_interleaved);
+  heif_chroma chroma = input->get_chroma_format();
+
+  size_t in_stride = 0;
+  const uint8_t* in_p = input->get_channel_memory(heif_channel_interleaved, &in_stride);
+
+  size_t out_stride = 0;
+  uint8_t* out_p = outimg->get_channel_memory(heif_channel_interleaved, &out_stride);
+
+  for (uint32_t y = first_row; y < end_row; y++) {
+    const uint8_t* in_row = in_p + y * in_stride;
+    uint8_t* out_row = out_p + y * out_stride;
+
+    if (chroma == heif_chroma_interleaved_RGBA) {
+      if (m_premultiply) {
+        m_kernels->premultiply_rgba_row(in_row, out_row, width);
+      }
+      else {
+        m_kernels->unpremultiply_rgba_row(in_row, out_row, width);
+      }
+    }
+    else {
+      bool big_endian = (chroma == heif_chroma_interleaved_RRGGBBAA_BE);
+
+      if (m_premultiply) {
+        m_kernels->premultiply_rrggbbaa_row(in_row, out_row, width, bpp, big_endian);
+      }
+      else {
+        m_kernels->unpremultiply_rrggbbaa_row(in_row, out_row, width, bpp, big_endian);
+      }
+    }
+  }
+
+  return Error::Ok;
+}
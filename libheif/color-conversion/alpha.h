@@ -22,6 +22,7 @@
 #define LIBHEIF_COLORCONVERSION_ALPHA_H
 
 #include "colorconversion.h"
+#include "alpha_kernels.h"
 #include <vector>
 #include <memory>
 
@@ -42,6 +43,16 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+  bool supports_inplace_conversion() const override { return true; }
+
+  Error
+  convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                             const ColorState& input_state,
+                             const ColorState& target_state,
+                             const heif_color_conversion_options& options,
+                             const heif_color_conversion_options_ext& options_ext,
+                             const heif_security_limits* limits) const override;
 };
 
 
@@ -80,6 +91,74 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+  bool supports_inplace_conversion() const override { return true; }
+
+  Error
+  convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                             const ColorState& input_state,
+                             const ColorState& target_state,
+                             const heif_color_conversion_options& options,
+                             const heif_color_conversion_options_ext& options_ext,
+                             const heif_security_limits* limits) const override;
+};
+
+
+// Converts interleaved RGBA and RRGGBBAA images between straight and premultiplied alpha.
+// This is only done when the target state asks for it (see heif_color_conversion_options_ext::alpha_premultiplication).
+class Op_alpha_premultiplication : public StripedColorConversionOperation
+{
+public:
+  bool changes_alpha_premultiplication() const override { return true; }
+
+  std::vector<ColorStateWithCost>
+  state_after_conversion(const ColorState& input_state,
+                         const ColorState& target_state,
+                         const heif_color_conversion_options& options,
+                         const heif_color_conversion_options_ext& options_ext) const override;
+
+  Result<std::shared_ptr<HeifPixelImage>>
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+protected:
+  Op_alpha_premultiplication(bool premultiply, const Alpha_premultiplication_kernels& kernels)
+      : m_premultiply(premultiply), m_kernels(&kernels) {}
+
+private:
+  bool m_premultiply;
+  const Alpha_premultiplication_kernels* m_kernels;
+};
+
+
+// The Ops are registered once with the scalar kernels and once with the fastest vectorized kernels.
+
+class Op_premultiply_alpha : public Op_alpha_premultiplication
+{
+public:
+  explicit Op_premultiply_alpha(const Alpha_premultiplication_kernels& kernels = get_scalar_Alpha_premultiplication_kernels())
+      : Op_alpha_premultiplication(true, kernels) {}
+};
+
+
+class Op_unpremultiply_alpha : public Op_alpha_premultiplication
+{
+public:
+  explicit Op_unpremultiply_alpha(const Alpha_premultiplication_kernels& kernels = get_scalar_Alpha_premultiplication_kernels())
+      : Op_alpha_premultiplication(false, kernels) {}
 };
 
 #endif //LIBHEIF_COLORCONVERSION_ALPHA_H
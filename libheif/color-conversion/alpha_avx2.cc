@@ -0,0 +1,185 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. See alpha_kernels.h.
+// The AVX2 unpack and pack instructions work within the two 128 bit lanes, which keeps the pixel order.
+
+#include "alpha_kernels.h"
+#include "colorconversion.h"
+#include <immintrin.h>
+
+
+static inline __m256i swap_bytes_16(__m256i v)
+{
+  return _mm256_shuffle_epi8(v, _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)));
+}
+
+
+// round(c*a/max) of 32 bit samples, see alpha_kernels.h
+static inline __m256i premultiply_32(__m256i c, __m256i a, __m256i bias, __m128i shift)
+{
+  __m256i t = _mm256_add_epi32(_mm256_mullo_epi32(c, a), bias);
+  return _mm256_srl_epi32(_mm256_add_epi32(t, _mm256_srl_epi32(t, shift)), shift);
+}
+
+
+// min(c*max/a + 0.5, max) of 32 bit samples, or 0 if a=0
+static inline __m256i unpremultiply_32(__m256i c, __m256i a, __m256 max_value)
+{
+  __m256 v = _mm256_div_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(c), max_value), _mm256_cvtepi32_ps(a));
+  v = _mm256_min_ps(_mm256_add_ps(v, _mm256_set1_ps(0.5f)), max_value);
+
+  __m256i zero_alpha = _mm256_cmpeq_epi32(a, _mm256_setzero_si256());
+  return _mm256_andnot_si256(zero_alpha, _mm256_cvttps_epi32(v));
+}
+
+
+static void premultiply_rgba_row_avx2(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi16(128);
+  const __m256i alpha_shuffle = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15));
+  const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) (in + 4 * x));
+
+    // 8 bit products fit into 16 bit
+    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+
+    __m256i t_lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, _mm256_shuffle_epi8(lo, alpha_shuffle)), bias);
+    __m256i t_hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, _mm256_shuffle_epi8(hi, alpha_shuffle)), bias);
+
+    t_lo = _mm256_srli_epi16(_mm256_add_epi16(t_lo, _mm256_srli_epi16(t_lo, 8)), 8);
+    t_hi = _mm256_srli_epi16(_mm256_add_epi16(t_hi, _mm256_srli_epi16(t_hi, 8)), 8);
+
+    __m256i result = _mm256_blendv_epi8(_mm256_packus_epi16(t_lo, t_hi), v, alpha_mask);
+    _mm256_storeu_si256((__m256i*) (out + 4 * x), result);
+  }
+
+  premultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void unpremultiply_rgba_row_avx2(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  const __m256 max_value = _mm256_set1_ps(255.0f);
+  const __m256i alpha_mask = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+  // The packing below interleaves the 128 bit lanes. This permutation restores the pixel order.
+  const __m256i pixel_order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) (in + 4 * x));
+
+    // two pixels per vector, one in each 128 bit lane
+    __m256i p[4];
+    for (int i = 0; i < 4; i++) {
+      __m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (in + 4 * x + 8 * i)));
+      p[i] = unpremultiply_32(c, _mm256_shuffle_epi32(c, 0xFF), max_value);
+    }
+
+    __m256i result = _mm256_packus_epi16(_mm256_packus_epi32(p[0], p[1]), _mm256_packus_epi32(p[2], p[3]));
+    result = _mm256_permutevar8x32_epi32(result, pixel_order);
+    result = _mm256_blendv_epi8(result, v, alpha_mask);
+    _mm256_storeu_si256((__m256i*) (out + 4 * x), result);
+  }
+
+  unpremultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void premultiply_rrggbbaa_row_avx2(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i bias = _mm256_set1_epi32(1 << (bpp - 1));
+  const __m128i shift = _mm_cvtsi32_si128(bpp);
+  const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) (in + 8 * x));
+    if (big_endian) {
+      v = swap_bytes_16(v);
+    }
+
+    // one pixel per 128 bit lane
+    __m256i lo = _mm256_unpacklo_epi16(v, zero);
+    __m256i hi = _mm256_unpackhi_epi16(v, zero);
+
+    // Keep the lower 16 bits like the scalar code (only relevant for samples that exceed 'bpp').
+    lo = _mm256_and_si256(premultiply_32(lo, _mm256_shuffle_epi32(lo, 0xFF), bias, shift), low16);
+    hi = _mm256_and_si256(premultiply_32(hi, _mm256_shuffle_epi32(hi, 0xFF), bias, shift), low16);
+
+    __m256i result = _mm256_blend_epi16(_mm256_packus_epi32(lo, hi), v, 0x88);
+    if (big_endian) {
+      result = swap_bytes_16(result);
+    }
+
+    _mm256_storeu_si256((__m256i*) (out + 8 * x), result);
+  }
+
+  premultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+static void unpremultiply_rrggbbaa_row_avx2(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256 max_value = _mm256_set1_ps(static_cast<float>((1 << bpp) - 1));
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*) (in + 8 * x));
+    if (big_endian) {
+      v = swap_bytes_16(v);
+    }
+
+    __m256i lo = _mm256_unpacklo_epi16(v, zero);
+    __m256i hi = _mm256_unpackhi_epi16(v, zero);
+
+    lo = unpremultiply_32(lo, _mm256_shuffle_epi32(lo, 0xFF), max_value);
+    hi = unpremultiply_32(hi, _mm256_shuffle_epi32(hi, 0xFF), max_value);
+
+    __m256i result = _mm256_blend_epi16(_mm256_packus_epi32(lo, hi), v, 0x88);
+    if (big_endian) {
+      result = swap_bytes_16(result);
+    }
+
+    _mm256_storeu_si256((__m256i*) (out + 8 * x), result);
+  }
+
+  unpremultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+extern const Alpha_premultiplication_kernels alpha_kernels_avx2{
+  "avx2",
+  SpeedCosts_OptimizedSoftware,
+  premultiply_rgba_row_avx2,
+  unpremultiply_rgba_row_avx2,
+  premultiply_rrggbbaa_row_avx2,
+  unpremultiply_rrggbbaa_row_avx2
+};
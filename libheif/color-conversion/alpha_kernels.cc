@@ -0,0 +1,160 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "alpha_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+#include <algorithm>
+
+
+static inline uint32_t premultiply_sample(uint32_t c, uint32_t a, int bpp)
+{
+  uint32_t t = c * a + (1u << (bpp - 1));
+  return (t + (t >> bpp)) >> bpp;
+}
+
+
+static inline uint32_t unpremultiply_sample(uint32_t c, uint32_t a, float max_value)
+{
+  if (a == 0) {
+    return 0;
+  }
+
+  float v = static_cast<float>(c) * max_value / static_cast<float>(a) + 0.5f;
+  return static_cast<uint32_t>(std::min(v, max_value));
+}
+
+
+static inline uint32_t load_sample_16(const uint8_t* p, bool big_endian)
+{
+  return big_endian ? ((p[0] << 8) | p[1]) : (p[0] | (p[1] << 8));
+}
+
+
+static inline void store_sample_16(uint8_t* p, uint32_t v, bool big_endian)
+{
+  if (big_endian) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+  }
+  else {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+  }
+}
+
+
+void premultiply_rgba_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t a = in[4 * x + 3];
+
+    for (int c = 0; c < 3; c++) {
+      out[4 * x + c] = static_cast<uint8_t>(premultiply_sample(in[4 * x + c], a, 8));
+    }
+
+    out[4 * x + 3] = static_cast<uint8_t>(a);
+  }
+}
+
+
+void unpremultiply_rgba_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t a = in[4 * x + 3];
+
+    for (int c = 0; c < 3; c++) {
+      out[4 * x + c] = static_cast<uint8_t>(unpremultiply_sample(in[4 * x + c], a, 255.0f));
+    }
+
+    out[4 * x + 3] = static_cast<uint8_t>(a);
+  }
+}
+
+
+void premultiply_rrggbbaa_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t a = load_sample_16(&in[8 * x + 6], big_endian);
+
+    for (int c = 0; c < 3; c++) {
+      uint32_t v = premultiply_sample(load_sample_16(&in[8 * x + 2 * c], big_endian), a, bpp);
+      store_sample_16(&out[8 * x + 2 * c], v, big_endian);
+    }
+
+    store_sample_16(&out[8 * x + 6], a, big_endian);
+  }
+}
+
+
+void unpremultiply_rrggbbaa_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  float max_value = static_cast<float>((1 << bpp) - 1);
+
+  for (uint32_t x = 0; x < width; x++) {
+    uint32_t a = load_sample_16(&in[8 * x + 6], big_endian);
+
+    for (int c = 0; c < 3; c++) {
+      uint32_t v = unpremultiply_sample(load_sample_16(&in[8 * x + 2 * c], big_endian), a, max_value);
+      store_sample_16(&out[8 * x + 2 * c], v, big_endian);
+    }
+
+    store_sample_16(&out[8 * x + 6], a, big_endian);
+  }
+}
+
+
+static const Alpha_premultiplication_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  premultiply_rgba_row_scalar,
+  unpremultiply_rgba_row_scalar,
+  premultiply_rrggbbaa_row_scalar,
+  unpremultiply_rrggbbaa_row_scalar
+};
+
+extern const Alpha_premultiplication_kernels alpha_kernels_sse41;
+extern const Alpha_premultiplication_kernels alpha_kernels_avx2;
+extern const Alpha_premultiplication_kernels alpha_kernels_neon;
+
+static const KernelDispatcher<Alpha_premultiplication_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(alpha_kernels_sse41),
+  AVX2_KERNELS(alpha_kernels_avx2),
+  NEON_KERNELS(alpha_kernels_neon)
+};
+
+
+const Alpha_premultiplication_kernels& get_scalar_Alpha_premultiplication_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const Alpha_premultiplication_kernels* get_simd_Alpha_premultiplication_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const Alpha_premultiplication_kernels*> get_supported_Alpha_premultiplication_kernels()
+{
+  return dispatcher.get_supported();
+}
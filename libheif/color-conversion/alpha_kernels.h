@@ -0,0 +1,73 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_ALPHA_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_ALPHA_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels for converting interleaved RGBA and RRGGBBAA between straight and premultiplied alpha.
+//
+// These follow the same scheme as the YCbCr -> RGB kernels (see yuv2rgb_kernels.h): there is a scalar
+// reference implementation and vectorized implementations in translation units that are compiled with
+// SSE4.1, AVX2 or NEON enabled. All kernels are bit-exact.
+//
+// With max = (1<<bpp)-1, premultiplication computes round(c*a/max). The division by max is computed exactly with
+// shifts: t = c*a + (1<<(bpp-1)), c' = (t + (t>>bpp)) >> bpp.
+// Unpremultiplication computes min(c*max/a + 0.5, max) in single precision float and sets the colors to 0 when a=0.
+
+struct Alpha_premultiplication_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  // 'in' and 'out' may be the same row.
+  void (*premultiply_rgba_row)(const uint8_t* in, uint8_t* out, uint32_t width);
+
+  void (*unpremultiply_rgba_row)(const uint8_t* in, uint8_t* out, uint32_t width);
+
+  // RRGGBBAA rows with 2 bytes per sample in little or big endian order.
+  void (*premultiply_rrggbbaa_row)(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian);
+
+  void (*unpremultiply_rrggbbaa_row)(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void premultiply_rgba_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width);
+
+void unpremultiply_rgba_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width);
+
+void premultiply_rrggbbaa_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian);
+
+void unpremultiply_rrggbbaa_row_scalar(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian);
+
+
+const Alpha_premultiplication_kernels& get_scalar_Alpha_premultiplication_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const Alpha_premultiplication_kernels* get_simd_Alpha_premultiplication_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const Alpha_premultiplication_kernels*> get_supported_Alpha_premultiplication_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_ALPHA_KERNELS_H
@@ -0,0 +1,196 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See alpha_kernels.h.
+
+#include "alpha_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+
+
+static inline uint16x8_t swap_bytes_16(uint16x8_t v)
+{
+  return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+}
+
+
+// round(c*a/max) of 8 bit samples, see alpha_kernels.h
+static inline uint8x16_t premultiply_8(uint8x16_t c, uint8x16_t a)
+{
+  const uint16x8_t bias = vdupq_n_u16(128);
+
+  uint16x8_t lo = vaddq_u16(vmull_u8(vget_low_u8(c), vget_low_u8(a)), bias);
+  uint16x8_t hi = vaddq_u16(vmull_u8(vget_high_u8(c), vget_high_u8(a)), bias);
+
+  return vcombine_u8(vshrn_n_u16(vsraq_n_u16(lo, lo, 8), 8),
+                     vshrn_n_u16(vsraq_n_u16(hi, hi, 8), 8));
+}
+
+
+// round(c*a/max) of 16 bit samples. 'shift' is -bpp.
+static inline uint16x8_t premultiply_16(uint16x8_t c, uint16x8_t a, uint32x4_t bias, int32x4_t shift)
+{
+  uint32x4_t lo = vaddq_u32(vmull_u16(vget_low_u16(c), vget_low_u16(a)), bias);
+  uint32x4_t hi = vaddq_u32(vmull_u16(vget_high_u16(c), vget_high_u16(a)), bias);
+
+  lo = vshlq_u32(vaddq_u32(lo, vshlq_u32(lo, shift)), shift);
+  hi = vshlq_u32(vaddq_u32(hi, vshlq_u32(hi, shift)), shift);
+
+  // Keep the lower 16 bits like the scalar code (only relevant for samples that exceed 'bpp').
+  return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+}
+
+
+// min(c*max/a + 0.5, max) of 32 bit samples, or 0 if a=0
+static inline uint32x4_t unpremultiply_32(uint32x4_t c, uint32x4_t a, float32x4_t max_value)
+{
+  float32x4_t v = vdivq_f32(vmulq_f32(vcvtq_f32_u32(c), max_value), vcvtq_f32_u32(a));
+  v = vminq_f32(vaddq_f32(v, vdupq_n_f32(0.5f)), max_value);
+
+  uint32x4_t zero_alpha = vceqq_u32(a, vdupq_n_u32(0));
+  return vbicq_u32(vcvtq_u32_f32(v), zero_alpha);
+}
+
+
+static inline uint16x8_t unpremultiply_16(uint16x8_t c, uint16x8_t a, float32x4_t max_value)
+{
+  uint32x4_t lo = unpremultiply_32(vmovl_u16(vget_low_u16(c)), vmovl_u16(vget_low_u16(a)), max_value);
+  uint32x4_t hi = unpremultiply_32(vmovl_u16(vget_high_u16(c)), vmovl_u16(vget_high_u16(a)), max_value);
+
+  return vcombine_u16(vmovn_u32(lo), vmovn_u32(hi));
+}
+
+
+static inline uint8x16_t unpremultiply_8(uint8x16_t c, uint8x16_t a, float32x4_t max_value)
+{
+  uint16x8_t lo = unpremultiply_16(vmovl_u8(vget_low_u8(c)), vmovl_u8(vget_low_u8(a)), max_value);
+  uint16x8_t hi = unpremultiply_16(vmovl_u8(vget_high_u8(c)), vmovl_u8(vget_high_u8(a)), max_value);
+
+  return vcombine_u8(vmovn_u16(lo), vmovn_u16(hi));
+}
+
+
+static void premultiply_rgba_row_neon(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x4_t rgba = vld4q_u8(in + 4 * x);
+
+    for (int c = 0; c < 3; c++) {
+      rgba.val[c] = premultiply_8(rgba.val[c], rgba.val[3]);
+    }
+
+    vst4q_u8(out + 4 * x, rgba);
+  }
+
+  premultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void unpremultiply_rgba_row_neon(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  const float32x4_t max_value = vdupq_n_f32(255.0f);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x4_t rgba = vld4q_u8(in + 4 * x);
+
+    for (int c = 0; c < 3; c++) {
+      rgba.val[c] = unpremultiply_8(rgba.val[c], rgba.val[3], max_value);
+    }
+
+    vst4q_u8(out + 4 * x, rgba);
+  }
+
+  unpremultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void premultiply_rrggbbaa_row_neon(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const uint32x4_t bias = vdupq_n_u32(1u << (bpp - 1));
+  const int32x4_t shift = vdupq_n_s32(-bpp);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8x4_t rgba = vld4q_u16((const uint16_t*) (in + 8 * x));
+
+    if (big_endian) {
+      for (int c = 0; c < 4; c++) {
+        rgba.val[c] = swap_bytes_16(rgba.val[c]);
+      }
+    }
+
+    for (int c = 0; c < 3; c++) {
+      rgba.val[c] = premultiply_16(rgba.val[c], rgba.val[3], bias, shift);
+    }
+
+    if (big_endian) {
+      for (int c = 0; c < 4; c++) {
+        rgba.val[c] = swap_bytes_16(rgba.val[c]);
+      }
+    }
+
+    vst4q_u16((uint16_t*) (out + 8 * x), rgba);
+  }
+
+  premultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+static void unpremultiply_rrggbbaa_row_neon(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const float32x4_t max_value = vdupq_n_f32(static_cast<float>((1 << bpp) - 1));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8x4_t rgba = vld4q_u16((const uint16_t*) (in + 8 * x));
+
+    if (big_endian) {
+      for (int c = 0; c < 4; c++) {
+        rgba.val[c] = swap_bytes_16(rgba.val[c]);
+      }
+    }
+
+    for (int c = 0; c < 3; c++) {
+      rgba.val[c] = unpremultiply_16(rgba.val[c], rgba.val[3], max_value);
+    }
+
+    if (big_endian) {
+      for (int c = 0; c < 4; c++) {
+        rgba.val[c] = swap_bytes_16(rgba.val[c]);
+      }
+    }
+
+    vst4q_u16((uint16_t*) (out + 8 * x), rgba);
+  }
+
+  unpremultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+extern const Alpha_premultiplication_kernels alpha_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  premultiply_rgba_row_neon,
+  unpremultiply_rgba_row_neon,
+  premultiply_rrggbbaa_row_neon,
+  unpremultiply_rrggbbaa_row_neon
+};
@@ -0,0 +1,182 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See alpha_kernels.h.
+
+#include "alpha_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+
+
+static inline __m128i swap_bytes_16(__m128i v)
+{
+  return _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+}
+
+
+// round(c*a/max) of 32 bit samples, see alpha_kernels.h
+static inline __m128i premultiply_32(__m128i c, __m128i a, __m128i bias, __m128i shift)
+{
+  __m128i t = _mm_add_epi32(_mm_mullo_epi32(c, a), bias);
+  return _mm_srl_epi32(_mm_add_epi32(t, _mm_srl_epi32(t, shift)), shift);
+}
+
+
+// min(c*max/a + 0.5, max) of 32 bit samples, or 0 if a=0
+static inline __m128i unpremultiply_32(__m128i c, __m128i a, __m128 max_value)
+{
+  __m128 v = _mm_div_ps(_mm_mul_ps(_mm_cvtepi32_ps(c), max_value), _mm_cvtepi32_ps(a));
+  v = _mm_min_ps(_mm_add_ps(v, _mm_set1_ps(0.5f)), max_value);
+
+  __m128i zero_alpha = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+  return _mm_andnot_si128(zero_alpha, _mm_cvttps_epi32(v));
+}
+
+
+static void premultiply_rgba_row_sse41(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi16(128);
+  const __m128i alpha_shuffle = _mm_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+  const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*) (in + 4 * x));
+
+    // 8 bit products fit into 16 bit
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+    __m128i t_lo = _mm_add_epi16(_mm_mullo_epi16(lo, _mm_shuffle_epi8(lo, alpha_shuffle)), bias);
+    __m128i t_hi = _mm_add_epi16(_mm_mullo_epi16(hi, _mm_shuffle_epi8(hi, alpha_shuffle)), bias);
+
+    t_lo = _mm_srli_epi16(_mm_add_epi16(t_lo, _mm_srli_epi16(t_lo, 8)), 8);
+    t_hi = _mm_srli_epi16(_mm_add_epi16(t_hi, _mm_srli_epi16(t_hi, 8)), 8);
+
+    __m128i result = _mm_blendv_epi8(_mm_packus_epi16(t_lo, t_hi), v, alpha_mask);
+    _mm_storeu_si128((__m128i*) (out + 4 * x), result);
+  }
+
+  premultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void unpremultiply_rgba_row_sse41(const uint8_t* in, uint8_t* out, uint32_t width)
+{
+  const __m128 max_value = _mm_set1_ps(255.0f);
+  const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*) (in + 4 * x));
+
+    // one pixel per vector
+    __m128i p[4];
+    p[0] = _mm_cvtepu8_epi32(v);
+    p[1] = _mm_cvtepu8_epi32(_mm_srli_si128(v, 4));
+    p[2] = _mm_cvtepu8_epi32(_mm_srli_si128(v, 8));
+    p[3] = _mm_cvtepu8_epi32(_mm_srli_si128(v, 12));
+
+    for (auto& c : p) {
+      c = unpremultiply_32(c, _mm_shuffle_epi32(c, 0xFF), max_value);
+    }
+
+    __m128i result = _mm_packus_epi16(_mm_packus_epi32(p[0], p[1]), _mm_packus_epi32(p[2], p[3]));
+    result = _mm_blendv_epi8(result, v, alpha_mask);
+    _mm_storeu_si128((__m128i*) (out + 4 * x), result);
+  }
+
+  unpremultiply_rgba_row_scalar(in + 4 * x, out + 4 * x, width - x);
+}
+
+
+static void premultiply_rrggbbaa_row_sse41(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i bias = _mm_set1_epi32(1 << (bpp - 1));
+  const __m128i shift = _mm_cvtsi32_si128(bpp);
+  const __m128i low16 = _mm_set1_epi32(0xFFFF);
+
+  uint32_t x = 0;
+  for (; x + 2 <= width; x += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*) (in + 8 * x));
+    if (big_endian) {
+      v = swap_bytes_16(v);
+    }
+
+    // one pixel per vector
+    __m128i lo = _mm_unpacklo_epi16(v, zero);
+    __m128i hi = _mm_unpackhi_epi16(v, zero);
+
+    // Keep the lower 16 bits like the scalar code (only relevant for samples that exceed 'bpp').
+    lo = _mm_and_si128(premultiply_32(lo, _mm_shuffle_epi32(lo, 0xFF), bias, shift), low16);
+    hi = _mm_and_si128(premultiply_32(hi, _mm_shuffle_epi32(hi, 0xFF), bias, shift), low16);
+
+    __m128i result = _mm_blend_epi16(_mm_packus_epi32(lo, hi), v, 0x88);
+    if (big_endian) {
+      result = swap_bytes_16(result);
+    }
+
+    _mm_storeu_si128((__m128i*) (out + 8 * x), result);
+  }
+
+  premultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+static void unpremultiply_rrggbbaa_row_sse41(const uint8_t* in, uint8_t* out, uint32_t width, int bpp, bool big_endian)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 max_value = _mm_set1_ps(static_cast<float>((1 << bpp) - 1));
+
+  uint32_t x = 0;
+  for (; x + 2 <= width; x += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*) (in + 8 * x));
+    if (big_endian) {
+      v = swap_bytes_16(v);
+    }
+
+    __m128i lo = _mm_unpacklo_epi16(v, zero);
+    __m128i hi = _mm_unpackhi_epi16(v, zero);
+
+    lo = unpremultiply_32(lo, _mm_shuffle_epi32(lo, 0xFF), max_value);
+    hi = unpremultiply_32(hi, _mm_shuffle_epi32(hi, 0xFF), max_value);
+
+    __m128i result = _mm_blend_epi16(_mm_packus_epi32(lo, hi), v, 0x88);
+    if (big_endian) {
+      result = swap_bytes_16(result);
+    }
+
+    _mm_storeu_si128((__m128i*) (out + 8 * x), result);
+  }
+
+  unpremultiply_rrggbbaa_row_scalar(in + 8 * x, out + 8 * x, width - x, bpp, big_endian);
+}
+
+
+extern const Alpha_premultiplication_kernels alpha_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  premultiply_rgba_row_sse41,
+  unpremultiply_rgba_row_sse41,
+  premultiply_rrggbbaa_row_sse41,
+  unpremultiply_rrggbbaa_row_sse41
+};
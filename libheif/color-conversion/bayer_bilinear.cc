@@ -54,7 +54,7 @@ Op_bayer_bilinear_to_RGB24_32::state_after_conversion(const ColorState& input_st
     return {};
   }
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
@@ -77,13 +77,57 @@ static int component_type_to_rgb_index(uint16_t component_type)
 }
 
 
+// For each pattern position, which RGB channel (0=R,1=G,2=B) does it provide?
+static Error get_pattern_channels(const std::shared_ptr<const HeifPixelImage>& input, std::vector<int>& pattern_channel)
+{
+  const BayerPattern& pattern = input->get_any_bayer_pattern();
+  uint16_t pw = pattern.pattern_width;
+  uint16_t ph = pattern.pattern_height;
+
+  pattern_channel.resize(pw * ph);
+  for (int i = 0; i < pw * ph; i++) {
+    uint16_t comp_type = input->get_component_type(pattern.pixels[i].component_id);
+    pattern_channel[i] = component_type_to_rgb_index(comp_type);
+    if (pattern_channel[i] < 0) {
+      return Error(heif_error_Unsupported_feature,
+                   heif_suberror_Unsupported_data_version,
+                   "Bayer pattern contains component types that we currently cannot convert to RGB");
+    }
+  }
+
+  return Error::Ok;
+}
+
+
+// A 2x2 pattern with green on one diagonal and red and blue on the other one.
+static bool is_2x2_bayer_pattern(uint16_t pw, uint16_t ph, const std::vector<int>& pattern_channel)
+{
+  if (pw != 2 || ph != 2) {
+    return false;
+  }
+
+  int c00 = pattern_channel[0], c01 = pattern_channel[1];
+  int c10 = pattern_channel[2], c11 = pattern_channel[3];
+
+  if (c00 == 1 && c11 == 1) {
+    return (c01 != 1 && c10 == 2 - c01);
+  }
+
+  if (c01 == 1 && c10 == 1) {
+    return (c00 != 1 && c11 == 2 - c00);
+  }
+
+  return false;
+}
+
+
 Result<std::shared_ptr<HeifPixelImage>>
-Op_bayer_bilinear_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                         const ColorState& input_state,
-                                         const ColorState& target_state,
-                                         const heif_color_conversion_options& options,
-                                         const heif_color_conversion_options_ext& options_ext,
-                                         const heif_security_limits* limits) const
+Op_bayer_bilinear_to_RGB24_32::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                   const ColorState& input_state,
+                                                   const ColorState& target_state,
+                                                   const heif_color_conversion_options& options,
+                                                   const heif_color_conversion_options_ext& options_ext,
+                                                   const heif_security_limits* limits) const
 {
   uint32_t width = input->get_width();
   uint32_t height = input->get_height();
@@ -93,13 +137,15 @@ Op_bayer_bilinear_to_RGB24_32::convert_colorspace(const std::shared_ptr<const He
   }
 
   const BayerPattern& pattern = input->get_any_bayer_pattern();
-  uint16_t pw = pattern.pattern_width;
-  uint16_t ph = pattern.pattern_height;
-
-  if (pw == 0 || ph == 0) {
+  if (pattern.pattern_width == 0 || pattern.pattern_height == 0) {
     return Error::InternalError;
   }
 
+  std::vector<int> pattern_channel;
+  if (auto err = get_pattern_channels(input, pattern_channel)) {
+    return err;
+  }
+
   int bpp = input->get_bits_per_pixel(heif_channel_filter_array);
   bool hdr = bpp > 8;
 
@@ -113,24 +159,43 @@ Op_bayer_bilinear_to_RGB24_32::convert_colorspace(const std::shared_ptr<const He
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_bayer_bilinear_to_RGB24_32::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                              const std::shared_ptr<HeifPixelImage>& outimg,
+                                              const ColorState& input_state,
+                                              const ColorState& target_state,
+                                              const heif_color_conversion_options& options,
+                                              const heif_color_conversion_options_ext& options_ext,
+                                              uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+
+  const BayerPattern& pattern = input->get_any_bayer_pattern();
+  uint16_t pw = pattern.pattern_width;
+  uint16_t ph = pattern.pattern_height;
+
+  int bpp = input->get_bits_per_pixel(heif_channel_filter_array);
+  bool hdr = bpp > 8;
+
   size_t in_stride = 0;
   const uint8_t* in_p = input->get_channel_memory(heif_channel_filter_array, &in_stride);
 
   size_t out_stride = 0;
   uint8_t* out_p = outimg->get_channel_memory(heif_channel_interleaved, &out_stride);
 
-  // Build a lookup table: for each pattern position, which RGB channel (0=R,1=G,2=B) does it provide?
-  std::vector<int> pattern_channel(pw * ph);
-  for (int i = 0; i < pw * ph; i++) {
-    uint16_t comp_type = input->get_component_type(pattern.pixels[i].component_id);
-    pattern_channel[i] = component_type_to_rgb_index(comp_type);
-    if (pattern_channel[i] < 0) {
-      return Error(heif_error_Unsupported_feature,
-                   heif_suberror_Unsupported_data_version,
-                   "Bayer pattern contains component types that we currently cannot convert to RGB");
-    }
+  std::vector<int> pattern_channel;
+  if (auto err = get_pattern_channels(input, pattern_channel)) {
+    return err;
   }
 
+  // 2x2 Bayer patterns use the row kernels for all pixels that are not at the image border.
+  bool use_kernels = is_2x2_bayer_pattern(pw, ph, pattern_channel);
+
   // Precompute neighbor offset tables for each pattern position and channel.
   // neighbor_offsets[py * pw + px][ch] = list of (dx, dy) offsets to average.
   // For the channel this position directly provides: single entry (0, 0).
@@ -167,34 +232,55 @@ Op_bayer_bilinear_to_RGB24_32::convert_colorspace(const std::shared_ptr<const He
     }
   }
 
-  // Bilinear demosaicing using precomputed offset tables.
-  auto demosaic = [&]<typename Pixel>(const Pixel* in, Pixel* out,
-                                      size_t in_str, size_t out_str) {
-    for (uint32_t y = 0; y < height; y++) {
-      for (uint32_t x = 0; x < width; x++) {
-        const auto& offsets = neighbor_offsets[(y % ph) * pw + (x % pw)];
+  // Bilinear demosaicing of a single pixel using the precomputed offset tables.
+  auto demosaic_pixel = [&]<typename Pixel>(const Pixel* in, Pixel* out,
+                                            size_t in_str, size_t out_str,
+                                            uint32_t x, uint32_t y) {
+    const auto& offsets = neighbor_offsets[(y % ph) * pw + (x % pw)];
 
-        Pixel* out_pixel = &out[y * out_str + x * 3];
+    Pixel* out_pixel = &out[y * out_str + x * 3];
 
-        for (int ch = 0; ch < 3; ch++) {
-          const auto& ch_offsets = offsets[ch];
-          int sum = 0;
-          int count = 0;
+    for (int ch = 0; ch < 3; ch++) {
+      const auto& ch_offsets = offsets[ch];
+      int sum = 0;
+      int count = 0;
 
-          for (const auto& [dx, dy] : ch_offsets) {
-            int nx = static_cast<int>(x) + dx;
-            int ny = static_cast<int>(y) + dy;
+      for (const auto& [dx, dy] : ch_offsets) {
+        int nx = static_cast<int>(x) + dx;
+        int ny = static_cast<int>(y) + dy;
 
-            if (nx < 0 || nx >= static_cast<int>(width) ||
-                ny < 0 || ny >= static_cast<int>(height)) {
-              continue;
-            }
+        if (nx < 0 || nx >= static_cast<int>(width) ||
+            ny < 0 || ny >= static_cast<int>(height)) {
+          continue;
+        }
 
-            sum += in[ny * in_str + nx];
-            count++;
-          }
+        sum += in[ny * in_str + nx];
+        count++;
+      }
+
+      out_pixel[ch] = count > 0 ? static_cast<Pixel>((sum + count / 2) / count) : 0;
+    }
+  };
 
-          out_pixel[ch] = count > 0 ? static_cast<Pixel>((sum + count / 2) / count) : 0;
+  auto demosaic = [&]<typename Pixel>(const Pixel* in, Pixel* out,
+                                      size_t in_str, size_t out_str,
+                                      void (*demosaic_row)(const Pixel* above, const Pixel* row, const Pixel* below,
+                                                           Pixel* out, uint32_t width,
+                                                           int even_channel, int odd_channel)) {
+    for (uint32_t y = first_row; y < end_row; y++) {
+      if (use_kernels && y > 0 && y + 1 < height && width >= 3) {
+        int even_channel = pattern_channel[(y % 2) * 2];
+        int odd_channel = pattern_channel[(y % 2) * 2 + 1];
+
+        demosaic_row(&in[(y - 1) * in_str], &in[y * in_str], &in[(y + 1) * in_str],
+                     &out[y * out_str], width, even_channel, odd_channel);
+
+        demosaic_pixel(in, out, in_str, out_str, 0, y);
+        demosaic_pixel(in, out, in_str, out_str, width - 1, y);
+      }
+      else {
+        for (uint32_t x = 0; x < width; x++) {
+          demosaic_pixel(in, out, in_str, out_str, x, y);
         }
       }
     }
@@ -203,11 +289,13 @@ Op_bayer_bilinear_to_RGB24_32::convert_colorspace(const std::shared_ptr<const He
   if (hdr) {
     demosaic(reinterpret_cast<const uint16_t*>(in_p),
              reinterpret_cast<uint16_t*>(out_p),
-             in_stride / 2, out_stride / 2);
+             in_stride / 2, out_stride / 2,
+             m_kernels->demosaic_row_16);
   }
   else {
-    demosaic(in_p, out_p, in_stride, out_stride);
+    demosaic(in_p, out_p, in_stride, out_stride,
+             m_kernels->demosaic_row_8);
   }
 
-  return outimg;
+  return Error::Ok;
 }
@@ -22,13 +22,19 @@
 #define LIBHEIF_COLORCONVERSION_BAYER_BILINEAR_H
 
 #include "colorconversion.h"
+#include "bayer_bilinear_kernels.h"
 #include <vector>
 #include <memory>
 
 
-class Op_bayer_bilinear_to_RGB24_32 : public ColorConversionOperation
+// Bilinear demosaicing of filter array images. Images with a 2x2 Bayer pattern (RGGB, BGGR, GRBG, GBRG)
+// are processed with the row kernels, all other patterns with a generic (slower) neighborhood search.
+class Op_bayer_bilinear_to_RGB24_32 : public StripedColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_bayer_bilinear_to_RGB24_32(const Bayer_demosaic_kernels& kernels = get_scalar_Bayer_demosaic_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -36,12 +42,27 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+  // The demosaicing reads the rows above and below each output row.
+  bool needs_neighboring_rows(const ColorState& input_state) const override { return true; }
+
+private:
+  const Bayer_demosaic_kernels* m_kernels;
 };
 
 #endif //LIBHEIF_COLORCONVERSION_BAYER_BILINEAR_H
@@ -0,0 +1,99 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bayer_bilinear_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+
+
+template<class Pixel>
+static void demosaic_row_scalar(const Pixel* above, const Pixel* row, const Pixel* below,
+                                Pixel* out, uint32_t width, int even_channel, int odd_channel)
+{
+  for (uint32_t x = 1; x + 1 < width; x++) {
+    int channel = (x % 2 == 0) ? even_channel : odd_channel;
+    Pixel* rgb = &out[3 * x];
+
+    if (channel == 1) {
+      // The other color of this row is left and right, the color of the neighboring rows is above and below.
+      int row_channel = (x % 2 == 0) ? odd_channel : even_channel;
+
+      rgb[1] = row[x];
+      rgb[row_channel] = static_cast<Pixel>((row[x - 1] + row[x + 1] + 1) >> 1);
+      rgb[2 - row_channel] = static_cast<Pixel>((above[x] + below[x] + 1) >> 1);
+    }
+    else {
+      rgb[channel] = row[x];
+      rgb[1] = static_cast<Pixel>((row[x - 1] + row[x + 1] + above[x] + below[x] + 2) >> 2);
+      rgb[2 - channel] = static_cast<Pixel>((above[x - 1] + above[x + 1] + below[x - 1] + below[x + 1] + 2) >> 2);
+    }
+  }
+}
+
+
+void demosaic_row_8_scalar(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                           uint8_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  demosaic_row_scalar(above, row, below, out, width, even_channel, odd_channel);
+}
+
+
+void demosaic_row_16_scalar(const uint16_t* above, const uint16_t* row, const uint16_t* below,
+                            uint16_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  demosaic_row_scalar(above, row, below, out, width, even_channel, odd_channel);
+}
+
+
+static const Bayer_demosaic_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  demosaic_row_8_scalar,
+  demosaic_row_16_scalar
+};
+
+extern const Bayer_demosaic_kernels bayer_bilinear_kernels_sse41;
+extern const Bayer_demosaic_kernels bayer_bilinear_kernels_avx2;
+extern const Bayer_demosaic_kernels bayer_bilinear_kernels_neon;
+
+static const KernelDispatcher<Bayer_demosaic_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(bayer_bilinear_kernels_sse41),
+  AVX2_KERNELS(bayer_bilinear_kernels_avx2),
+  NEON_KERNELS(bayer_bilinear_kernels_neon)
+};
+
+
+const Bayer_demosaic_kernels& get_scalar_Bayer_demosaic_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const Bayer_demosaic_kernels* get_simd_Bayer_demosaic_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const Bayer_demosaic_kernels*> get_supported_Bayer_demosaic_kernels()
+{
+  return dispatcher.get_supported();
+}
@@ -0,0 +1,71 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_BAYER_BILINEAR_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_BAYER_BILINEAR_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels for the bilinear demosaicing of 2x2 Bayer patterns (RGGB, BGGR, GRBG, GBRG).
+//
+// These follow the same scheme as the YCbCr -> RGB kernels (see yuv2rgb_kernels.h): there is a scalar
+// reference implementation and vectorized implementations in translation units that are compiled with
+// SSE4.1, AVX2 or NEON enabled. All kernels are bit-exact.
+//
+// The missing colors are the rounded averages of the nearest neighbors of that color:
+//  - at red and blue pixels: green from the 4 horizontal and vertical neighbors, the other color from the 4 diagonal neighbors,
+//  - at green pixels: the color of the same row from the left and right neighbor, the other color from above and below.
+
+struct Bayer_demosaic_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  // Demosaics the inner pixels 1 ... width-2 of one row into interleaved RGB. The border pixels are not written.
+  // 'above', 'row' and 'below' are the filter array rows y-1, y and y+1. 'out' points to the start of the output row.
+  // 'even_channel' and 'odd_channel' are the colors (0=R, 1=G, 2=B) of the pixels at even and odd x.
+  // One of them has to be green.
+  void (*demosaic_row_8)(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                         uint8_t* out, uint32_t width, int even_channel, int odd_channel);
+
+  void (*demosaic_row_16)(const uint16_t* above, const uint16_t* row, const uint16_t* below,
+                          uint16_t* out, uint32_t width, int even_channel, int odd_channel);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void demosaic_row_8_scalar(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                           uint8_t* out, uint32_t width, int even_channel, int odd_channel);
+
+void demosaic_row_16_scalar(const uint16_t* above, const uint16_t* row, const uint16_t* below,
+                            uint16_t* out, uint32_t width, int even_channel, int odd_channel);
+
+
+const Bayer_demosaic_kernels& get_scalar_Bayer_demosaic_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const Bayer_demosaic_kernels* get_simd_Bayer_demosaic_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const Bayer_demosaic_kernels*> get_supported_Bayer_demosaic_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_BAYER_BILINEAR_KERNELS_H
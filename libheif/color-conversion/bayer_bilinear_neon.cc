@@ -0,0 +1,137 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See bayer_bilinear_kernels.h.
+
+#include "bayer_bilinear_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+
+
+// Alternating lane masks. Loading at offset 0 selects the even lanes, at offset 1 the odd lanes.
+static const uint8_t alternating_mask_8[17] = {
+    0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF
+};
+
+static const uint16_t alternating_mask_16[9] = {
+    0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF
+};
+
+
+// (a + b + c + d + 2) >> 2
+static inline uint8x16_t average4(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+  uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)), vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+  uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)), vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+  return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+
+
+static inline uint16x8_t average4(uint16x8_t a, uint16x8_t b, uint16x8_t c, uint16x8_t d)
+{
+  uint32x4_t lo = vaddq_u32(vaddl_u16(vget_low_u16(a), vget_low_u16(b)), vaddl_u16(vget_low_u16(c), vget_low_u16(d)));
+  uint32x4_t hi = vaddq_u32(vaddl_u16(vget_high_u16(a), vget_high_u16(b)), vaddl_u16(vget_high_u16(c), vget_high_u16(d)));
+  return vcombine_u16(vrshrn_n_u32(lo, 2), vrshrn_n_u32(hi, 2));
+}
+
+
+static void demosaic_row_8_neon(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                                uint8_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  // The red or blue pixels of this row are at the 'site' positions, the green pixels in between.
+  // The vectors start at odd x. Hence, the site positions are the even lanes when the green pixels are at even x.
+  int site_channel = (even_channel == 1) ? odd_channel : even_channel;
+  uint8x16_t site_mask = vld1q_u8(alternating_mask_8 + (even_channel == 1 ? 0 : 1));
+
+  uint32_t x = 1;
+  for (; x + 16 + 1 <= width; x += 16) {
+    uint8x16_t c = vld1q_u8(row + x);
+    uint8x16_t l = vld1q_u8(row + x - 1);
+    uint8x16_t r = vld1q_u8(row + x + 1);
+    uint8x16_t u = vld1q_u8(above + x);
+    uint8x16_t d = vld1q_u8(below + x);
+
+    uint8x16_t horizontal = vrhaddq_u8(l, r);
+    uint8x16_t vertical = vrhaddq_u8(u, d);
+    uint8x16_t cross = average4(l, r, u, d);
+    uint8x16_t diagonal = average4(vld1q_u8(above + x - 1), vld1q_u8(above + x + 1),
+                                   vld1q_u8(below + x - 1), vld1q_u8(below + x + 1));
+
+    uint8x16_t site_color = vbslq_u8(site_mask, c, horizontal);
+    uint8x16_t green = vbslq_u8(site_mask, cross, c);
+    uint8x16_t other_color = vbslq_u8(site_mask, diagonal, vertical);
+
+    uint8x16x3_t rgb;
+    rgb.val[0] = (site_channel == 0) ? site_color : other_color;
+    rgb.val[1] = green;
+    rgb.val[2] = (site_channel == 0) ? other_color : site_color;
+    vst3q_u8(out + 3 * x, rgb);
+  }
+
+  // The remaining pixels. Since x-1 is even, the pixel colors at even and odd positions stay the same.
+  uint32_t offset = x - 1;
+  demosaic_row_8_scalar(above + offset, row + offset, below + offset, out + 3 * offset, width - offset,
+                        even_channel, odd_channel);
+}
+
+
+static void demosaic_row_16_neon(const uint16_t* above, const uint16_t* row, const uint16_t* below,
+                                 uint16_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  int site_channel = (even_channel == 1) ? odd_channel : even_channel;
+  uint16x8_t site_mask = vld1q_u16(alternating_mask_16 + (even_channel == 1 ? 0 : 1));
+
+  uint32_t x = 1;
+  for (; x + 8 + 1 <= width; x += 8) {
+    uint16x8_t c = vld1q_u16(row + x);
+    uint16x8_t l = vld1q_u16(row + x - 1);
+    uint16x8_t r = vld1q_u16(row + x + 1);
+    uint16x8_t u = vld1q_u16(above + x);
+    uint16x8_t d = vld1q_u16(below + x);
+
+    uint16x8_t horizontal = vrhaddq_u16(l, r);
+    uint16x8_t vertical = vrhaddq_u16(u, d);
+    uint16x8_t cross = average4(l, r, u, d);
+    uint16x8_t diagonal = average4(vld1q_u16(above + x - 1), vld1q_u16(above + x + 1),
+                                   vld1q_u16(below + x - 1), vld1q_u16(below + x + 1));
+
+    uint16x8_t site_color = vbslq_u16(site_mask, c, horizontal);
+    uint16x8_t green = vbslq_u16(site_mask, cross, c);
+    uint16x8_t other_color = vbslq_u16(site_mask, diagonal, vertical);
+
+    uint16x8x3_t rgb;
+    rgb.val[0] = (site_channel == 0) ? site_color : other_color;
+    rgb.val[1] = green;
+    rgb.val[2] = (site_channel == 0) ? other_color : site_color;
+    vst3q_u16(out + 3 * x, rgb);
+  }
+
+  uint32_t offset = x - 1;
+  demosaic_row_16_scalar(above + offset, row + offset, below + offset, out + 3 * offset, width - offset,
+                         even_channel, odd_channel);
+}
+
+
+extern const Bayer_demosaic_kernels bayer_bilinear_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  demosaic_row_8_neon,
+  demosaic_row_16_neon
+};
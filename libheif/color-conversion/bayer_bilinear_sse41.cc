@@ -0,0 +1,195 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See bayer_bilinear_kernels.h.
+
+#include "bayer_bilinear_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+
+
+// Alternating lane masks. Loading at offset 0 selects the even lanes, at offset 1 the odd lanes.
+alignas(16) static const uint8_t alternating_mask_8[17] = {
+    0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF, 0, 0xFF
+};
+
+alignas(16) static const uint16_t alternating_mask_16[9] = {
+    0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF, 0, 0xFFFF
+};
+
+
+// (a + b + c + d + 2) >> 2
+static inline __m128i average4(__m128i a, __m128i b, __m128i c, __m128i d, uint8_t)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two = _mm_set1_epi16(2);
+
+  __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+                             _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+  __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+                             _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+
+  return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2),
+                          _mm_srli_epi16(_mm_add_epi16(hi, two), 2));
+}
+
+
+static inline __m128i average4(__m128i a, __m128i b, __m128i c, __m128i d, uint16_t)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i two = _mm_set1_epi32(2);
+
+  __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero)),
+                             _mm_add_epi32(_mm_unpacklo_epi16(c, zero), _mm_unpacklo_epi16(d, zero)));
+  __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero)),
+                             _mm_add_epi32(_mm_unpackhi_epi16(c, zero), _mm_unpackhi_epi16(d, zero)));
+
+  return _mm_packus_epi32(_mm_srli_epi32(_mm_add_epi32(lo, two), 2),
+                          _mm_srli_epi32(_mm_add_epi32(hi, two), 2));
+}
+
+
+// (a + b + 1) >> 1
+static inline __m128i average2(__m128i a, __m128i b, uint8_t) { return _mm_avg_epu8(a, b); }
+
+static inline __m128i average2(__m128i a, __m128i b, uint16_t) { return _mm_avg_epu16(a, b); }
+
+
+// Interleaves the R, G, B vectors and stores them as 48 bytes.
+static inline void store_rgb(uint8_t* out, __m128i r, __m128i g, __m128i b)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+  __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+  __m128i b0_lo = _mm_unpacklo_epi8(b, zero);
+  __m128i b0_hi = _mm_unpackhi_epi8(b, zero);
+
+  // remove the 4th byte of each pixel, leaving 12 bytes per vector
+  const __m128i drop = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  __m128i p0 = _mm_shuffle_epi8(_mm_unpacklo_epi16(rg_lo, b0_lo), drop);
+  __m128i p1 = _mm_shuffle_epi8(_mm_unpackhi_epi16(rg_lo, b0_lo), drop);
+  __m128i p2 = _mm_shuffle_epi8(_mm_unpacklo_epi16(rg_hi, b0_hi), drop);
+  __m128i p3 = _mm_shuffle_epi8(_mm_unpackhi_epi16(rg_hi, b0_hi), drop);
+
+  _mm_storeu_si128((__m128i*) (out + 0), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+  _mm_storeu_si128((__m128i*) (out + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+  _mm_storeu_si128((__m128i*) (out + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+}
+
+
+static inline void store_rgb(uint16_t* out, __m128i r, __m128i g, __m128i b)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  __m128i rg_lo = _mm_unpacklo_epi16(r, g);
+  __m128i rg_hi = _mm_unpackhi_epi16(r, g);
+  __m128i b0_lo = _mm_unpacklo_epi16(b, zero);
+  __m128i b0_hi = _mm_unpackhi_epi16(b, zero);
+
+  // remove the 4th sample of each pixel, leaving 12 bytes per vector
+  const __m128i drop = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+  __m128i p0 = _mm_shuffle_epi8(_mm_unpacklo_epi32(rg_lo, b0_lo), drop);
+  __m128i p1 = _mm_shuffle_epi8(_mm_unpackhi_epi32(rg_lo, b0_lo), drop);
+  __m128i p2 = _mm_shuffle_epi8(_mm_unpacklo_epi32(rg_hi, b0_hi), drop);
+  __m128i p3 = _mm_shuffle_epi8(_mm_unpackhi_epi32(rg_hi, b0_hi), drop);
+
+  auto* o = (uint8_t*) out;
+  _mm_storeu_si128((__m128i*) (o + 0), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+  _mm_storeu_si128((__m128i*) (o + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+  _mm_storeu_si128((__m128i*) (o + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+}
+
+
+template<class Pixel>
+static void demosaic_row_sse41(const Pixel* above, const Pixel* row, const Pixel* below,
+                               Pixel* out, uint32_t width, int even_channel, int odd_channel)
+{
+  constexpr uint32_t n = 16 / sizeof(Pixel);
+
+  // The red or blue pixels of this row are at the 'site' positions, the green pixels in between.
+  int site_parity = (even_channel == 1) ? 1 : 0;
+  int site_channel = (even_channel == 1) ? odd_channel : even_channel;
+
+  // The vectors start at odd x. Hence, the site positions are the even lanes when the site parity is odd.
+  const auto* mask_table = (sizeof(Pixel) == 1) ? (const uint8_t*) alternating_mask_8 : (const uint8_t*) alternating_mask_16;
+  __m128i site_mask = _mm_loadu_si128((const __m128i*) (mask_table + (site_parity == 1 ? 0 : sizeof(Pixel))));
+
+  uint32_t x = 1;
+  for (; x + n + 1 <= width; x += n) {
+    __m128i c = _mm_loadu_si128((const __m128i*) (row + x));
+    __m128i l = _mm_loadu_si128((const __m128i*) (row + x - 1));
+    __m128i r = _mm_loadu_si128((const __m128i*) (row + x + 1));
+    __m128i u = _mm_loadu_si128((const __m128i*) (above + x));
+    __m128i ul = _mm_loadu_si128((const __m128i*) (above + x - 1));
+    __m128i ur = _mm_loadu_si128((const __m128i*) (above + x + 1));
+    __m128i d = _mm_loadu_si128((const __m128i*) (below + x));
+    __m128i dl = _mm_loadu_si128((const __m128i*) (below + x - 1));
+    __m128i dr = _mm_loadu_si128((const __m128i*) (below + x + 1));
+
+    __m128i horizontal = average2(l, r, Pixel{});
+    __m128i vertical = average2(u, d, Pixel{});
+    __m128i cross = average4(l, r, u, d, Pixel{});
+    __m128i diagonal = average4(ul, ur, dl, dr, Pixel{});
+
+    __m128i site_color = _mm_blendv_epi8(horizontal, c, site_mask);
+    __m128i green = _mm_blendv_epi8(c, cross, site_mask);
+    __m128i other_color = _mm_blendv_epi8(vertical, diagonal, site_mask);
+
+    __m128i red = (site_channel == 0) ? site_color : other_color;
+    __m128i blue = (site_channel == 0) ? other_color : site_color;
+
+    store_rgb(out + 3 * x, red, green, blue);
+  }
+
+  // The remaining pixels. Since x-1 is even, the pixel colors at even and odd positions stay the same.
+  uint32_t offset = x - 1;
+
+  if constexpr (sizeof(Pixel) == 1) {
+    demosaic_row_8_scalar(above + offset, row + offset, below + offset, out + 3 * offset, width - offset,
+                          even_channel, odd_channel);
+  }
+  else {
+    demosaic_row_16_scalar(above + offset, row + offset, below + offset, out + 3 * offset, width - offset,
+                           even_channel, odd_channel);
+  }
+}
+
+
+static void demosaic_row_8_sse41(const uint8_t* above, const uint8_t* row, const uint8_t* below,
+                                 uint8_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  demosaic_row_sse41(above, row, below, out, width, even_channel, odd_channel);
+}
+
+
+static void demosaic_row_16_sse41(const uint16_t* above, const uint16_t* row, const uint16_t* below,
+                                  uint16_t* out, uint32_t width, int even_channel, int odd_channel)
+{
+  demosaic_row_sse41(above, row, below, out, width, even_channel, odd_channel);
+}
+
+
+extern const Bayer_demosaic_kernels bayer_bilinear_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  demosaic_row_8_sse41,
+  demosaic_row_16_sse41
+};
@@ -0,0 +1,78 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. See blend_kernels.h.
+
+#include "blend_kernels.h"
+#include "colorconversion.h"
+#include <immintrin.h>
+
+
+static void blend_row_8_avx2(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width)
+{
+  const __m256i max = _mm256_set1_epi16(255);
+  const __m256i one = _mm256_set1_epi16(1);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i i = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (in + x)));
+    __m256i o = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (out + x)));
+    __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (alpha + x)));
+
+    __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(i, a), _mm256_mullo_epi16(o, _mm256_sub_epi16(max, a)));
+    v = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v, one), _mm256_srli_epi16(v, 8)), 8);
+
+    __m128i result = _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    _mm_storeu_si128((__m128i*) (out + x), result);
+  }
+
+  blend_row_8_scalar(out + x, in + x, alpha + x, width - x);
+}
+
+
+static void blend_row_16_avx2(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max)
+{
+  const __m256 scale = _mm256_set1_ps(1.0f / static_cast<float>(alpha_max));
+  const __m256 half = _mm256_set1_ps(0.5f);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256 i = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (in + x))));
+    __m256 o = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (out + x))));
+    __m256 a = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (alpha + x))));
+
+    // same operation order as the scalar code
+    __m256 v = _mm256_add_ps(o, _mm256_mul_ps(_mm256_sub_ps(i, o), _mm256_mul_ps(a, scale)));
+    __m256i r = _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+
+    __m128i result = _mm_packus_epi32(_mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1));
+    _mm_storeu_si128((__m128i*) (out + x), result);
+  }
+
+  blend_row_16_scalar(out + x, in + x, alpha + x, width - x, alpha_max);
+}
+
+
+extern const Alpha_blending_kernels blend_kernels_avx2{
+  "avx2",
+  SpeedCosts_OptimizedSoftware,
+  blend_row_8_avx2,
+  blend_row_16_avx2
+};
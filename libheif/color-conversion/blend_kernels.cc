@@ -0,0 +1,86 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "blend_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+
+
+void blend_row_8_scalar(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint16_t a = alpha[x];
+    uint16_t v = static_cast<uint16_t>(in[x] * a + out[x] * (255 - a));
+
+    // exact v/255 for all v <= 255*255
+    out[x] = static_cast<uint8_t>((v + 1 + (v >> 8)) >> 8);
+  }
+}
+
+
+void blend_row_16_scalar(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max)
+{
+  const float scale = 1.0f / static_cast<float>(alpha_max);
+
+  for (uint32_t x = 0; x < width; x++) {
+    float a = static_cast<float>(alpha[x]) * scale;
+    float o = static_cast<float>(out[x]);
+    float v = o + (static_cast<float>(in[x]) - o) * a;
+
+    out[x] = static_cast<uint16_t>(v + 0.5f);
+  }
+}
+
+
+static const Alpha_blending_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  blend_row_8_scalar,
+  blend_row_16_scalar
+};
+
+extern const Alpha_blending_kernels blend_kernels_sse41;
+extern const Alpha_blending_kernels blend_kernels_avx2;
+extern const Alpha_blending_kernels blend_kernels_neon;
+
+static const KernelDispatcher<Alpha_blending_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(blend_kernels_sse41),
+  AVX2_KERNELS(blend_kernels_avx2),
+  NEON_KERNELS(blend_kernels_neon)
+};
+
+
+const Alpha_blending_kernels& get_scalar_Alpha_blending_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const Alpha_blending_kernels* get_simd_Alpha_blending_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const Alpha_blending_kernels*> get_supported_Alpha_blending_kernels()
+{
+  return dispatcher.get_supported();
+}
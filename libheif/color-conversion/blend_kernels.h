@@ -0,0 +1,63 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_BLEND_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_BLEND_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels for alpha-blending one plane onto another (used for compositing overlay images).
+//
+// These follow the same scheme as the YCbCr -> RGB kernels (see yuv2rgb_kernels.h): there is a scalar
+// reference implementation and vectorized implementations in translation units that are compiled with
+// SSE4.1, AVX2 or NEON enabled.
+//
+// 8 bit: out = (in*a + out*(255-a)) / 255 with integer division, which is computed exactly with shifts:
+//        v = in*a + out*(255-a), out' = (v + 1 + (v>>8)) >> 8. These kernels are bit-exact.
+// 16 bit: out = out + (in - out) * a/alpha_max + 0.5, computed in single precision float.
+
+struct Alpha_blending_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  void (*blend_row_8)(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width);
+
+  void (*blend_row_16)(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void blend_row_8_scalar(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width);
+
+void blend_row_16_scalar(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max);
+
+
+const Alpha_blending_kernels& get_scalar_Alpha_blending_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const Alpha_blending_kernels* get_simd_Alpha_blending_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const Alpha_blending_kernels*> get_supported_Alpha_blending_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_BLEND_KERNELS_H
@@ -0,0 +1,90 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See blend_kernels.h.
+
+#include "blend_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+
+
+static inline uint8x8_t blend_8x8(uint8x8_t in, uint8x8_t out, uint8x8_t a)
+{
+  uint16x8_t v = vmlal_u8(vmull_u8(in, a), out, vsub_u8(vdup_n_u8(255), a));
+  return vmovn_u16(vshrq_n_u16(vaddq_u16(vaddq_u16(v, vdupq_n_u16(1)), vshrq_n_u16(v, 8)), 8));
+}
+
+
+static void blend_row_8_neon(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width)
+{
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t i = vld1q_u8(in + x);
+    uint8x16_t o = vld1q_u8(out + x);
+    uint8x16_t a = vld1q_u8(alpha + x);
+
+    uint8x8_t lo = blend_8x8(vget_low_u8(i), vget_low_u8(o), vget_low_u8(a));
+    uint8x8_t hi = blend_8x8(vget_high_u8(i), vget_high_u8(o), vget_high_u8(a));
+
+    vst1q_u8(out + x, vcombine_u8(lo, hi));
+  }
+
+  blend_row_8_scalar(out + x, in + x, alpha + x, width - x);
+}
+
+
+// same operation order as the scalar code (separate multiply and add)
+static inline uint16x4_t blend_4xf(uint16x4_t in, uint16x4_t out, uint16x4_t a, float32x4_t scale)
+{
+  float32x4_t af = vmulq_f32(vcvtq_f32_u32(vmovl_u16(a)), scale);
+  float32x4_t o = vcvtq_f32_u32(vmovl_u16(out));
+  float32x4_t d = vsubq_f32(vcvtq_f32_u32(vmovl_u16(in)), o);
+  float32x4_t v = vaddq_f32(vaddq_f32(o, vmulq_f32(d, af)), vdupq_n_f32(0.5f));
+
+  return vqmovn_u32(vcvtq_u32_f32(v));
+}
+
+
+static void blend_row_16_neon(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max)
+{
+  const float32x4_t scale = vdupq_n_f32(1.0f / static_cast<float>(alpha_max));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t i = vld1q_u16(in + x);
+    uint16x8_t o = vld1q_u16(out + x);
+    uint16x8_t a = vld1q_u16(alpha + x);
+
+    uint16x4_t lo = blend_4xf(vget_low_u16(i), vget_low_u16(o), vget_low_u16(a), scale);
+    uint16x4_t hi = blend_4xf(vget_high_u16(i), vget_high_u16(o), vget_high_u16(a), scale);
+
+    vst1q_u16(out + x, vcombine_u16(lo, hi));
+  }
+
+  blend_row_16_scalar(out + x, in + x, alpha + x, width - x, alpha_max);
+}
+
+
+extern const Alpha_blending_kernels blend_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  blend_row_8_neon,
+  blend_row_16_neon
+};
@@ -0,0 +1,96 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See blend_kernels.h.
+
+#include "blend_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+
+
+// blends 8 pixels in 16 bit lanes
+static inline __m128i blend_8x16(__m128i in, __m128i out, __m128i a)
+{
+  const __m128i max = _mm_set1_epi16(255);
+  const __m128i one = _mm_set1_epi16(1);
+
+  __m128i v = _mm_add_epi16(_mm_mullo_epi16(in, a), _mm_mullo_epi16(out, _mm_sub_epi16(max, a)));
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, one), _mm_srli_epi16(v, 8)), 8);
+}
+
+
+static void blend_row_8_sse41(uint8_t* out, const uint8_t* in, const uint8_t* alpha, uint32_t width)
+{
+  const __m128i zero = _mm_setzero_si128();
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i i = _mm_loadu_si128((const __m128i*) (in + x));
+    __m128i o = _mm_loadu_si128((const __m128i*) (out + x));
+    __m128i a = _mm_loadu_si128((const __m128i*) (alpha + x));
+
+    __m128i lo = blend_8x16(_mm_unpacklo_epi8(i, zero), _mm_unpacklo_epi8(o, zero), _mm_unpacklo_epi8(a, zero));
+    __m128i hi = blend_8x16(_mm_unpackhi_epi8(i, zero), _mm_unpackhi_epi8(o, zero), _mm_unpackhi_epi8(a, zero));
+
+    _mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi16(lo, hi));
+  }
+
+  blend_row_8_scalar(out + x, in + x, alpha + x, width - x);
+}
+
+
+// blends 4 pixels in float, with the same operation order as the scalar code
+static inline __m128i blend_4xf(__m128i in, __m128i out, __m128i a, __m128 scale)
+{
+  __m128 af = _mm_mul_ps(_mm_cvtepi32_ps(a), scale);
+  __m128 o = _mm_cvtepi32_ps(out);
+  __m128 v = _mm_add_ps(o, _mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(in), o), af));
+
+  return _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+}
+
+
+static void blend_row_16_sse41(uint16_t* out, const uint16_t* in, const uint16_t* alpha, uint32_t width, uint16_t alpha_max)
+{
+  const __m128 scale = _mm_set1_ps(1.0f / static_cast<float>(alpha_max));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i i = _mm_loadu_si128((const __m128i*) (in + x));
+    __m128i o = _mm_loadu_si128((const __m128i*) (out + x));
+    __m128i a = _mm_loadu_si128((const __m128i*) (alpha + x));
+
+    __m128i lo = blend_4xf(_mm_cvtepu16_epi32(i), _mm_cvtepu16_epi32(o), _mm_cvtepu16_epi32(a), scale);
+    __m128i hi = blend_4xf(_mm_cvtepu16_epi32(_mm_srli_si128(i, 8)), _mm_cvtepu16_epi32(_mm_srli_si128(o, 8)),
+                           _mm_cvtepu16_epi32(_mm_srli_si128(a, 8)), scale);
+
+    _mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi32(lo, hi));
+  }
+
+  blend_row_16_scalar(out + x, in + x, alpha + x, width - x, alpha_max);
+}
+
+
+extern const Alpha_blending_kernels blend_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  blend_row_8_sse41,
+  blend_row_16_sse41
+};
@@ -20,6 +20,7 @@
 
 #include "chroma_sampling.h"
 #include <cstring>
+#include <algorithm>
 
 
 template<class Pixel>
@@ -70,7 +71,7 @@ Op_YCbCr444_to_YCbCr420_average<Pixel>::state_after_conversion(const ColorState&
   output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
   output_state.nclx = input_state.nclx;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
@@ -208,20 +209,23 @@ Op_YCbCr444_to_YCbCr420_average<Pixel>::convert_colorspace(const std::shared_ptr
 
   // --- averaging filter
 
-  uint32_t x, y;
+  uint32_t y;
   for (y = 0; y < height - 1; y += 2) {
-    for (x = 0; x < width - 1; x += 2) {
-      Pixel cb00 = in_cb[y * in_cb_stride + x];
-      Pixel cr00 = in_cr[y * in_cr_stride + x];
-      Pixel cb01 = in_cb[y * in_cb_stride + x + 1];
-      Pixel cr01 = in_cr[y * in_cr_stride + x + 1];
-      Pixel cb10 = in_cb[(y + 1) * in_cb_stride + x];
-      Pixel cr10 = in_cr[(y + 1) * in_cr_stride + x];
-      Pixel cb11 = in_cb[(y + 1) * in_cb_stride + x + 1];
-      Pixel cr11 = in_cr[(y + 1) * in_cr_stride + x + 1];
-
-      out_cb[(y / 2) * out_cb_stride + x / 2] = (Pixel) ((cb00 + cb01 + cb10 + cb11 + 2) / 4);
-      out_cr[(y / 2) * out_cr_stride + x / 2] = (Pixel) ((cr00 + cr01 + cr10 + cr11 + 2) / 4);
+    if (hdr) {
+      m_kernels->average_420_row_16((const uint16_t*) &in_cb[y * in_cb_stride],
+                                    (const uint16_t*) &in_cb[(y + 1) * in_cb_stride],
+                                    (uint16_t*) &out_cb[(y / 2) * out_cb_stride], width / 2);
+      m_kernels->average_420_row_16((const uint16_t*) &in_cr[y * in_cr_stride],
+                                    (const uint16_t*) &in_cr[(y + 1) * in_cr_stride],
+                                    (uint16_t*) &out_cr[(y / 2) * out_cr_stride], width / 2);
+    }
+    else {
+      m_kernels->average_420_row_8((const uint8_t*) &in_cb[y * in_cb_stride],
+                                   (const uint8_t*) &in_cb[(y + 1) * in_cb_stride],
+                                   (uint8_t*) &out_cb[(y / 2) * out_cb_stride], width / 2);
+      m_kernels->average_420_row_8((const uint8_t*) &in_cr[y * in_cr_stride],
+                                   (const uint8_t*) &in_cr[(y + 1) * in_cr_stride],
+                                   (uint8_t*) &out_cr[(y / 2) * out_cr_stride], width / 2);
     }
   }
 
@@ -449,63 +453,9 @@ template class Op_YCbCr444_to_YCbCr422_average<uint16_t>;
 
 
 template<class Pixel>
-std::vector<ColorStateWithCost>
-Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState& input_state,
-                                                                const ColorState& target_state,
-                                                                const heif_color_conversion_options& options,
-                                                                const heif_color_conversion_options_ext& options_ext) const
-{
-  if (input_state.colorspace != heif_colorspace_YCbCr) {
-    return {};
-  }
-
-  if (input_state.chroma != heif_chroma_420) {
-    return {};
-  }
-
-  // this Op only implements the bilinear algorithm
-
-  if (options.preferred_chroma_upsampling_algorithm != heif_chroma_upsampling_bilinear) {
-    return {};
-  }
-
-  bool hdr = !std::is_same<Pixel, uint8_t>::value;
-
-  if ((input_state.bits_per_pixel > 8) != hdr) {
-    return {};
-  }
-
-  if (input_state.nclx.get_matrix_coefficients() == 0) {
-    return {};
-  }
-
-  std::vector<ColorStateWithCost> states;
-
-  ColorState output_state;
-
-  // --- convert to 4:4:4
-
-  output_state.colorspace = heif_colorspace_YCbCr;
-  output_state.chroma = heif_chroma_444;
-  output_state.has_alpha = input_state.has_alpha;  // we simply keep the old alpha plane
-  output_state.bits_per_pixel = input_state.bits_per_pixel;
-  output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
-  output_state.nclx = input_state.nclx;
-
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
-
-  return states;
-}
-
-
-template<class Pixel>
-Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                                            const ColorState& input_state,
-                                                            const ColorState& target_state,
-                                                            const heif_color_conversion_options& options,
-                                                            const heif_color_conversion_options_ext& options_ext,
-                                                            const heif_security_limits* limits) const
+static Result<std::shared_ptr<HeifPixelImage>>
+create_upsampled_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                              const heif_security_limits* limits)
 {
   bool hdr = !std::is_same<Pixel, uint8_t>::value;
 
@@ -562,31 +512,62 @@ Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::convert_colorspace(const std::shared_pt
     }
   }
 
-  const Pixel* in_y, * in_cb, * in_cr;
-  size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0, in_a_stride = 0;
+  return outimg;
+}
 
-  Pixel* out_y, * out_cb, * out_cr;
+
+/*
+ *  We assume that chroma pixels are located in the center of 2x2 (4:2:0) or 2x1 (4:2:2) luma pixels.
+ *  Each output row is interpolated from the closer chroma row (weight 3/4) and the other neighboring
+ *  chroma row (weight 1/4). The horizontal interpolation is done by the row kernels.
+ *
+ *  Upsampling weights are 3/4, 1/4. For example:
+ *    A = 3/4*3/4 * C1 + 3/4*1/4 * C2 + 1/4*3/4 * C3 + 1/4*1/4 * C4
+ *
+ *    +---+---+---+---+
+ *    | b | b | b | b |
+ *    +---C1--+---C2--+
+ *    | b | A |   | b |
+ *    +---+---+---+---+
+ *    | b |   |   | b |
+ *    +---C3--+---C4--+
+ *    | b | b | b | b |
+ *    +---+---+---+---+
+ *
+ *  At the image border 'b', the chroma samples are only interpolated in one direction.
+ */
+template<class Pixel>
+static void upsample_bilinear_stripe(const YCbCr_to_RGB_kernels& kernels,
+                                     bool vertical_subsampling,
+                                     const std::shared_ptr<const HeifPixelImage>& input,
+                                     const std::shared_ptr<HeifPixelImage>& outimg,
+                                     uint32_t first_row, uint32_t end_row)
+{
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
+
+  uint32_t width = input->get_width();
+  uint32_t chroma_height = input->get_height(heif_channel_Cb);
+
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+  int bpp_a = (has_alpha ? input->get_bits_per_pixel(heif_channel_Alpha) : 0);
+
+  size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0, in_a_stride = 0;
   size_t out_y_stride = 0, out_cb_stride = 0, out_cr_stride = 0, out_a_stride = 0;
 
-  in_y = (const Pixel*) input->get_channel_memory(heif_channel_Y, &in_y_stride);
-  in_cb = (const Pixel*) input->get_channel_memory(heif_channel_Cb, &in_cb_stride);
-  in_cr = (const Pixel*) input->get_channel_memory(heif_channel_Cr, &in_cr_stride);
-  out_y = (Pixel*) outimg->get_channel_memory(heif_channel_Y, &out_y_stride);
-  out_cb = (Pixel*) outimg->get_channel_memory(heif_channel_Cb, &out_cb_stride);
-  out_cr = (Pixel*) outimg->get_channel_memory(heif_channel_Cr, &out_cr_stride);
+  const auto* in_y = (const Pixel*) input->get_channel_memory(heif_channel_Y, &in_y_stride);
+  const auto* in_cb = (const Pixel*) input->get_channel_memory(heif_channel_Cb, &in_cb_stride);
+  const auto* in_cr = (const Pixel*) input->get_channel_memory(heif_channel_Cr, &in_cr_stride);
+  auto* out_y = (Pixel*) outimg->get_channel_memory(heif_channel_Y, &out_y_stride);
+  auto* out_cb = (Pixel*) outimg->get_channel_memory(heif_channel_Cb, &out_cb_stride);
+  auto* out_cr = (Pixel*) outimg->get_channel_memory(heif_channel_Cr, &out_cr_stride);
 
-  const uint8_t* in_a;
-  uint8_t* out_a;
+  const uint8_t* in_a = nullptr;
+  uint8_t* out_a = nullptr;
 
   if (has_alpha) {
     in_a = input->get_channel_memory(heif_channel_Alpha, &in_a_stride);
     out_a = outimg->get_channel_memory(heif_channel_Alpha, &out_a_stride);
   }
-  else {
-    in_a = nullptr;
-    out_a = nullptr;
-  }
-
 
   if (hdr) {
     in_y_stride /= 2;
@@ -597,121 +578,42 @@ Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::convert_colorspace(const std::shared_pt
     out_cr_stride /= 2;
   }
 
-  /*
-   *  We assume that chroma pixels are located in the center of 2x2 luma pixels.
-   *  The image border 'b' is handled separately.
-   *  The right and bottom border are not processed when the size is odd.
-   *  Then, each 2x2 square between 4 chroma samples is computed in one iteration.
-   *
-   *  Upsampling weights are 3/4, 1/4. For example:
-   *    A = 3/4*3/4 * C1 + 3/4*1/4 * C2 + 1/4*3/4 * C3 + 1/4*1/4 * C4
-   *
-   *    +---+---+---+---+
-   *    | b | b | b | b |
-   *    +---C1--+---C2--+
-   *    | b | A |   | b |
-   *    +---+---+---+---+
-   *    | b |   |   | b |
-   *    +---C3--+---C4--+
-   *    | b | b | b | b |
-   *    +---+---+---+---+
-   */
-
-  // --- fill borders
-
-  // top left corner
-  out_cb[0] = in_cb[0];
-  out_cr[0] = in_cr[0];
-
-  // top border
-  for (uint32_t cx = 0; cx < (width - 1) / 2; cx++) {
-    out_cb[0 * out_cb_stride + 2 * cx + 1] = (Pixel) ((3 * in_cb[cx / 2] + 1 * in_cb[cx / 2 + 1] + 2) / 4);
-    out_cb[0 * out_cb_stride + 2 * cx + 2] = (Pixel) ((1 * in_cb[cx / 2] + 3 * in_cb[cx / 2 + 1] + 2) / 4);
-    out_cr[0 * out_cr_stride + 2 * cx + 1] = (Pixel) ((3 * in_cr[cx / 2] + 1 * in_cr[cx / 2 + 1] + 2) / 4);
-    out_cr[0 * out_cr_stride + 2 * cx + 2] = (Pixel) ((1 * in_cr[cx / 2] + 3 * in_cr[cx / 2 + 1] + 2) / 4);
-  }
-
-  // top right corner
-  if (width % 2 == 0) {
-    out_cb[width - 1] = in_cb[width / 2 - 1];
-    out_cr[width - 1] = in_cr[width / 2 - 1];
-  }
-
-  // left border
-  for (uint32_t cy = 0; cy < (height - 1) / 2; cy++) {
-    out_cb[(2 * cy + 1) * out_cb_stride + 0] = (Pixel) ((3 * in_cb[cy / 2 * in_cb_stride] + 1 * in_cb[(cy / 2 + 1) * in_cb_stride] + 2) / 4);
-    out_cb[(2 * cy + 2) * out_cb_stride + 0] = (Pixel) ((1 * in_cb[cy / 2 * in_cb_stride] + 3 * in_cb[(cy / 2 + 1) * in_cb_stride] + 2) / 4);
-    out_cr[(2 * cy + 1) * out_cr_stride + 0] = (Pixel) ((3 * in_cr[cy / 2 * in_cr_stride] + 1 * in_cr[(cy / 2 + 1) * in_cr_stride] + 2) / 4);
-    out_cr[(2 * cy + 2) * out_cr_stride + 0] = (Pixel) ((1 * in_cr[cy / 2 * in_cr_stride] + 3 * in_cr[(cy / 2 + 1) * in_cr_stride] + 2) / 4);
-  }
-
-  // bottom left corner
-  if (height % 2 == 0) {
-    out_cb[(height - 1) * out_cb_stride] = in_cb[(height / 2 - 1) * in_cb_stride];
-    out_cr[(height - 1) * out_cr_stride] = in_cr[(height / 2 - 1) * in_cr_stride];
-  }
-
-  // right border
-  if (width % 2 == 0) {
-    for (uint32_t cy = 0; cy < (height - 1) / 2; cy++) {
-      out_cb[(2 * cy + 1) * out_cb_stride + width - 1] = (Pixel) ((3 * in_cb[cy / 2 * in_cb_stride + width / 2 - 1] + 1 * in_cb[(cy / 2 + 1) * in_cb_stride + width / 2 - 1] + 2) / 4);
-      out_cb[(2 * cy + 2) * out_cb_stride + width - 1] = (Pixel) ((1 * in_cb[cy / 2 * in_cb_stride + width / 2 - 1] + 3 * in_cb[(cy / 2 + 1) * in_cb_stride + width / 2 - 1] + 2) / 4);
-      out_cr[(2 * cy + 1) * out_cr_stride + width - 1] = (Pixel) ((3 * in_cr[cy / 2 * in_cr_stride + width / 2 - 1] + 1 * in_cr[(cy / 2 + 1) * in_cr_stride + width / 2 - 1] + 2) / 4);
-      out_cr[(2 * cy + 2) * out_cr_stride + width - 1] = (Pixel) ((1 * in_cr[cy / 2 * in_cr_stride + width / 2 - 1] + 3 * in_cr[(cy / 2 + 1) * in_cr_stride + width / 2 - 1] + 2) / 4);
-    }
-  }
-
-  // bottom border
-  if (height % 2 == 0) {
-    for (uint32_t cx = 0; cx < (width - 1) / 2; cx++) {
-      out_cb[(height - 1) * out_cb_stride + 2 * cx + 1] = (Pixel) ((3 * in_cb[(height / 2 - 1) * in_cb_stride + cx / 2] + 1 * in_cb[(height / 2 - 1) * in_cb_stride + cx / 2 + 1] + 2) / 4);
-      out_cb[(height - 1) * out_cb_stride + 2 * cx + 2] = (Pixel) ((1 * in_cb[(height / 2 - 1) * in_cb_stride + cx / 2] + 3 * in_cb[(height / 2 - 1) * in_cb_stride + cx / 2 + 1] + 2) / 4);
-      out_cr[(height - 1) * out_cr_stride + 2 * cx + 1] = (Pixel) ((3 * in_cr[(height / 2 - 1) * in_cr_stride + cx / 2] + 1 * in_cr[(height / 2 - 1) * in_cr_stride + cx / 2 + 1] + 2) / 4);
-      out_cr[(height - 1) * out_cr_stride + 2 * cx + 2] = (Pixel) ((1 * in_cr[(height / 2 - 1) * in_cr_stride + cx / 2] + 3 * in_cr[(height / 2 - 1) * in_cr_stride + cx / 2 + 1] + 2) / 4);
-    }
-  }
-
-  // bottom right corner
-  if (width % 2 == 0 && height % 2 == 0) {
-    out_cb[(height - 1) * out_cb_stride + width - 1] = in_cb[(height / 2 - 1) * in_cb_stride + width / 2 - 1];
-    out_cr[(height - 1) * out_cr_stride + width - 1] = in_cr[(height / 2 - 1) * in_cr_stride + width / 2 - 1];
-  }
+  for (uint32_t y = first_row; y < end_row; y++) {
+    uint32_t cy0 = y;
+    uint32_t cy1 = y;
 
+    if (vertical_subsampling) {
+      // The closer chroma row is above the output row for odd rows and below it for even rows.
+      cy0 = y / 2;
 
-  // --- bilinear filtering of inner part
+      if (y % 2 == 0) {
+        cy1 = (cy0 > 0 ? cy0 - 1 : cy0);
+      }
+      else {
+        cy1 = std::min(cy0 + 1, chroma_height - 1);
+      }
+    }
 
-  uint32_t x, y;
-  for (y = 1; y < height - 1; y += 2) {
-    for (x = 1; x < width - 1; x += 2) {
-      uint32_t cx = x / 2;
-      uint32_t cy = y / 2;
-
-      Pixel cb00 = in_cb[cy * in_cb_stride + cx];
-      Pixel cr00 = in_cr[cy * in_cr_stride + cx];
-      Pixel cb01 = in_cb[cy * in_cb_stride + cx + 1];
-      Pixel cr01 = in_cr[cy * in_cr_stride + cx + 1];
-      Pixel cb10 = in_cb[(cy + 1) * in_cb_stride + cx];
-      Pixel cr10 = in_cr[(cy + 1) * in_cr_stride + cx];
-      Pixel cb11 = in_cb[(cy + 1) * in_cb_stride + cx + 1];
-      Pixel cr11 = in_cr[(cy + 1) * in_cr_stride + cx + 1];
-
-      out_cb[(y + 0) * out_cb_stride + x + 0] = (Pixel) ((cb00 * 3 * 3 + cb01 * 1 * 3 + cb10 * 3 * 1 + cb11 * 1 * 1 + 8) / 16);
-      out_cb[(y + 0) * out_cb_stride + x + 1] = (Pixel) ((cb00 * 1 * 3 + cb01 * 3 * 3 + cb10 * 1 * 1 + cb11 * 3 * 1 + 8) / 16);
-      out_cb[(y + 1) * out_cb_stride + x + 0] = (Pixel) ((cb00 * 3 * 1 + cb01 * 1 * 1 + cb10 * 3 * 3 + cb11 * 1 * 3 + 8) / 16);
-      out_cb[(y + 1) * out_cb_stride + x + 1] = (Pixel) ((cb00 * 1 * 1 + cb01 * 3 * 1 + cb10 * 1 * 3 + cb11 * 3 * 3 + 8) / 16);
-
-      out_cr[(y + 0) * out_cr_stride + x + 0] = (Pixel) ((cr00 * 3 * 3 + cr01 * 1 * 3 + cr10 * 3 * 1 + cr11 * 1 * 1 + 8) / 16);
-      out_cr[(y + 0) * out_cr_stride + x + 1] = (Pixel) ((cr00 * 1 * 3 + cr01 * 3 * 3 + cr10 * 1 * 1 + cr11 * 3 * 1 + 8) / 16);
-      out_cr[(y + 1) * out_cr_stride + x + 0] = (Pixel) ((cr00 * 3 * 1 + cr01 * 1 * 1 + cr10 * 3 * 3 + cr11 * 1 * 3 + 8) / 16);
-      out_cr[(y + 1) * out_cr_stride + x + 1] = (Pixel) ((cr00 * 1 * 1 + cr01 * 3 * 1 + cr10 * 1 * 3 + cr11 * 3 * 3 + 8) / 16);
+    if (hdr) {
+      kernels.upsample_chroma_bilinear_row_16((const uint16_t*) &in_cb[cy0 * in_cb_stride],
+                                              (const uint16_t*) &in_cb[cy1 * in_cb_stride],
+                                              (uint16_t*) &out_cb[y * out_cb_stride], width);
+      kernels.upsample_chroma_bilinear_row_16((const uint16_t*) &in_cr[cy0 * in_cr_stride],
+                                              (const uint16_t*) &in_cr[cy1 * in_cr_stride],
+                                              (uint16_t*) &out_cr[y * out_cr_stride], width);
+    }
+    else {
+      kernels.upsample_chroma_bilinear_row_8((const uint8_t*) &in_cb[cy0 * in_cb_stride],
+                                             (const uint8_t*) &in_cb[cy1 * in_cb_stride],
+                                             (uint8_t*) &out_cb[y * out_cb_stride], width);
+      kernels.upsample_chroma_bilinear_row_8((const uint8_t*) &in_cr[cy0 * in_cr_stride],
+                                             (const uint8_t*) &in_cr[cy1 * in_cr_stride],
+                                             (uint8_t*) &out_cr[y * out_cr_stride], width);
     }
-  }
 
-  // TODO: check whether we can use HeifPixelImage::transfer_channel_from_image_as() instead of copying Y and Alpha
+    // TODO: check whether we can use HeifPixelImage::transfer_channel_from_image_as() instead of copying Y and Alpha
 
-  for (y = 0; y < height; y++) {
     uint32_t copyWidth = (hdr ? width * 2 : width);
-
     memcpy(&out_y[y * out_y_stride], &in_y[y * in_y_stride], copyWidth);
 
     if (has_alpha) {
@@ -719,19 +621,12 @@ Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::convert_colorspace(const std::shared_pt
       memcpy(&out_a[y * out_a_stride], &in_a[y * in_a_stride], alphaCopyWidth);
     }
   }
-
-  return outimg;
 }
 
-template class Op_YCbCr420_bilinear_to_YCbCr444<uint8_t>;
-template class Op_YCbCr420_bilinear_to_YCbCr444<uint16_t>;
-
-
-
 
 template<class Pixel>
 std::vector<ColorStateWithCost>
-Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState& input_state,
+Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState& input_state,
                                                                 const ColorState& target_state,
                                                                 const heif_color_conversion_options& options,
                                                                 const heif_color_conversion_options_ext& options_ext) const
@@ -740,7 +635,7 @@ Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState
     return {};
   }
 
-  if (input_state.chroma != heif_chroma_422) {
+  if (input_state.chroma != heif_chroma_420) {
     return {};
   }
 
@@ -773,7 +668,7 @@ Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState
   output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
   output_state.nclx = input_state.nclx;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
@@ -781,173 +676,114 @@ Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState
 
 template<class Pixel>
 Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                                            const ColorState& input_state,
-                                                            const ColorState& target_state,
-                                                            const heif_color_conversion_options& options,
-                                                            const heif_color_conversion_options_ext& options_ext,
-                                                            const heif_security_limits* limits) const
+Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                             const ColorState& input_state,
+                                                             const ColorState& target_state,
+                                                             const heif_color_conversion_options& options,
+                                                             const heif_color_conversion_options_ext& options_ext,
+                                                             const heif_security_limits* limits) const
 {
-  bool hdr = !std::is_same<Pixel, uint8_t>::value;
-
-  int bpp_y = input->get_bits_per_pixel(heif_channel_Y);
-  int bpp_cb = input->get_bits_per_pixel(heif_channel_Cb);
-  int bpp_cr = input->get_bits_per_pixel(heif_channel_Cr);
-  int bpp_a = 0;
-
-  bool has_alpha = input->has_channel(heif_channel_Alpha);
+  return create_upsampled_output_image<Pixel>(input, limits);
+}
 
-  if (has_alpha) {
-    bpp_a = input->get_bits_per_pixel(heif_channel_Alpha);
-  }
-
-  if (!hdr) {
-    if (bpp_y > 8 ||
-        bpp_cb > 8 ||
-        bpp_cr > 8) {
-      return Error::InternalError;
-    }
-  }
-  else {
-    if (bpp_y <= 8 ||
-        bpp_cb <= 8 ||
-        bpp_cr <= 8) {
-      return Error::InternalError;
-    }
-  }
 
+template<class Pixel>
+Error
+Op_YCbCr420_bilinear_to_YCbCr444<Pixel>::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                                        const std::shared_ptr<HeifPixelImage>& output,
+                                                        const ColorState& input_state,
+                                                        const ColorState& target_state,
+                                                        const heif_color_conversion_options& options,
+                                                        const heif_color_conversion_options_ext& options_ext,
+                                                        uint32_t first_row, uint32_t end_row) const
+{
+  upsample_bilinear_stripe<Pixel>(*m_kernels, true, input, output, first_row, end_row);
 
-  if (bpp_y != bpp_cb ||
-      bpp_y != bpp_cr) {
-    // TODO: test with varying bit depths when we have a test image
-    return Error::InternalError;
-  }
+  return Error::Ok;
+}
 
+template class Op_YCbCr420_bilinear_to_YCbCr444<uint8_t>;
+template class Op_YCbCr420_bilinear_to_YCbCr444<uint16_t>;
 
-  uint32_t width = input->get_width();
-  uint32_t height = input->get_height();
 
-  auto outimg = std::make_shared<HeifPixelImage>();
 
-  outimg->create(width, height, heif_colorspace_YCbCr, heif_chroma_444);
 
-  if (auto err = outimg->add_channel(heif_channel_Y, width, height, bpp_y, limits) ||
-                 outimg->add_channel(heif_channel_Cb, width, height, bpp_cb, limits) ||
-                 outimg->add_channel(heif_channel_Cr, width, height, bpp_cr, limits)) {
-    return err;
+template<class Pixel>
+std::vector<ColorStateWithCost>
+Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::state_after_conversion(const ColorState& input_state,
+                                                                const ColorState& target_state,
+                                                                const heif_color_conversion_options& options,
+                                                                const heif_color_conversion_options_ext& options_ext) const
+{
+  if (input_state.colorspace != heif_colorspace_YCbCr) {
+    return {};
   }
 
-  if (has_alpha) {
-    if (auto err = outimg->add_channel(heif_channel_Alpha, width, height, bpp_a, limits)) {
-      return err;
-    }
+  if (input_state.chroma != heif_chroma_422) {
+    return {};
   }
 
-  const Pixel* in_y, * in_cb, * in_cr;
-  size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0, in_a_stride = 0;
-
-  Pixel* out_y, * out_cb, * out_cr;
-  size_t out_y_stride = 0, out_cb_stride = 0, out_cr_stride = 0, out_a_stride = 0;
-
-  in_y = (const Pixel*) input->get_channel_memory(heif_channel_Y, &in_y_stride);
-  in_cb = (const Pixel*) input->get_channel_memory(heif_channel_Cb, &in_cb_stride);
-  in_cr = (const Pixel*) input->get_channel_memory(heif_channel_Cr, &in_cr_stride);
-  out_y = (Pixel*) outimg->get_channel_memory(heif_channel_Y, &out_y_stride);
-  out_cb = (Pixel*) outimg->get_channel_memory(heif_channel_Cb, &out_cb_stride);
-  out_cr = (Pixel*) outimg->get_channel_memory(heif_channel_Cr, &out_cr_stride);
-
-  const uint8_t* in_a;
-  uint8_t* out_a;
+  // this Op only implements the bilinear algorithm
 
-  if (has_alpha) {
-    in_a = input->get_channel_memory(heif_channel_Alpha, &in_a_stride);
-    out_a = outimg->get_channel_memory(heif_channel_Alpha, &out_a_stride);
-  }
-  else {
-    in_a = nullptr;
-    out_a = nullptr;
+  if (options.preferred_chroma_upsampling_algorithm != heif_chroma_upsampling_bilinear) {
+    return {};
   }
 
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
 
-  if (hdr) {
-    in_y_stride /= 2;
-    in_cb_stride /= 2;
-    in_cr_stride /= 2;
-    out_y_stride /= 2;
-    out_cb_stride /= 2;
-    out_cr_stride /= 2;
+  if ((input_state.bits_per_pixel > 8) != hdr) {
+    return {};
   }
 
-  /*
-   *  We assume that chroma pixels are located in the center of 2x1 luma pixels.
-   *  The image border 'b' is handled separately.
-   *  The right border is not processed when the size is odd.
-   *
-   *  Upsampling weights are 3/4, 1/4. For example:
-   *    A = 3/4 * X + 1/4 * Y
-   *
-   *  X,Y,Z are the chroma samples
-   *
-   *    +---+---+---+---+
-   *    | b X A | B Y b |    even image width
-   *    +---+---+---+---+
-   *
-   *    +---+---+---+---+---+
-   *    | b X A | B Y b | b Z    odd image width
-   *    +---+---+---+---+---+
-   */
-
-  // --- fill borders
-
-  // left border
-  for (uint32_t cy = 0; cy < height; cy++) {
-    out_cb[cy * out_cb_stride] = in_cb[cy * in_cb_stride];
-    out_cr[cy * out_cr_stride] = in_cr[cy * in_cr_stride];
-  }
-
-  // right border
-  if (width % 2 == 0) {
-    for (uint32_t cy = 0; cy < height; cy++) {
-      out_cb[cy * out_cb_stride + width - 1] = in_cb[cy * in_cb_stride + width / 2 - 1];
-      out_cr[cy * out_cr_stride + width - 1] = in_cr[cy * in_cr_stride + width / 2 - 1];
-    }
+  if (input_state.nclx.get_matrix_coefficients() == 0) {
+    return {};
   }
 
+  std::vector<ColorStateWithCost> states;
 
-  // --- bilinear filtering of inner part
+  ColorState output_state;
 
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
-    for (x = 1; x < width - 1; x += 2) {
-      int cx = x / 2;
+  // --- convert to 4:4:4
 
-      Pixel cb00 = in_cb[y * in_cb_stride + cx];
-      Pixel cr00 = in_cr[y * in_cr_stride + cx];
-      Pixel cb01 = in_cb[y * in_cb_stride + cx + 1];
-      Pixel cr01 = in_cr[y * in_cr_stride + cx + 1];
+  output_state.colorspace = heif_colorspace_YCbCr;
+  output_state.chroma = heif_chroma_444;
+  output_state.has_alpha = input_state.has_alpha;  // we simply keep the old alpha plane
+  output_state.bits_per_pixel = input_state.bits_per_pixel;
+  output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
+  output_state.nclx = input_state.nclx;
 
-      out_cb[y * out_cb_stride + x + 0] = (Pixel) ((cb00 * 3 + cb01 * 1 + 2) / 4);
-      out_cb[y * out_cb_stride + x + 1] = (Pixel) ((cb00 * 1 + cb01 * 3 + 2) / 4);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
-      out_cr[y * out_cr_stride + x + 0] = (Pixel) ((cr00 * 3 + cr01 * 1 + 2) / 4);
-      out_cr[y * out_cr_stride + x + 1] = (Pixel) ((cr00 * 1 + cr01 * 3 + 2) / 4);
-    }
-  }
+  return states;
+}
 
-  // TODO: check whether we can use HeifPixelImage::transfer_channel_from_image_as() instead of copying Y and Alpha
 
-  for (y = 0; y < height; y++) {
-    uint32_t copyWidth = (hdr ? width * 2 : width);
+template<class Pixel>
+Result<std::shared_ptr<HeifPixelImage>>
+Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                             const ColorState& input_state,
+                                                             const ColorState& target_state,
+                                                             const heif_color_conversion_options& options,
+                                                             const heif_color_conversion_options_ext& options_ext,
+                                                             const heif_security_limits* limits) const
+{
+  return create_upsampled_output_image<Pixel>(input, limits);
+}
 
-    memcpy(&out_y[y * out_y_stride], &in_y[y * in_y_stride], copyWidth);
 
-    if (has_alpha) {
-      uint32_t alphaCopyWidth = (bpp_a > 8 ? width * 2 : width);
-      memcpy(&out_a[y * out_a_stride], &in_a[y * in_a_stride], alphaCopyWidth);
-    }
-  }
+template<class Pixel>
+Error
+Op_YCbCr422_bilinear_to_YCbCr444<Pixel>::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                                        const std::shared_ptr<HeifPixelImage>& output,
+                                                        const ColorState& input_state,
+                                                        const ColorState& target_state,
+                                                        const heif_color_conversion_options& options,
+                                                        const heif_color_conversion_options_ext& options_ext,
+                                                        uint32_t first_row, uint32_t end_row) const
+{
+  upsample_bilinear_stripe<Pixel>(*m_kernels, false, input, output, first_row, end_row);
 
-  return outimg;
+  return Error::Ok;
 }
 
 template class Op_YCbCr422_bilinear_to_YCbCr444<uint8_t>;
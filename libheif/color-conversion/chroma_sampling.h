@@ -22,6 +22,8 @@
 #define LIBHEIF_CHROMA_SAMPLING_H
 
 #include "color-conversion/colorconversion.h"
+#include "color-conversion/rgb2yuv_kernels.h"
+#include "color-conversion/yuv2rgb_kernels.h"
 #include <memory>
 #include <vector>
 
@@ -32,6 +34,9 @@ template <class Pixel>
 class Op_YCbCr444_to_YCbCr420_average : public ColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_YCbCr444_to_YCbCr420_average(const RGB_to_YCbCr_kernels& kernels = get_scalar_RGB_to_YCbCr_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -45,6 +50,9 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+private:
+  const RGB_to_YCbCr_kernels* m_kernels;
 };
 
 
@@ -71,9 +79,11 @@ public:
 // --- upsampling ---
 
 template <class Pixel>
-class Op_YCbCr420_bilinear_to_YCbCr444 : public ColorConversionOperation
+class Op_YCbCr420_bilinear_to_YCbCr444 : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr420_bilinear_to_YCbCr444(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -81,18 +91,35 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+  // The chroma rows are interpolated vertically.
+  bool needs_neighboring_rows(const ColorState& input_state) const override { return true; }
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 template <class Pixel>
-class Op_YCbCr422_bilinear_to_YCbCr444 : public ColorConversionOperation
+class Op_YCbCr422_bilinear_to_YCbCr444 : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr422_bilinear_to_YCbCr444(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -100,12 +127,24 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 #endif //LIBHEIF_CHROMA_SAMPLING_H
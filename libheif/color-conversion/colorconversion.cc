@@ -40,10 +40,14 @@
 #include "hdr_sdr.h"
 #include "chroma_sampling.h"
 #include "bayer_bilinear.h"
+#include "parallel.h"
+
+#include <atomic>
 
 #if ENABLE_MULTITHREADING_SUPPORT
 
 #include <mutex>
+#include <shared_mutex>
 
 #endif
 
@@ -159,11 +163,17 @@ bool ColorState::operator==(const ColorState& b) const
   }
 
   if (has_alpha && b.has_alpha) {
-    if (get_alpha_bits_per_pixel() != b.get_alpha_bits_per_pixel()) {
+    if (get_alpha_bits_per_pixel() != b.get_alpha_bits_per_pixel() ||
+        premultiplied_alpha != b.premultiplied_alpha) {
       return false;
     }
   }
 
+  if (transfer_characteristics != b.transfer_characteristics ||
+      colour_primaries != b.colour_primaries) {
+    return false;
+  }
+
   if (colorspace == heif_colorspace_YCbCr) {
     bool ycbcr_parameters_match = nclx.equal_except_transfer_curve(b.nclx);
 
@@ -210,6 +220,16 @@ std::ostream& operator<<(std::ostream& ostr, const ColorState& state)
     ostr << " alpha_bpp=" << state.get_alpha_bits_per_pixel();
   }
 
+  if (state.has_alpha && state.premultiplied_alpha) {
+    ostr << " premultiplied";
+  }
+
+  if (state.transfer_characteristics != heif_transfer_characteristic_unspecified ||
+      state.colour_primaries != heif_color_primaries_unspecified) {
+    ostr << " pixel-transfer-characteristics=" << state.transfer_characteristics
+         << " pixel-colour-primaries=" << state.colour_primaries;
+  }
+
   if (state.colorspace == heif_colorspace_YCbCr) {
     ostr << " matrix-coefficients=" << state.nclx.get_matrix_coefficients()
          << " colour-primaries=" << state.nclx.get_colour_primaries()
@@ -221,9 +241,32 @@ std::ostream& operator<<(std::ostream& ostr, const ColorState& state)
 }
 
 std::vector<std::shared_ptr<ColorConversionOperation>> ColorConversionPipeline::m_operation_pool;
+std::vector<std::string> ColorConversionPipeline::m_operation_ids;
+
+// The operation pool is not modified after it has been initialized (until release_ops()).
+// Hence, it can be read without locking once this flag is set.
+static std::atomic<bool> sOperationPoolInitialized{false};
+
+std::vector<ColorConversionPipeline::CachedPipeline> ColorConversionPipeline::m_pipeline_cache;
+uint64_t ColorConversionPipeline::m_pipeline_cache_generation = 0;
+
+static constexpr size_t max_cached_pipelines = 32;
+
+#if ENABLE_MULTITHREADING_SUPPORT
+static std::shared_mutex& get_pipeline_cache_mutex()
+{
+  static std::shared_mutex sMutex;
+  return sMutex;
+}
+#endif
+
 
 void ColorConversionPipeline::init_ops()
 {
+  if (sOperationPoolInitialized.load(std::memory_order_acquire)) {
+    return;
+  }
+
 #if ENABLE_MULTITHREADING_SUPPORT
   static std::mutex init_ops_mutex;
   std::lock_guard<std::mutex> lock(init_ops_mutex);
@@ -237,6 +280,8 @@ void ColorConversionPipeline::init_ops()
   ops.emplace_back(std::make_shared<Op_RGB24_32_to_RGB>());
   ops.emplace_back(std::make_shared<Op_YCbCr_to_RGB<uint16_t>>());
   ops.emplace_back(std::make_shared<Op_YCbCr_to_RGB<uint8_t>>());
+  ops.emplace_back(std::make_shared<Op_YCbCr_bilinear_to_RGB<uint16_t>>());
+  ops.emplace_back(std::make_shared<Op_YCbCr_bilinear_to_RGB<uint8_t>>());
   ops.emplace_back(std::make_shared<Op_YCbCr420_to_RGB24>());
   ops.emplace_back(std::make_shared<Op_YCbCr420_to_RGB32>());
   ops.emplace_back(std::make_shared<Op_YCbCr420_to_RRGGBBaa>());
@@ -256,8 +301,11 @@ void ColorConversionPipeline::init_ops()
   ops.emplace_back(std::make_shared<Op_flatten_alpha_plane<uint8_t>>());
   ops.emplace_back(std::make_shared<Op_flatten_alpha_plane<uint16_t>>());
   ops.emplace_back(std::make_shared<Op_adjust_alpha_bit_depth>());
+  ops.emplace_back(std::make_shared<Op_premultiply_alpha>());
+  ops.emplace_back(std::make_shared<Op_unpremultiply_alpha>());
   ops.emplace_back(std::make_shared<Op_to_hdr_planes>());
   ops.emplace_back(std::make_shared<Op_to_sdr_planes>());
+  ops.emplace_back(std::make_shared<Op_convert_transfer_and_primaries>());
   ops.emplace_back(std::make_shared<Op_YCbCr420_bilinear_to_YCbCr444<uint8_t>>());
   ops.emplace_back(std::make_shared<Op_YCbCr420_bilinear_to_YCbCr444<uint16_t>>());
   ops.emplace_back(std::make_shared<Op_YCbCr422_bilinear_to_YCbCr444<uint8_t>>());
@@ -267,12 +315,112 @@ void ColorConversionPipeline::init_ops()
   ops.emplace_back(std::make_shared<Op_YCbCr444_to_YCbCr422_average<uint8_t>>());
   ops.emplace_back(std::make_shared<Op_YCbCr444_to_YCbCr422_average<uint16_t>>());
   ops.emplace_back(std::make_shared<Op_Any_RGB_to_YCbCr_420_Sharp>());
+
+  // Vectorized variants of the ops above. They are preferred because of their lower costs.
+
+  if (const YCbCr_to_RGB_kernels* kernels = get_simd_YCbCr_to_RGB_kernels()) {
+    ops.emplace_back(std::make_shared<Op_YCbCr_to_RGB<uint16_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr_to_RGB<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr_bilinear_to_RGB<uint16_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr_bilinear_to_RGB<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr420_bilinear_to_YCbCr444<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr420_bilinear_to_YCbCr444<uint16_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr422_bilinear_to_YCbCr444<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr422_bilinear_to_YCbCr444<uint16_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr420_to_RGB24>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr420_to_RGB32>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr420_to_RRGGBBaa>(*kernels));
+  }
+
+  if (const RGB_to_YCbCr_kernels* kernels = get_simd_RGB_to_YCbCr_kernels()) {
+    ops.emplace_back(std::make_shared<Op_RGB24_32_to_YCbCr>(*kernels));
+    ops.emplace_back(std::make_shared<Op_RGB_to_YCbCr<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_RGB_to_YCbCr<uint16_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr444_to_YCbCr420_average<uint8_t>>(*kernels));
+    ops.emplace_back(std::make_shared<Op_YCbCr444_to_YCbCr420_average<uint16_t>>(*kernels));
+  }
+
+  if (const Alpha_premultiplication_kernels* kernels = get_simd_Alpha_premultiplication_kernels()) {
+    ops.emplace_back(std::make_shared<Op_premultiply_alpha>(*kernels));
+    ops.emplace_back(std::make_shared<Op_unpremultiply_alpha>(*kernels));
+  }
+
+  if (const Bayer_demosaic_kernels* kernels = get_simd_Bayer_demosaic_kernels()) {
+    ops.emplace_back(std::make_shared<Op_bayer_bilinear_to_RGB24_32>(*kernels));
+  }
+
+  if (const Interleaving_kernels* kernels = get_simd_Interleaving_kernels()) {
+    ops.emplace_back(std::make_shared<Op_mono_to_RGB24_32>(*kernels));
+    ops.emplace_back(std::make_shared<Op_RGB_HDR_to_RRGGBBaa_BE>(*kernels));
+    ops.emplace_back(std::make_shared<Op_RGB_to_RRGGBBaa_BE>(*kernels));
+  }
+
+  m_operation_ids.clear();
+  for (size_t i = 0; i < ops.size(); i++) {
+    int instance = 0;
+    for (size_t k = 0; k < i; k++) {
+      if (typeid(*ops[k]) == typeid(*ops[i])) {
+        instance++;
+      }
+    }
+
+    m_operation_ids.push_back(std::string(typeid(*ops[i]).name()) + "#" + std::to_string(instance));
+  }
+
+  sOperationPoolInitialized.store(true, std::memory_order_release);
 }
 
 
 void ColorConversionPipeline::release_ops()
 {
+  sOperationPoolInitialized.store(false, std::memory_order_release);
+
+  set_cost_calibration(nullptr);
+
   m_operation_pool.clear();
+  m_operation_ids.clear();
+}
+
+
+void ColorConversionPipeline::clear_pipeline_cache()
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  std::unique_lock<std::shared_mutex> lock(get_pipeline_cache_mutex());
+#endif
+  m_pipeline_cache.clear();
+  m_pipeline_cache_generation++;
+}
+
+
+const std::vector<std::shared_ptr<ColorConversionOperation>>& ColorConversionPipeline::get_operations()
+{
+  init_ops();
+
+  return m_operation_pool;
+}
+
+
+static bool options_match(const heif_color_conversion_options& a, const heif_color_conversion_options& b)
+{
+  return (a.preferred_chroma_downsampling_algorithm == b.preferred_chroma_downsampling_algorithm &&
+          a.preferred_chroma_upsampling_algorithm == b.preferred_chroma_upsampling_algorithm &&
+          a.only_use_preferred_chroma_algorithm == b.only_use_preferred_chroma_algorithm);
+}
+
+
+static bool options_match(const heif_color_conversion_options_ext& a, const heif_color_conversion_options_ext& b)
+{
+  return (a.alpha_composition_mode == b.alpha_composition_mode &&
+          a.background_red == b.background_red &&
+          a.background_green == b.background_green &&
+          a.background_blue == b.background_blue &&
+          a.secondary_background_red == b.secondary_background_red &&
+          a.secondary_background_green == b.secondary_background_green &&
+          a.secondary_background_blue == b.secondary_background_blue &&
+          a.checkerboard_square_size == b.checkerboard_square_size &&
+          a.use_float_arithmetic == b.use_float_arithmetic &&
+          a.alpha_premultiplication == b.alpha_premultiplication &&
+          a.convert_transfer_and_primaries == b.convert_transfer_and_primaries);
 }
 
 
@@ -290,15 +438,87 @@ bool ColorConversionPipeline::construct_pipeline(const ColorState& input_state,
     return true;
   }
 
+  init_ops(); // to be sure these are initialized even without heif_init()
+
+  // --- look up the pipeline in the cache
+
+  uint64_t generation;
+
+  {
+#if ENABLE_MULTITHREADING_SUPPORT
+    std::shared_lock<std::shared_mutex> lock(get_pipeline_cache_mutex());
+#endif
+
+    if (const CachedPipeline* cached = find_cached_pipeline(input_state, target_state, options, options_ext)) {
+      m_conversion_steps = cached->conversion_steps;
+      return cached->success;
+    }
+
+    generation = m_pipeline_cache_generation;
+  }
+
+  // The search is done without holding the lock. The result is not cached when the costs changed in the meantime
+  // or when another thread added the same pipeline.
+
+  bool success = search_pipeline(input_state, target_state, options, options_ext);
+
+  {
+#if ENABLE_MULTITHREADING_SUPPORT
+    std::unique_lock<std::shared_mutex> lock(get_pipeline_cache_mutex());
+#endif
+
+    if (generation == m_pipeline_cache_generation &&
+        !find_cached_pipeline(input_state, target_state, options, options_ext)) {
+      if (m_pipeline_cache.size() >= max_cached_pipelines) {
+        m_pipeline_cache.erase(m_pipeline_cache.begin());
+      }
+
+      m_pipeline_cache.push_back({input_state, target_state, options, options_ext, success, m_conversion_steps});
+    }
+  }
+
+  return success;
+}
+
+
+const ColorConversionPipeline::CachedPipeline*
+ColorConversionPipeline::find_cached_pipeline(const ColorState& input_state,
+                                              const ColorState& target_state,
+                                              const heif_color_conversion_options& options,
+                                              const heif_color_conversion_options_ext& options_ext)
+{
+  // ColorState::operator== does not compare the nclx profiles, but the planned steps carry them
+  // and the operations write them into the output images.
+
+  for (const auto& cached : m_pipeline_cache) {
+    if (cached.input_state == input_state &&
+        cached.target_state == target_state &&
+        cached.input_state.nclx == input_state.nclx &&
+        cached.target_state.nclx == target_state.nclx &&
+        options_match(cached.options, options) &&
+        options_match(cached.options_ext, options_ext)) {
+      return &cached;
+    }
+  }
+
+  return nullptr;
+}
+
+
+bool ColorConversionPipeline::search_pipeline(const ColorState& input_state,
+                                              const ColorState& target_state,
+                                              const heif_color_conversion_options& options,
+                                              const heif_color_conversion_options_ext& options_ext)
+{
 #if DEBUG_ME
   std::cerr << "--- construct_pipeline\n";
   std::cerr << "from: " << input_state << "\nto: " << target_state << "\n";
 #endif
 
-  init_ops(); // to be sure these are initialized even without heif_init()
-
   std::vector<std::shared_ptr<ColorConversionOperation>>& ops = m_operation_pool;
 
+  auto calibration = get_cost_calibration();
+
   // --- Dijkstra search for the minimum-cost conversion pipeline
 
   std::vector<Node> processed_states;
@@ -371,7 +591,8 @@ bool ColorConversionPipeline::construct_pipeline(const ColorState& input_state,
 
     // expand the node with minimum cost
 
-    for (const auto& op_ptr : ops) {
+    for (size_t op_idx = 0; op_idx < ops.size(); op_idx++) {
+      const auto& op_ptr = ops[op_idx];
 
 #if DEBUG_PIPELINE_CREATION
       auto& op = *op_ptr;
@@ -381,7 +602,24 @@ bool ColorConversionPipeline::construct_pipeline(const ColorState& input_state,
       auto out_states = op_ptr->state_after_conversion(processed_states.back().output_state,
                                                        target_state,
                                                        options, options_ext);
-      for (const auto& out_state : out_states) {
+      for (auto& out_state : out_states) {
+        if (!op_ptr->changes_alpha_premultiplication()) {
+          out_state.color_state.premultiplied_alpha = (processed_states.back().output_state.premultiplied_alpha &&
+                                                       out_state.color_state.has_alpha);
+        }
+
+        if (!op_ptr->changes_transfer_and_primaries()) {
+          out_state.color_state.transfer_characteristics = processed_states.back().output_state.transfer_characteristics;
+          out_state.color_state.colour_primaries = processed_states.back().output_state.colour_primaries;
+        }
+
+        if (calibration) {
+          out_state.speed_costs = calibration->get_costs(m_operation_ids[op_idx],
+                                                         processed_states.back().output_state,
+                                                         out_state.color_state,
+                                                         out_state.speed_costs);
+        }
+
         int new_op_costs = out_state.speed_costs + processed_states.back().speed_costs;
 #if DEBUG_PIPELINE_CREATION
         std::cerr << "--- " << out_state.color_state << " with cost " << new_op_costs << "\n";
@@ -447,20 +685,405 @@ std::string ColorConversionPipeline::debug_dump_pipeline() const
 }
 
 
-Result<std::shared_ptr<HeifPixelImage>> ColorConversionPipeline::convert_image(const std::shared_ptr<HeifPixelImage>& input,
-                                                                               const heif_security_limits* limits)
+Result<std::shared_ptr<HeifPixelImage>>
+StripedColorConversionOperation::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
+                                                    const ColorState& input_state,
+                                                    const ColorState& target_state,
+                                                    const heif_color_conversion_options& options,
+                                                    const heif_color_conversion_options_ext& options_ext,
+                                                    const heif_security_limits* limits) const
 {
-  std::shared_ptr<HeifPixelImage> in = input;
-  std::shared_ptr<HeifPixelImage> out = in;
+  auto outResult = create_output_image(input, input_state, target_state, options, options_ext, limits);
+  if (!outResult) {
+    return outResult.error();
+  }
+
+  if (Error err = convert_stripe(input, *outResult, input_state, target_state, options, options_ext,
+                                 0, input->get_height())) {
+    return err;
+  }
+
+  return *outResult;
+}
+
+
+// Smaller images are not split into stripes because the threading overhead would outweigh the gain.
+static constexpr uint32_t min_rows_per_stripe = 64;
+
+
+static Error color_conversion_canceled_error()
+{
+  return Error{heif_error_Canceled, heif_suberror_Unspecified, "Color conversion was canceled"};
+}
+
+
+// The cancel callback is only called on the calling thread. The worker threads see the result of its last call.
+static bool poll_canceled(CancelPoller* cancel_poller)
+{
+  return cancel_poller && cancel_poller->is_canceled();
+}
+
+static Result<std::shared_ptr<HeifPixelImage>> convert_in_stripes(const StripedColorConversionOperation& op,
+                                                                  const std::shared_ptr<const HeifPixelImage>& input,
+                                                                  const ColorState& input_state,
+                                                                  const ColorState& target_state,
+                                                                  const heif_color_conversion_options& options,
+                                                                  const heif_color_conversion_options_ext& options_ext,
+                                                                  const heif_security_limits* limits,
+                                                                  uint32_t num_stripes,
+                                                                  int num_threads,
+                                                                  CancelPoller* cancel_poller,
+                                                                  std::vector<ExternalPlaneBuffer>* output_buffers)
+{
+  uint32_t height = input->get_height();
+
+  // round up to even rows
+  uint32_t rows_per_stripe = ((height + num_stripes - 1) / num_stripes + 1) & ~1U;
+  num_stripes = (height + rows_per_stripe - 1) / rows_per_stripe;
+
+  Result<std::shared_ptr<HeifPixelImage>> outResult;
+  {
+    ScopedExternalPlaneBuffers external_buffers(output_buffers);
+    outResult = op.create_output_image(input, input_state, target_state, options, options_ext, limits);
+  }
+
+  if (!outResult) {
+    return outResult.error();
+  }
+
+  std::vector<Error> errors(num_stripes);
+
+  parallel_for(num_stripes, num_threads, [&](uint32_t stripe) {
+    if (poll_canceled(cancel_poller)) {
+      errors[stripe] = color_conversion_canceled_error();
+      return;
+    }
+
+    uint32_t first_row = stripe * rows_per_stripe;
+    uint32_t end_row = std::min(first_row + rows_per_stripe, height);
+
+    errors[stripe] = op.convert_stripe(input, *outResult, input_state, target_state, options, options_ext,
+                                       first_row, end_row);
+  }, [cancel_poller]() { poll_canceled(cancel_poller); });
+
+  for (const Error& err : errors) {
+    if (err) {
+      return err;
+    }
+  }
+
+  return *outResult;
+}
 
-  for (const auto& step : m_conversion_steps) {
+
+// Fused operations are executed on strips of this size (summed over all images of the fused steps),
+// so that the intermediate rows are still in the cache when the next operation reads them.
+static constexpr size_t fused_strip_target_bytes = 256 * 1024;
+
+
+// Creates an image that shares the rows [first_row, first_row + num_rows) of the planes of 'image'.
+// 'first_row' has to be even. Returns nullptr when the planes cannot be represented as a row view.
+static std::shared_ptr<HeifPixelImage> create_row_view(const std::shared_ptr<const HeifPixelImage>& image,
+                                                       uint32_t first_row, uint32_t num_rows)
+{
+  heif_chroma chroma = image->get_chroma_format();
+  std::set<heif_channel> channels = image->get_channel_set();
+
+  std::vector<ExternalPlaneBuffer> buffers;
+
+  for (heif_channel channel : channels) {
+    if (image->get_height(channel) != channel_height(image->get_height(), chroma, channel)) {
+      return nullptr;
+    }
+
+    uint32_t plane_first_row = channel_height(first_row, chroma, channel);
+    uint32_t plane_rows = channel_height(num_rows, chroma, channel);
+
+    size_t stride;
+    const uint8_t* data = image->get_channel_memory(channel, &stride);
+
+    ExternalPlaneBuffer buffer;
+    buffer.channel = channel;
+    buffer.data = const_cast<uint8_t*>(data) + plane_first_row * stride;
+    buffer.stride = stride;
+    buffer.size = plane_rows * stride;
+    buffers.push_back(buffer);
+  }
+
+  auto view = std::make_shared<HeifPixelImage>();
+  view->create(image->get_width(), num_rows, image->get_colorspace(), chroma);
+
+  {
+    ScopedExternalPlaneBuffers external_buffers(&buffers);
+
+    for (heif_channel channel : channels) {
+      if (view->add_channel(channel, image->get_width(channel), channel_height(num_rows, chroma, channel),
+                            image->get_bits_per_pixel(channel), nullptr, image->get_datatype(channel))) {
+        return nullptr;
+      }
+    }
+  }
+
+  for (const auto& buffer : buffers) {
+    if (!buffer.used) {
+      return nullptr;
+    }
+  }
+
+  if (image->has_nclx_color_profile()) {
+    view->set_color_profile_nclx(image->get_color_profile_nclx());
+  }
+
+  return view;
+}
+
+
+static size_t get_row_size_in_bytes(const std::shared_ptr<const HeifPixelImage>& image)
+{
+  size_t size = 0;
+  for (heif_channel channel : image->get_channel_set()) {
+    size += static_cast<size_t>(image->get_width(channel)) * image->get_storage_bits_per_pixel(channel) / 8;
+  }
+
+  return size;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage>>
+ColorConversionPipeline::convert_fused_steps(size_t first_step, size_t end_step,
+                                             const std::shared_ptr<HeifPixelImage>& input,
+                                             const heif_security_limits* limits,
+                                             std::vector<ExternalPlaneBuffer>* output_buffers,
+                                             int num_threads,
+                                             CancelPoller* cancel_poller) const
+{
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+
+  auto get_op = [this](size_t i) {
+    return static_cast<const StripedColorConversionOperation*>(m_conversion_steps[i].operation.get());
+  };
+
+  // --- run the output image allocation of all steps on two rows to get the layout of the images
+
+  std::shared_ptr<HeifPixelImage> probe = create_row_view(input, 0, std::min(height, 2U));
+  if (!probe) {
+    return std::shared_ptr<HeifPixelImage>();
+  }
+
+  size_t row_size = get_row_size_in_bytes(probe);
+
+  for (size_t i = first_step; i < end_step; i++) {
+    const auto& step = m_conversion_steps[i];
+    auto probeResult = get_op(i)->create_output_image(probe, step.input_state, step.output_state, m_options, m_options_ext, limits);
+    if (!probeResult) {
+      return probeResult.error();
+    }
+
+    probe = *probeResult;
+    probe->set_color_profile_nclx(step.output_state.nclx);
+    row_size += get_row_size_in_bytes(probe);
+  }
+
+  uint32_t rows_per_strip = static_cast<uint32_t>(std::min(fused_strip_target_bytes / std::max(row_size, size_t{1}),
+                                                           size_t{height}));
+  rows_per_strip = std::max(rows_per_strip & ~1U, std::min(height, 2U));
+
+  uint32_t num_strips = (height + rows_per_strip - 1) / rows_per_strip;
+
+  // --- only the final image is allocated in full size
+
+  auto output = std::make_shared<HeifPixelImage>();
+  {
+    ScopedExternalPlaneBuffers external_buffers(output_buffers);
+
+    if (auto err = output->create_clone_image_at_new_size(probe, width, height, limits)) {
+      return err;
+    }
+  }
+
+  // --- convert the strips. Each thread allocates its own intermediate images and reuses them for all of its strips.
+
+  uint32_t num_jobs = std::min(static_cast<uint32_t>(std::max(num_threads, 1)), num_strips);
+  std::vector<Error> errors(num_jobs);
+
+  parallel_for(num_jobs, num_threads, [&](uint32_t job) {
+    std::vector<std::shared_ptr<HeifPixelImage>> intermediates;
+
+    std::shared_ptr<HeifPixelImage> img = create_row_view(input, 0, rows_per_strip);
+    if (!img) {
+      errors[job] = Error::InternalError;
+      return;
+    }
+
+    for (size_t i = first_step; i + 1 < end_step; i++) {
+      const auto& step = m_conversion_steps[i];
+      auto imgResult = get_op(i)->create_output_image(img, step.input_state, step.output_state, m_options, m_options_ext, limits);
+      if (!imgResult) {
+        errors[job] = imgResult.error();
+        return;
+      }
+
+      img = *imgResult;
+      img->set_color_profile_nclx(step.output_state.nclx);
+      intermediates.push_back(img);
+    }
+
+    uint32_t first_strip = job * num_strips / num_jobs;
+    uint32_t end_strip = (job + 1) * num_strips / num_jobs;
+
+    for (uint32_t strip = first_strip; strip < end_strip; strip++) {
+      if (poll_canceled(cancel_poller)) {
+        errors[job] = color_conversion_canceled_error();
+        return;
+      }
+
+      uint32_t first_row = strip * rows_per_strip;
+      uint32_t num_rows = std::min(rows_per_strip, height - first_row);
+
+      std::shared_ptr<HeifPixelImage> in_view = create_row_view(input, first_row, num_rows);
+
+      for (size_t i = first_step; i < end_step; i++) {
+        const auto& step = m_conversion_steps[i];
+
+        std::shared_ptr<HeifPixelImage> out_view;
+        if (i + 1 == end_step) {
+          out_view = create_row_view(output, first_row, num_rows);
+        }
+        else {
+          out_view = create_row_view(intermediates[i - first_step], 0, num_rows);
+        }
+
+        if (!in_view || !out_view) {
+          errors[job] = Error::InternalError;
+          return;
+        }
+
+        if (auto err = get_op(i)->convert_stripe(in_view, out_view, step.input_state, step.output_state,
+                                                 m_options, m_options_ext, 0, num_rows)) {
+          errors[job] = err;
+          return;
+        }
+
+        in_view = out_view;
+      }
+    }
+  }, [cancel_poller]() { poll_canceled(cancel_poller); });
+
+  for (const Error& err : errors) {
+    if (err) {
+      return err;
+    }
+  }
+
+  return output;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage>> ColorConversionPipeline::convert_image(std::shared_ptr<HeifPixelImage> input,
+                                                                               const heif_security_limits* limits,
+                                                                               const std::function<bool()>& is_canceled,
+                                                                               std::vector<ExternalPlaneBuffer>* output_buffers,
+                                                                               int num_threads)
+{
+  std::shared_ptr<HeifPixelImage> in = std::move(input);
+  std::shared_ptr<HeifPixelImage> out;
+
+  CancelPoller cancel_poller(is_canceled);
+
+  for (size_t i = 0; i < m_conversion_steps.size(); i++) {
+    const auto& step = m_conversion_steps[i];
+
+    if (poll_canceled(&cancel_poller)) {
+      return color_conversion_canceled_error();
+    }
+
+    // --- fuse consecutive striped operations that only read the rows of their own strip
+
+    size_t end_fused = i;
+    while (end_fused < m_conversion_steps.size()) {
+      auto* op = dynamic_cast<const StripedColorConversionOperation*>(m_conversion_steps[end_fused].operation.get());
+      if (!op || op->needs_neighboring_rows(m_conversion_steps[end_fused].input_state)) {
+        break;
+      }
+
+      end_fused++;
+    }
+
+    if (end_fused - i >= 2) {
+      bool last_steps = (end_fused == m_conversion_steps.size());
+
+      auto fusedResult = convert_fused_steps(i, end_fused, in, limits, last_steps ? output_buffers : nullptr, num_threads,
+                                             &cancel_poller);
+      if (!fusedResult) {
+        return fusedResult.error();
+      }
+
+      if (*fusedResult) {
+        out = *fusedResult;
+        out->copy_metadata_from(*in);
+        out->set_color_profile_nclx(m_conversion_steps[end_fused - 1].output_state.nclx);
+        if (m_conversion_steps[end_fused - 1].output_state.has_alpha) {
+          out->set_premultiplied_alpha(m_conversion_steps[end_fused - 1].output_state.premultiplied_alpha);
+        }
+
+        for (const auto& warning : in->get_warnings()) {
+          out->add_warning(warning);
+        }
+
+        in = std::move(out);
+        i = end_fused - 1;
+        continue;
+      }
+
+      // The input cannot be split into strips. Convert it step by step.
+    }
 
 #if DEBUG_ME
     std::cerr << "input spec: ";
     print_spec(std::cerr, in);
 #endif
 
-    auto outResult = step.operation->convert_colorspace(in, step.input_state, step.output_state, m_options, m_options_ext, limits);
+    bool last_step = (i + 1 == m_conversion_steps.size());
+
+    // --- convert the image in place when nothing else references it.
+    //     When the planes of the last step should go into the output buffers, a new image has to be allocated.
+
+    if (step.operation->supports_inplace_conversion() &&
+        in.use_count() == 1 &&
+        !(last_step && output_buffers)) {
+      if (Error err = step.operation->convert_colorspace_inplace(in, step.input_state, step.output_state,
+                                                                m_options, m_options_ext, limits)) {
+        return err;
+      }
+
+      in->set_color_profile_nclx(step.output_state.nclx);
+      if (step.output_state.has_alpha) {
+        in->set_premultiplied_alpha(step.output_state.premultiplied_alpha);
+      }
+
+      continue;
+    }
+
+    uint32_t num_stripes = std::min(static_cast<uint32_t>(std::max(num_threads, 1)),
+                                    in->get_height() / min_rows_per_stripe);
+
+    auto* striped_op = dynamic_cast<const StripedColorConversionOperation*>(step.operation.get());
+
+    // The output buffers are only used for the output image of striped operations, because only these
+    // allocate their output image separately. Otherwise, the caller has to copy the result into the buffers.
+
+    Result<std::shared_ptr<HeifPixelImage>> outResult;
+    if (striped_op && (num_stripes > 1 || (last_step && output_buffers && in->get_height() > 0))) {
+      outResult = convert_in_stripes(*striped_op, in, step.input_state, step.output_state, m_options, m_options_ext,
+                                     limits, std::max(num_stripes, 1U), num_threads, &cancel_poller,
+                                     last_step ? output_buffers : nullptr);
+    }
+    else {
+      outResult = step.operation->convert_colorspace_with_threads(in, step.input_state, step.output_state, m_options, m_options_ext,
+                                                                  limits, num_threads);
+    }
+
     if (!outResult) {
       return outResult.error();
     }
@@ -471,8 +1094,11 @@ Result<std::shared_ptr<HeifPixelImage>> ColorConversionPipeline::convert_image(c
     // copy metadata over to new image
     out->copy_metadata_from(*in);
 
-    // overwrite color profile nclx from color conversion
+    // overwrite color profile nclx and alpha premultiplication from color conversion
     out->set_color_profile_nclx(step.output_state.nclx);
+    if (step.output_state.has_alpha) {
+      out->set_premultiplied_alpha(step.output_state.premultiplied_alpha);
+    }
 
 
     const auto& warnings = in->get_warnings();
@@ -480,21 +1106,24 @@ Result<std::shared_ptr<HeifPixelImage>> ColorConversionPipeline::convert_image(c
       out->add_warning(warning);
     }
 
-    in = out;
+    in = std::move(out);
   }
 
-  return out;
+  return in;
 }
 
 
-Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(const std::shared_ptr<HeifPixelImage>& input,
+Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(std::shared_ptr<HeifPixelImage> input,
                                                            heif_colorspace target_colorspace,
                                                            heif_chroma target_chroma,
                                                            const nclx_profile& target_profile,
                                                            int output_bpp,
                                                            const heif_color_conversion_options& options,
                                                            const heif_color_conversion_options_ext* options_ext_optional,
-                                                           const heif_security_limits* limits)
+                                                           const heif_security_limits* limits,
+                                                           const std::function<bool()>& is_canceled,
+                                                           std::vector<ExternalPlaneBuffer>* output_buffers,
+                                                           int num_threads)
 {
   std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
       options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
@@ -546,6 +1175,8 @@ Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(const std::shared_ptr
     input_state.alpha_bits_per_pixel = input->get_bits_per_pixel(heif_channel_Alpha);
   }
 
+  input_state.premultiplied_alpha = input_state.has_alpha && input->is_premultiplied_alpha();
+
   ColorState output_state = input_state;
   output_state.colorspace = target_colorspace;
   output_state.chroma = target_chroma;
@@ -607,8 +1238,48 @@ Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(const std::shared_ptr
   // Output alpha should always match the output color BPP
   output_state.alpha_bits_per_pixel = output_state.bits_per_pixel;
 
+  // The alpha premultiplication can only be changed for interleaved RGBA output.
+  // All other formats keep the premultiplication of the input.
+
+  output_state.premultiplied_alpha = output_state.has_alpha && input_state.premultiplied_alpha;
+
+  if (output_state.has_alpha && input_state.has_alpha &&
+      (target_chroma == heif_chroma_interleaved_RGBA ||
+       target_chroma == heif_chroma_interleaved_RRGGBBAA_LE ||
+       target_chroma == heif_chroma_interleaved_RRGGBBAA_BE)) {
+    if (options_ext->alpha_premultiplication == heif_alpha_premultiplication_straight) {
+      output_state.premultiplied_alpha = false;
+    }
+    else if (options_ext->alpha_premultiplication == heif_alpha_premultiplication_premultiplied) {
+      output_state.premultiplied_alpha = true;
+    }
+  }
+
+  // Convert the pixel values between transfer characteristics and colour primaries only when requested.
+  // Otherwise, they are just tagged with the output nclx.
+
+  if (options_ext->convert_transfer_and_primaries &&
+      is_supported_transfer_characteristics(input_state.nclx.get_transfer_characteristics()) &&
+      is_supported_transfer_characteristics(output_state.nclx.get_transfer_characteristics()) &&
+      is_supported_colour_primaries(input_state.nclx.get_colour_primaries()) &&
+      is_supported_colour_primaries(output_state.nclx.get_colour_primaries())) {
+    input_state.transfer_characteristics = input_state.nclx.get_transfer_characteristics();
+    input_state.colour_primaries = input_state.nclx.get_colour_primaries();
+    output_state.transfer_characteristics = output_state.nclx.get_transfer_characteristics();
+    output_state.colour_primaries = output_state.nclx.get_colour_primaries();
+  }
+
   ColorConversionPipeline pipeline;
   bool success = pipeline.construct_pipeline(input_state, output_state, options, *options_ext);
+
+  if (!success && input_state.transfer_characteristics != heif_transfer_characteristic_unspecified) {
+    // There is no conversion path through the transfer and primaries conversion (e.g. for monochrome output).
+    // Fall back to the conversion without it.
+    input_state.transfer_characteristics = output_state.transfer_characteristics = heif_transfer_characteristic_unspecified;
+    input_state.colour_primaries = output_state.colour_primaries = heif_color_primaries_unspecified;
+    success = pipeline.construct_pipeline(input_state, output_state, options, *options_ext);
+  }
+
   if (!success) {
     return Error{heif_error_Unsupported_feature,
                  heif_suberror_Unsupported_color_conversion};
@@ -618,7 +1289,7 @@ Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(const std::shared_ptr
     return input;
   }
   else {
-    return pipeline.convert_image(input, limits);
+    return pipeline.convert_image(std::move(input), limits, is_canceled, output_buffers, num_threads);
   }
 }
 
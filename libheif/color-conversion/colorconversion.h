@@ -22,11 +22,15 @@
 #define LIBHEIF_COLORCONVERSION_H
 
 #include "image/pixelimage.h"
+#include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+class CancelPoller;
+
 
 struct ColorState
 {
@@ -35,6 +39,13 @@ struct ColorState
   bool has_alpha = false;
   int bits_per_pixel = 8;
   int alpha_bits_per_pixel = 0; // 0 = not set, treated as bits_per_pixel
+  bool premultiplied_alpha = false; // only meaningful if has_alpha
+
+  // Transfer characteristics and colour primaries of the pixel values. These are only set when a conversion
+  // between them was requested (heif_color_conversion_options_ext::convert_transfer_and_primaries) and stay
+  // 'unspecified' otherwise.
+  heif_transfer_characteristics transfer_characteristics = heif_transfer_characteristic_unspecified;
+  heif_color_primaries colour_primaries = heif_color_primaries_unspecified;
 
   // ColorConversionOperations can assume that the input and target nclx has no 'unspecified' values
   // if the colorspace is heif_colorspace_YCbCr. Otherwise, the values should preferably be 'unspecified'.
@@ -97,6 +108,83 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const = 0;
+
+  // Operations that can modify their input image instead of allocating a new output image return true here and
+  // implement convert_colorspace_inplace(). The pipeline uses this for intermediate images that nothing else references.
+  virtual bool supports_inplace_conversion() const { return false; }
+
+  // Converts 'image' into 'target_state'. The image keeps the planes that are not changed.
+  virtual Error
+  convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                             const ColorState& input_state,
+                             const ColorState& target_state,
+                             const heif_color_conversion_options& options,
+                             const heif_color_conversion_options_ext& options_ext,
+                             const heif_security_limits* limits) const
+  {
+    return Error::InternalError;
+  }
+
+  // Operations that cannot be split into independent stripes (see StripedColorConversionOperation) may
+  // parallelize internally with up to 'num_threads' threads. The default converts on the calling thread.
+  virtual Result<std::shared_ptr<HeifPixelImage>>
+  convert_colorspace_with_threads(const std::shared_ptr<const HeifPixelImage>& input,
+                                  const ColorState& input_state,
+                                  const ColorState& target_state,
+                                  const heif_color_conversion_options& options,
+                                  const heif_color_conversion_options_ext& options_ext,
+                                  const heif_security_limits* limits,
+                                  int num_threads) const
+  {
+    return convert_colorspace(input, input_state, target_state, options, options_ext, limits);
+  }
+
+  // The premultiplication state of the alpha channel is passed through all operations that do not
+  // convert it themselves. These return true and set the state of their output.
+  virtual bool changes_alpha_premultiplication() const { return false; }
+
+  // The same for ColorState::transfer_characteristics and ColorState::colour_primaries.
+  virtual bool changes_transfer_and_primaries() const { return false; }
+};
+
+
+// Base class for operations that can convert independent stripes of image rows.
+// The ColorConversionPipeline allocates the output image with create_output_image() and then
+// converts the stripes in parallel with convert_stripe().
+// Stripes always start at even rows, so that vertically subsampled chroma rows are never split.
+class StripedColorConversionOperation : public ColorConversionOperation
+{
+public:
+  // Converts the whole image as a single stripe.
+  Result<std::shared_ptr<HeifPixelImage>>
+  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
+                     const ColorState& input_state,
+                     const ColorState& target_state,
+                     const heif_color_conversion_options& options,
+                     const heif_color_conversion_options_ext& options_ext,
+                     const heif_security_limits* limits) const override;
+
+  virtual Result<std::shared_ptr<HeifPixelImage>>
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const = 0;
+
+  // Converts the rows [first_row, end_row) of 'input' into 'output'.
+  virtual Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const = 0;
+
+  // Whether convert_stripe() also reads input rows outside of [first_row, end_row), e.g. for a vertical interpolation.
+  // These operations are not fused with other steps, because each strip of fused steps only sees its own rows.
+  virtual bool needs_neighboring_rows(const ColorState& input_state) const { return false; }
 };
 
 
@@ -106,21 +194,80 @@ public:
   static void init_ops();
   static void release_ops();
 
+  // All registered operations, in the order of registration. Vectorized variants follow the scalar operations.
+  static const std::vector<std::shared_ptr<ColorConversionOperation>>& get_operations();
+
+  // --- cost calibration
+  //
+  // By default, the pipelines are planned with the static SpeedCosts of the operations. After a calibration,
+  // the measured conversion times are used instead. Operations and states that were not measured keep their
+  // static costs, scaled to the range of the measured costs.
+
+  // Measures the operations on a small synthetic image. This takes some tens of milliseconds.
+  static void calibrate_costs();
+
+  // The exported table is text. It is only valid for the same libheif version on the same CPU.
+  static std::string export_cost_calibration();
+
+  static Error import_cost_calibration(const std::string& table);
+
+  // Goes back to the static costs.
+  static void reset_cost_calibration();
+
+  // The planned pipelines have to be discarded when the costs change.
+  static void clear_pipeline_cache();
+
   bool is_nop() const { return m_conversion_steps.empty(); }
 
+  // The planned pipelines are cached. Repeated calls with the same states and options do not search again.
   bool construct_pipeline(const ColorState& input_state,
                           const ColorState& target_state,
                           const heif_color_conversion_options& options,
                           const heif_color_conversion_options_ext& options_ext);
 
-  Result<std::shared_ptr<HeifPixelImage>> convert_image(const std::shared_ptr<HeifPixelImage>& input,
-                                                        const heif_security_limits* limits);
+  // If 'is_canceled' is set, it is polled between the conversion steps and between the stripes of
+  // multithreaded steps, and the conversion stops with heif_error_Canceled when it returns true.
+  // It is only called from the calling thread.
+  // If 'output_buffers' is set, the planes of the output image are placed into these buffers when they fit
+  // and the last step allocates its output image separately (striped operations, see ScopedExternalPlaneBuffers).
+  // Operations that support it are split into stripes that are converted with up to 'num_threads' threads.
+  // Consecutive operations of this kind are fused: they are executed on small strips of rows so that only
+  // strip-sized intermediate images are allocated.
+  // Operations that support it convert the intermediate images in place. The input image is also converted in place
+  // when the caller passes the only reference to it (with std::move). Otherwise, it is not modified.
+  Result<std::shared_ptr<HeifPixelImage>> convert_image(std::shared_ptr<HeifPixelImage> input,
+                                                        const heif_security_limits* limits,
+                                                        const std::function<bool()>& is_canceled = nullptr,
+                                                        std::vector<ExternalPlaneBuffer>* output_buffers = nullptr,
+                                                        int num_threads = 1);
 
   std::string debug_dump_pipeline() const;
 
 private:
   static std::vector<std::shared_ptr<ColorConversionOperation>> m_operation_pool;
 
+  // Identifies the operations in the calibration table: the class name and the number of previous
+  // registrations of the same class (0 for the scalar operation, higher numbers for the vectorized variants).
+  static std::vector<std::string> m_operation_ids;
+
+  struct CostCalibration
+  {
+    // Measured costs in units of 0.1 ns per pixel. See calibration_key().
+    std::map<std::string, int> costs;
+
+    // The ratio of the measured costs to the static costs. Used for everything that was not measured.
+    double static_costs_factor = 1;
+
+    int get_costs(const std::string& operation_id, const ColorState& input_state, const ColorState& output_state,
+                  int static_costs) const;
+  };
+
+  static std::shared_ptr<const CostCalibration> m_cost_calibration;
+
+  static std::shared_ptr<const CostCalibration> get_cost_calibration();
+
+  static void set_cost_calibration(std::shared_ptr<const CostCalibration>);
+
   struct ConversionStep {
     std::shared_ptr<ColorConversionOperation> operation;
     ColorState input_state;
@@ -129,21 +276,60 @@ private:
 
   std::vector<ConversionStep> m_conversion_steps;
 
+  struct CachedPipeline {
+    ColorState input_state;
+    ColorState target_state;
+    heif_color_conversion_options options;
+    heif_color_conversion_options_ext options_ext;
+
+    bool success;
+    std::vector<ConversionStep> conversion_steps;
+  };
+
+  static std::vector<CachedPipeline> m_pipeline_cache;
+
+  // Incremented when the cache is cleared. Pipelines that were searched with older costs are not added.
+  static uint64_t m_pipeline_cache_generation;
+
+  // The cache mutex has to be held.
+  static const CachedPipeline* find_cached_pipeline(const ColorState& input_state,
+                                                    const ColorState& target_state,
+                                                    const heif_color_conversion_options& options,
+                                                    const heif_color_conversion_options_ext& options_ext);
+
+  bool search_pipeline(const ColorState& input_state,
+                       const ColorState& target_state,
+                       const heif_color_conversion_options& options,
+                       const heif_color_conversion_options_ext& options_ext);
+
+  // Converts 'input' with the striped operations of the steps [first_step, end_step) in strips of rows.
+  // Returns nullptr when the planes of 'input' cannot be split into strips.
+  Result<std::shared_ptr<HeifPixelImage>> convert_fused_steps(size_t first_step, size_t end_step,
+                                                              const std::shared_ptr<HeifPixelImage>& input,
+                                                              const heif_security_limits* limits,
+                                                              std::vector<ExternalPlaneBuffer>* output_buffers,
+                                                              int num_threads,
+                                                              CancelPoller* cancel_poller) const;
+
   heif_color_conversion_options m_options;
   heif_color_conversion_options_ext m_options_ext;
 };
 
 
 // If no conversion is required, the input is simply passed through without copy.
-// The input image is never modified by this function, but the input is still non-const because we may pass it through.
-Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(const std::shared_ptr<HeifPixelImage>& input,
+// The input image is not modified by this function unless the caller passes the only reference to it (with std::move).
+// Then, some conversion steps may be done in place. The input is non-const because we may pass it through.
+Result<std::shared_ptr<HeifPixelImage>> convert_colorspace(std::shared_ptr<HeifPixelImage> input,
                                                            heif_colorspace colorspace,
                                                            heif_chroma chroma,
                                                            const nclx_profile& target_profile,
                                                            int output_bpp,
                                                            const heif_color_conversion_options& options,
                                                            const heif_color_conversion_options_ext* options_ext,
-                                                           const heif_security_limits* limits);
+                                                           const heif_security_limits* limits,
+                                                           const std::function<bool()>& is_canceled = nullptr,
+                                                           std::vector<ExternalPlaneBuffer>* output_buffers = nullptr,
+                                                           int num_threads = 1);
 
 Result<std::shared_ptr<const HeifPixelImage>> convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
                                                                  heif_colorspace colorspace,
@@ -0,0 +1,346 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "colorconversion.h"
+#include "synthetic_images.h"
+#include "common_utils.h"
+#include "libheif/heif.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <locale>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+
+std::shared_ptr<const ColorConversionPipeline::CostCalibration> ColorConversionPipeline::m_cost_calibration;
+
+#if ENABLE_MULTITHREADING_SUPPORT
+static std::mutex& get_cost_calibration_mutex()
+{
+  static std::mutex sMutex;
+  return sMutex;
+}
+#endif
+
+static const char* const calibration_table_header = "libheif-color-conversion-costs";
+
+// The costs of a pipeline are the sum of the costs of its steps. Limiting the costs of a single step
+// (here to 0.1 ms per pixel) keeps this sum far away from an integer overflow.
+static constexpr int max_step_costs = 1000000;
+
+
+static int clamp_costs(double costs)
+{
+  if (!(costs >= 1)) {
+    return 1;
+  }
+
+  return static_cast<int>(std::lround(std::min(costs, static_cast<double>(max_step_costs))));
+}
+
+
+static std::string state_key(const ColorState& state)
+{
+  std::ostringstream ostr;
+  ostr << state.colorspace << "/" << state.chroma << "/" << state.has_alpha << "/" << state.bits_per_pixel
+       << "/" << (state.has_alpha ? state.get_alpha_bits_per_pixel() : 0);
+  return ostr.str();
+}
+
+
+// The nclx profile does not influence the speed and is not part of the key.
+static std::string calibration_key(const std::string& operation_id, const ColorState& input_state,
+                                   const ColorState& output_state)
+{
+  return operation_id + "\t" + state_key(input_state) + "\t" + state_key(output_state);
+}
+
+
+int ColorConversionPipeline::CostCalibration::get_costs(const std::string& operation_id,
+                                                        const ColorState& input_state,
+                                                        const ColorState& output_state,
+                                                        int static_costs) const
+{
+  auto iter = costs.find(calibration_key(operation_id, input_state, output_state));
+  if (iter != costs.end()) {
+    return iter->second;
+  }
+
+  return clamp_costs(static_costs * static_costs_factor);
+}
+
+
+std::shared_ptr<const ColorConversionPipeline::CostCalibration> ColorConversionPipeline::get_cost_calibration()
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  std::lock_guard<std::mutex> lock(get_cost_calibration_mutex());
+#endif
+
+  return m_cost_calibration;
+}
+
+
+void ColorConversionPipeline::set_cost_calibration(std::shared_ptr<const CostCalibration> calibration)
+{
+  {
+#if ENABLE_MULTITHREADING_SUPPORT
+    std::lock_guard<std::mutex> lock(get_cost_calibration_mutex());
+#endif
+
+    m_cost_calibration = std::move(calibration);
+  }
+
+  clear_pipeline_cache();
+}
+
+
+void ColorConversionPipeline::reset_cost_calibration()
+{
+  set_cost_calibration(nullptr);
+}
+
+
+// Some operations also offer output states for targets that they cannot convert into (e.g. YCbCr with
+// interleaved RGB chroma). The search never reaches the target through these, but they cannot be measured.
+static bool is_valid_state(const ColorState& state)
+{
+  if (state.bits_per_pixel < 1 || state.bits_per_pixel > 16) {
+    return false;
+  }
+
+  switch (state.chroma) {
+    case heif_chroma_monochrome:
+      return state.colorspace == heif_colorspace_monochrome;
+    case heif_chroma_420:
+    case heif_chroma_422:
+      return state.colorspace == heif_colorspace_YCbCr;
+    case heif_chroma_444:
+      return state.colorspace == heif_colorspace_YCbCr || state.colorspace == heif_colorspace_RGB;
+    case heif_chroma_interleaved_RGB:
+    case heif_chroma_interleaved_RGBA:
+      return state.colorspace == heif_colorspace_RGB && state.bits_per_pixel == 8;
+    case heif_chroma_interleaved_RRGGBB_BE:
+    case heif_chroma_interleaved_RRGGBB_LE:
+    case heif_chroma_interleaved_RRGGBBAA_BE:
+    case heif_chroma_interleaved_RRGGBBAA_LE:
+      return state.colorspace == heif_colorspace_RGB && state.bits_per_pixel > 8;
+    default:
+      return false;
+  }
+}
+
+
+void ColorConversionPipeline::calibrate_costs()
+{
+  init_ops();
+
+  const uint32_t width = 128;
+  const uint32_t height = 64;
+  const int timed_runs = 3;
+
+  heif_color_conversion_options options;
+  heif_color_conversion_options_set_defaults(&options);
+  options.only_use_preferred_chroma_algorithm = false;
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  // --- the input and output states of decoding and encoding
+
+  std::vector<ColorState> targets;
+  for (const auto& conversion : get_common_color_conversions()) {
+    for (const ColorState& state : {conversion.first, conversion.second}) {
+      std::string key = state_key(state);
+      if (std::none_of(targets.begin(), targets.end(),
+                       [&key](const ColorState& s) { return state_key(s) == key; })) {
+        targets.push_back(state);
+      }
+    }
+  }
+
+  // --- collect all conversion steps that are reachable from these states
+
+  struct Step
+  {
+    size_t op_idx;
+    ColorState input_state;
+    ColorState output_state;
+    int static_costs;
+  };
+
+  std::vector<Step> steps;
+  std::vector<ColorState> states = targets;
+  std::set<std::string> known_steps;
+
+  for (size_t state_idx = 0; state_idx < states.size(); state_idx++) {
+    const ColorState input_state = states[state_idx];
+
+    for (size_t op_idx = 0; op_idx < m_operation_pool.size(); op_idx++) {
+      for (const auto& target : targets) {
+        for (const auto& out : m_operation_pool[op_idx]->state_after_conversion(input_state, target, options, *options_ext)) {
+          // The search never takes steps that do not change the state.
+          if (out.color_state == input_state || !is_valid_state(out.color_state)) {
+            continue;
+          }
+
+          std::string key = calibration_key(m_operation_ids[op_idx], input_state, out.color_state);
+          if (!known_steps.insert(key).second) {
+            continue;
+          }
+
+          steps.push_back({op_idx, input_state, out.color_state, out.speed_costs});
+
+          std::string out_key = state_key(out.color_state);
+          if (std::none_of(states.begin(), states.end(),
+                           [&out_key](const ColorState& s) { return state_key(s) == out_key; })) {
+            states.push_back(out.color_state);
+          }
+        }
+      }
+    }
+  }
+
+  // --- measure
+
+  auto calibration = std::make_shared<CostCalibration>();
+  double measured_sum = 0;
+  double static_sum = 0;
+
+  for (const auto& step : steps) {
+    auto input = create_synthetic_image(step.input_state, width, height);
+    if (!input) {
+      continue;
+    }
+
+    const auto& op = m_operation_pool[step.op_idx];
+    double best = std::numeric_limits<double>::max();
+    bool failed = false;
+
+    // The first run is not timed. It initializes the tables of the operations.
+    for (int run = 0; run <= timed_runs && !failed; run++) {
+      auto start = std::chrono::steady_clock::now();
+      auto result = op->convert_colorspace(input, step.input_state, step.output_state, options, *options_ext, nullptr);
+      std::chrono::duration<double, std::nano> duration = std::chrono::steady_clock::now() - start;
+
+      failed = !result;
+      if (run > 0) {
+        best = std::min(best, duration.count());
+      }
+    }
+
+    if (failed) {
+      continue;
+    }
+
+    int costs = clamp_costs(best * 10 / (width * height));
+    calibration->costs[calibration_key(m_operation_ids[step.op_idx], step.input_state, step.output_state)] = costs;
+
+    measured_sum += costs;
+    static_sum += step.static_costs;
+  }
+
+  if (static_sum > 0) {
+    calibration->static_costs_factor = measured_sum / static_sum;
+  }
+
+  set_cost_calibration(calibration);
+}
+
+
+std::string ColorConversionPipeline::export_cost_calibration()
+{
+  auto calibration = get_cost_calibration();
+
+  std::ostringstream ostr;
+  ostr.imbue(std::locale::classic());
+
+  ostr << calibration_table_header << "\t" << LIBHEIF_VERSION << "\n";
+
+  if (calibration) {
+    ostr << "static-costs-factor\t" << calibration->static_costs_factor << "\n";
+
+    for (const auto& [key, costs] : calibration->costs) {
+      ostr << key << "\t" << costs << "\n";
+    }
+  }
+
+  return ostr.str();
+}
+
+
+Error ColorConversionPipeline::import_cost_calibration(const std::string& table)
+{
+  std::istringstream istr(table);
+  istr.imbue(std::locale::classic());
+
+  auto invalid_table = [](const std::string& reason) {
+    return Error(heif_error_Usage_error,
+                 heif_suberror_Invalid_parameter_value,
+                 "Invalid color conversion cost calibration: " + reason);
+  };
+
+  std::string line;
+  if (!std::getline(istr, line) ||
+      line != std::string(calibration_table_header) + "\t" + LIBHEIF_VERSION) {
+    return invalid_table("the table was not exported by this libheif version");
+  }
+
+  auto calibration = std::make_shared<CostCalibration>();
+  bool has_entries = false;
+
+  while (std::getline(istr, line)) {
+    if (line.empty()) {
+      continue;
+    }
+
+    size_t tab = line.rfind('\t');
+    if (tab == std::string::npos) {
+      return invalid_table("missing value in line '" + line + "'");
+    }
+
+    std::string key = line.substr(0, tab);
+    std::istringstream value(line.substr(tab + 1));
+    value.imbue(std::locale::classic());
+
+    if (key == "static-costs-factor") {
+      if (!(value >> calibration->static_costs_factor) || calibration->static_costs_factor <= 0) {
+        return invalid_table("invalid factor in line '" + line + "'");
+      }
+    }
+    else {
+      int costs;
+      if (std::count(key.begin(), key.end(), '\t') != 2 ||
+          !(value >> costs) || costs < 1) {
+        return invalid_table("invalid line '" + line + "'");
+      }
+
+      calibration->costs[key] = std::min(costs, max_step_costs);
+    }
+
+    has_entries = true;
+  }
+
+  set_cost_calibration(has_entries ? calibration : nullptr);
+
+  return Error::Ok;
+}
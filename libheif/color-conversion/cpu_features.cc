@@ -0,0 +1,80 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "cpu_features.h"
+#include <cstdlib>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+static CpuFeatures detect_cpu_features()
+{
+  CpuFeatures features{};
+
+  if (getenv("LIBHEIF_DISABLE_SIMD")) {
+    return features;
+  }
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  features.sse41 = __builtin_cpu_supports("sse4.1");
+  features.avx2 = __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  int max_leaf = info[0];
+
+  __cpuid(info, 1);
+  features.sse41 = (info[2] & (1 << 19)) != 0;
+
+  // AVX2 also requires that the OS saves the YMM registers.
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+    __cpuidex(info, 7, 0);
+    features.avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  // NEON is a mandatory part of ARMv8-A.
+  features.neon = true;
+#endif
+
+#if !HAVE_SIMD_SSE41
+  features.sse41 = false;
+#endif
+#if !HAVE_SIMD_AVX2
+  features.avx2 = false;
+#endif
+#if !HAVE_SIMD_NEON
+  features.neon = false;
+#endif
+
+  return features;
+}
+
+
+const CpuFeatures& get_cpu_features()
+{
+  static const CpuFeatures features = detect_cpu_features();
+  return features;
+}
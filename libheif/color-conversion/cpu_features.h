@@ -0,0 +1,111 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_CPU_FEATURES_H
+#define LIBHEIF_COLORCONVERSION_CPU_FEATURES_H
+
+#include <vector>
+
+
+// Instruction set extensions that are supported by the CPU and for which libheif has been compiled with
+// vectorized kernels (HAVE_SIMD_SSE41, HAVE_SIMD_AVX2, HAVE_SIMD_NEON).
+struct CpuFeatures
+{
+  bool sse41;
+  bool avx2;
+  bool neon;
+};
+
+// The features are detected once on the first call.
+// Setting the environment variable LIBHEIF_DISABLE_SIMD disables all vectorized kernels.
+const CpuFeatures& get_cpu_features();
+
+
+// Selects between the scalar reference kernels of an operation and its vectorized variants.
+// The variants are only referenced when libheif is compiled with them. Use the SSE41_KERNELS(), AVX2_KERNELS()
+// and NEON_KERNELS() macros for the constructor arguments.
+template<class Kernels>
+class KernelDispatcher
+{
+public:
+  constexpr KernelDispatcher(const Kernels& scalar, const Kernels* sse41, const Kernels* avx2, const Kernels* neon)
+      : m_scalar(scalar), m_sse41(sse41), m_avx2(avx2), m_neon(neon) {}
+
+  const Kernels& get_scalar() const { return m_scalar; }
+
+  // The scalar kernels, followed by the vectorized kernels that the CPU supports. The last one is the fastest.
+  std::vector<const Kernels*> get_supported() const
+  {
+    std::vector<const Kernels*> kernels{&m_scalar};
+
+    const CpuFeatures& cpu = get_cpu_features();
+
+    if (m_sse41 && cpu.sse41) {
+      kernels.push_back(m_sse41);
+    }
+
+    if (m_avx2 && cpu.avx2) {
+      kernels.push_back(m_avx2);
+    }
+
+    if (m_neon && cpu.neon) {
+      kernels.push_back(m_neon);
+    }
+
+    return kernels;
+  }
+
+  // The fastest vectorized kernels or nullptr if the CPU supports none.
+  const Kernels* get_simd() const
+  {
+    auto supported = get_supported();
+    if (supported.size() == 1) {
+      return nullptr;
+    }
+
+    return supported.back();
+  }
+
+private:
+  const Kernels& m_scalar;
+  const Kernels* m_sse41;
+  const Kernels* m_avx2;
+  const Kernels* m_neon;
+};
+
+#if HAVE_SIMD_SSE41
+#define SSE41_KERNELS(kernels) (&(kernels))
+#else
+#define SSE41_KERNELS(kernels) nullptr
+#endif
+
+#if HAVE_SIMD_AVX2
+#define AVX2_KERNELS(kernels) (&(kernels))
+#else
+#define AVX2_KERNELS(kernels) nullptr
+#endif
+
+#if HAVE_SIMD_NEON
+#define NEON_KERNELS(kernels) (&(kernels))
+#else
+#define NEON_KERNELS(kernels) nullptr
+#endif
+
+#endif //LIBHEIF_COLORCONVERSION_CPU_FEATURES_H
@@ -19,7 +19,12 @@
  */
 
 #include <cassert>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <array>
 #include "hdr_sdr.h"
+#include "nclx.h"
 
 
 std::vector<ColorStateWithCost>
@@ -53,12 +58,12 @@ Op_to_hdr_planes::state_after_conversion(const ColorState& input_state,
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_to_hdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                     const ColorState& input_state,
-                                     const ColorState& target_state,
-                                     const heif_color_conversion_options& options,
-                                     const heif_color_conversion_options_ext& options_ext,
-                                     const heif_security_limits* limits) const
+Op_to_hdr_planes::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                      const ColorState& input_state,
+                                      const ColorState& target_state,
+                                      const heif_color_conversion_options& options,
+                                      const heif_color_conversion_options_ext& options_ext,
+                                      const heif_security_limits* limits) const
 {
   auto outimg = std::make_shared<HeifPixelImage>();
 
@@ -80,6 +85,35 @@ Op_to_hdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
       if (auto err = outimg->add_channel(channel, width, height, target_state.bits_per_pixel, limits)) {
         return err;
       }
+    }
+  }
+
+  return outimg;
+}
+
+
+Error
+Op_to_hdr_planes::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                 const std::shared_ptr<HeifPixelImage>& outimg,
+                                 const ColorState& input_state,
+                                 const ColorState& target_state,
+                                 const heif_color_conversion_options& options,
+                                 const heif_color_conversion_options_ext& options_ext,
+                                 uint32_t first_row, uint32_t end_row) const
+{
+  heif_chroma chroma = input->get_chroma_format();
+
+  for (heif_channel channel : {heif_channel_Y,
+                               heif_channel_Cb,
+                               heif_channel_Cr,
+                               heif_channel_R,
+                               heif_channel_G,
+                               heif_channel_B,
+                               heif_channel_Alpha}) {
+    if (input->has_channel(channel)) {
+      uint32_t width = input->get_width(channel);
+      uint32_t first_channel_row = channel_height(first_row, chroma, channel);
+      uint32_t end_channel_row = channel_height(end_row, chroma, channel);
 
       int input_bits = input->get_bits_per_pixel(channel);
       int output_bits = target_state.bits_per_pixel;
@@ -96,7 +130,7 @@ Op_to_hdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
       p_out = (uint16_t*) outimg->get_channel_memory(channel, &stride_out);
       stride_out /= 2;
 
-      for (uint32_t y = 0; y < height; y++)
+      for (uint32_t y = first_channel_row; y < end_channel_row; y++)
         for (uint32_t x = 0; x < width; x++) {
           int in = p_in[y * stride_in + x];
           // TODO: support for <8 bpp may need more than two copies of the input bit pattern
@@ -105,7 +139,7 @@ Op_to_hdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -144,14 +178,13 @@ Op_to_sdr_planes::state_after_conversion(const ColorState& input_state,
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                     const ColorState& input_state,
-                                     const ColorState& target_state,
-                                     const heif_color_conversion_options& options,
-                                     const heif_color_conversion_options_ext& options_ext,
-                                     const heif_security_limits* limits) const
+Op_to_sdr_planes::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                      const ColorState& input_state,
+                                      const ColorState& target_state,
+                                      const heif_color_conversion_options& options,
+                                      const heif_color_conversion_options_ext& options_ext,
+                                      const heif_security_limits* limits) const
 {
-
   auto outimg = std::make_shared<HeifPixelImage>();
 
   outimg->create(input->get_width(),
@@ -159,6 +192,37 @@ Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
                  input->get_colorspace(),
                  input->get_chroma_format());
 
+  for (heif_channel channel : {heif_channel_Y,
+                               heif_channel_Cb,
+                               heif_channel_Cr,
+                               heif_channel_R,
+                               heif_channel_G,
+                               heif_channel_B,
+                               heif_channel_Alpha}) {
+    if (input->has_channel(channel)) {
+      uint32_t width = input->get_width(channel);
+      uint32_t height = input->get_height(channel);
+      if (auto err = outimg->add_channel(channel, width, height, 8, limits)) {
+        return err;
+      }
+    }
+  }
+
+  return outimg;
+}
+
+
+Error
+Op_to_sdr_planes::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                 const std::shared_ptr<HeifPixelImage>& outimg,
+                                 const ColorState& input_state,
+                                 const ColorState& target_state,
+                                 const heif_color_conversion_options& options,
+                                 const heif_color_conversion_options_ext& options_ext,
+                                 uint32_t first_row, uint32_t end_row) const
+{
+  heif_chroma chroma = input->get_chroma_format();
+
   for (heif_channel channel : {heif_channel_Y,
                                heif_channel_Cb,
                                heif_channel_Cr,
@@ -169,13 +233,11 @@ Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
     if (input->has_channel(channel)) {
       int input_bits = input->get_bits_per_pixel(channel);
 
-      if (input_bits > 8) {
-        uint32_t width = input->get_width(channel);
-        uint32_t height = input->get_height(channel);
-        if (auto err = outimg->add_channel(channel, width, height, 8, limits)) {
-          return err;
-        }
+      uint32_t width = input->get_width(channel);
+      uint32_t first_channel_row = channel_height(first_row, chroma, channel);
+      uint32_t end_channel_row = channel_height(end_row, chroma, channel);
 
+      if (input_bits > 8) {
         int shift = input_bits - 8;
 
         const uint16_t* p_in;
@@ -187,18 +249,12 @@ Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
         size_t stride_out;
         p_out = outimg->get_channel_memory(channel, &stride_out);
 
-        for (uint32_t y = 0; y < height; y++)
+        for (uint32_t y = first_channel_row; y < end_channel_row; y++)
           for (uint32_t x = 0; x < width; x++) {
             int in = p_in[y * stride_in + x];
             p_out[y * stride_out + x] = (uint8_t) (in >> shift); // TODO: I think no rounding here, but am not sure.
           }
       } else if (input_bits < 8) {
-        uint32_t width = input->get_width(channel);
-        uint32_t height = input->get_height(channel);
-        if (auto err = outimg->add_channel(channel, width, height, 8, limits)) {
-          return err;
-        }
-
         // We also want to support converting inputs with < 4 bits per pixel covering the whole output range.
         // E.g. a 1-bit input should map to the output 0x00 / 0xFF.
         // We do so by constructing a fixed-point multiplication factor that effectively shifts and combines the input to
@@ -229,13 +285,405 @@ Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
         size_t stride_out;
         uint8_t* p_out = outimg->get_channel_memory(channel, &stride_out);
 
-        for (uint32_t y = 0; y < height; y++)
+        for (uint32_t y = first_channel_row; y < end_channel_row; y++)
           for (uint32_t x = 0; x < width; x++) {
             int in = p_in[y * stride_in + x];
             p_out[y * stride_out + x] = (uint8_t) ((in * mulFactor) >> 8);
           }
       } else {
-        outimg->copy_new_channel_from(input, channel, channel, limits);
+        size_t stride_in;
+        const uint8_t* p_in = input->get_channel_memory(channel, &stride_in);
+
+        size_t stride_out;
+        uint8_t* p_out = outimg->get_channel_memory(channel, &stride_out);
+
+        for (uint32_t y = first_channel_row; y < end_channel_row; y++) {
+          memcpy(p_out + y * stride_out, p_in + y * stride_in, width);
+        }
+      }
+    }
+  }
+
+  return Error::Ok;
+}
+
+
+// --- transfer characteristics and colour primaries
+
+// Luminance of the SDR reference white and of HDR diffuse white (ITU-R BT.2408).
+static const double reference_white_nits = 203.0;
+
+static const double pq_peak_nits = 10000.0;
+
+// Nominal peak luminance of the HLG reference display (ITU-R BT.2100).
+static const double hlg_peak_nits = 1000.0;
+
+// PQ content is seldom mastered on displays brighter than this. Tone mapping of PQ input starts from this peak
+// luminance, brighter values are clipped.
+static const double pq_content_peak_nits = 1000.0;
+
+static const double hlg_a = 0.17883277;
+static const double hlg_b = 0.28466892;
+static const double hlg_c = 0.55991073;
+
+static const double pq_m1 = 2610.0 / 16384;
+static const double pq_m2 = 2523.0 / 4096 * 128;
+static const double pq_c1 = 3424.0 / 4096;
+static const double pq_c2 = 2413.0 / 4096 * 32;
+static const double pq_c3 = 2392.0 / 4096 * 32;
+
+
+bool is_supported_transfer_characteristics(heif_transfer_characteristics transfer)
+{
+  switch (transfer) {
+    case heif_transfer_characteristic_ITU_R_BT_709_5:
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_M:
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_B_G:
+    case heif_transfer_characteristic_ITU_R_BT_601_6:
+    case heif_transfer_characteristic_linear:
+    case heif_transfer_characteristic_IEC_61966_2_1:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_10bit:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_12bit:
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_PQ:
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_HLG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+bool is_supported_colour_primaries(heif_color_primaries primaries)
+{
+  return get_colour_primaries(primaries).defined;
+}
+
+
+static double peak_luminance(heif_transfer_characteristics transfer)
+{
+  switch (transfer) {
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_PQ:
+      return pq_peak_nits;
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_HLG:
+      return hlg_peak_nits;
+    default:
+      return reference_white_nits;
+  }
+}
+
+
+// Maps a normalized code value [0;1] to the displayed luminance in cd/m^2.
+// The HLG OOTF is approximated per component with the system gamma 1.2 of the 1000 cd/m^2 reference display.
+static double code_value_to_luminance(heif_transfer_characteristics transfer, double v)
+{
+  switch (transfer) {
+    case heif_transfer_characteristic_ITU_R_BT_709_5:
+    case heif_transfer_characteristic_ITU_R_BT_601_6:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_10bit:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_12bit:
+      return reference_white_nits * (v < 0.081 ? v / 4.5 : std::pow((v + 0.099) / 1.099, 1 / 0.45));
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_M:
+      return reference_white_nits * std::pow(v, 2.2);
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_B_G:
+      return reference_white_nits * std::pow(v, 2.8);
+    case heif_transfer_characteristic_IEC_61966_2_1:
+      return reference_white_nits * (v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4));
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_PQ: {
+      double p = std::pow(v, 1 / pq_m2);
+      return pq_peak_nits * std::pow(std::max(p - pq_c1, 0.0) / (pq_c2 - pq_c3 * p), 1 / pq_m1);
+    }
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_HLG: {
+      double scene = (v <= 0.5 ? v * v / 3 : (std::exp((v - hlg_c) / hlg_a) + hlg_b) / 12);
+      return hlg_peak_nits * std::pow(scene, 1.2);
+    }
+    default:
+      return reference_white_nits * v;
+  }
+}
+
+
+// Inverse of code_value_to_luminance(). The result is clipped to [0;1].
+static double luminance_to_code_value(heif_transfer_characteristics transfer, double nits)
+{
+  double v;
+
+  switch (transfer) {
+    case heif_transfer_characteristic_ITU_R_BT_709_5:
+    case heif_transfer_characteristic_ITU_R_BT_601_6:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_10bit:
+    case heif_transfer_characteristic_ITU_R_BT_2020_2_12bit: {
+      double l = nits / reference_white_nits;
+      v = (l < 0.018 ? 4.5 * l : 1.099 * std::pow(l, 0.45) - 0.099);
+      break;
+    }
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_M:
+      v = std::pow(nits / reference_white_nits, 1 / 2.2);
+      break;
+    case heif_transfer_characteristic_ITU_R_BT_470_6_System_B_G:
+      v = std::pow(nits / reference_white_nits, 1 / 2.8);
+      break;
+    case heif_transfer_characteristic_IEC_61966_2_1: {
+      double l = nits / reference_white_nits;
+      v = (l <= 0.0031308 ? 12.92 * l : 1.055 * std::pow(l, 1 / 2.4) - 0.055);
+      break;
+    }
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_PQ: {
+      double p = std::pow(nits / pq_peak_nits, pq_m1);
+      v = std::pow((pq_c1 + pq_c2 * p) / (1 + pq_c3 * p), pq_m2);
+      break;
+    }
+    case heif_transfer_characteristic_ITU_R_BT_2100_0_HLG: {
+      double scene = std::pow(nits / hlg_peak_nits, 1 / 1.2);
+      v = (scene <= 1.0 / 12 ? std::sqrt(3 * scene) : hlg_a * std::log(std::max(12 * scene - hlg_b, 1e-12)) + hlg_c);
+      break;
+    }
+    default:
+      v = nits / reference_white_nits;
+  }
+
+  return std::clamp(v, 0.0, 1.0);
+}
+
+
+// Compresses the luminance range [0;peak] into [0;1] (in units of the output peak luminance).
+// Values below the knee are kept, the highlights are compressed with an extended Reinhard curve that has
+// a continuous slope at the knee and reaches 1 at 'peak'.
+static double tone_map(double x, double peak)
+{
+  const double knee = 0.5;
+
+  if (peak <= 1 || x <= knee) {
+    return std::min(x, 1.0);
+  }
+
+  if (x >= peak) {
+    return 1;
+  }
+
+  double u = (x - knee) / (1 - knee);
+  double u_peak = (peak - knee) / (1 - knee);
+
+  return knee + (1 - knee) * u * (1 + u / (u_peak * u_peak)) / (1 + u);
+}
+
+
+using Matrix3x3 = std::array<std::array<double, 3>, 3>;
+
+static Matrix3x3 invert(const Matrix3x3& m)
+{
+  double det = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]));
+
+  Matrix3x3 inv{};
+  inv[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det;
+  inv[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det;
+  inv[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det;
+  inv[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det;
+  inv[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+  inv[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det;
+  inv[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det;
+  inv[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det;
+  inv[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+  return inv;
+}
+
+
+static Matrix3x3 multiply(const Matrix3x3& a, const Matrix3x3& b)
+{
+  Matrix3x3 m{};
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      for (int i = 0; i < 3; i++) {
+        m[r][c] += a[r][i] * b[i][c];
+      }
+  return m;
+}
+
+
+// Linear RGB -> CIE XYZ. The white point has Y=1.
+static Matrix3x3 RGB_to_XYZ_matrix(const primaries& p)
+{
+  double xy[3][2] = {{p.redX,   p.redY},
+                     {p.greenX, p.greenY},
+                     {p.blueX,  p.blueY}};
+
+  Matrix3x3 m{};
+  for (int c = 0; c < 3; c++) {
+    m[0][c] = xy[c][0] / xy[c][1];
+    m[1][c] = 1;
+    m[2][c] = (1 - xy[c][0] - xy[c][1]) / xy[c][1];
+  }
+
+  // scale the primaries such that RGB=(1,1,1) is the white point
+
+  double white[3] = {p.whiteX / p.whiteY, 1, (1 - p.whiteX - p.whiteY) / p.whiteY};
+  Matrix3x3 inv = invert(m);
+
+  for (int c = 0; c < 3; c++) {
+    double s = inv[c][0] * white[0] + inv[c][1] * white[1] + inv[c][2] * white[2];
+    for (int r = 0; r < 3; r++) {
+      m[r][c] *= s;
+    }
+  }
+
+  return m;
+}
+
+
+static const int linear_bits = 24;
+static const int matrix_bits = 14;
+static const int dark_table_bits = 16;
+static const int table_shift = linear_bits - 16;
+
+
+std::shared_ptr<const Op_convert_transfer_and_primaries::Tables>
+Op_convert_transfer_and_primaries::get_tables(heif_transfer_characteristics input_transfer,
+                                              heif_color_primaries input_primaries,
+                                              heif_transfer_characteristics output_transfer,
+                                              heif_color_primaries output_primaries,
+                                              int bits_per_pixel) const
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  std::lock_guard<std::mutex> lock(m_tables_mutex);
+#endif
+
+  for (const auto& tables : m_tables_cache) {
+    if (tables->input_transfer == input_transfer &&
+        tables->input_primaries == input_primaries &&
+        tables->output_transfer == output_transfer &&
+        tables->output_primaries == output_primaries &&
+        tables->bits_per_pixel == bits_per_pixel) {
+      return tables;
+    }
+  }
+
+  auto tables = std::make_shared<Tables>();
+  tables->input_transfer = input_transfer;
+  tables->input_primaries = input_primaries;
+  tables->output_transfer = output_transfer;
+  tables->output_primaries = output_primaries;
+  tables->bits_per_pixel = bits_per_pixel;
+
+  const int max_value = (1 << bits_per_pixel) - 1;
+  const double one = double(1 << linear_bits);
+
+  // --- input code values -> linear light, tone mapped into the output luminance range
+
+  double output_peak = peak_luminance(output_transfer);
+  double input_peak = (input_transfer == heif_transfer_characteristic_ITU_R_BT_2100_0_PQ ?
+                       pq_content_peak_nits : peak_luminance(input_transfer));
+
+  tables->to_linear.resize(max_value + 1);
+  for (int i = 0; i <= max_value; i++) {
+    double nits = code_value_to_luminance(input_transfer, i / double(max_value));
+    double linear = tone_map(nits / output_peak, input_peak / output_peak);
+    tables->to_linear[i] = static_cast<int32_t>(std::lround(linear * one));
+  }
+
+  // --- primaries
+
+  tables->has_matrix = (input_primaries != output_primaries);
+  if (tables->has_matrix) {
+    Matrix3x3 m = multiply(invert(RGB_to_XYZ_matrix(get_colour_primaries(output_primaries))),
+                           RGB_to_XYZ_matrix(get_colour_primaries(input_primaries)));
+
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++) {
+        tables->matrix[r][c] = static_cast<int32_t>(std::lround(m[r][c] * (1 << matrix_bits)));
+      }
+  }
+
+  // --- linear light -> output code values
+
+  auto encode = [&](double linear) {
+    return static_cast<uint16_t>(std::lround(luminance_to_code_value(output_transfer, linear * output_peak) * max_value));
+  };
+
+  tables->from_linear_dark.resize(1 << dark_table_bits);
+  for (int i = 0; i < (1 << dark_table_bits); i++) {
+    tables->from_linear_dark[i] = encode(i / one);
+  }
+
+  tables->from_linear.resize((1 << (linear_bits - table_shift)) + 1);
+  for (size_t i = 0; i < tables->from_linear.size(); i++) {
+    tables->from_linear[i] = encode(double(i << table_shift) / one);
+  }
+
+  // Only a few combinations are used by an application. Drop the oldest tables if there are many.
+
+  const size_t max_cached_tables = 8;
+  if (m_tables_cache.size() >= max_cached_tables) {
+    m_tables_cache.erase(m_tables_cache.begin());
+  }
+
+  m_tables_cache.push_back(tables);
+
+  return tables;
+}
+
+
+std::vector<ColorStateWithCost>
+Op_convert_transfer_and_primaries::state_after_conversion(const ColorState& input_state,
+                                                          const ColorState& target_state,
+                                                          const heif_color_conversion_options& options,
+                                                          const heif_color_conversion_options_ext& options_ext) const
+{
+  if (input_state.colorspace != heif_colorspace_RGB ||
+      input_state.chroma != heif_chroma_444 ||
+      input_state.bits_per_pixel > 16) {
+    return {};
+  }
+
+  if (input_state.transfer_characteristics == target_state.transfer_characteristics &&
+      input_state.colour_primaries == target_state.colour_primaries) {
+    return {};
+  }
+
+  if (!is_supported_transfer_characteristics(input_state.transfer_characteristics) ||
+      !is_supported_transfer_characteristics(target_state.transfer_characteristics) ||
+      !is_supported_colour_primaries(input_state.colour_primaries) ||
+      !is_supported_colour_primaries(target_state.colour_primaries)) {
+    return {};
+  }
+
+  std::vector<ColorStateWithCost> states;
+
+  ColorState output_state = input_state;
+  output_state.transfer_characteristics = target_state.transfer_characteristics;
+  output_state.colour_primaries = target_state.colour_primaries;
+  output_state.nclx.set_transfer_characteristics(target_state.transfer_characteristics);
+  output_state.nclx.set_colour_primaries(target_state.colour_primaries);
+
+  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+
+  return states;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage>>
+Op_convert_transfer_and_primaries::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                       const ColorState& input_state,
+                                                       const ColorState& target_state,
+                                                       const heif_color_conversion_options& options,
+                                                       const heif_color_conversion_options_ext& options_ext,
+                                                       const heif_security_limits* limits) const
+{
+  auto outimg = std::make_shared<HeifPixelImage>();
+
+  outimg->create(input->get_width(),
+                 input->get_height(),
+                 heif_colorspace_RGB,
+                 heif_chroma_444);
+
+  for (heif_channel channel : {heif_channel_R,
+                               heif_channel_G,
+                               heif_channel_B,
+                               heif_channel_Alpha}) {
+    if (input->has_channel(channel)) {
+      if (auto err = outimg->add_channel(channel, input->get_width(channel), input->get_height(channel),
+                                         input->get_bits_per_pixel(channel), limits)) {
+        return err;
       }
     }
   }
@@ -243,3 +691,113 @@ Op_to_sdr_planes::convert_colorspace(const std::shared_ptr<const HeifPixelImage>
   return outimg;
 }
 
+
+template<class Pixel>
+static void convert_transfer_and_primaries(const Op_convert_transfer_and_primaries::Tables& tables,
+                                           const std::shared_ptr<const HeifPixelImage>& input,
+                                           const std::shared_ptr<HeifPixelImage>& outimg,
+                                           uint32_t first_row, uint32_t end_row)
+{
+  const heif_channel channels[3] = {heif_channel_R, heif_channel_G, heif_channel_B};
+
+  const Pixel* in[3];
+  Pixel* out[3];
+  size_t in_stride[3], out_stride[3];
+
+  for (int c = 0; c < 3; c++) {
+    in[c] = reinterpret_cast<const Pixel*>(input->get_channel_memory(channels[c], &in_stride[c]));
+    out[c] = reinterpret_cast<Pixel*>(outimg->get_channel_memory(channels[c], &out_stride[c]));
+    in_stride[c] /= sizeof(Pixel);
+    out_stride[c] /= sizeof(Pixel);
+  }
+
+  const uint32_t width = input->get_width();
+  const uint32_t max_value = static_cast<uint32_t>(tables.to_linear.size() - 1);
+  const int64_t round = 1 << (matrix_bits - 1);
+  const int64_t one = int64_t{1} << linear_bits;
+
+  auto encode = [&tables, one](int64_t linear) {
+    linear = std::clamp<int64_t>(linear, 0, one);
+    if (linear < (1 << dark_table_bits)) {
+      return tables.from_linear_dark[linear];
+    }
+    else {
+      return tables.from_linear[(linear + (1 << (table_shift - 1))) >> table_shift];
+    }
+  };
+
+  for (uint32_t y = first_row; y < end_row; y++) {
+    const Pixel* r_in = in[0] + y * in_stride[0];
+    const Pixel* g_in = in[1] + y * in_stride[1];
+    const Pixel* b_in = in[2] + y * in_stride[2];
+    Pixel* r_out = out[0] + y * out_stride[0];
+    Pixel* g_out = out[1] + y * out_stride[1];
+    Pixel* b_out = out[2] + y * out_stride[2];
+
+    for (uint32_t x = 0; x < width; x++) {
+      int64_t r = tables.to_linear[std::min<uint32_t>(r_in[x], max_value)];
+      int64_t g = tables.to_linear[std::min<uint32_t>(g_in[x], max_value)];
+      int64_t b = tables.to_linear[std::min<uint32_t>(b_in[x], max_value)];
+
+      if (tables.has_matrix) {
+        const auto& m = tables.matrix;
+        int64_t r2 = (m[0][0] * r + m[0][1] * g + m[0][2] * b + round) >> matrix_bits;
+        int64_t g2 = (m[1][0] * r + m[1][1] * g + m[1][2] * b + round) >> matrix_bits;
+        int64_t b2 = (m[2][0] * r + m[2][1] * g + m[2][2] * b + round) >> matrix_bits;
+        r = r2;
+        g = g2;
+        b = b2;
+      }
+
+      r_out[x] = static_cast<Pixel>(encode(r));
+      g_out[x] = static_cast<Pixel>(encode(g));
+      b_out[x] = static_cast<Pixel>(encode(b));
+    }
+  }
+}
+
+
+Error
+Op_convert_transfer_and_primaries::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                                  const std::shared_ptr<HeifPixelImage>& outimg,
+                                                  const ColorState& input_state,
+                                                  const ColorState& target_state,
+                                                  const heif_color_conversion_options& options,
+                                                  const heif_color_conversion_options_ext& options_ext,
+                                                  uint32_t first_row, uint32_t end_row) const
+{
+  int bpp = input->get_bits_per_pixel(heif_channel_R);
+  if (input->get_bits_per_pixel(heif_channel_G) != bpp ||
+      input->get_bits_per_pixel(heif_channel_B) != bpp) {
+    return Error::InternalError;
+  }
+
+  auto tables = get_tables(input_state.transfer_characteristics, input_state.colour_primaries,
+                           target_state.transfer_characteristics, target_state.colour_primaries,
+                           bpp);
+
+  if (bpp <= 8) {
+    convert_transfer_and_primaries<uint8_t>(*tables, input, outimg, first_row, end_row);
+  }
+  else {
+    convert_transfer_and_primaries<uint16_t>(*tables, input, outimg, first_row, end_row);
+  }
+
+  if (input->has_channel(heif_channel_Alpha)) {
+    const uint8_t* p_in;
+    size_t stride_in;
+    p_in = input->get_channel_memory(heif_channel_Alpha, &stride_in);
+
+    uint8_t* p_out;
+    size_t stride_out;
+    p_out = outimg->get_channel_memory(heif_channel_Alpha, &stride_out);
+
+    size_t row_bytes = input->get_width(heif_channel_Alpha) * ((input->get_bits_per_pixel(heif_channel_Alpha) + 7) / 8);
+
+    for (uint32_t y = first_row; y < end_row; y++) {
+      memcpy(p_out + y * stride_out, p_in + y * stride_in, row_bytes);
+    }
+  }
+
+  return Error::Ok;
+}
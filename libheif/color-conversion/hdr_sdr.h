@@ -26,7 +26,39 @@
 #include <vector>
 #include <memory>
 
-class Op_to_hdr_planes : public ColorConversionOperation
+#if ENABLE_MULTITHREADING_SUPPORT
+#include <mutex>
+#endif
+
+class Op_to_hdr_planes : public StripedColorConversionOperation
+{
+public:
+  std::vector<ColorStateWithCost>
+  state_after_conversion(const ColorState& input_state,
+                         const ColorState& target_state,
+                         const heif_color_conversion_options& options,
+                         const heif_color_conversion_options_ext& options_ext) const override;
+
+  Result<std::shared_ptr<HeifPixelImage>>
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+};
+
+
+class Op_to_sdr_planes : public StripedColorConversionOperation
 {
 public:
   std::vector<ColorStateWithCost>
@@ -36,16 +68,39 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
 };
 
 
-class Op_to_sdr_planes : public ColorConversionOperation
+// Returns whether Op_convert_transfer_and_primaries can convert from and into these transfer characteristics
+// and colour primaries.
+bool is_supported_transfer_characteristics(heif_transfer_characteristics transfer);
+
+bool is_supported_colour_primaries(heif_color_primaries primaries);
+
+
+// Converts planar RGB 4:4:4 between transfer characteristics (PQ, HLG, sRGB, BT.709, gamma and linear) and
+// colour primaries (e.g. BT.2020 to BT.709). HDR input (PQ or HLG) is tone mapped when the output has a lower
+// peak luminance.
+//
+// The conversion uses precomputed tables: a 1D LUT from the input code values into linear light (including the
+// tone mapping), a 3x3 primaries matrix in fixed point and a 1D LUT from linear light into the output code values.
+// The tables depend only on the transfer characteristics, primaries and bit depths and are cached.
+class Op_convert_transfer_and_primaries : public StripedColorConversionOperation
 {
 public:
   std::vector<ColorStateWithCost>
@@ -55,12 +110,55 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+  bool changes_transfer_and_primaries() const override { return true; }
+
+  struct Tables
+  {
+    heif_transfer_characteristics input_transfer;
+    heif_color_primaries input_primaries;
+    heif_transfer_characteristics output_transfer;
+    heif_color_primaries output_primaries;
+    int bits_per_pixel;
+
+    // input code value -> linear light in units of the output peak luminance (fixed point, 1.0 = 1<<24)
+    std::vector<int32_t> to_linear;
+
+    // primaries conversion in fixed point (1.0 = 1<<14)
+    bool has_matrix;
+    int32_t matrix[3][3];
+
+    // linear light -> output code value. Values below 1<<16 use the finer table to keep the precision in dark areas.
+    std::vector<uint16_t> from_linear_dark; // index: linear value
+    std::vector<uint16_t> from_linear; // index: linear value >> 8
+  };
+
+  std::shared_ptr<const Tables> get_tables(heif_transfer_characteristics input_transfer,
+                                           heif_color_primaries input_primaries,
+                                           heif_transfer_characteristics output_transfer,
+                                           heif_color_primaries output_primaries,
+                                           int bits_per_pixel) const;
+
+private:
+#if ENABLE_MULTITHREADING_SUPPORT
+  mutable std::mutex m_tables_mutex;
+#endif
+  mutable std::vector<std::shared_ptr<const Tables>> m_tables_cache;
 };
 
 #endif //LIBHEIF_COLORCONVERSION_HDR_SDR_H
@@ -0,0 +1,229 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. See interleave_kernels.h.
+
+#include "interleave_kernels.h"
+#include "colorconversion.h"
+#include <immintrin.h>
+
+
+static inline __m256i combine(__m128i lo, __m128i hi)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+
+static inline __m256i swap_bytes_16(__m256i v)
+{
+  const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  return _mm256_shuffle_epi8(v, combine(shuffle, shuffle));
+}
+
+
+// Stores 8 blocks of 16 bytes in order. After two stages of in-lane unpacking, the lanes of o0 ... o3
+// hold the blocks 0|4, 1|5, 2|6 and 3|7.
+static inline void store_unpacked_lanes(uint8_t* out, __m256i o0, __m256i o1, __m256i o2, __m256i o3)
+{
+  _mm256_storeu_si256((__m256i*) (out), _mm256_permute2x128_si256(o0, o1, 0x20));
+  _mm256_storeu_si256((__m256i*) (out + 32), _mm256_permute2x128_si256(o2, o3, 0x20));
+  _mm256_storeu_si256((__m256i*) (out + 64), _mm256_permute2x128_si256(o0, o1, 0x31));
+  _mm256_storeu_si256((__m256i*) (out + 96), _mm256_permute2x128_si256(o2, o3, 0x31));
+}
+
+
+static void mono_to_rgb24_row_avx2(const uint8_t* in_y, uint8_t* out, uint32_t width)
+{
+  // Each output byte 3*x+c is taken from y[x]. 16 pixels give three 16 byte blocks.
+  const __m128i shuffle0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+  const __m128i shuffle1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+  const __m128i shuffle2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+  const __m256i shuffle01 = combine(shuffle0, shuffle1);
+  const __m256i shuffle20 = combine(shuffle2, shuffle0);
+  const __m256i shuffle12 = combine(shuffle1, shuffle2);
+
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i y = _mm256_loadu_si256((const __m256i*) (in_y + x));
+
+    // pixels 0-15 in both lanes, pixels 0-15 | 16-31, pixels 16-31 in both lanes
+    __m256i y_lo = _mm256_permute2x128_si256(y, y, 0x00);
+    __m256i y_hi = _mm256_permute2x128_si256(y, y, 0x11);
+
+    _mm256_storeu_si256((__m256i*) (out + 3 * x), _mm256_shuffle_epi8(y_lo, shuffle01));
+    _mm256_storeu_si256((__m256i*) (out + 3 * x + 32), _mm256_shuffle_epi8(y, shuffle20));
+    _mm256_storeu_si256((__m256i*) (out + 3 * x + 64), _mm256_shuffle_epi8(y_hi, shuffle12));
+  }
+
+  mono_to_rgb24_row_scalar(in_y + x, out + 3 * x, width - x);
+}
+
+
+static void mono_to_rgba_row_avx2(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width)
+{
+  __m256i a = _mm256_set1_epi8(static_cast<char>(0xFF));
+
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i y = _mm256_loadu_si256((const __m256i*) (in_y + x));
+    if (in_a) {
+      a = _mm256_loadu_si256((const __m256i*) (in_a + x));
+    }
+
+    __m256i yy_lo = _mm256_unpacklo_epi8(y, y);
+    __m256i yy_hi = _mm256_unpackhi_epi8(y, y);
+    __m256i ya_lo = _mm256_unpacklo_epi8(y, a);
+    __m256i ya_hi = _mm256_unpackhi_epi8(y, a);
+
+    store_unpacked_lanes(out + 4 * x,
+                         _mm256_unpacklo_epi16(yy_lo, ya_lo), _mm256_unpackhi_epi16(yy_lo, ya_lo),
+                         _mm256_unpacklo_epi16(yy_hi, ya_hi), _mm256_unpackhi_epi16(yy_hi, ya_hi));
+  }
+
+  mono_to_rgba_row_scalar(in_y + x, in_a ? in_a + x : nullptr, out + 4 * x, width - x);
+}
+
+
+// Interleaves 16 pixels of 16 bit samples that are already in big-endian byte order into RRGGBB.
+static inline void store_rrggbb_16(uint8_t* out, __m256i r, __m256i g, __m256i b)
+{
+  // Shuffles for the three 16 byte output blocks of 8 pixels.
+  const __m128i r0 = _mm_setr_epi8(0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5, -1, -1);
+  const __m128i g0 = _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5);
+  const __m128i b0 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 10, 11);
+  const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1);
+  const __m128i b1 = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15);
+
+  auto interleave = [](__m256i r, __m256i g, __m256i b, __m256i r_shuffle, __m256i g_shuffle, __m256i b_shuffle) {
+    return _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(r, r_shuffle), _mm256_shuffle_epi8(g, g_shuffle)),
+                           _mm256_shuffle_epi8(b, b_shuffle));
+  };
+
+  // pixels 0-7 in both lanes, pixels 0-7 | 8-15, pixels 8-15 in both lanes
+  __m256i r_lo = _mm256_permute2x128_si256(r, r, 0x00);
+  __m256i g_lo = _mm256_permute2x128_si256(g, g, 0x00);
+  __m256i b_lo = _mm256_permute2x128_si256(b, b, 0x00);
+  __m256i r_hi = _mm256_permute2x128_si256(r, r, 0x11);
+  __m256i g_hi = _mm256_permute2x128_si256(g, g, 0x11);
+  __m256i b_hi = _mm256_permute2x128_si256(b, b, 0x11);
+
+  _mm256_storeu_si256((__m256i*) (out),
+                      interleave(r_lo, g_lo, b_lo, combine(r0, r1), combine(g0, g1), combine(b0, b1)));
+  _mm256_storeu_si256((__m256i*) (out + 32),
+                      interleave(r, g, b, combine(r2, r0), combine(g2, g0), combine(b2, b0)));
+  _mm256_storeu_si256((__m256i*) (out + 64),
+                      interleave(r_hi, g_hi, b_hi, combine(r1, r2), combine(g1, g2), combine(b1, b2)));
+}
+
+
+// Interleaves 16 pixels of 16 bit samples that are already in big-endian byte order into RRGGBBAA.
+static inline void store_rrggbbaa_16(uint8_t* out, __m256i r, __m256i g, __m256i b, __m256i a)
+{
+  __m256i rg_lo = _mm256_unpacklo_epi16(r, g);
+  __m256i rg_hi = _mm256_unpackhi_epi16(r, g);
+  __m256i ba_lo = _mm256_unpacklo_epi16(b, a);
+  __m256i ba_hi = _mm256_unpackhi_epi16(b, a);
+
+  store_unpacked_lanes(out,
+                       _mm256_unpacklo_epi32(rg_lo, ba_lo), _mm256_unpackhi_epi32(rg_lo, ba_lo),
+                       _mm256_unpacklo_epi32(rg_hi, ba_hi), _mm256_unpackhi_epi32(rg_hi, ba_hi));
+}
+
+
+// 16 samples as big-endian 16 bit values with a zero high byte
+static inline __m256i load_8_as_be16(const uint8_t* p)
+{
+  return _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) p)), 8);
+}
+
+
+static void rgb8_to_rrggbbaa_be_row_avx2(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                         uint8_t* out, uint32_t width, bool output_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  __m256i a = _mm256_set1_epi16(static_cast<short>(0xFF00));
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i r = load_8_as_be16(in_r + x);
+    __m256i g = load_8_as_be16(in_g + x);
+    __m256i b = load_8_as_be16(in_b + x);
+
+    if (output_alpha) {
+      if (in_a) {
+        a = load_8_as_be16(in_a + x);
+      }
+
+      store_rrggbbaa_16(out + 8 * x, r, g, b, a);
+    }
+    else {
+      store_rrggbb_16(out + 6 * x, r, g, b);
+    }
+  }
+
+  rgb8_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                 out + pixelsize * x, width - x, output_alpha);
+}
+
+
+static void rgb16_to_rrggbbaa_be_row_avx2(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                          uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  __m256i a = swap_bytes_16(_mm256_set1_epi16(static_cast<short>(default_alpha)));
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i r = swap_bytes_16(_mm256_loadu_si256((const __m256i*) (in_r + x)));
+    __m256i g = swap_bytes_16(_mm256_loadu_si256((const __m256i*) (in_g + x)));
+    __m256i b = swap_bytes_16(_mm256_loadu_si256((const __m256i*) (in_b + x)));
+
+    if (output_alpha) {
+      if (in_a) {
+        a = swap_bytes_16(_mm256_loadu_si256((const __m256i*) (in_a + x)));
+      }
+
+      store_rrggbbaa_16(out + 8 * x, r, g, b, a);
+    }
+    else {
+      store_rrggbb_16(out + 6 * x, r, g, b);
+    }
+  }
+
+  rgb16_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                  out + pixelsize * x, width - x, output_alpha, default_alpha);
+}
+
+
+extern const Interleaving_kernels interleave_kernels_avx2{
+  "avx2",
+  SpeedCosts_OptimizedSoftware,
+  mono_to_rgb24_row_avx2,
+  mono_to_rgba_row_avx2,
+  rgb8_to_rrggbbaa_be_row_avx2,
+  rgb16_to_rrggbbaa_be_row_avx2
+};
@@ -0,0 +1,130 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "interleave_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+
+
+void mono_to_rgb24_row_scalar(const uint8_t* in_y, uint8_t* out, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint8_t v = in_y[x];
+    out[3 * x + 0] = v;
+    out[3 * x + 1] = v;
+    out[3 * x + 2] = v;
+  }
+}
+
+
+void mono_to_rgba_row_scalar(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    uint8_t v = in_y[x];
+    out[4 * x + 0] = v;
+    out[4 * x + 1] = v;
+    out[4 * x + 2] = v;
+    out[4 * x + 3] = in_a ? in_a[x] : 0xFF;
+  }
+}
+
+
+void rgb8_to_rrggbbaa_be_row_scalar(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                    uint8_t* out, uint32_t width, bool output_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  for (uint32_t x = 0; x < width; x++) {
+    uint8_t* p = out + pixelsize * x;
+    p[0] = 0;
+    p[1] = in_r[x];
+    p[2] = 0;
+    p[3] = in_g[x];
+    p[4] = 0;
+    p[5] = in_b[x];
+
+    if (output_alpha) {
+      p[6] = 0;
+      p[7] = in_a ? in_a[x] : 0xFF;
+    }
+  }
+}
+
+
+void rgb16_to_rrggbbaa_be_row_scalar(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                     uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  for (uint32_t x = 0; x < width; x++) {
+    uint8_t* p = out + pixelsize * x;
+    p[0] = static_cast<uint8_t>(in_r[x] >> 8);
+    p[1] = static_cast<uint8_t>(in_r[x]);
+    p[2] = static_cast<uint8_t>(in_g[x] >> 8);
+    p[3] = static_cast<uint8_t>(in_g[x]);
+    p[4] = static_cast<uint8_t>(in_b[x] >> 8);
+    p[5] = static_cast<uint8_t>(in_b[x]);
+
+    if (output_alpha) {
+      uint16_t a = in_a ? in_a[x] : default_alpha;
+      p[6] = static_cast<uint8_t>(a >> 8);
+      p[7] = static_cast<uint8_t>(a);
+    }
+  }
+}
+
+
+static const Interleaving_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  mono_to_rgb24_row_scalar,
+  mono_to_rgba_row_scalar,
+  rgb8_to_rrggbbaa_be_row_scalar,
+  rgb16_to_rrggbbaa_be_row_scalar
+};
+
+extern const Interleaving_kernels interleave_kernels_sse41;
+extern const Interleaving_kernels interleave_kernels_avx2;
+extern const Interleaving_kernels interleave_kernels_neon;
+
+static const KernelDispatcher<Interleaving_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(interleave_kernels_sse41),
+  AVX2_KERNELS(interleave_kernels_avx2),
+  NEON_KERNELS(interleave_kernels_neon)
+};
+
+
+const Interleaving_kernels& get_scalar_Interleaving_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const Interleaving_kernels* get_simd_Interleaving_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const Interleaving_kernels*> get_supported_Interleaving_kernels()
+{
+  return dispatcher.get_supported();
+}
@@ -0,0 +1,77 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_INTERLEAVE_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_INTERLEAVE_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels that interleave planar monochrome and RGB images into RGB24/RGBA and big-endian RRGGBB(AA).
+//
+// These follow the same scheme as the YCbCr -> RGB kernels (see yuv2rgb_kernels.h): there is a scalar
+// reference implementation and vectorized implementations in translation units that are compiled with
+// SSE4.1, AVX2 or NEON enabled. The kernels only copy and rearrange bytes, they are bit-exact for all bit depths.
+
+struct Interleaving_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  // Y -> RGB24 with R=G=B=Y.
+  void (*mono_to_rgb24_row)(const uint8_t* in_y, uint8_t* out, uint32_t width);
+
+  // Y (+ alpha) -> RGBA. If 'in_a' is nullptr, alpha is set to 0xFF.
+  void (*mono_to_rgba_row)(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width);
+
+  // 8 bit planar RGB (+ alpha) -> RRGGBB(AA)_BE with the high bytes set to 0.
+  // If 'output_alpha' is set and 'in_a' is nullptr, alpha is set to 0xFF.
+  void (*rgb8_to_rrggbbaa_be_row)(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                  uint8_t* out, uint32_t width, bool output_alpha);
+
+  // 16 bit planar RGB (+ alpha) -> RRGGBB(AA)_BE.
+  // If 'output_alpha' is set and 'in_a' is nullptr, alpha is set to 'default_alpha'.
+  void (*rgb16_to_rrggbbaa_be_row)(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                   uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void mono_to_rgb24_row_scalar(const uint8_t* in_y, uint8_t* out, uint32_t width);
+
+void mono_to_rgba_row_scalar(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width);
+
+void rgb8_to_rrggbbaa_be_row_scalar(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                    uint8_t* out, uint32_t width, bool output_alpha);
+
+void rgb16_to_rrggbbaa_be_row_scalar(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                     uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha);
+
+
+const Interleaving_kernels& get_scalar_Interleaving_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const Interleaving_kernels* get_simd_Interleaving_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const Interleaving_kernels*> get_supported_Interleaving_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_INTERLEAVE_KERNELS_H
@@ -0,0 +1,174 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See interleave_kernels.h.
+
+#include "interleave_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+
+
+static inline uint16x8_t swap_bytes_16(uint16x8_t v)
+{
+  return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+}
+
+
+static void mono_to_rgb24_row_neon(const uint8_t* in_y, uint8_t* out, uint32_t width)
+{
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t y = vld1q_u8(in_y + x);
+
+    uint8x16x3_t rgb;
+    rgb.val[0] = y;
+    rgb.val[1] = y;
+    rgb.val[2] = y;
+    vst3q_u8(out + 3 * x, rgb);
+  }
+
+  mono_to_rgb24_row_scalar(in_y + x, out + 3 * x, width - x);
+}
+
+
+static void mono_to_rgba_row_neon(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width)
+{
+  uint8x16x4_t rgba;
+  rgba.val[3] = vdupq_n_u8(0xFF);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t y = vld1q_u8(in_y + x);
+
+    rgba.val[0] = y;
+    rgba.val[1] = y;
+    rgba.val[2] = y;
+    if (in_a) {
+      rgba.val[3] = vld1q_u8(in_a + x);
+    }
+
+    vst4q_u8(out + 4 * x, rgba);
+  }
+
+  mono_to_rgba_row_scalar(in_y + x, in_a ? in_a + x : nullptr, out + 4 * x, width - x);
+}
+
+
+static void rgb8_to_rrggbbaa_be_row_neon(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                         uint8_t* out, uint32_t width, bool output_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  // Shifting into the high byte of a little-endian 16 bit value gives a big-endian sample with a zero high byte.
+  uint16x8_t a_lo = vdupq_n_u16(0xFF00);
+  uint16x8_t a_hi = a_lo;
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16_t r = vld1q_u8(in_r + x);
+    uint8x16_t g = vld1q_u8(in_g + x);
+    uint8x16_t b = vld1q_u8(in_b + x);
+
+    if (output_alpha) {
+      if (in_a) {
+        uint8x16_t a = vld1q_u8(in_a + x);
+        a_lo = vshll_n_u8(vget_low_u8(a), 8);
+        a_hi = vshll_n_u8(vget_high_u8(a), 8);
+      }
+
+      uint16x8x4_t rgba;
+      rgba.val[0] = vshll_n_u8(vget_low_u8(r), 8);
+      rgba.val[1] = vshll_n_u8(vget_low_u8(g), 8);
+      rgba.val[2] = vshll_n_u8(vget_low_u8(b), 8);
+      rgba.val[3] = a_lo;
+      vst4q_u16((uint16_t*) (out + 8 * x), rgba);
+
+      rgba.val[0] = vshll_n_u8(vget_high_u8(r), 8);
+      rgba.val[1] = vshll_n_u8(vget_high_u8(g), 8);
+      rgba.val[2] = vshll_n_u8(vget_high_u8(b), 8);
+      rgba.val[3] = a_hi;
+      vst4q_u16((uint16_t*) (out + 8 * x + 64), rgba);
+    }
+    else {
+      uint16x8x3_t rgb;
+      rgb.val[0] = vshll_n_u8(vget_low_u8(r), 8);
+      rgb.val[1] = vshll_n_u8(vget_low_u8(g), 8);
+      rgb.val[2] = vshll_n_u8(vget_low_u8(b), 8);
+      vst3q_u16((uint16_t*) (out + 6 * x), rgb);
+
+      rgb.val[0] = vshll_n_u8(vget_high_u8(r), 8);
+      rgb.val[1] = vshll_n_u8(vget_high_u8(g), 8);
+      rgb.val[2] = vshll_n_u8(vget_high_u8(b), 8);
+      vst3q_u16((uint16_t*) (out + 6 * x + 48), rgb);
+    }
+  }
+
+  rgb8_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                 out + pixelsize * x, width - x, output_alpha);
+}
+
+
+static void rgb16_to_rrggbbaa_be_row_neon(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                          uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  uint16x8_t a = swap_bytes_16(vdupq_n_u16(default_alpha));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t r = swap_bytes_16(vld1q_u16(in_r + x));
+    uint16x8_t g = swap_bytes_16(vld1q_u16(in_g + x));
+    uint16x8_t b = swap_bytes_16(vld1q_u16(in_b + x));
+
+    if (output_alpha) {
+      if (in_a) {
+        a = swap_bytes_16(vld1q_u16(in_a + x));
+      }
+
+      uint16x8x4_t rgba;
+      rgba.val[0] = r;
+      rgba.val[1] = g;
+      rgba.val[2] = b;
+      rgba.val[3] = a;
+      vst4q_u16((uint16_t*) (out + 8 * x), rgba);
+    }
+    else {
+      uint16x8x3_t rgb;
+      rgb.val[0] = r;
+      rgb.val[1] = g;
+      rgb.val[2] = b;
+      vst3q_u16((uint16_t*) (out + 6 * x), rgb);
+    }
+  }
+
+  rgb16_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                  out + pixelsize * x, width - x, output_alpha, default_alpha);
+}
+
+
+extern const Interleaving_kernels interleave_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  mono_to_rgb24_row_neon,
+  mono_to_rgba_row_neon,
+  rgb8_to_rrggbbaa_be_row_neon,
+  rgb16_to_rrggbbaa_be_row_neon
+};
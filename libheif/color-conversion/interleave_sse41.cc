@@ -0,0 +1,192 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See interleave_kernels.h.
+
+#include "interleave_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+
+
+static inline __m128i swap_bytes_16(__m128i v)
+{
+  return _mm_shuffle_epi8(v, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+}
+
+
+static void mono_to_rgb24_row_sse41(const uint8_t* in_y, uint8_t* out, uint32_t width)
+{
+  // Each output byte 3*x+c is taken from y[x].
+  const __m128i shuffle0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+  const __m128i shuffle1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+  const __m128i shuffle2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i y = _mm_loadu_si128((const __m128i*) (in_y + x));
+
+    _mm_storeu_si128((__m128i*) (out + 3 * x), _mm_shuffle_epi8(y, shuffle0));
+    _mm_storeu_si128((__m128i*) (out + 3 * x + 16), _mm_shuffle_epi8(y, shuffle1));
+    _mm_storeu_si128((__m128i*) (out + 3 * x + 32), _mm_shuffle_epi8(y, shuffle2));
+  }
+
+  mono_to_rgb24_row_scalar(in_y + x, out + 3 * x, width - x);
+}
+
+
+static void mono_to_rgba_row_sse41(const uint8_t* in_y, const uint8_t* in_a, uint8_t* out, uint32_t width)
+{
+  __m128i a = _mm_set1_epi8(static_cast<char>(0xFF));
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i y = _mm_loadu_si128((const __m128i*) (in_y + x));
+    if (in_a) {
+      a = _mm_loadu_si128((const __m128i*) (in_a + x));
+    }
+
+    // YY and YA pairs, then YYYA quadruples
+    __m128i yy_lo = _mm_unpacklo_epi8(y, y);
+    __m128i yy_hi = _mm_unpackhi_epi8(y, y);
+    __m128i ya_lo = _mm_unpacklo_epi8(y, a);
+    __m128i ya_hi = _mm_unpackhi_epi8(y, a);
+
+    _mm_storeu_si128((__m128i*) (out + 4 * x), _mm_unpacklo_epi16(yy_lo, ya_lo));
+    _mm_storeu_si128((__m128i*) (out + 4 * x + 16), _mm_unpackhi_epi16(yy_lo, ya_lo));
+    _mm_storeu_si128((__m128i*) (out + 4 * x + 32), _mm_unpacklo_epi16(yy_hi, ya_hi));
+    _mm_storeu_si128((__m128i*) (out + 4 * x + 48), _mm_unpackhi_epi16(yy_hi, ya_hi));
+  }
+
+  mono_to_rgba_row_scalar(in_y + x, in_a ? in_a + x : nullptr, out + 4 * x, width - x);
+}
+
+
+// Interleaves 8 pixels of 16 bit samples that are already in big-endian byte order into RRGGBB.
+static inline void store_rrggbb_8(uint8_t* out, __m128i r, __m128i g, __m128i b)
+{
+  const __m128i r0 = _mm_setr_epi8(0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5, -1, -1);
+  const __m128i g0 = _mm_setr_epi8(-1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 4, 5);
+  const __m128i b0 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, -1, -1, -1, -1, 2, 3, -1, -1, -1, -1);
+  const __m128i r1 = _mm_setr_epi8(-1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 10, 11);
+  const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1, -1, -1);
+  const __m128i b1 = _mm_setr_epi8(4, 5, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, 8, 9, -1, -1);
+  const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, -1, 10, 11, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1, 14, 15);
+
+  __m128i o0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)), _mm_shuffle_epi8(b, b0));
+  __m128i o1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)), _mm_shuffle_epi8(b, b1));
+  __m128i o2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)), _mm_shuffle_epi8(b, b2));
+
+  _mm_storeu_si128((__m128i*) (out), o0);
+  _mm_storeu_si128((__m128i*) (out + 16), o1);
+  _mm_storeu_si128((__m128i*) (out + 32), o2);
+}
+
+
+// Interleaves 8 pixels of 16 bit samples that are already in big-endian byte order into RRGGBBAA.
+static inline void store_rrggbbaa_8(uint8_t* out, __m128i r, __m128i g, __m128i b, __m128i a)
+{
+  __m128i rg_lo = _mm_unpacklo_epi16(r, g);
+  __m128i rg_hi = _mm_unpackhi_epi16(r, g);
+  __m128i ba_lo = _mm_unpacklo_epi16(b, a);
+  __m128i ba_hi = _mm_unpackhi_epi16(b, a);
+
+  _mm_storeu_si128((__m128i*) (out), _mm_unpacklo_epi32(rg_lo, ba_lo));
+  _mm_storeu_si128((__m128i*) (out + 16), _mm_unpackhi_epi32(rg_lo, ba_lo));
+  _mm_storeu_si128((__m128i*) (out + 32), _mm_unpacklo_epi32(rg_hi, ba_hi));
+  _mm_storeu_si128((__m128i*) (out + 48), _mm_unpackhi_epi32(rg_hi, ba_hi));
+}
+
+
+static void rgb8_to_rrggbbaa_be_row_sse41(const uint8_t* in_r, const uint8_t* in_g, const uint8_t* in_b, const uint8_t* in_a,
+                                          uint8_t* out, uint32_t width, bool output_alpha)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  __m128i a = _mm_set1_epi8(static_cast<char>(0xFF));
+
+  // Unpacking with zero as the first operand gives big-endian 16 bit samples with a zero high byte.
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i r = _mm_loadu_si128((const __m128i*) (in_r + x));
+    __m128i g = _mm_loadu_si128((const __m128i*) (in_g + x));
+    __m128i b = _mm_loadu_si128((const __m128i*) (in_b + x));
+
+    if (output_alpha) {
+      if (in_a) {
+        a = _mm_loadu_si128((const __m128i*) (in_a + x));
+      }
+
+      store_rrggbbaa_8(out + 8 * x, _mm_unpacklo_epi8(zero, r), _mm_unpacklo_epi8(zero, g),
+                       _mm_unpacklo_epi8(zero, b), _mm_unpacklo_epi8(zero, a));
+      store_rrggbbaa_8(out + 8 * x + 64, _mm_unpackhi_epi8(zero, r), _mm_unpackhi_epi8(zero, g),
+                       _mm_unpackhi_epi8(zero, b), _mm_unpackhi_epi8(zero, a));
+    }
+    else {
+      store_rrggbb_8(out + 6 * x, _mm_unpacklo_epi8(zero, r), _mm_unpacklo_epi8(zero, g), _mm_unpacklo_epi8(zero, b));
+      store_rrggbb_8(out + 6 * x + 48, _mm_unpackhi_epi8(zero, r), _mm_unpackhi_epi8(zero, g), _mm_unpackhi_epi8(zero, b));
+    }
+  }
+
+  rgb8_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                 out + pixelsize * x, width - x, output_alpha);
+}
+
+
+static void rgb16_to_rrggbbaa_be_row_sse41(const uint16_t* in_r, const uint16_t* in_g, const uint16_t* in_b, const uint16_t* in_a,
+                                           uint8_t* out, uint32_t width, bool output_alpha, uint16_t default_alpha)
+{
+  const int pixelsize = (output_alpha ? 8 : 6);
+
+  __m128i a = swap_bytes_16(_mm_set1_epi16(static_cast<short>(default_alpha)));
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i r = swap_bytes_16(_mm_loadu_si128((const __m128i*) (in_r + x)));
+    __m128i g = swap_bytes_16(_mm_loadu_si128((const __m128i*) (in_g + x)));
+    __m128i b = swap_bytes_16(_mm_loadu_si128((const __m128i*) (in_b + x)));
+
+    if (output_alpha) {
+      if (in_a) {
+        a = swap_bytes_16(_mm_loadu_si128((const __m128i*) (in_a + x)));
+      }
+
+      store_rrggbbaa_8(out + 8 * x, r, g, b, a);
+    }
+    else {
+      store_rrggbb_8(out + 6 * x, r, g, b);
+    }
+  }
+
+  rgb16_to_rrggbbaa_be_row_scalar(in_r + x, in_g + x, in_b + x, in_a ? in_a + x : nullptr,
+                                  out + pixelsize * x, width - x, output_alpha, default_alpha);
+}
+
+
+extern const Interleaving_kernels interleave_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  mono_to_rgb24_row_sse41,
+  mono_to_rgba_row_sse41,
+  rgb8_to_rrggbbaa_be_row_sse41,
+  rgb16_to_rrggbbaa_be_row_sse41
+};
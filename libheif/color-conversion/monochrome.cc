@@ -18,6 +18,7 @@
  * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cstring>
 #include "monochrome.h"
 
@@ -129,11 +130,12 @@ Op_mono_to_YCbCr420::convert_colorspace(const std::shared_ptr<const HeifPixelIma
     out_cb_stride /= 2;
     out_cr_stride /= 2;
 
-    for (uint32_t y = 0; y < chroma_height; y++)
-      for (uint32_t x = 0; x < chroma_width; x++) {
-        out_cb[x + y * out_cb_stride] = (uint16_t) (128 << (input_bpp - 8));
-        out_cr[x + y * out_cr_stride] = (uint16_t) (128 << (input_bpp - 8));
-      }
+    auto chroma_value = static_cast<uint16_t>(1 << (input_bpp - 1));
+
+    for (uint32_t y = 0; y < chroma_height; y++) {
+      std::fill_n(out_cb + y * out_cb_stride, chroma_width, chroma_value);
+      std::fill_n(out_cr + y * out_cr_stride, chroma_width, chroma_value);
+    }
 
     for (uint32_t y = 0; y < height; y++) {
       memcpy(out_y + y * out_y_stride,
@@ -192,7 +194,7 @@ Op_mono_to_RGB24_32::state_after_conversion(const ColorState& input_state,
     output_state.has_alpha = false;
     output_state.bits_per_pixel = 8;
 
-    states.emplace_back(output_state, SpeedCosts_Unoptimized);
+    states.emplace_back(output_state, m_kernels->speed_costs);
   }
 
 
@@ -203,19 +205,19 @@ Op_mono_to_RGB24_32::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = true;
   output_state.bits_per_pixel = 8;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_mono_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                        const ColorState& input_state,
-                                        const ColorState& target_state,
-                                        const heif_color_conversion_options& options,
-                                        const heif_color_conversion_options_ext& options_ext,
-                                        const heif_security_limits* limits) const
+Op_mono_to_RGB24_32::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                         const ColorState& input_state,
+                                         const ColorState& target_state,
+                                         const heif_color_conversion_options& options,
+                                         const heif_color_conversion_options_ext& options_ext,
+                                         const heif_security_limits* limits) const
 {
   uint32_t width = input->get_width();
   uint32_t height = input->get_height();
@@ -226,8 +228,6 @@ Op_mono_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelIma
 
   auto outimg = std::make_shared<HeifPixelImage>();
 
-  bool has_alpha = input->has_channel(heif_channel_Alpha);
-
   if (target_state.has_alpha) {
     outimg->create(width, height, heif_colorspace_RGB, heif_chroma_interleaved_32bit);
   }
@@ -239,6 +239,23 @@ Op_mono_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelIma
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_mono_to_RGB24_32::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                    const std::shared_ptr<HeifPixelImage>& outimg,
+                                    const ColorState& input_state,
+                                    const ColorState& target_state,
+                                    const heif_color_conversion_options& options,
+                                    const heif_color_conversion_options_ext& options_ext,
+                                    uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+
   const uint8_t* in_y, * in_a = nullptr;
   size_t in_y_stride = 0, in_a_stride = 0;
 
@@ -252,37 +269,17 @@ Op_mono_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelIma
 
   out_p = outimg->get_channel_memory(heif_channel_interleaved, &out_p_stride);
 
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
+  for (uint32_t y = first_row; y < end_row; y++) {
     if (target_state.has_alpha == false) {
-      for (x = 0; x < width; x++) {
-        uint8_t v = in_y[x + y * in_y_stride];
-        out_p[y * out_p_stride + 3 * x + 0] = v;
-        out_p[y * out_p_stride + 3 * x + 1] = v;
-        out_p[y * out_p_stride + 3 * x + 2] = v;
-      }
-    }
-    else if (has_alpha) {
-      for (x = 0; x < width; x++) {
-        uint8_t v = in_y[x + y * in_y_stride];
-        out_p[y * out_p_stride + 4 * x + 0] = v;
-        out_p[y * out_p_stride + 4 * x + 1] = v;
-        out_p[y * out_p_stride + 4 * x + 2] = v;
-        out_p[y * out_p_stride + 4 * x + 3] = in_a[x + y * in_a_stride];
-      }
+      m_kernels->mono_to_rgb24_row(in_y + y * in_y_stride, out_p + y * out_p_stride, width);
     }
     else {
-      for (x = 0; x < width; x++) {
-        uint8_t v = in_y[x + y * in_y_stride];
-        out_p[y * out_p_stride + 4 * x + 0] = v;
-        out_p[y * out_p_stride + 4 * x + 1] = v;
-        out_p[y * out_p_stride + 4 * x + 2] = v;
-        out_p[y * out_p_stride + 4 * x + 3] = 0xFF;
-      }
+      m_kernels->mono_to_rgba_row(in_y + y * in_y_stride, has_alpha ? in_a + y * in_a_stride : nullptr,
+                                  out_p + y * out_p_stride, width);
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -22,6 +22,7 @@
 #define LIBHEIF_COLORCONVERSION_MONOCHROME_H
 
 #include "colorconversion.h"
+#include "interleave_kernels.h"
 #include <vector>
 #include <memory>
 
@@ -45,9 +46,12 @@ public:
 };
 
 
-class Op_mono_to_RGB24_32 : public ColorConversionOperation
+class Op_mono_to_RGB24_32 : public StripedColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_mono_to_RGB24_32(const Interleaving_kernels& kernels = get_scalar_Interleaving_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -55,12 +59,24 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const Interleaving_kernels* m_kernels;
 };
 
 #endif //LIBHEIF_COLORCONVERSION_MONOCHROME_H
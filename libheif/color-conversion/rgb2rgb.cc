@@ -21,6 +21,7 @@
 #include <algorithm>
 #include <cassert>
 #include <memory>
+#include <utility>
 #include <vector>
 #include "rgb2rgb.h"
 
@@ -69,12 +70,12 @@ Op_RGB_to_RGB24_32::state_after_conversion(const ColorState& input_state,
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_RGB_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                       const ColorState& input_state,
-                                       const ColorState& target_state,
-                                       const heif_color_conversion_options& options,
-                                       const heif_color_conversion_options_ext& options_ext,
-                                       const heif_security_limits* limits) const
+Op_RGB_to_RGB24_32::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                        const ColorState& input_state,
+                                        const ColorState& target_state,
+                                        const heif_color_conversion_options& options,
+                                        const heif_color_conversion_options_ext& options_ext,
+                                        const heif_security_limits* limits) const
 {
   bool has_alpha = input->has_channel(heif_channel_Alpha);
   bool want_alpha = target_state.has_alpha;
@@ -101,6 +102,24 @@ Op_RGB_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImag
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_RGB_to_RGB24_32::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                   const std::shared_ptr<HeifPixelImage>& outimg,
+                                   const ColorState& input_state,
+                                   const ColorState& target_state,
+                                   const heif_color_conversion_options& options,
+                                   const heif_color_conversion_options_ext& options_ext,
+                                   uint32_t first_row, uint32_t end_row) const
+{
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+  bool want_alpha = target_state.has_alpha;
+
+  uint32_t width = input->get_width();
+
   const uint8_t* in_r, * in_g, * in_b, * in_a = nullptr;
   size_t in_r_stride = 0, in_g_stride = 0, in_b_stride = 0, in_a_stride = 0;
 
@@ -117,7 +136,7 @@ Op_RGB_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImag
   }
 
   uint32_t x, y;
-  for (y = 0; y < height; y++) {
+  for (y = first_row; y < end_row; y++) {
 
     if (has_alpha && want_alpha) {
       for (x = 0; x < width; x++) {
@@ -146,7 +165,7 @@ Op_RGB_to_RGB24_32::convert_colorspace(const std::shared_ptr<const HeifPixelImag
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -180,7 +199,7 @@ Op_RGB_HDR_to_RRGGBBaa_BE::state_after_conversion(const ColorState& input_state,
     output_state.has_alpha = false;
     output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-    states.emplace_back(output_state, SpeedCosts_Unoptimized);
+    states.emplace_back(output_state, m_kernels->speed_costs);
   }
 
 
@@ -191,7 +210,7 @@ Op_RGB_HDR_to_RRGGBBaa_BE::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = true;
   output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
 
   return states;
@@ -199,12 +218,12 @@ Op_RGB_HDR_to_RRGGBBaa_BE::state_after_conversion(const ColorState& input_state,
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_RGB_HDR_to_RRGGBBaa_BE::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                              const ColorState& input_state,
-                                              const ColorState& target_state,
-                                              const heif_color_conversion_options& options,
-                                              const heif_color_conversion_options_ext& options_ext,
-                                              const heif_security_limits* limits) const
+Op_RGB_HDR_to_RRGGBBaa_BE::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                               const ColorState& input_state,
+                                               const ColorState& target_state,
+                                               const heif_color_conversion_options& options,
+                                               const heif_color_conversion_options_ext& options_ext,
+                                               const heif_security_limits* limits) const
 {
   if (input->get_bits_per_pixel(heif_channel_R) <= 8 ||
       input->get_bits_per_pixel(heif_channel_G) <= 8 ||
@@ -239,6 +258,25 @@ Op_RGB_HDR_to_RRGGBBaa_BE::convert_colorspace(const std::shared_ptr<const HeifPi
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_RGB_HDR_to_RRGGBBaa_BE::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                          const std::shared_ptr<HeifPixelImage>& outimg,
+                                          const ColorState& input_state,
+                                          const ColorState& target_state,
+                                          const heif_color_conversion_options& options,
+                                          const heif_color_conversion_options_ext& options_ext,
+                                          uint32_t first_row, uint32_t end_row) const
+{
+  bool input_has_alpha = input->has_channel(heif_channel_Alpha);
+  bool output_has_alpha = input_has_alpha || target_state.has_alpha;
+
+  int bpp = input->get_bits_per_pixel(heif_channel_R);
+  uint32_t width = input->get_width();
+
   const uint16_t* in_r, * in_g, * in_b, * in_a = nullptr;
   size_t in_r_stride = 0, in_g_stride = 0, in_b_stride = 0, in_a_stride = 0;
 
@@ -265,30 +303,14 @@ Op_RGB_HDR_to_RRGGBBaa_BE::convert_colorspace(const std::shared_ptr<const HeifPi
   in_b_stride /= 2;
   in_a_stride /= 2;
 
-  const int pixelsize = (output_has_alpha ? 8 : 6);
-
-  uint32_t x, y;
   auto alpha_max = static_cast<uint16_t>((1 << bpp) - 1);
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < width; x++) {
-      uint16_t r = in_r[x + y * in_r_stride];
-      uint16_t g = in_g[x + y * in_g_stride];
-      uint16_t b = in_b[x + y * in_b_stride];
-      out_p[y * out_p_stride + pixelsize * x + 0] = (uint8_t)(r >> 8);
-      out_p[y * out_p_stride + pixelsize * x + 1] = (uint8_t)(r & 0xFF);
-      out_p[y * out_p_stride + pixelsize * x + 2] = (uint8_t)(g >> 8);
-      out_p[y * out_p_stride + pixelsize * x + 3] = (uint8_t)(g & 0xFF);
-      out_p[y * out_p_stride + pixelsize * x + 4] = (uint8_t)(b >> 8);
-      out_p[y * out_p_stride + pixelsize * x + 5] = (uint8_t)(b & 0xFF);
-      if (output_has_alpha) {
-        uint16_t a = input_has_alpha ? in_a[x + y * in_a_stride] : alpha_max;
-        out_p[y * out_p_stride + pixelsize * x + 6] = (uint8_t)(a >> 8);
-        out_p[y * out_p_stride + pixelsize * x + 7] = (uint8_t)(a & 0xFF);
-      }
-    }
+  for (uint32_t y = first_row; y < end_row; y++) {
+    m_kernels->rgb16_to_rrggbbaa_be_row(in_r + y * in_r_stride, in_g + y * in_g_stride, in_b + y * in_b_stride,
+                                        input_has_alpha ? in_a + y * in_a_stride : nullptr,
+                                        out_p + y * out_p_stride, width, output_has_alpha, alpha_max);
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -322,7 +344,7 @@ Op_RGB_to_RRGGBBaa_BE::state_after_conversion(const ColorState& input_state,
     output_state.has_alpha = false;
     output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-    states.emplace_back(output_state, SpeedCosts_Unoptimized);
+    states.emplace_back(output_state, m_kernels->speed_costs);
   }
 
 
@@ -333,7 +355,7 @@ Op_RGB_to_RRGGBBaa_BE::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = true;
   output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
@@ -389,38 +411,10 @@ Op_RGB_to_RRGGBBaa_BE::convert_colorspace(const std::shared_ptr<const HeifPixelI
     in_a = input->get_channel_memory(heif_channel_Alpha, &in_a_stride);
   }
 
-  const int pixelsize = (output_has_alpha ? 8 : 6);
-
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
-
-    if (input_has_alpha) {
-      for (x = 0; x < width; x++) {
-        out_p[y * out_p_stride + 8 * x + 0] = 0;
-        out_p[y * out_p_stride + 8 * x + 1] = in_r[x + y * in_r_stride];
-        out_p[y * out_p_stride + 8 * x + 2] = 0;
-        out_p[y * out_p_stride + 8 * x + 3] = in_g[x + y * in_g_stride];
-        out_p[y * out_p_stride + 8 * x + 4] = 0;
-        out_p[y * out_p_stride + 8 * x + 5] = in_b[x + y * in_b_stride];
-        out_p[y * out_p_stride + 8 * x + 6] = 0;
-        out_p[y * out_p_stride + 8 * x + 7] = in_a[x + y * in_a_stride];
-      }
-    }
-    else {
-      for (x = 0; x < width; x++) {
-        out_p[y * out_p_stride + pixelsize * x + 0] = 0;
-        out_p[y * out_p_stride + pixelsize * x + 1] = in_r[x + y * in_r_stride];
-        out_p[y * out_p_stride + pixelsize * x + 2] = 0;
-        out_p[y * out_p_stride + pixelsize * x + 3] = in_g[x + y * in_g_stride];
-        out_p[y * out_p_stride + pixelsize * x + 4] = 0;
-        out_p[y * out_p_stride + pixelsize * x + 5] = in_b[x + y * in_b_stride];
-
-        if (output_has_alpha) {
-          out_p[y * out_p_stride + pixelsize * x + 6] = 0;
-          out_p[y * out_p_stride + pixelsize * x + 7] = 0xFF;
-        }
-      }
-    }
+  for (uint32_t y = 0; y < height; y++) {
+    m_kernels->rgb8_to_rrggbbaa_be_row(in_r + y * in_r_stride, in_g + y * in_g_stride, in_b + y * in_b_stride,
+                                       input_has_alpha ? in_a + y * in_a_stride : nullptr,
+                                       out_p + y * out_p_stride, width, output_has_alpha);
   }
 
   return outimg;
@@ -762,3 +756,51 @@ Op_RRGGBBaa_swap_endianness::convert_colorspace(const std::shared_ptr<const Heif
 
   return outimg;
 }
+
+
+Error
+Op_RRGGBBaa_swap_endianness::convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                                                        const ColorState& input_state,
+                                                        const ColorState& target_state,
+                                                        const heif_color_conversion_options& options,
+                                                        const heif_color_conversion_options_ext& options_ext,
+                                                        const heif_security_limits* limits) const
+{
+  heif_chroma output_chroma;
+
+  switch (image->get_chroma_format()) {
+    case heif_chroma_interleaved_RRGGBB_LE:
+      output_chroma = heif_chroma_interleaved_RRGGBB_BE;
+      break;
+    case heif_chroma_interleaved_RRGGBB_BE:
+      output_chroma = heif_chroma_interleaved_RRGGBB_LE;
+      break;
+    case heif_chroma_interleaved_RRGGBBAA_LE:
+      output_chroma = heif_chroma_interleaved_RRGGBBAA_BE;
+      break;
+    case heif_chroma_interleaved_RRGGBBAA_BE:
+      output_chroma = heif_chroma_interleaved_RRGGBBAA_LE;
+      break;
+    default:
+      return Error::InternalError;
+  }
+
+  uint32_t width = image->get_width();
+  uint32_t height = image->get_height();
+
+  size_t stride;
+  uint8_t* p = image->get_channel_memory(heif_channel_interleaved, &stride);
+
+  size_t n_bytes = static_cast<size_t>(width) * image->get_storage_bits_per_pixel(heif_channel_interleaved) / 8;
+
+  for (uint32_t y = 0; y < height; y++) {
+    uint8_t* row = p + y * stride;
+    for (size_t x = 0; x < n_bytes; x += 2) {
+      std::swap(row[x], row[x + 1]);
+    }
+  }
+
+  image->set_chroma_format(output_chroma);
+
+  return Error::Ok;
+}
@@ -22,11 +22,12 @@
 #define LIBHEIF_RGB2RGB_H
 
 #include "colorconversion.h"
+#include "interleave_kernels.h"
 #include <vector>
 #include <memory>
 
 
-class Op_RGB_to_RGB24_32 : public ColorConversionOperation
+class Op_RGB_to_RGB24_32 : public StripedColorConversionOperation
 {
 public:
   std::vector<ColorStateWithCost>
@@ -36,18 +37,30 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
 };
 
 
-class Op_RGB_HDR_to_RRGGBBaa_BE : public ColorConversionOperation
+class Op_RGB_HDR_to_RRGGBBaa_BE : public StripedColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_RGB_HDR_to_RRGGBBaa_BE(const Interleaving_kernels& kernels = get_scalar_Interleaving_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -55,18 +68,33 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const Interleaving_kernels* m_kernels;
 };
 
 
 class Op_RGB_to_RRGGBBaa_BE : public ColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_RGB_to_RRGGBBaa_BE(const Interleaving_kernels& kernels = get_scalar_Interleaving_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -80,6 +108,9 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+private:
+  const Interleaving_kernels* m_kernels;
 };
 
 
@@ -137,6 +168,16 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+  bool supports_inplace_conversion() const override { return true; }
+
+  Error
+  convert_colorspace_inplace(const std::shared_ptr<HeifPixelImage>& image,
+                             const ColorState& input_state,
+                             const ColorState& target_state,
+                             const heif_color_conversion_options& options,
+                             const heif_color_conversion_options_ext& options_ext,
+                             const heif_security_limits* limits) const override;
 };
 
 
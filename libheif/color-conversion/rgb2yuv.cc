@@ -62,6 +62,10 @@ Op_RGB_to_YCbCr<Pixel>::state_after_conversion(const ColorState& input_state,
   //   BT.2020 NCL. A correct CL path needs OETF application before deriving Y'C, not the
   //   linear matrix below.
 
+  // The special matrices are not handled by the kernels.
+  bool uses_kernels = (matrix != 0 && matrix != 8);
+  int costs = uses_kernels ? m_kernels->speed_costs : SpeedCosts_Unoptimized;
+
   std::vector<ColorStateWithCost> states;
 
   ColorState output_state;
@@ -80,7 +84,7 @@ Op_RGB_to_YCbCr<Pixel>::state_after_conversion(const ColorState& input_state,
     output_state.bits_per_pixel = input_state.bits_per_pixel;
     output_state.nclx = target_state.nclx;
 
-    states.emplace_back(output_state, SpeedCosts_Unoptimized);
+    states.emplace_back(output_state, costs);
   }
   else {
     // --- convert to YCbCr 4:4:4
@@ -91,7 +95,7 @@ Op_RGB_to_YCbCr<Pixel>::state_after_conversion(const ColorState& input_state,
     output_state.bits_per_pixel = input_state.bits_per_pixel;
     output_state.nclx = target_state.nclx;
 
-    states.emplace_back(output_state, SpeedCosts_Unoptimized);
+    states.emplace_back(output_state, costs);
   }
 
   return states;
@@ -99,12 +103,12 @@ Op_RGB_to_YCbCr<Pixel>::state_after_conversion(const ColorState& input_state,
 
 template<class Pixel>
 Result<std::shared_ptr<HeifPixelImage>>
-Op_RGB_to_YCbCr<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                           const ColorState& input_state,
-                                           const ColorState& target_state,
-                                           const heif_color_conversion_options& options,
-                                           const heif_color_conversion_options_ext& options_ext,
-                                           const heif_security_limits* limits) const
+Op_RGB_to_YCbCr<Pixel>::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                            const ColorState& input_state,
+                                            const ColorState& target_state,
+                                            const heif_color_conversion_options& options,
+                                            const heif_color_conversion_options_ext& options_ext,
+                                            const heif_security_limits* limits) const
 {
   bool hdr = !std::is_same<Pixel, uint8_t>::value;
 
@@ -145,6 +149,33 @@ Op_RGB_to_YCbCr<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
     }
   }
 
+  return outimg;
+}
+
+
+template<class Pixel>
+Error
+Op_RGB_to_YCbCr<Pixel>::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                       const std::shared_ptr<HeifPixelImage>& outimg,
+                                       const ColorState& input_state,
+                                       const ColorState& target_state,
+                                       const heif_color_conversion_options& options,
+                                       const heif_color_conversion_options_ext& options_ext,
+                                       uint32_t first_row, uint32_t end_row) const
+{
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
+
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+
+  heif_chroma chroma = target_state.chroma;
+  int subH = chroma_h_subsampling(chroma);
+  int subV = chroma_v_subsampling(chroma);
+
+  int bpp = input->get_bits_per_pixel(heif_channel_R);
+
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+
   const Pixel* in_r, * in_g, * in_b;
   size_t in_r_stride = 0, in_g_stride = 0, in_b_stride = 0, in_a_stride = 0;
 
@@ -191,9 +222,38 @@ Op_RGB_to_YCbCr<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
   coeffs = get_RGB_to_YCbCr_coefficients(target_state.nclx.get_matrix_coefficients(),
                                          target_state.nclx.get_colour_primaries());
 
+  RGB_to_YCbCr_float_parameters params{};
+  memcpy(params.c, coeffs.c, sizeof(params.c));
+  params.full_range = full_range_flag;
+  params.limited_range_offset = limited_range_offset;
+  params.chroma_offset = halfRange;
+  params.max_value = fullRange;
+
+  // The special matrices are not handled by the kernels.
+  bool use_kernels = (matrix_coeffs != 0 && matrix_coeffs != 8);
+
   uint32_t x, y;
 
-  for (y = 0; y < height; y++) {
+  for (y = first_row; y < end_row; y++) {
+    if (use_kernels) {
+      if (hdr) {
+        m_kernels->rgb_to_y_row_16((const uint16_t*) &in_r[y * in_r_stride],
+                                   (const uint16_t*) &in_g[y * in_g_stride],
+                                   (const uint16_t*) &in_b[y * in_b_stride],
+                                   (uint16_t*) &out_y[y * out_y_stride],
+                                   width, params);
+      }
+      else {
+        m_kernels->rgb_to_y_row_8((const uint8_t*) &in_r[y * in_r_stride],
+                                  (const uint8_t*) &in_g[y * in_g_stride],
+                                  (const uint8_t*) &in_b[y * in_b_stride],
+                                  (uint8_t*) &out_y[y * out_y_stride],
+                                  width, params);
+      }
+
+      continue;
+    }
+
     for (x = 0; x < width; x++) {
       if (matrix_coeffs == 0) {
         if (full_range_flag) {
@@ -226,7 +286,57 @@ Op_RGB_to_YCbCr<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
     }
   }
 
-  for (y = 0; y < height; y += subV) {
+  for (y = first_row; y < end_row; y += subV) {
+    if (use_kernels && subH == 1 && subV == 1) {
+      if (hdr) {
+        m_kernels->rgb_to_cbcr_row_16((const uint16_t*) &in_r[y * in_r_stride],
+                                      (const uint16_t*) &in_g[y * in_g_stride],
+                                      (const uint16_t*) &in_b[y * in_b_stride],
+                                      (uint16_t*) &out_cb[y * out_cb_stride],
+                                      (uint16_t*) &out_cr[y * out_cr_stride],
+                                      width, params);
+      }
+      else {
+        m_kernels->rgb_to_cbcr_row_8((const uint8_t*) &in_r[y * in_r_stride],
+                                     (const uint8_t*) &in_g[y * in_g_stride],
+                                     (const uint8_t*) &in_b[y * in_b_stride],
+                                     (uint8_t*) &out_cb[y * out_cb_stride],
+                                     (uint8_t*) &out_cr[y * out_cr_stride],
+                                     width, params);
+      }
+
+      continue;
+    }
+
+    if (use_kernels && subH == 2 && subV == 2) {
+      uint32_t y2 = (y + 1 < height) ? y + 1 : y;
+
+      if (hdr) {
+        m_kernels->rgb_to_cbcr420_row_16((const uint16_t*) &in_r[y * in_r_stride],
+                                         (const uint16_t*) &in_g[y * in_g_stride],
+                                         (const uint16_t*) &in_b[y * in_b_stride],
+                                         (const uint16_t*) &in_r[y2 * in_r_stride],
+                                         (const uint16_t*) &in_g[y2 * in_g_stride],
+                                         (const uint16_t*) &in_b[y2 * in_b_stride],
+                                         (uint16_t*) &out_cb[(y / 2) * out_cb_stride],
+                                         (uint16_t*) &out_cr[(y / 2) * out_cr_stride],
+                                         width, params);
+      }
+      else {
+        m_kernels->rgb_to_cbcr420_row_8((const uint8_t*) &in_r[y * in_r_stride],
+                                        (const uint8_t*) &in_g[y * in_g_stride],
+                                        (const uint8_t*) &in_b[y * in_b_stride],
+                                        (const uint8_t*) &in_r[y2 * in_r_stride],
+                                        (const uint8_t*) &in_g[y2 * in_g_stride],
+                                        (const uint8_t*) &in_b[y2 * in_b_stride],
+                                        (uint8_t*) &out_cb[(y / 2) * out_cb_stride],
+                                        (uint8_t*) &out_cr[(y / 2) * out_cr_stride],
+                                        width, params);
+      }
+
+      continue;
+    }
+
     for (x = 0; x < width; x += subH) {
       if (matrix_coeffs == 0) {
         if (full_range_flag) {
@@ -296,12 +406,12 @@ Op_RGB_to_YCbCr<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
     int bpp_a = input->get_bits_per_pixel(heif_channel_Alpha);
     int alphaCopyWidth = (bpp_a > 8 ? width * 2 : width);
 
-    for (y = 0; y < height; y++) {
+    for (y = first_row; y < end_row; y++) {
       memcpy(&out_a[y * out_a_stride], &in_a[y * in_a_stride], alphaCopyWidth);
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 template class Op_RGB_to_YCbCr<uint8_t>;
@@ -547,7 +657,7 @@ Op_RGB24_32_to_YCbCr::state_after_conversion(const ColorState& input_state,
   output_state.bits_per_pixel = 8;
   output_state.nclx = target_state.nclx;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
@@ -573,12 +683,12 @@ inline void set_chroma_pixels(uint8_t* out_cb, uint8_t* out_cr,
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                         const ColorState& input_state,
-                                         const ColorState& target_state,
-                                         const heif_color_conversion_options& options,
-                                         const heif_color_conversion_options_ext& options_ext,
-                                         const heif_security_limits* limits) const
+Op_RGB24_32_to_YCbCr::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                          const ColorState& input_state,
+                                          const ColorState& target_state,
+                                          const heif_color_conversion_options& options,
+                                          const heif_color_conversion_options_ext& options_ext,
+                                          const heif_security_limits* limits) const
 {
   uint32_t width = input->get_width();
   uint32_t height = input->get_height();
@@ -594,7 +704,6 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
   int chroma_width = (width + chromaSubH - 1) / chromaSubH;
   int chroma_height = (height + chromaSubV - 1) / chromaSubV;
 
-  const bool has_alpha = (input->get_chroma_format() == heif_chroma_interleaved_32bit);
   const bool want_alpha = target_state.has_alpha;
 
   if (auto err = outimg->add_channel(heif_channel_Y, width, height, 8, limits) ||
@@ -609,6 +718,29 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
     }
   }
 
+  return outimg;
+}
+
+
+Error
+Op_RGB24_32_to_YCbCr::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                     const std::shared_ptr<HeifPixelImage>& outimg,
+                                     const ColorState& input_state,
+                                     const ColorState& target_state,
+                                     const heif_color_conversion_options& options,
+                                     const heif_color_conversion_options_ext& options_ext,
+                                     uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+  uint32_t height = input->get_height();
+
+  auto chroma = target_state.chroma;
+  uint8_t chromaSubH = chroma_h_subsampling(chroma);
+  uint8_t chromaSubV = chroma_v_subsampling(chroma);
+
+  const bool has_alpha = (input->get_chroma_format() == heif_chroma_interleaved_32bit);
+  const bool want_alpha = target_state.has_alpha;
+
   uint8_t* out_cb, * out_cr, * out_y, * out_a;
   size_t out_cb_stride = 0, out_cr_stride = 0, out_y_stride = 0, out_a_stride = 0;
 
@@ -636,32 +768,21 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
                                          target_state.nclx.get_colour_primaries());
 
 
-  int bytes_per_pixel = (has_alpha ? 4 : 3);
+  RGB_to_YCbCr_float_parameters params{};
+  memcpy(params.c, coeffs.c, sizeof(params.c));
+  params.full_range = full_range_flag;
 
-  for (uint32_t y = 0; y < height; y++) {
-    const uint8_t* p = &in_p[y * in_stride];
-
-    for (uint32_t x = 0; x < width; x++) {
-      uint8_t r = p[0];
-      uint8_t g = p[1];
-      uint8_t b = p[2];
-      p += bytes_per_pixel;
-
-      float yv = r * coeffs.c[0][0] + g * coeffs.c[0][1] + b * coeffs.c[0][2];
+  int bytes_per_pixel = (has_alpha ? 4 : 3);
 
-      if (full_range_flag) {
-        out_y[y * out_y_stride + x] = clip_f_u8(yv);
-      }
-      else {
-        out_y[y * out_y_stride + x] = (uint8_t) (clip_f_u16(yv * 0.85547f, 219) + 16);
-      }
-    }
+  for (uint32_t y = first_row; y < end_row; y++) {
+    m_kernels->rgb_interleaved_to_y_row(&in_p[y * in_stride], bytes_per_pixel,
+                                        &out_y[y * out_y_stride], width, params);
   }
 
   if (chromaSubH == 1 && chromaSubV == 1) {
     // chroma 4:4:4
 
-    for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t y = first_row; y < end_row; y++) {
       const uint8_t* p = &in_p[y * in_stride];
 
       for (uint32_t x = 0; x < width; x++) {
@@ -680,29 +801,20 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
   else if (chromaSubH == 2 && chromaSubV == 2) {
     // chroma 4:2:0
 
-    for (uint32_t y = 0; y < (height & ~1U); y += 2) {
-      const uint8_t* p = &in_p[y * in_stride];
-
-      for (uint32_t x = 0; x < (width & ~1U); x += 2) {
-        uint8_t r = uint8_t((p[0] + p[bytes_per_pixel + 0] + p[in_stride + 0] + p[bytes_per_pixel + in_stride + 0]) / 4);
-        uint8_t g = uint8_t((p[1] + p[bytes_per_pixel + 1] + p[in_stride + 1] + p[bytes_per_pixel + in_stride + 1]) / 4);
-        uint8_t b = uint8_t((p[2] + p[bytes_per_pixel + 2] + p[in_stride + 2] + p[bytes_per_pixel + in_stride + 2]) / 4);
-
-        p += bytes_per_pixel * 2;
-
-        set_chroma_pixels(out_cb + (y / 2) * out_cb_stride + (x / 2),
-                          out_cr + (y / 2) * out_cr_stride + (x / 2),
-                          r, g, b,
-                          coeffs, full_range_flag);
-      }
+    // Stripes start at even rows. Only the last stripe can end at an odd row.
+    for (uint32_t y = first_row; y + 1 < end_row; y += 2) {
+      m_kernels->rgb_interleaved_to_cbcr420_row(&in_p[y * in_stride], &in_p[(y + 1) * in_stride], bytes_per_pixel,
+                                                out_cb + (y / 2) * out_cb_stride,
+                                                out_cr + (y / 2) * out_cr_stride,
+                                                width / 2, params);
     }
 
     // 4:2:0 right column (if odd width)
     if (width & 1) {
       uint32_t x = width - 1;
-      const uint8_t* p = &in_p[x * bytes_per_pixel];
+      const uint8_t* p = &in_p[first_row * in_stride + x * bytes_per_pixel];
 
-      for (uint32_t y = 0; y < height; y += 2) {
+      for (uint32_t y = first_row; y < end_row; y += 2) {
         uint8_t r, g, b;
         if (y + 1 < height) {
           r = uint8_t((p[0] + p[in_stride + 0]) / 2);
@@ -725,7 +837,7 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
     }
 
     // 4:2:0 bottom row (if odd height)
-    if (height & 1) {
+    if ((height & 1) && end_row == height) {
       uint32_t y = height - 1;
       const uint8_t* p = &in_p[y * in_stride];
 
@@ -754,7 +866,7 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
   else if (chromaSubH == 2 && chromaSubV == 1) {
     // chroma 4:2:2
 
-    for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t y = first_row; y < end_row; y++) {
       const uint8_t* p = &in_p[y * in_stride];
 
       for (uint32_t x = 0; x < width; x += 2) {
@@ -795,7 +907,7 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
       assert(bytes_per_pixel == 4);
     }
 
-    for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t y = first_row; y < end_row; y++) {
       for (uint32_t x = 0; x < width; x++) {
         uint8_t a = has_alpha ? in_p[y * in_stride + x * 4 + 3] : 0xff;
 
@@ -805,7 +917,7 @@ Op_RGB24_32_to_YCbCr::convert_colorspace(const std::shared_ptr<const HeifPixelIm
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -22,14 +22,18 @@
 #define LIBHEIF_COLORCONVERSION_RGB2YUV_H
 
 #include "color-conversion/colorconversion.h"
+#include "color-conversion/rgb2yuv_kernels.h"
 #include <vector>
 #include <memory>
 
 
 template<class Pixel>
-class Op_RGB_to_YCbCr : public ColorConversionOperation
+class Op_RGB_to_YCbCr : public StripedColorConversionOperation
 {
 public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_RGB_to_YCbCr(const RGB_to_YCbCr_kernels& kernels = get_scalar_RGB_to_YCbCr_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -37,12 +41,24 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const RGB_to_YCbCr_kernels* m_kernels;
 };
 
 
@@ -66,9 +82,11 @@ public:
 };
 
 
-class Op_RGB24_32_to_YCbCr : public ColorConversionOperation
+class Op_RGB24_32_to_YCbCr : public StripedColorConversionOperation
 {
 public:
+  explicit Op_RGB24_32_to_YCbCr(const RGB_to_YCbCr_kernels& kernels = get_scalar_RGB_to_YCbCr_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -76,12 +94,24 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const RGB_to_YCbCr_kernels* m_kernels;
 };
 
 
@@ -0,0 +1,453 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. See rgb2yuv_kernels.h.
+
+#include "rgb2yuv_kernels.h"
+#include "colorconversion.h"
+#include <immintrin.h>
+#include <cstring>
+
+
+static inline __m256i load_8_as_epi32(const uint8_t* p)
+{
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) p));
+}
+
+static inline __m256i load_8_as_epi32(const uint16_t* p)
+{
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) p));
+}
+
+static inline void store_8(uint8_t* p, __m256i v)
+{
+  __m128i v16 = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  _mm_storel_epi64((__m128i*) p, _mm_packus_epi16(v16, v16));
+}
+
+static inline void store_8(uint16_t* p, __m256i v)
+{
+  _mm_storeu_si128((__m128i*) p, _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+
+// Same as clip_f_u16(): rounds by adding 0.5 and truncating, then clips to [0;max_value].
+static inline __m256i to_pixel(__m256 v, __m256i max_value)
+{
+  __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(v, _mm256_set1_ps(0.5f)));
+  return _mm256_min_epi32(_mm256_max_epi32(i, _mm256_setzero_si256()), max_value);
+}
+
+
+// Computes c[0]*r + c[1]*g + c[2]*b in the same order as the scalar code.
+static inline __m256 weighted_sum(const float c[3], __m256 r, __m256 g, __m256 b)
+{
+  return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r, _mm256_set1_ps(c[0])),
+                                     _mm256_mul_ps(g, _mm256_set1_ps(c[1]))),
+                       _mm256_mul_ps(b, _mm256_set1_ps(c[2])));
+}
+
+
+static inline __m256i combine(__m128i lo, __m128i hi)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+
+// --- interleaved RGB input
+
+// Shuffle mask that extracts one channel of 4 interleaved pixels into 32-bit lanes.
+static inline __m128i channel_mask(int bytes_per_pixel, int channel)
+{
+  auto idx = [&](int i) { return (char) (i * bytes_per_pixel + channel); };
+  return _mm_setr_epi8(idx(0), -1, -1, -1, idx(1), -1, -1, -1, idx(2), -1, -1, -1, idx(3), -1, -1, -1);
+}
+
+
+// Extracts one channel of 8 interleaved pixels.
+static inline __m256 load_channel_8(const uint8_t* p, int bytes_per_pixel, __m128i mask)
+{
+  __m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) p), mask);
+  __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (p + 4 * bytes_per_pixel)), mask);
+  return _mm256_cvtepi32_ps(combine(lo, hi));
+}
+
+
+static void rgb_interleaved_to_y_row_avx2(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                          const RGB_to_YCbCr_float_parameters& params)
+{
+  const __m128i mask_r = channel_mask(bytes_per_pixel, 0);
+  const __m128i mask_g = channel_mask(bytes_per_pixel, 1);
+  const __m128i mask_b = channel_mask(bytes_per_pixel, 2);
+  const __m256i max_8bit = _mm256_set1_epi32(255);
+  const __m256i max_limited = _mm256_set1_epi32(219);
+  const __m256i limited_offset = _mm256_set1_epi32(16);
+  const __m256 limited_scale = _mm256_set1_ps(0.85547f);
+
+  // With 3 bytes per pixel, the last 16 byte load reads 4 bytes beyond the 8 pixels.
+  const uint32_t lookahead = (bytes_per_pixel == 3 ? 2 : 0);
+
+  uint32_t x = 0;
+  for (; x + 8 + lookahead <= width; x += 8) {
+    const uint8_t* p = rgb + x * bytes_per_pixel;
+
+    __m256 yv = weighted_sum(params.c[0],
+                             load_channel_8(p, bytes_per_pixel, mask_r),
+                             load_channel_8(p, bytes_per_pixel, mask_g),
+                             load_channel_8(p, bytes_per_pixel, mask_b));
+
+    if (params.full_range) {
+      store_8(y + x, to_pixel(yv, max_8bit));
+    }
+    else {
+      store_8(y + x, _mm256_add_epi32(to_pixel(_mm256_mul_ps(yv, limited_scale), max_limited), limited_offset));
+    }
+  }
+
+  if (x < width) {
+    rgb_interleaved_to_y_row_scalar(rgb + x * bytes_per_pixel, bytes_per_pixel, y + x, width - x, params);
+  }
+}
+
+
+// Sums channel values of 8 interleaved pixels horizontally pairwise, giving 4 sums.
+static inline __m128i pair_sums_interleaved(const uint8_t* p, int bytes_per_pixel, __m128i mask)
+{
+  __m128i p0 = _mm_loadu_si128((const __m128i*) p);
+  __m128i p1 = _mm_loadu_si128((const __m128i*) (p + 4 * bytes_per_pixel));
+  return _mm_hadd_epi32(_mm_shuffle_epi8(p0, mask), _mm_shuffle_epi8(p1, mask));
+}
+
+
+static void rgb_interleaved_to_cbcr420_row_avx2(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                                uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                                const RGB_to_YCbCr_float_parameters& params)
+{
+  const __m128i mask[3] = {channel_mask(bytes_per_pixel, 0),
+                           channel_mask(bytes_per_pixel, 1),
+                           channel_mask(bytes_per_pixel, 2)};
+  const __m256i max_8bit = _mm256_set1_epi32(255);
+  const __m256 offset = _mm256_set1_ps(128.0f);
+  const __m256 limited_scale = _mm256_set1_ps(0.875f);
+
+  const uint32_t lookahead = (bytes_per_pixel == 3 ? 2 : 0);
+
+  uint32_t x = 0;
+  for (; 2 * (x + 8) + lookahead <= 2 * chroma_width; x += 8) {
+    const uint8_t* p0 = rgb0 + 2 * x * bytes_per_pixel;
+    const uint8_t* p1 = rgb1 + 2 * x * bytes_per_pixel;
+    const int half = 8 * bytes_per_pixel;
+
+    __m256 rgb_avg[3];
+
+    for (int c = 0; c < 3; c++) {
+      __m128i sum_lo = _mm_add_epi32(pair_sums_interleaved(p0, bytes_per_pixel, mask[c]),
+                                     pair_sums_interleaved(p1, bytes_per_pixel, mask[c]));
+      __m128i sum_hi = _mm_add_epi32(pair_sums_interleaved(p0 + half, bytes_per_pixel, mask[c]),
+                                     pair_sums_interleaved(p1 + half, bytes_per_pixel, mask[c]));
+      rgb_avg[c] = _mm256_cvtepi32_ps(_mm256_srli_epi32(combine(sum_lo, sum_hi), 2));
+    }
+
+    __m256 cb_v = weighted_sum(params.c[1], rgb_avg[0], rgb_avg[1], rgb_avg[2]);
+    __m256 cr_v = weighted_sum(params.c[2], rgb_avg[0], rgb_avg[1], rgb_avg[2]);
+
+    if (!params.full_range) {
+      cb_v = _mm256_mul_ps(cb_v, limited_scale);
+      cr_v = _mm256_mul_ps(cr_v, limited_scale);
+    }
+
+    store_8(cb + x, to_pixel(_mm256_add_ps(cb_v, offset), max_8bit));
+    store_8(cr + x, to_pixel(_mm256_add_ps(cr_v, offset), max_8bit));
+  }
+
+  if (x < chroma_width) {
+    rgb_interleaved_to_cbcr420_row_scalar(rgb0 + 2 * x * bytes_per_pixel, rgb1 + 2 * x * bytes_per_pixel, bytes_per_pixel,
+                                          cb + x, cr + x, chroma_width - x, params);
+  }
+}
+
+
+// --- planar RGB input
+
+struct planar_constants_avx2
+{
+  __m256i max_value;
+  __m256 chroma_offset;
+  __m256 limited_range_offset;
+};
+
+static inline planar_constants_avx2 get_planar_constants(const RGB_to_YCbCr_float_parameters& params)
+{
+  return {_mm256_set1_epi32(params.max_value),
+          _mm256_set1_ps((float) params.chroma_offset),
+          _mm256_set1_ps(params.limited_range_offset)};
+}
+
+
+static inline __m256 luma(__m256 r, __m256 g, __m256 b,
+                          const RGB_to_YCbCr_float_parameters& params, const planar_constants_avx2& k)
+{
+  __m256 v = weighted_sum(params.c[0], r, g, b);
+  if (!params.full_range) {
+    // (v * 219) / 256 + offset. The division by a power of two is exact and equal to the multiplication.
+    v = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(v, _mm256_set1_ps(219.0f)), _mm256_set1_ps(1.0f / 256)),
+                      k.limited_range_offset);
+  }
+
+  return v;
+}
+
+
+template<class Pixel>
+static inline void store_chroma(Pixel* cb, Pixel* cr, __m256 r, __m256 g, __m256 b,
+                                const RGB_to_YCbCr_float_parameters& params, const planar_constants_avx2& k)
+{
+  __m256 cb_v = weighted_sum(params.c[1], r, g, b);
+  __m256 cr_v = weighted_sum(params.c[2], r, g, b);
+
+  if (!params.full_range) {
+    const __m256 c224 = _mm256_set1_ps(224.0f);
+    const __m256 c1_256 = _mm256_set1_ps(1.0f / 256);
+    cb_v = _mm256_mul_ps(_mm256_mul_ps(cb_v, c224), c1_256);
+    cr_v = _mm256_mul_ps(_mm256_mul_ps(cr_v, c224), c1_256);
+  }
+
+  store_8(cb, to_pixel(_mm256_add_ps(cb_v, k.chroma_offset), k.max_value));
+  store_8(cr, to_pixel(_mm256_add_ps(cr_v, k.chroma_offset), k.max_value));
+}
+
+
+template<class Pixel>
+static void rgb_to_y_row_avx2(const Pixel* r, const Pixel* g, const Pixel* b,
+                              Pixel* y, uint32_t width,
+                              const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_avx2 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256 v = luma(_mm256_cvtepi32_ps(load_8_as_epi32(r + x)),
+                    _mm256_cvtepi32_ps(load_8_as_epi32(g + x)),
+                    _mm256_cvtepi32_ps(load_8_as_epi32(b + x)), params, k);
+    store_8(y + x, to_pixel(v, k.max_value));
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_y_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                            (uint8_t*) y + x, width - x, params);
+    }
+    else {
+      rgb_to_y_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                             (uint16_t*) y + x, width - x, params);
+    }
+  }
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr_row_avx2(const Pixel* r, const Pixel* g, const Pixel* b,
+                                 Pixel* cb, Pixel* cr, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_avx2 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    store_chroma(cb + x, cr + x,
+                 _mm256_cvtepi32_ps(load_8_as_epi32(r + x)),
+                 _mm256_cvtepi32_ps(load_8_as_epi32(g + x)),
+                 _mm256_cvtepi32_ps(load_8_as_epi32(b + x)), params, k);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                               (uint8_t*) cb + x, (uint8_t*) cr + x, width - x, params);
+    }
+    else {
+      rgb_to_cbcr_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                                (uint16_t*) cb + x, (uint16_t*) cr + x, width - x, params);
+    }
+  }
+}
+
+
+// Horizontal pairwise sums of 16 samples. _mm256_hadd_epi32 works within the 128-bit lanes,
+// the permutation restores the sample order.
+template<class Pixel>
+static inline __m256i pair_sums_16(const Pixel* p)
+{
+  __m256i sums = _mm256_hadd_epi32(load_8_as_epi32(p), load_8_as_epi32(p + 8));
+  return _mm256_permute4x64_epi64(sums, 0xD8);
+}
+
+
+// Average of the 2x2 blocks of 16 samples in two rows. The scalar code sums the integer samples in float,
+// which is exact. Hence, summing them as integers gives the same result.
+template<class Pixel>
+static inline __m256 block_average_8(const Pixel* p0, const Pixel* p1)
+{
+  __m256i sum = _mm256_add_epi32(pair_sums_16(p0), pair_sums_16(p1));
+  return _mm256_mul_ps(_mm256_cvtepi32_ps(sum), _mm256_set1_ps(0.25f));
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr420_row_avx2(const Pixel* r0, const Pixel* g0, const Pixel* b0,
+                                    const Pixel* r1, const Pixel* g1, const Pixel* b1,
+                                    Pixel* cb, Pixel* cr, uint32_t width,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_avx2 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    store_chroma(cb + x / 2, cr + x / 2,
+                 block_average_8(r0 + x, r1 + x),
+                 block_average_8(g0 + x, g1 + x),
+                 block_average_8(b0 + x, b1 + x), params, k);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr420_row_8_scalar((const uint8_t*) r0 + x, (const uint8_t*) g0 + x, (const uint8_t*) b0 + x,
+                                  (const uint8_t*) r1 + x, (const uint8_t*) g1 + x, (const uint8_t*) b1 + x,
+                                  (uint8_t*) cb + x / 2, (uint8_t*) cr + x / 2, width - x, params);
+    }
+    else {
+      rgb_to_cbcr420_row_16_scalar((const uint16_t*) r0 + x, (const uint16_t*) g0 + x, (const uint16_t*) b0 + x,
+                                   (const uint16_t*) r1 + x, (const uint16_t*) g1 + x, (const uint16_t*) b1 + x,
+                                   (uint16_t*) cb + x / 2, (uint16_t*) cr + x / 2, width - x, params);
+    }
+  }
+}
+
+
+static void rgb_to_y_row_8_avx2(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                uint8_t* y, uint32_t width,
+                                const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_avx2(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_y_row_16_avx2(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                 uint16_t* y, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_avx2(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_cbcr_row_8_avx2(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                   uint8_t* cb, uint8_t* cr, uint32_t width,
+                                   const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_avx2(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr_row_16_avx2(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                    uint16_t* cb, uint16_t* cr, uint32_t width,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_avx2(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_8_avx2(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                                      const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                                      uint8_t* cb, uint8_t* cr, uint32_t width,
+                                      const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_avx2(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_16_avx2(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                       const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                       uint16_t* cb, uint16_t* cr, uint32_t width,
+                                       const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_avx2(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+// --- chroma downsampling
+
+static void average_420_row_8_avx2(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width)
+{
+  const __m256i ones = _mm256_set1_epi8(1);
+  const __m256i two = _mm256_set1_epi16(2);
+
+  auto averages_16 = [&](const uint8_t* p0, const uint8_t* p1) {
+    // pairwise horizontal sums as 16 bit
+    __m256i sum = _mm256_add_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*) p0), ones),
+                                   _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*) p1), ones));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+  };
+
+  uint32_t x = 0;
+  for (; x + 32 <= out_width; x += 32) {
+    __m256i lo = averages_16(in0 + 2 * x, in1 + 2 * x);
+    __m256i hi = averages_16(in0 + 2 * x + 32, in1 + 2 * x + 32);
+
+    // _mm256_packus_epi16 interleaves the 128-bit lanes
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    _mm256_storeu_si256((__m256i*) (out + x), packed);
+  }
+
+  if (x < out_width) {
+    average_420_row_8_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+static void average_420_row_16_avx2(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width)
+{
+  const __m256i two = _mm256_set1_epi32(2);
+
+  uint32_t x = 0;
+  for (; x + 8 <= out_width; x += 8) {
+    __m256i sum = _mm256_add_epi32(pair_sums_16(in0 + 2 * x), pair_sums_16(in1 + 2 * x));
+    store_8(out + x, _mm256_srli_epi32(_mm256_add_epi32(sum, two), 2));
+  }
+
+  if (x < out_width) {
+    average_420_row_16_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_avx2{
+  "avx2",
+  SpeedCosts_OptimizedSoftware,
+  rgb_interleaved_to_y_row_avx2,
+  rgb_interleaved_to_cbcr420_row_avx2,
+  rgb_to_y_row_8_avx2,
+  rgb_to_y_row_16_avx2,
+  rgb_to_cbcr_row_8_avx2,
+  rgb_to_cbcr_row_16_avx2,
+  rgb_to_cbcr420_row_8_avx2,
+  rgb_to_cbcr420_row_16_avx2,
+  average_420_row_8_avx2,
+  average_420_row_16_avx2
+};
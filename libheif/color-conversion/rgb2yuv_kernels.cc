@@ -0,0 +1,263 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rgb2yuv_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+#include "common_utils.h"
+
+
+void rgb_interleaved_to_y_row_scalar(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                     const RGB_to_YCbCr_float_parameters& params)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    const uint8_t* p = &rgb[x * bytes_per_pixel];
+
+    float yv = p[0] * params.c[0][0] + p[1] * params.c[0][1] + p[2] * params.c[0][2];
+
+    if (params.full_range) {
+      y[x] = clip_f_u8(yv);
+    }
+    else {
+      y[x] = (uint8_t) (clip_f_u16(yv * 0.85547f, 219) + 16);
+    }
+  }
+}
+
+
+void rgb_interleaved_to_cbcr420_row_scalar(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                           uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                           const RGB_to_YCbCr_float_parameters& params)
+{
+  for (uint32_t x = 0; x < chroma_width; x++) {
+    const uint8_t* p0 = &rgb0[2 * x * bytes_per_pixel];
+    const uint8_t* p1 = &rgb1[2 * x * bytes_per_pixel];
+
+    uint8_t r = uint8_t((p0[0] + p0[bytes_per_pixel + 0] + p1[0] + p1[bytes_per_pixel + 0]) / 4);
+    uint8_t g = uint8_t((p0[1] + p0[bytes_per_pixel + 1] + p1[1] + p1[bytes_per_pixel + 1]) / 4);
+    uint8_t b = uint8_t((p0[2] + p0[bytes_per_pixel + 2] + p1[2] + p1[bytes_per_pixel + 2]) / 4);
+
+    float cb_v = r * params.c[1][0] + g * params.c[1][1] + b * params.c[1][2];
+    float cr_v = r * params.c[2][0] + g * params.c[2][1] + b * params.c[2][2];
+
+    if (params.full_range) {
+      cb[x] = clip_f_u8(cb_v + 128);
+      cr[x] = clip_f_u8(cr_v + 128);
+    }
+    else {
+      cb[x] = clip_f_u8(cb_v * 0.875f + 128.0f);
+      cr[x] = clip_f_u8(cr_v * 0.875f + 128.0f);
+    }
+  }
+}
+
+
+template<class Pixel>
+static void rgb_to_y_row_scalar(const Pixel* r, const Pixel* g, const Pixel* b,
+                                Pixel* y, uint32_t width,
+                                const RGB_to_YCbCr_float_parameters& params)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    float v = r[x] * params.c[0][0] + g[x] * params.c[0][1] + b[x] * params.c[0][2];
+    if (!params.full_range) {
+      v = (((v * 219) / 256) + params.limited_range_offset);
+    }
+
+    y[x] = (Pixel) clip_f_u16(v, params.max_value);
+  }
+}
+
+
+template<class Pixel>
+static inline void set_chroma_pixel(Pixel* out_cb, Pixel* out_cr, float r, float g, float b,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  float cb = r * params.c[1][0] + g * params.c[1][1] + b * params.c[1][2];
+  float cr = r * params.c[2][0] + g * params.c[2][1] + b * params.c[2][2];
+
+  if (!params.full_range) {
+    cb = (cb * 224) / 256;
+    cr = (cr * 224) / 256;
+  }
+
+  *out_cb = (Pixel) clip_f_u16(cb + (float) params.chroma_offset, params.max_value);
+  *out_cr = (Pixel) clip_f_u16(cr + (float) params.chroma_offset, params.max_value);
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr_row_scalar(const Pixel* r, const Pixel* g, const Pixel* b,
+                                   Pixel* cb, Pixel* cr, uint32_t width,
+                                   const RGB_to_YCbCr_float_parameters& params)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    set_chroma_pixel(&cb[x], &cr[x], r[x], g[x], b[x], params);
+  }
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr420_row_scalar(const Pixel* r0, const Pixel* g0, const Pixel* b0,
+                                      const Pixel* r1, const Pixel* g1, const Pixel* b1,
+                                      Pixel* cb, Pixel* cr, uint32_t width,
+                                      const RGB_to_YCbCr_float_parameters& params)
+{
+  for (uint32_t x = 0; x < width; x += 2) {
+    uint32_t x2 = (x + 1 < width) ? x + 1 : x;
+
+    float r = r0[x];
+    float g = g0[x];
+    float b = b0[x];
+
+    r += r0[x2];
+    g += g0[x2];
+    b += b0[x2];
+
+    r += r1[x];
+    g += g1[x];
+    b += b1[x];
+
+    r += r1[x2];
+    g += g1[x2];
+    b += b1[x2];
+
+    r *= 0.25f;
+    g *= 0.25f;
+    b *= 0.25f;
+
+    set_chroma_pixel(&cb[x / 2], &cr[x / 2], r, g, b, params);
+  }
+}
+
+
+void rgb_to_y_row_8_scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                           uint8_t* y, uint32_t width,
+                           const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_scalar(r, g, b, y, width, params);
+}
+
+
+void rgb_to_y_row_16_scalar(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                            uint16_t* y, uint32_t width,
+                            const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_scalar(r, g, b, y, width, params);
+}
+
+
+void rgb_to_cbcr_row_8_scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                              uint8_t* cb, uint8_t* cr, uint32_t width,
+                              const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_scalar(r, g, b, cb, cr, width, params);
+}
+
+
+void rgb_to_cbcr_row_16_scalar(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                               uint16_t* cb, uint16_t* cr, uint32_t width,
+                               const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_scalar(r, g, b, cb, cr, width, params);
+}
+
+
+void rgb_to_cbcr420_row_8_scalar(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                                 const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                                 uint8_t* cb, uint8_t* cr, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_scalar(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+void rgb_to_cbcr420_row_16_scalar(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                  const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                  uint16_t* cb, uint16_t* cr, uint32_t width,
+                                  const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_scalar(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+template<class Pixel>
+static void average_420_row_scalar(const Pixel* in0, const Pixel* in1, Pixel* out, uint32_t out_width)
+{
+  for (uint32_t x = 0; x < out_width; x++) {
+    out[x] = (Pixel) ((in0[2 * x] + in0[2 * x + 1] + in1[2 * x] + in1[2 * x + 1] + 2) / 4);
+  }
+}
+
+
+void average_420_row_8_scalar(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width)
+{
+  average_420_row_scalar(in0, in1, out, out_width);
+}
+
+
+void average_420_row_16_scalar(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width)
+{
+  average_420_row_scalar(in0, in1, out, out_width);
+}
+
+
+static const RGB_to_YCbCr_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  rgb_interleaved_to_y_row_scalar,
+  rgb_interleaved_to_cbcr420_row_scalar,
+  rgb_to_y_row_8_scalar,
+  rgb_to_y_row_16_scalar,
+  rgb_to_cbcr_row_8_scalar,
+  rgb_to_cbcr_row_16_scalar,
+  rgb_to_cbcr420_row_8_scalar,
+  rgb_to_cbcr420_row_16_scalar,
+  average_420_row_8_scalar,
+  average_420_row_16_scalar
+};
+
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_sse41;
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_avx2;
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_neon;
+
+static const KernelDispatcher<RGB_to_YCbCr_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(rgb2yuv_kernels_sse41),
+  AVX2_KERNELS(rgb2yuv_kernels_avx2),
+  NEON_KERNELS(rgb2yuv_kernels_neon)
+};
+
+
+const RGB_to_YCbCr_kernels& get_scalar_RGB_to_YCbCr_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const RGB_to_YCbCr_kernels* get_simd_RGB_to_YCbCr_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const RGB_to_YCbCr_kernels*> get_supported_RGB_to_YCbCr_kernels()
+{
+  return dispatcher.get_supported();
+}
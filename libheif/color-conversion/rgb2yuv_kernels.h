@@ -0,0 +1,147 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_RGB2YUV_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_RGB2YUV_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels for the RGB -> YCbCr conversion and the 4:2:0 chroma downsampling operations.
+//
+// These follow the same scheme as the YCbCr -> RGB kernels (see yuv2rgb_kernels.h): there is a scalar
+// reference implementation and vectorized implementations in translation units that are compiled with
+// SSE4.1, AVX2 or NEON enabled. The vectorized kernels compute the same sequence of operations as the
+// scalar kernels and are bit-exact, with the same exception for fused multiply-adds on ARM.
+
+struct RGB_to_YCbCr_float_parameters
+{
+  float c[3][3]; // RGB_to_YCbCr_coefficients::c
+
+  bool full_range;
+  float limited_range_offset; // 16 << (bpp-8)
+
+  int32_t chroma_offset; // 1 << (bpp-1)
+  int32_t max_value; // (1 << bpp) - 1
+};
+
+
+struct RGB_to_YCbCr_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  // Converts one row of interleaved RGB or RGBA (bytes_per_pixel = 3 or 4) into 8-bit luma.
+  void (*rgb_interleaved_to_y_row)(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                   const RGB_to_YCbCr_float_parameters& params);
+
+  // Converts two rows of interleaved RGB or RGBA into one row of 8-bit 4:2:0 chroma.
+  // The 2x2 input blocks are averaged. Only complete blocks are processed, i.e. 'chroma_width' = width/2.
+  void (*rgb_interleaved_to_cbcr420_row)(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                         uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                         const RGB_to_YCbCr_float_parameters& params);
+
+  // Converts one row of planar RGB into luma.
+  void (*rgb_to_y_row_8)(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                         uint8_t* y, uint32_t width,
+                         const RGB_to_YCbCr_float_parameters& params);
+
+  void (*rgb_to_y_row_16)(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                          uint16_t* y, uint32_t width,
+                          const RGB_to_YCbCr_float_parameters& params);
+
+  // Converts one row of planar RGB into 4:4:4 chroma.
+  void (*rgb_to_cbcr_row_8)(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                            uint8_t* cb, uint8_t* cr, uint32_t width,
+                            const RGB_to_YCbCr_float_parameters& params);
+
+  void (*rgb_to_cbcr_row_16)(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                             uint16_t* cb, uint16_t* cr, uint32_t width,
+                             const RGB_to_YCbCr_float_parameters& params);
+
+  // Converts two rows of planar RGB into one row of 4:2:0 chroma by averaging the 2x2 input blocks.
+  // 'width' is the luma width. For odd widths, the last chroma sample is computed from the last column only.
+  // For the last row of an image with odd height, pass the same row twice.
+  void (*rgb_to_cbcr420_row_8)(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                               const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                               uint8_t* cb, uint8_t* cr, uint32_t width,
+                               const RGB_to_YCbCr_float_parameters& params);
+
+  void (*rgb_to_cbcr420_row_16)(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                uint16_t* cb, uint16_t* cr, uint32_t width,
+                                const RGB_to_YCbCr_float_parameters& params);
+
+  // Averages the 2x2 blocks of two rows with rounding. Only complete blocks are processed, i.e. 'out_width' = width/2.
+  void (*average_420_row_8)(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width);
+
+  void (*average_420_row_16)(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void rgb_interleaved_to_y_row_scalar(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                     const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_interleaved_to_cbcr420_row_scalar(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                           uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                           const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_y_row_8_scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                           uint8_t* y, uint32_t width,
+                           const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_y_row_16_scalar(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                            uint16_t* y, uint32_t width,
+                            const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_cbcr_row_8_scalar(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                              uint8_t* cb, uint8_t* cr, uint32_t width,
+                              const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_cbcr_row_16_scalar(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                               uint16_t* cb, uint16_t* cr, uint32_t width,
+                               const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_cbcr420_row_8_scalar(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                                 const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                                 uint8_t* cb, uint8_t* cr, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params);
+
+void rgb_to_cbcr420_row_16_scalar(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                  const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                  uint16_t* cb, uint16_t* cr, uint32_t width,
+                                  const RGB_to_YCbCr_float_parameters& params);
+
+void average_420_row_8_scalar(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width);
+
+void average_420_row_16_scalar(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width);
+
+
+const RGB_to_YCbCr_kernels& get_scalar_RGB_to_YCbCr_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const RGB_to_YCbCr_kernels* get_simd_RGB_to_YCbCr_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const RGB_to_YCbCr_kernels*> get_supported_RGB_to_YCbCr_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_RGB2YUV_KERNELS_H
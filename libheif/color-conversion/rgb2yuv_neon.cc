@@ -0,0 +1,425 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See rgb2yuv_kernels.h.
+
+#include "rgb2yuv_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+
+
+static inline uint16x8_t load_8(const uint8_t* p)
+{
+  return vmovl_u8(vld1_u8(p));
+}
+
+static inline uint16x8_t load_8(const uint16_t* p)
+{
+  return vld1q_u16(p);
+}
+
+static inline void store_8(uint8_t* p, int32x4_t lo, int32x4_t hi)
+{
+  vst1_u8(p, vqmovn_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi))));
+}
+
+static inline void store_8(uint16_t* p, int32x4_t lo, int32x4_t hi)
+{
+  vst1q_u16(p, vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)));
+}
+
+
+static inline float32x4x2_t to_float(uint16x8_t v)
+{
+  float32x4x2_t f;
+  f.val[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(v)));
+  f.val[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(v)));
+  return f;
+}
+
+
+// Same as clip_f_u16(): rounds by adding 0.5 and truncating, then clips to [0;max_value].
+static inline int32x4_t to_pixel(float32x4_t v, int32x4_t max_value)
+{
+  int32x4_t i = vcvtq_s32_f32(vaddq_f32(v, vdupq_n_f32(0.5f)));
+  return vminq_s32(vmaxq_s32(i, vdupq_n_s32(0)), max_value);
+}
+
+
+// Computes c[0]*r + c[1]*g + c[2]*b in the same order as the scalar code.
+static inline float32x4_t weighted_sum(const float c[3], float32x4_t r, float32x4_t g, float32x4_t b)
+{
+  return vaddq_f32(vaddq_f32(vmulq_n_f32(r, c[0]), vmulq_n_f32(g, c[1])), vmulq_n_f32(b, c[2]));
+}
+
+
+// --- interleaved RGB input
+
+static void rgb_interleaved_to_y_row_neon(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                          const RGB_to_YCbCr_float_parameters& params)
+{
+  const int32x4_t max_8bit = vdupq_n_s32(255);
+  const int32x4_t max_limited = vdupq_n_s32(219);
+  const int32x4_t limited_offset = vdupq_n_s32(16);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const uint8_t* p = rgb + x * bytes_per_pixel;
+    uint8x8_t r8, g8, b8;
+
+    if (bytes_per_pixel == 3) {
+      uint8x8x3_t v = vld3_u8(p);
+      r8 = v.val[0];
+      g8 = v.val[1];
+      b8 = v.val[2];
+    }
+    else {
+      uint8x8x4_t v = vld4_u8(p);
+      r8 = v.val[0];
+      g8 = v.val[1];
+      b8 = v.val[2];
+    }
+
+    float32x4x2_t r = to_float(vmovl_u8(r8));
+    float32x4x2_t g = to_float(vmovl_u8(g8));
+    float32x4x2_t b = to_float(vmovl_u8(b8));
+
+    int32x4_t out[2];
+    for (int i = 0; i < 2; i++) {
+      float32x4_t yv = weighted_sum(params.c[0], r.val[i], g.val[i], b.val[i]);
+
+      if (params.full_range) {
+        out[i] = to_pixel(yv, max_8bit);
+      }
+      else {
+        out[i] = vaddq_s32(to_pixel(vmulq_n_f32(yv, 0.85547f), max_limited), limited_offset);
+      }
+    }
+
+    store_8(y + x, out[0], out[1]);
+  }
+
+  if (x < width) {
+    rgb_interleaved_to_y_row_scalar(rgb + x * bytes_per_pixel, bytes_per_pixel, y + x, width - x, params);
+  }
+}
+
+
+static inline uint8x16x3_t load_rgb_16(const uint8_t* p, int bytes_per_pixel)
+{
+  if (bytes_per_pixel == 3) {
+    return vld3q_u8(p);
+  }
+
+  uint8x16x4_t v = vld4q_u8(p);
+  uint8x16x3_t rgb;
+  rgb.val[0] = v.val[0];
+  rgb.val[1] = v.val[1];
+  rgb.val[2] = v.val[2];
+  return rgb;
+}
+
+
+static void rgb_interleaved_to_cbcr420_row_neon(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                                uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                                const RGB_to_YCbCr_float_parameters& params)
+{
+  const int32x4_t max_8bit = vdupq_n_s32(255);
+  const float32x4_t offset = vdupq_n_f32(128.0f);
+
+  uint32_t x = 0;
+  for (; x + 8 <= chroma_width; x += 8) {
+    uint8x16x3_t p0 = load_rgb_16(rgb0 + 2 * x * bytes_per_pixel, bytes_per_pixel);
+    uint8x16x3_t p1 = load_rgb_16(rgb1 + 2 * x * bytes_per_pixel, bytes_per_pixel);
+
+    float32x4x2_t rgb_avg[3];
+    for (int c = 0; c < 3; c++) {
+      // sum of the 2x2 blocks, divided by 4 with truncation
+      uint16x8_t sum = vpadalq_u8(vpaddlq_u8(p0.val[c]), p1.val[c]);
+      rgb_avg[c] = to_float(vshrq_n_u16(sum, 2));
+    }
+
+    int32x4_t cb_i[2], cr_i[2];
+    for (int i = 0; i < 2; i++) {
+      float32x4_t cb_v = weighted_sum(params.c[1], rgb_avg[0].val[i], rgb_avg[1].val[i], rgb_avg[2].val[i]);
+      float32x4_t cr_v = weighted_sum(params.c[2], rgb_avg[0].val[i], rgb_avg[1].val[i], rgb_avg[2].val[i]);
+
+      if (!params.full_range) {
+        cb_v = vmulq_n_f32(cb_v, 0.875f);
+        cr_v = vmulq_n_f32(cr_v, 0.875f);
+      }
+
+      cb_i[i] = to_pixel(vaddq_f32(cb_v, offset), max_8bit);
+      cr_i[i] = to_pixel(vaddq_f32(cr_v, offset), max_8bit);
+    }
+
+    store_8(cb + x, cb_i[0], cb_i[1]);
+    store_8(cr + x, cr_i[0], cr_i[1]);
+  }
+
+  if (x < chroma_width) {
+    rgb_interleaved_to_cbcr420_row_scalar(rgb0 + 2 * x * bytes_per_pixel, rgb1 + 2 * x * bytes_per_pixel, bytes_per_pixel,
+                                          cb + x, cr + x, chroma_width - x, params);
+  }
+}
+
+
+// --- planar RGB input
+
+template<class Pixel>
+static inline void store_chroma(Pixel* cb, Pixel* cr,
+                                const float32x4x2_t& r, const float32x4x2_t& g, const float32x4x2_t& b,
+                                const RGB_to_YCbCr_float_parameters& params)
+{
+  const float32x4_t chroma_offset = vdupq_n_f32((float) params.chroma_offset);
+  const int32x4_t max_value = vdupq_n_s32(params.max_value);
+
+  int32x4_t cb_i[2], cr_i[2];
+
+  for (int i = 0; i < 2; i++) {
+    float32x4_t cb_v = weighted_sum(params.c[1], r.val[i], g.val[i], b.val[i]);
+    float32x4_t cr_v = weighted_sum(params.c[2], r.val[i], g.val[i], b.val[i]);
+
+    if (!params.full_range) {
+      // (v * 224) / 256. The division by a power of two is exact and equal to the multiplication.
+      cb_v = vmulq_n_f32(vmulq_n_f32(cb_v, 224.0f), 1.0f / 256);
+      cr_v = vmulq_n_f32(vmulq_n_f32(cr_v, 224.0f), 1.0f / 256);
+    }
+
+    cb_i[i] = to_pixel(vaddq_f32(cb_v, chroma_offset), max_value);
+    cr_i[i] = to_pixel(vaddq_f32(cr_v, chroma_offset), max_value);
+  }
+
+  store_8(cb, cb_i[0], cb_i[1]);
+  store_8(cr, cr_i[0], cr_i[1]);
+}
+
+
+template<class Pixel>
+static void rgb_to_y_row_neon(const Pixel* r, const Pixel* g, const Pixel* b,
+                              Pixel* y, uint32_t width,
+                              const RGB_to_YCbCr_float_parameters& params)
+{
+  const float32x4_t limited_range_offset = vdupq_n_f32(params.limited_range_offset);
+  const int32x4_t max_value = vdupq_n_s32(params.max_value);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    float32x4x2_t r_v = to_float(load_8(r + x));
+    float32x4x2_t g_v = to_float(load_8(g + x));
+    float32x4x2_t b_v = to_float(load_8(b + x));
+
+    int32x4_t out[2];
+    for (int i = 0; i < 2; i++) {
+      float32x4_t v = weighted_sum(params.c[0], r_v.val[i], g_v.val[i], b_v.val[i]);
+      if (!params.full_range) {
+        v = vaddq_f32(vmulq_n_f32(vmulq_n_f32(v, 219.0f), 1.0f / 256), limited_range_offset);
+      }
+
+      out[i] = to_pixel(v, max_value);
+    }
+
+    store_8(y + x, out[0], out[1]);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_y_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                            (uint8_t*) y + x, width - x, params);
+    }
+    else {
+      rgb_to_y_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                             (uint16_t*) y + x, width - x, params);
+    }
+  }
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr_row_neon(const Pixel* r, const Pixel* g, const Pixel* b,
+                                 Pixel* cb, Pixel* cr, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    store_chroma(cb + x, cr + x,
+                 to_float(load_8(r + x)),
+                 to_float(load_8(g + x)),
+                 to_float(load_8(b + x)), params);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                               (uint8_t*) cb + x, (uint8_t*) cr + x, width - x, params);
+    }
+    else {
+      rgb_to_cbcr_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                                (uint16_t*) cb + x, (uint16_t*) cr + x, width - x, params);
+    }
+  }
+}
+
+
+// Average of the 2x2 blocks of 16 samples in two rows. The scalar code sums the integer samples in float,
+// which is exact. Hence, summing them as integers gives the same result.
+static inline float32x4x2_t block_average_8(const uint8_t* p0, const uint8_t* p1)
+{
+  float32x4x2_t f = to_float(vpadalq_u8(vpaddlq_u8(vld1q_u8(p0)), vld1q_u8(p1)));
+  f.val[0] = vmulq_n_f32(f.val[0], 0.25f);
+  f.val[1] = vmulq_n_f32(f.val[1], 0.25f);
+  return f;
+}
+
+static inline float32x4x2_t block_average_8(const uint16_t* p0, const uint16_t* p1)
+{
+  uint32x4_t lo = vpadalq_u16(vpaddlq_u16(vld1q_u16(p0)), vld1q_u16(p1));
+  uint32x4_t hi = vpadalq_u16(vpaddlq_u16(vld1q_u16(p0 + 8)), vld1q_u16(p1 + 8));
+
+  float32x4x2_t f;
+  f.val[0] = vmulq_n_f32(vcvtq_f32_u32(lo), 0.25f);
+  f.val[1] = vmulq_n_f32(vcvtq_f32_u32(hi), 0.25f);
+  return f;
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr420_row_neon(const Pixel* r0, const Pixel* g0, const Pixel* b0,
+                                    const Pixel* r1, const Pixel* g1, const Pixel* b1,
+                                    Pixel* cb, Pixel* cr, uint32_t width,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    store_chroma(cb + x / 2, cr + x / 2,
+                 block_average_8(r0 + x, r1 + x),
+                 block_average_8(g0 + x, g1 + x),
+                 block_average_8(b0 + x, b1 + x), params);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr420_row_8_scalar((const uint8_t*) r0 + x, (const uint8_t*) g0 + x, (const uint8_t*) b0 + x,
+                                  (const uint8_t*) r1 + x, (const uint8_t*) g1 + x, (const uint8_t*) b1 + x,
+                                  (uint8_t*) cb + x / 2, (uint8_t*) cr + x / 2, width - x, params);
+    }
+    else {
+      rgb_to_cbcr420_row_16_scalar((const uint16_t*) r0 + x, (const uint16_t*) g0 + x, (const uint16_t*) b0 + x,
+                                   (const uint16_t*) r1 + x, (const uint16_t*) g1 + x, (const uint16_t*) b1 + x,
+                                   (uint16_t*) cb + x / 2, (uint16_t*) cr + x / 2, width - x, params);
+    }
+  }
+}
+
+
+static void rgb_to_y_row_8_neon(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                uint8_t* y, uint32_t width,
+                                const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_neon(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_y_row_16_neon(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                 uint16_t* y, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_neon(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_cbcr_row_8_neon(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                   uint8_t* cb, uint8_t* cr, uint32_t width,
+                                   const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_neon(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr_row_16_neon(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                    uint16_t* cb, uint16_t* cr, uint32_t width,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_neon(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_8_neon(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                                      const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                                      uint8_t* cb, uint8_t* cr, uint32_t width,
+                                      const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_neon(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_16_neon(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                       const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                       uint16_t* cb, uint16_t* cr, uint32_t width,
+                                       const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_neon(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+// --- chroma downsampling
+
+static void average_420_row_8_neon(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width)
+{
+  uint32_t x = 0;
+  for (; x + 8 <= out_width; x += 8) {
+    uint16x8_t sum = vpadalq_u8(vpaddlq_u8(vld1q_u8(in0 + 2 * x)), vld1q_u8(in1 + 2 * x));
+    vst1_u8(out + x, vrshrn_n_u16(sum, 2)); // (sum + 2) >> 2
+  }
+
+  if (x < out_width) {
+    average_420_row_8_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+static void average_420_row_16_neon(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width)
+{
+  uint32_t x = 0;
+  for (; x + 4 <= out_width; x += 4) {
+    uint32x4_t sum = vpadalq_u16(vpaddlq_u16(vld1q_u16(in0 + 2 * x)), vld1q_u16(in1 + 2 * x));
+    vst1_u16(out + x, vrshrn_n_u32(sum, 2)); // (sum + 2) >> 2
+  }
+
+  if (x < out_width) {
+    average_420_row_16_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  rgb_interleaved_to_y_row_neon,
+  rgb_interleaved_to_cbcr420_row_neon,
+  rgb_to_y_row_8_neon,
+  rgb_to_y_row_16_neon,
+  rgb_to_cbcr_row_8_neon,
+  rgb_to_cbcr_row_16_neon,
+  rgb_to_cbcr420_row_8_neon,
+  rgb_to_cbcr420_row_16_neon,
+  average_420_row_8_neon,
+  average_420_row_16_neon
+};
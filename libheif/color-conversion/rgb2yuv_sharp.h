@@ -42,6 +42,16 @@ public:
                      const heif_color_conversion_options& options,
                      const heif_color_conversion_options_ext& options_ext,
                      const heif_security_limits* limits) const override;
+
+  // Converts overlapping stripes of rows in parallel. See heif_color_conversion_options_ext::max_sharp_yuv_threads.
+  Result<std::shared_ptr<HeifPixelImage>>
+  convert_colorspace_with_threads(const std::shared_ptr<const HeifPixelImage>& input,
+                                  const ColorState& input_state,
+                                  const ColorState& target_state,
+                                  const heif_color_conversion_options& options,
+                                  const heif_color_conversion_options_ext& options_ext,
+                                  const heif_security_limits* limits,
+                                  int num_threads) const override;
 };
 
 
@@ -0,0 +1,426 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See rgb2yuv_kernels.h.
+
+#include "rgb2yuv_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+#include <cstring>
+
+
+static inline __m128i load_4_as_epi32(const uint8_t* p)
+{
+  int32_t v;
+  memcpy(&v, p, 4);
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static inline __m128i load_4_as_epi32(const uint16_t* p)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) p));
+}
+
+static inline void store_4(uint8_t* p, __m128i v)
+{
+  __m128i v16 = _mm_packus_epi32(v, v);
+  int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(v16, v16));
+  memcpy(p, &packed, 4);
+}
+
+static inline void store_4(uint16_t* p, __m128i v)
+{
+  _mm_storel_epi64((__m128i*) p, _mm_packus_epi32(v, v));
+}
+
+
+// Same as clip_f_u16(): rounds by adding 0.5 and truncating, then clips to [0;max_value].
+static inline __m128i to_pixel(__m128 v, __m128i max_value)
+{
+  __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, _mm_set1_ps(0.5f)));
+  return _mm_min_epi32(_mm_max_epi32(i, _mm_setzero_si128()), max_value);
+}
+
+
+// Computes c[0]*r + c[1]*g + c[2]*b in the same order as the scalar code.
+static inline __m128 weighted_sum(const float c[3], __m128 r, __m128 g, __m128 b)
+{
+  return _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, _mm_set1_ps(c[0])),
+                               _mm_mul_ps(g, _mm_set1_ps(c[1]))),
+                    _mm_mul_ps(b, _mm_set1_ps(c[2])));
+}
+
+
+// --- interleaved RGB input
+
+// Shuffle mask that extracts one channel of 4 interleaved pixels into 32-bit lanes.
+static inline __m128i channel_mask(int bytes_per_pixel, int channel)
+{
+  auto idx = [&](int i) { return (char) (i * bytes_per_pixel + channel); };
+  return _mm_setr_epi8(idx(0), -1, -1, -1, idx(1), -1, -1, -1, idx(2), -1, -1, -1, idx(3), -1, -1, -1);
+}
+
+
+static void rgb_interleaved_to_y_row_sse41(const uint8_t* rgb, int bytes_per_pixel, uint8_t* y, uint32_t width,
+                                           const RGB_to_YCbCr_float_parameters& params)
+{
+  const __m128i mask_r = channel_mask(bytes_per_pixel, 0);
+  const __m128i mask_g = channel_mask(bytes_per_pixel, 1);
+  const __m128i mask_b = channel_mask(bytes_per_pixel, 2);
+  const __m128i max_8bit = _mm_set1_epi32(255);
+  const __m128i max_limited = _mm_set1_epi32(219);
+  const __m128i limited_offset = _mm_set1_epi32(16);
+  const __m128 limited_scale = _mm_set1_ps(0.85547f);
+
+  // With 3 bytes per pixel, the 16 byte load reads 4 bytes beyond the 4 pixels.
+  const uint32_t lookahead = (bytes_per_pixel == 3 ? 2 : 0);
+
+  uint32_t x = 0;
+  for (; x + 4 + lookahead <= width; x += 4) {
+    __m128i p = _mm_loadu_si128((const __m128i*) (rgb + x * bytes_per_pixel));
+    __m128 r = _mm_cvtepi32_ps(_mm_shuffle_epi8(p, mask_r));
+    __m128 g = _mm_cvtepi32_ps(_mm_shuffle_epi8(p, mask_g));
+    __m128 b = _mm_cvtepi32_ps(_mm_shuffle_epi8(p, mask_b));
+
+    __m128 yv = weighted_sum(params.c[0], r, g, b);
+
+    if (params.full_range) {
+      store_4(y + x, to_pixel(yv, max_8bit));
+    }
+    else {
+      store_4(y + x, _mm_add_epi32(to_pixel(_mm_mul_ps(yv, limited_scale), max_limited), limited_offset));
+    }
+  }
+
+  if (x < width) {
+    rgb_interleaved_to_y_row_scalar(rgb + x * bytes_per_pixel, bytes_per_pixel, y + x, width - x, params);
+  }
+}
+
+
+// Sums channel values of 8 interleaved pixels horizontally pairwise, giving 4 sums.
+static inline __m128i pair_sums_interleaved(const uint8_t* p, int bytes_per_pixel, __m128i mask)
+{
+  __m128i p0 = _mm_loadu_si128((const __m128i*) p);
+  __m128i p1 = _mm_loadu_si128((const __m128i*) (p + 4 * bytes_per_pixel));
+  return _mm_hadd_epi32(_mm_shuffle_epi8(p0, mask), _mm_shuffle_epi8(p1, mask));
+}
+
+
+static void rgb_interleaved_to_cbcr420_row_sse41(const uint8_t* rgb0, const uint8_t* rgb1, int bytes_per_pixel,
+                                                 uint8_t* cb, uint8_t* cr, uint32_t chroma_width,
+                                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  const __m128i mask[3] = {channel_mask(bytes_per_pixel, 0),
+                           channel_mask(bytes_per_pixel, 1),
+                           channel_mask(bytes_per_pixel, 2)};
+  const __m128i max_8bit = _mm_set1_epi32(255);
+  const __m128 offset = _mm_set1_ps(128.0f);
+  const __m128 limited_scale = _mm_set1_ps(0.875f);
+
+  const uint32_t lookahead = (bytes_per_pixel == 3 ? 2 : 0);
+
+  uint32_t x = 0;
+  for (; 2 * (x + 4) + lookahead <= 2 * chroma_width; x += 4) {
+    __m128 rgb_avg[3];
+
+    for (int c = 0; c < 3; c++) {
+      __m128i sum = _mm_add_epi32(pair_sums_interleaved(rgb0 + 2 * x * bytes_per_pixel, bytes_per_pixel, mask[c]),
+                                  pair_sums_interleaved(rgb1 + 2 * x * bytes_per_pixel, bytes_per_pixel, mask[c]));
+      rgb_avg[c] = _mm_cvtepi32_ps(_mm_srli_epi32(sum, 2));
+    }
+
+    __m128 cb_v = weighted_sum(params.c[1], rgb_avg[0], rgb_avg[1], rgb_avg[2]);
+    __m128 cr_v = weighted_sum(params.c[2], rgb_avg[0], rgb_avg[1], rgb_avg[2]);
+
+    if (!params.full_range) {
+      cb_v = _mm_mul_ps(cb_v, limited_scale);
+      cr_v = _mm_mul_ps(cr_v, limited_scale);
+    }
+
+    store_4(cb + x, to_pixel(_mm_add_ps(cb_v, offset), max_8bit));
+    store_4(cr + x, to_pixel(_mm_add_ps(cr_v, offset), max_8bit));
+  }
+
+  if (x < chroma_width) {
+    rgb_interleaved_to_cbcr420_row_scalar(rgb0 + 2 * x * bytes_per_pixel, rgb1 + 2 * x * bytes_per_pixel, bytes_per_pixel,
+                                          cb + x, cr + x, chroma_width - x, params);
+  }
+}
+
+
+// --- planar RGB input
+
+struct planar_constants_sse41
+{
+  __m128i max_value;
+  __m128 chroma_offset;
+  __m128 limited_range_offset;
+};
+
+static inline planar_constants_sse41 get_planar_constants(const RGB_to_YCbCr_float_parameters& params)
+{
+  return {_mm_set1_epi32(params.max_value),
+          _mm_set1_ps((float) params.chroma_offset),
+          _mm_set1_ps(params.limited_range_offset)};
+}
+
+
+static inline __m128 luma(__m128 r, __m128 g, __m128 b,
+                          const RGB_to_YCbCr_float_parameters& params, const planar_constants_sse41& k)
+{
+  __m128 v = weighted_sum(params.c[0], r, g, b);
+  if (!params.full_range) {
+    // (v * 219) / 256 + offset. The division by a power of two is exact and equal to the multiplication.
+    v = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(v, _mm_set1_ps(219.0f)), _mm_set1_ps(1.0f / 256)), k.limited_range_offset);
+  }
+
+  return v;
+}
+
+
+template<class Pixel>
+static inline void store_chroma(Pixel* cb, Pixel* cr, __m128 r, __m128 g, __m128 b,
+                                const RGB_to_YCbCr_float_parameters& params, const planar_constants_sse41& k)
+{
+  __m128 cb_v = weighted_sum(params.c[1], r, g, b);
+  __m128 cr_v = weighted_sum(params.c[2], r, g, b);
+
+  if (!params.full_range) {
+    const __m128 c224 = _mm_set1_ps(224.0f);
+    const __m128 c1_256 = _mm_set1_ps(1.0f / 256);
+    cb_v = _mm_mul_ps(_mm_mul_ps(cb_v, c224), c1_256);
+    cr_v = _mm_mul_ps(_mm_mul_ps(cr_v, c224), c1_256);
+  }
+
+  store_4(cb, to_pixel(_mm_add_ps(cb_v, k.chroma_offset), k.max_value));
+  store_4(cr, to_pixel(_mm_add_ps(cr_v, k.chroma_offset), k.max_value));
+}
+
+
+template<class Pixel>
+static void rgb_to_y_row_sse41(const Pixel* r, const Pixel* g, const Pixel* b,
+                               Pixel* y, uint32_t width,
+                               const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_sse41 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128 v = luma(_mm_cvtepi32_ps(load_4_as_epi32(r + x)),
+                    _mm_cvtepi32_ps(load_4_as_epi32(g + x)),
+                    _mm_cvtepi32_ps(load_4_as_epi32(b + x)), params, k);
+    store_4(y + x, to_pixel(v, k.max_value));
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_y_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                            (uint8_t*) y + x, width - x, params);
+    }
+    else {
+      rgb_to_y_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                             (uint16_t*) y + x, width - x, params);
+    }
+  }
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr_row_sse41(const Pixel* r, const Pixel* g, const Pixel* b,
+                                  Pixel* cb, Pixel* cr, uint32_t width,
+                                  const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_sse41 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    store_chroma(cb + x, cr + x,
+                 _mm_cvtepi32_ps(load_4_as_epi32(r + x)),
+                 _mm_cvtepi32_ps(load_4_as_epi32(g + x)),
+                 _mm_cvtepi32_ps(load_4_as_epi32(b + x)), params, k);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr_row_8_scalar((const uint8_t*) r + x, (const uint8_t*) g + x, (const uint8_t*) b + x,
+                               (uint8_t*) cb + x, (uint8_t*) cr + x, width - x, params);
+    }
+    else {
+      rgb_to_cbcr_row_16_scalar((const uint16_t*) r + x, (const uint16_t*) g + x, (const uint16_t*) b + x,
+                                (uint16_t*) cb + x, (uint16_t*) cr + x, width - x, params);
+    }
+  }
+}
+
+
+// Average of the 2x2 blocks of 8 samples in two rows. The scalar code sums the integer samples in float,
+// which is exact. Hence, summing them as integers gives the same result.
+template<class Pixel>
+static inline __m128 block_average_4(const Pixel* p0, const Pixel* p1)
+{
+  __m128i sum0 = _mm_hadd_epi32(load_4_as_epi32(p0), load_4_as_epi32(p0 + 4));
+  __m128i sum1 = _mm_hadd_epi32(load_4_as_epi32(p1), load_4_as_epi32(p1 + 4));
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(sum0, sum1)), _mm_set1_ps(0.25f));
+}
+
+
+template<class Pixel>
+static void rgb_to_cbcr420_row_sse41(const Pixel* r0, const Pixel* g0, const Pixel* b0,
+                                     const Pixel* r1, const Pixel* g1, const Pixel* b1,
+                                     Pixel* cb, Pixel* cr, uint32_t width,
+                                     const RGB_to_YCbCr_float_parameters& params)
+{
+  const planar_constants_sse41 k = get_planar_constants(params);
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    store_chroma(cb + x / 2, cr + x / 2,
+                 block_average_4(r0 + x, r1 + x),
+                 block_average_4(g0 + x, g1 + x),
+                 block_average_4(b0 + x, b1 + x), params, k);
+  }
+
+  if (x < width) {
+    if (sizeof(Pixel) == 1) {
+      rgb_to_cbcr420_row_8_scalar((const uint8_t*) r0 + x, (const uint8_t*) g0 + x, (const uint8_t*) b0 + x,
+                                  (const uint8_t*) r1 + x, (const uint8_t*) g1 + x, (const uint8_t*) b1 + x,
+                                  (uint8_t*) cb + x / 2, (uint8_t*) cr + x / 2, width - x, params);
+    }
+    else {
+      rgb_to_cbcr420_row_16_scalar((const uint16_t*) r0 + x, (const uint16_t*) g0 + x, (const uint16_t*) b0 + x,
+                                   (const uint16_t*) r1 + x, (const uint16_t*) g1 + x, (const uint16_t*) b1 + x,
+                                   (uint16_t*) cb + x / 2, (uint16_t*) cr + x / 2, width - x, params);
+    }
+  }
+}
+
+
+static void rgb_to_y_row_8_sse41(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                 uint8_t* y, uint32_t width,
+                                 const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_sse41(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_y_row_16_sse41(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                  uint16_t* y, uint32_t width,
+                                  const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_y_row_sse41(r, g, b, y, width, params);
+}
+
+
+static void rgb_to_cbcr_row_8_sse41(const uint8_t* r, const uint8_t* g, const uint8_t* b,
+                                    uint8_t* cb, uint8_t* cr, uint32_t width,
+                                    const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_sse41(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr_row_16_sse41(const uint16_t* r, const uint16_t* g, const uint16_t* b,
+                                     uint16_t* cb, uint16_t* cr, uint32_t width,
+                                     const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr_row_sse41(r, g, b, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_8_sse41(const uint8_t* r0, const uint8_t* g0, const uint8_t* b0,
+                                       const uint8_t* r1, const uint8_t* g1, const uint8_t* b1,
+                                       uint8_t* cb, uint8_t* cr, uint32_t width,
+                                       const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_sse41(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+static void rgb_to_cbcr420_row_16_sse41(const uint16_t* r0, const uint16_t* g0, const uint16_t* b0,
+                                        const uint16_t* r1, const uint16_t* g1, const uint16_t* b1,
+                                        uint16_t* cb, uint16_t* cr, uint32_t width,
+                                        const RGB_to_YCbCr_float_parameters& params)
+{
+  rgb_to_cbcr420_row_sse41(r0, g0, b0, r1, g1, b1, cb, cr, width, params);
+}
+
+
+// --- chroma downsampling
+
+static void average_420_row_8_sse41(const uint8_t* in0, const uint8_t* in1, uint8_t* out, uint32_t out_width)
+{
+  const __m128i ones = _mm_set1_epi8(1);
+  const __m128i two = _mm_set1_epi16(2);
+
+  auto averages_8 = [&](const uint8_t* p0, const uint8_t* p1) {
+    // pairwise horizontal sums as 16 bit
+    __m128i sum = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128((const __m128i*) p0), ones),
+                                _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*) p1), ones));
+    return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+  };
+
+  uint32_t x = 0;
+  for (; x + 16 <= out_width; x += 16) {
+    __m128i lo = averages_8(in0 + 2 * x, in1 + 2 * x);
+    __m128i hi = averages_8(in0 + 2 * x + 16, in1 + 2 * x + 16);
+    _mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi16(lo, hi));
+  }
+
+  if (x < out_width) {
+    average_420_row_8_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+static void average_420_row_16_sse41(const uint16_t* in0, const uint16_t* in1, uint16_t* out, uint32_t out_width)
+{
+  const __m128i two = _mm_set1_epi32(2);
+
+  uint32_t x = 0;
+  for (; x + 4 <= out_width; x += 4) {
+    const uint16_t* p0 = in0 + 2 * x;
+    const uint16_t* p1 = in1 + 2 * x;
+
+    __m128i sum = _mm_add_epi32(_mm_hadd_epi32(load_4_as_epi32(p0), load_4_as_epi32(p0 + 4)),
+                                _mm_hadd_epi32(load_4_as_epi32(p1), load_4_as_epi32(p1 + 4)));
+    store_4(out + x, _mm_srli_epi32(_mm_add_epi32(sum, two), 2));
+  }
+
+  if (x < out_width) {
+    average_420_row_16_scalar(in0 + 2 * x, in1 + 2 * x, out + x, out_width - x);
+  }
+}
+
+
+extern const RGB_to_YCbCr_kernels rgb2yuv_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  rgb_interleaved_to_y_row_sse41,
+  rgb_interleaved_to_cbcr420_row_sse41,
+  rgb_to_y_row_8_sse41,
+  rgb_to_y_row_16_sse41,
+  rgb_to_cbcr_row_8_sse41,
+  rgb_to_cbcr_row_16_sse41,
+  rgb_to_cbcr420_row_8_sse41,
+  rgb_to_cbcr420_row_16_sse41,
+  average_420_row_8_sse41,
+  average_420_row_16_sse41
+};
@@ -0,0 +1,151 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synthetic_images.h"
+#include "common_utils.h"
+#include "nclx.h"
+#include <random>
+
+
+ColorState make_synthetic_color_state(heif_colorspace colorspace, heif_chroma chroma, bool alpha, int bpp)
+{
+  ColorState state(colorspace, chroma, alpha, bpp);
+  state.nclx = nclx_profile::defaults();
+  state.nclx.replace_undefined_values_with_sRGB_defaults();
+  return state;
+}
+
+
+std::vector<std::pair<ColorState, ColorState>> get_common_color_conversions()
+{
+  const int bit_depths[] = {8, 10, 12};
+
+  std::vector<ColorState> decoded;
+  for (bool alpha : {false, true}) {
+    for (int bpp : bit_depths) {
+      for (heif_chroma chroma : {heif_chroma_420, heif_chroma_422, heif_chroma_444}) {
+        decoded.push_back(make_synthetic_color_state(heif_colorspace_YCbCr, chroma, alpha, bpp));
+      }
+      decoded.push_back(make_synthetic_color_state(heif_colorspace_monochrome, heif_chroma_monochrome, alpha, bpp));
+    }
+  }
+
+  std::vector<ColorState> rgb;
+  for (bool alpha : {false, true}) {
+    rgb.push_back(make_synthetic_color_state(heif_colorspace_RGB, alpha ? heif_chroma_interleaved_RGBA : heif_chroma_interleaved_RGB, alpha, 8));
+
+    for (int bpp : bit_depths) {
+      rgb.push_back(make_synthetic_color_state(heif_colorspace_RGB, heif_chroma_444, alpha, bpp));
+
+      if (bpp > 8) {
+        rgb.push_back(make_synthetic_color_state(heif_colorspace_RGB, alpha ? heif_chroma_interleaved_RRGGBBAA_LE : heif_chroma_interleaved_RRGGBB_LE, alpha, bpp));
+        rgb.push_back(make_synthetic_color_state(heif_colorspace_RGB, alpha ? heif_chroma_interleaved_RRGGBBAA_BE : heif_chroma_interleaved_RRGGBB_BE, alpha, bpp));
+      }
+    }
+  }
+
+  std::vector<std::pair<ColorState, ColorState>> conversions;
+
+  // --- decoding: YCbCr and monochrome into RGB of the same bit depth. Interleaved 8-bit RGB is also used for HDR input.
+
+  for (const auto& in : decoded) {
+    for (const auto& out : rgb) {
+      bool interleaved_8bit = (out.chroma == heif_chroma_interleaved_RGB || out.chroma == heif_chroma_interleaved_RGBA);
+      if (in.has_alpha == out.has_alpha &&
+          (in.bits_per_pixel == out.bits_per_pixel || interleaved_8bit)) {
+        conversions.emplace_back(in, out);
+      }
+    }
+  }
+
+  // --- encoding: RGB into YCbCr of the same bit depth
+
+  for (const auto& in : rgb) {
+    for (heif_chroma chroma : {heif_chroma_420, heif_chroma_422, heif_chroma_444}) {
+      conversions.emplace_back(in, make_synthetic_color_state(heif_colorspace_YCbCr, chroma, in.has_alpha, in.bits_per_pixel));
+    }
+  }
+
+  return conversions;
+}
+
+
+std::shared_ptr<HeifPixelImage> create_synthetic_image(const ColorState& state, uint32_t width, uint32_t height)
+{
+  std::mt19937 rng(state.bits_per_pixel);
+
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(width, height, state.colorspace, state.chroma);
+  img->set_color_profile_nclx(state.nclx);
+
+  std::vector<heif_channel> channels;
+  int components = num_interleaved_components_per_plane(state.chroma);
+
+  if (components > 1) {
+    channels = {heif_channel_interleaved};
+  }
+  else {
+    if (state.colorspace == heif_colorspace_YCbCr) {
+      channels = {heif_channel_Y, heif_channel_Cb, heif_channel_Cr};
+    }
+    else if (state.colorspace == heif_colorspace_monochrome) {
+      channels = {heif_channel_Y};
+    }
+    else if (state.colorspace == heif_colorspace_RGB) {
+      channels = {heif_channel_R, heif_channel_G, heif_channel_B};
+    }
+
+    if (state.has_alpha) {
+      channels.push_back(heif_channel_Alpha);
+    }
+  }
+
+  for (heif_channel channel : channels) {
+    uint32_t w = get_subsampled_size_h(width, channel, state.chroma, scaling_mode::round_up);
+    uint32_t h = get_subsampled_size_v(height, channel, state.chroma, scaling_mode::round_up);
+    int bpp = (channel == heif_channel_Alpha) ? state.get_alpha_bits_per_pixel() : state.bits_per_pixel;
+
+    if (img->add_channel(channel, w, h, bpp, nullptr)) {
+      return nullptr;
+    }
+
+    // Interleaved big-endian samples are byte-swapped, which does not matter here.
+
+    size_t stride;
+    uint8_t* p = img->get_channel_memory(channel, &stride);
+    uint32_t max_value = (1U << bpp) - 1;
+
+    for (uint32_t y = 0; y < h; y++) {
+      if (bpp > 8) {
+        auto* row = reinterpret_cast<uint16_t*>(p + y * stride);
+        for (uint32_t x = 0; x < w * components; x++) {
+          row[x] = static_cast<uint16_t>(rng() & max_value);
+        }
+      }
+      else {
+        for (uint32_t x = 0; x < w * components; x++) {
+          p[y * stride + x] = static_cast<uint8_t>(rng() & max_value);
+        }
+      }
+    }
+  }
+
+  return img;
+}
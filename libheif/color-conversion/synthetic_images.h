@@ -0,0 +1,41 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_SYNTHETIC_IMAGES_H
+#define LIBHEIF_COLORCONVERSION_SYNTHETIC_IMAGES_H
+
+#include "colorconversion.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Color states and images for measuring the color conversions. These are used by the cost calibration
+// and by the heif-bench-colorconv development tool.
+
+// A state with the default nclx profile.
+ColorState make_synthetic_color_state(heif_colorspace colorspace, heif_chroma chroma, bool alpha, int bpp);
+
+// The input and output states of typical decoding and encoding conversions.
+std::vector<std::pair<ColorState, ColorState>> get_common_color_conversions();
+
+// An image with random samples within the bit depth. Returns nullptr if the image cannot be created.
+std::shared_ptr<HeifPixelImage> create_synthetic_image(const ColorState& state, uint32_t width, uint32_t height);
+
+#endif
@@ -23,6 +23,94 @@
 #include "yuv2rgb.h"
 #include "nclx.h"
 #include "common_utils.h"
+#include <array>
+#include <algorithm>
+
+
+struct YCbCr_to_RGB_fixed_point_coefficients
+{
+  int32_t y_scale;
+  int32_t r_cr;
+  int32_t g_cb;
+  int32_t g_cr;
+  int32_t b_cb;
+};
+
+
+static YCbCr_to_RGB_fixed_point_coefficients compute_fixed_point_coefficients(const YCbCr_to_RGB_coefficients& coeffs,
+                                                                              bool full_range)
+{
+  // same range expansion factors as in the float conversion
+  float y_scale = full_range ? 1.0f : 1.1689f;
+  float chroma_scale = full_range ? 1.0f : 1.1429f;
+
+  auto to_fixed_point = [](float v) {
+    return static_cast<int32_t>(std::lround(v * (1 << YCbCr_to_RGB_fixed_point_precision)));
+  };
+
+  return {
+    to_fixed_point(y_scale),
+    to_fixed_point(coeffs.r_cr * chroma_scale),
+    to_fixed_point(coeffs.g_cb * chroma_scale),
+    to_fixed_point(coeffs.g_cr * chroma_scale),
+    to_fixed_point(coeffs.b_cb * chroma_scale)
+  };
+}
+
+
+static constexpr uint16_t num_tabulated_matrices = 15;
+
+// Fixed-point coefficients of all matrix_coefficients up to 14, for full range [0] and limited range [1].
+// Matrices 12 and 13 depend on the colour primaries and are computed when needed.
+static const std::array<std::array<YCbCr_to_RGB_fixed_point_coefficients, 2>, num_tabulated_matrices>&
+get_fixed_point_coefficients_table()
+{
+  static const auto table = [] {
+    std::array<std::array<YCbCr_to_RGB_fixed_point_coefficients, 2>, num_tabulated_matrices> t{};
+
+    for (uint16_t matrix = 0; matrix < num_tabulated_matrices; matrix++) {
+      YCbCr_to_RGB_coefficients coeffs = get_YCbCr_to_RGB_coefficients(matrix, heif_color_primaries_unspecified);
+      t[matrix][0] = compute_fixed_point_coefficients(coeffs, true);
+      t[matrix][1] = compute_fixed_point_coefficients(coeffs, false);
+    }
+
+    return t;
+  }();
+
+  return table;
+}
+
+
+YCbCr_to_RGB_fixed_point_parameters get_YCbCr_to_RGB_fixed_point_parameters(uint16_t matrix_coefficients,
+                                                                            uint16_t colour_primaries,
+                                                                            bool full_range,
+                                                                            int bpp,
+                                                                            int chroma_shift)
+{
+  YCbCr_to_RGB_fixed_point_coefficients coeffs;
+
+  if (matrix_coefficients < num_tabulated_matrices &&
+      matrix_coefficients != 12 && matrix_coefficients != 13) {
+    coeffs = get_fixed_point_coefficients_table()[matrix_coefficients][full_range ? 0 : 1];
+  }
+  else {
+    coeffs = compute_fixed_point_coefficients(get_YCbCr_to_RGB_coefficients(matrix_coefficients, colour_primaries),
+                                              full_range);
+  }
+
+  YCbCr_to_RGB_fixed_point_parameters params{};
+  params.y_scale = coeffs.y_scale;
+  params.r_cr = coeffs.r_cr;
+  params.g_cb = coeffs.g_cb;
+  params.g_cr = coeffs.g_cr;
+  params.b_cb = coeffs.b_cb;
+  params.y_offset = full_range ? 0 : (16 << (bpp - 8));
+  params.chroma_offset = 1 << (bpp - 1);
+  params.max_value = (1 << bpp) - 1;
+  params.chroma_shift = chroma_shift;
+
+  return params;
+}
 
 
 template<class Pixel>
@@ -83,25 +171,23 @@ Op_YCbCr_to_RGB<Pixel>::state_after_conversion(const ColorState& input_state,
   output_state.bits_per_pixel = input_state.bits_per_pixel;
   output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  // The special matrices are not handled by the kernels.
+  bool uses_kernels = (matrix != 0 && matrix != 8 && matrix != 16);
+
+  states.emplace_back(output_state, uses_kernels ? m_kernels->speed_costs : SpeedCosts_Unoptimized);
 
   return states;
 }
 
 
+// Creates the planar RGB output image with the bit depth of the YCbCr input.
 template<class Pixel>
-Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr_to_RGB<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                           const ColorState& input_state,
-                                           const ColorState& target_state,
-                                           const heif_color_conversion_options& options,
-                                           const heif_color_conversion_options_ext& options_ext,
-                                           const heif_security_limits* limits) const
+static Result<std::shared_ptr<HeifPixelImage>>
+create_planar_rgb_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                               const heif_security_limits* limits)
 {
   bool hdr = !std::is_same<Pixel, uint8_t>::value;
 
-  heif_chroma chroma = input->get_chroma_format();
-
   int bpp_y = input->get_bits_per_pixel(heif_channel_Y);
   int bpp_cb = input->get_bits_per_pixel(heif_channel_Cb);
   int bpp_cr = input->get_bits_per_pixel(heif_channel_Cr);
@@ -155,6 +241,49 @@ Op_YCbCr_to_RGB<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
     }
   }
 
+  return outimg;
+}
+
+
+template<class Pixel>
+Result<std::shared_ptr<HeifPixelImage>>
+Op_YCbCr_to_RGB<Pixel>::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                            const ColorState& input_state,
+                                            const ColorState& target_state,
+                                            const heif_color_conversion_options& options,
+                                            const heif_color_conversion_options_ext& options_ext,
+                                            const heif_security_limits* limits) const
+{
+  return create_planar_rgb_output_image<Pixel>(input, limits);
+}
+
+
+template<class Pixel>
+Error
+Op_YCbCr_to_RGB<Pixel>::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                       const std::shared_ptr<HeifPixelImage>& outimg,
+                                       const ColorState& input_state,
+                                       const ColorState& target_state,
+                                       const heif_color_conversion_options& options,
+                                       const heif_color_conversion_options_ext& options_ext,
+                                       uint32_t first_row, uint32_t end_row) const
+{
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
+
+  heif_chroma chroma = input->get_chroma_format();
+
+  int bpp_y = input->get_bits_per_pixel(heif_channel_Y);
+  int bpp_cb = input->get_bits_per_pixel(heif_channel_Cb);
+  int bpp_a = 0;
+
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+
+  if (has_alpha) {
+    bpp_a = input->get_bits_per_pixel(heif_channel_Alpha);
+  }
+
+  uint32_t width = input->get_width();
+
   const Pixel* in_y, * in_cb, * in_cr;
   size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0, in_a_stride = 0;
 
@@ -203,82 +332,134 @@ Op_YCbCr_to_RGB<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
   }
 
   int matrix_coeffs = 2;
+  uint16_t colour_primaries = heif_color_primaries_unspecified;
   bool full_range_flag = true;
   YCbCr_to_RGB_coefficients coeffs = YCbCr_to_RGB_coefficients::defaults();
   if (input->has_nclx_color_profile()) {
     nclx_profile colorProfile = input->get_color_profile_nclx();
 
     matrix_coeffs = colorProfile.get_matrix_coefficients();
+    colour_primaries = colorProfile.get_colour_primaries();
     full_range_flag = colorProfile.get_full_range_flag();
     coeffs = get_YCbCr_to_RGB_coefficients(colorProfile.get_matrix_coefficients(),
                                            colorProfile.get_colour_primaries());
   }
 
 
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < width; x++) {
-      int cx = (x >> shiftH);
-      int cy = (y >> shiftV);
-
-      if (matrix_coeffs == 0) {
-        if (full_range_flag) {
-          out_r[y * out_r_stride + x] = in_cr[cy * in_cr_stride + cx];
-          out_g[y * out_g_stride + x] = in_y[y * in_y_stride + x];
-          out_b[y * out_b_stride + x] = in_cb[cy * in_cb_stride + cx];
-        }
-        else {
-          // Convert from limited range to full range.
-          out_r[y * out_r_stride + x] = (Pixel) clip_f_u16((in_cr[cy * in_cr_stride + cx] - limited_range_offset) * 1.1429f, fullRange);
-          out_g[y * out_g_stride + x] = (Pixel) clip_f_u16((in_y[y * in_y_stride + x] - limited_range_offset) * 1.1689f, fullRange);
-          out_b[y * out_b_stride + x] = (Pixel) clip_f_u16((in_cb[cy * in_cb_stride + cx] - limited_range_offset) * 1.1429f, fullRange);
-        }
-      }
-      else if (matrix_coeffs == 8) {
-        // TODO: check this. I have no input image yet which is known to be correct.
-        // TODO: is there a coeff=8 with full_range=false ?
+  YCbCr_to_RGB_float_parameters params{};
+  params.r_cr = coeffs.r_cr;
+  params.g_cb = coeffs.g_cb;
+  params.g_cr = coeffs.g_cr;
+  params.b_cb = coeffs.b_cb;
+  params.full_range = full_range_flag;
+  params.limited_range_offset = limited_range_offset;
+  params.chroma_offset = halfRange;
+  params.max_value = fullRange;
+  params.chroma_shift = shiftH;
 
-        int yv = in_y[y * in_y_stride + x];
-        int cb = in_cb[cy * in_cb_stride + cx] - halfRange;
-        int cr = in_cr[cy * in_cr_stride + cx] - halfRange;
+  // The special matrices are not handled by the kernels.
+  bool use_kernels = (matrix_coeffs != 0 && matrix_coeffs != 8 && matrix_coeffs != 16); // TODO: matrix_coefficients = 11,14
 
-        out_r[y * out_r_stride + x] = (Pixel) (clip_int_u8(yv - cb + cr));
-        out_g[y * out_g_stride + x] = (Pixel) (clip_int_u8(yv + cb));
-        out_b[y * out_b_stride + x] = (Pixel) (clip_int_u8(yv - cb - cr));
+  // The fixed-point conversion is the default. The float conversion is used when explicitly requested.
+  bool use_fixed_point = use_kernels && !options_ext.use_float_arithmetic;
+
+  YCbCr_to_RGB_fixed_point_parameters fixed_point_params{};
+  if (use_fixed_point) {
+    fixed_point_params = get_YCbCr_to_RGB_fixed_point_parameters(static_cast<uint16_t>(matrix_coeffs), colour_primaries,
+                                                                 full_range_flag, bpp_y, shiftH);
+  }
+
+  uint32_t x, y;
+  for (y = first_row; y < end_row; y++) {
+    int cy = (y >> shiftV);
+
+    if (use_fixed_point) {
+      if (hdr) {
+        m_kernels->ycbcr_to_rgb_row_16_fixed_point((const uint16_t*) &in_y[y * in_y_stride],
+                                                   (const uint16_t*) &in_cb[cy * in_cb_stride],
+                                                   (const uint16_t*) &in_cr[cy * in_cr_stride],
+                                                   (uint16_t*) &out_r[y * out_r_stride],
+                                                   (uint16_t*) &out_g[y * out_g_stride],
+                                                   (uint16_t*) &out_b[y * out_b_stride],
+                                                   width, fixed_point_params);
+      }
+      else {
+        m_kernels->ycbcr_to_rgb_row_8_fixed_point((const uint8_t*) &in_y[y * in_y_stride],
+                                                  (const uint8_t*) &in_cb[cy * in_cb_stride],
+                                                  (const uint8_t*) &in_cr[cy * in_cr_stride],
+                                                  (uint8_t*) &out_r[y * out_r_stride],
+                                                  (uint8_t*) &out_g[y * out_g_stride],
+                                                  (uint8_t*) &out_b[y * out_b_stride],
+                                                  width, fixed_point_params);
       }
-      else if (matrix_coeffs == 16) {
-        int16_t yy = in_y[y * in_y_stride + x];
-        int16_t cb = static_cast<int16_t>(in_cb[cy * in_cb_stride + cx]) - halfRange_chroma;
-        int16_t cr = static_cast<int16_t>(in_cr[cy * in_cr_stride + cx]) - halfRange_chroma;
-
-        int16_t t = yy - (cb >> 1);
-        int16_t g = t + cb;
-        int16_t b = t - (cr>>1);
-        int16_t r = b + cr;
-
-        // TODO: we are extending the output RGB bpp by 2 bits because this function cannot do bit-depth
-        //       conversion yet. This should be ultimately replaced by a new function with implicit bit-depth reduction.
-
-        uint16_t max_rgb = static_cast<uint16_t>((1<<bpp_y)-1);
-        out_r[y * out_r_stride + x] = static_cast<Pixel>(clip_int_u16(r * 4, max_rgb));
-        out_g[y * out_g_stride + x] = static_cast<Pixel>(clip_int_u16(g * 4, max_rgb));
-        out_b[y * out_b_stride + x] = static_cast<Pixel>(clip_int_u16(b * 4, max_rgb));
+    }
+    else if (use_kernels) {
+      if (hdr) {
+        m_kernels->ycbcr_to_rgb_row_16((const uint16_t*) &in_y[y * in_y_stride],
+                                       (const uint16_t*) &in_cb[cy * in_cb_stride],
+                                       (const uint16_t*) &in_cr[cy * in_cr_stride],
+                                       (uint16_t*) &out_r[y * out_r_stride],
+                                       (uint16_t*) &out_g[y * out_g_stride],
+                                       (uint16_t*) &out_b[y * out_b_stride],
+                                       width, params);
+      }
+      else {
+        m_kernels->ycbcr_to_rgb_row_8((const uint8_t*) &in_y[y * in_y_stride],
+                                      (const uint8_t*) &in_cb[cy * in_cb_stride],
+                                      (const uint8_t*) &in_cr[cy * in_cr_stride],
+                                      (uint8_t*) &out_r[y * out_r_stride],
+                                      (uint8_t*) &out_g[y * out_g_stride],
+                                      (uint8_t*) &out_b[y * out_b_stride],
+                                      width, params);
       }
-      else { // TODO: matrix_coefficients = 11,14
-        float yv, cb, cr;
-        yv = static_cast<float>(in_y[y * in_y_stride + x] );
-        cb = static_cast<float>(in_cb[cy * in_cb_stride + cx] - halfRange);
-        cr = static_cast<float>(in_cr[cy * in_cr_stride + cx] - halfRange);
-
-        if (!full_range_flag) {
-          yv = (yv - limited_range_offset) * 1.1689f;
-          cb = cb * 1.1429f;
-          cr = cr * 1.1429f;
+    }
+    else {
+      for (x = 0; x < width; x++) {
+        int cx = (x >> shiftH);
+
+        if (matrix_coeffs == 0) {
+          if (full_range_flag) {
+            out_r[y * out_r_stride + x] = in_cr[cy * in_cr_stride + cx];
+            out_g[y * out_g_stride + x] = in_y[y * in_y_stride + x];
+            out_b[y * out_b_stride + x] = in_cb[cy * in_cb_stride + cx];
+          }
+          else {
+            // Convert from limited range to full range.
+            out_r[y * out_r_stride + x] = (Pixel) clip_f_u16((in_cr[cy * in_cr_stride + cx] - limited_range_offset) * 1.1429f, fullRange);
+            out_g[y * out_g_stride + x] = (Pixel) clip_f_u16((in_y[y * in_y_stride + x] - limited_range_offset) * 1.1689f, fullRange);
+            out_b[y * out_b_stride + x] = (Pixel) clip_f_u16((in_cb[cy * in_cb_stride + cx] - limited_range_offset) * 1.1429f, fullRange);
+          }
         }
+        else if (matrix_coeffs == 8) {
+          // TODO: check this. I have no input image yet which is known to be correct.
+          // TODO: is there a coeff=8 with full_range=false ?
+
+          int yv = in_y[y * in_y_stride + x];
+          int cb = in_cb[cy * in_cb_stride + cx] - halfRange;
+          int cr = in_cr[cy * in_cr_stride + cx] - halfRange;
 
-        out_r[y * out_r_stride + x] = (Pixel) (clip_f_u16(yv + coeffs.r_cr * cr, fullRange));
-        out_g[y * out_g_stride + x] = (Pixel) (clip_f_u16(yv + coeffs.g_cb * cb + coeffs.g_cr * cr, fullRange));
-        out_b[y * out_b_stride + x] = (Pixel) (clip_f_u16(yv + coeffs.b_cb * cb, fullRange));
+          out_r[y * out_r_stride + x] = (Pixel) (clip_int_u8(yv - cb + cr));
+          out_g[y * out_g_stride + x] = (Pixel) (clip_int_u8(yv + cb));
+          out_b[y * out_b_stride + x] = (Pixel) (clip_int_u8(yv - cb - cr));
+        }
+        else if (matrix_coeffs == 16) {
+          int16_t yy = in_y[y * in_y_stride + x];
+          int16_t cb = static_cast<int16_t>(in_cb[cy * in_cb_stride + cx]) - halfRange_chroma;
+          int16_t cr = static_cast<int16_t>(in_cr[cy * in_cr_stride + cx]) - halfRange_chroma;
+
+          int16_t t = yy - (cb >> 1);
+          int16_t g = t + cb;
+          int16_t b = t - (cr>>1);
+          int16_t r = b + cr;
+
+          // TODO: we are extending the output RGB bpp by 2 bits because this function cannot do bit-depth
+          //       conversion yet. This should be ultimately replaced by a new function with implicit bit-depth reduction.
+
+          uint16_t max_rgb = static_cast<uint16_t>((1<<bpp_y)-1);
+          out_r[y * out_r_stride + x] = static_cast<Pixel>(clip_int_u16(r * 4, max_rgb));
+          out_g[y * out_g_stride + x] = static_cast<Pixel>(clip_int_u16(g * 4, max_rgb));
+          out_b[y * out_b_stride + x] = static_cast<Pixel>(clip_int_u16(b * 4, max_rgb));
+        }
       }
     }
 
@@ -288,13 +469,266 @@ Op_YCbCr_to_RGB<Pixel>::convert_colorspace(const std::shared_ptr<const HeifPixel
     }
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 template class Op_YCbCr_to_RGB<uint8_t>;
 template class Op_YCbCr_to_RGB<uint16_t>;
 
 
+template<class Pixel>
+std::vector<ColorStateWithCost>
+Op_YCbCr_bilinear_to_RGB<Pixel>::state_after_conversion(const ColorState& input_state,
+                                                        const ColorState& target_state,
+                                                        const heif_color_conversion_options& options,
+                                                        const heif_color_conversion_options_ext& options_ext) const
+{
+  if (input_state.colorspace != heif_colorspace_YCbCr ||
+      (input_state.chroma != heif_chroma_422 &&
+       input_state.chroma != heif_chroma_420)) {
+    return {};
+  }
+
+  // this Op only implements the bilinear algorithm
+
+  if (options.preferred_chroma_upsampling_algorithm != heif_chroma_upsampling_bilinear) {
+    return {};
+  }
+
+  // The special matrices are not handled by the kernels.
+  int matrix = input_state.nclx.get_matrix_coefficients();
+  if (matrix == 0 || matrix == 8 || matrix == 11 || matrix == 14 || matrix == 16) {
+    return {};
+  }
+
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
+
+  if ((input_state.bits_per_pixel > 8) != hdr) {
+    return {};
+  }
+
+  if (input_state.bits_per_pixel < 8 ||
+      input_state.bits_per_pixel > 14) {
+    return {};
+  }
+
+  std::vector<ColorStateWithCost> states;
+
+  ColorState output_state;
+
+  // --- convert to RGB
+
+  output_state.colorspace = heif_colorspace_RGB;
+  output_state.chroma = heif_chroma_444;
+  output_state.has_alpha = input_state.has_alpha;  // we simply keep the old alpha plane
+  output_state.bits_per_pixel = input_state.bits_per_pixel;
+  output_state.alpha_bits_per_pixel = input_state.alpha_bits_per_pixel;
+
+  states.emplace_back(output_state, m_kernels->speed_costs);
+
+  return states;
+}
+
+
+template<class Pixel>
+Result<std::shared_ptr<HeifPixelImage>>
+Op_YCbCr_bilinear_to_RGB<Pixel>::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                                     const ColorState& input_state,
+                                                     const ColorState& target_state,
+                                                     const heif_color_conversion_options& options,
+                                                     const heif_color_conversion_options_ext& options_ext,
+                                                     const heif_security_limits* limits) const
+{
+  return create_planar_rgb_output_image<Pixel>(input, limits);
+}
+
+
+template<class Pixel>
+Error
+Op_YCbCr_bilinear_to_RGB<Pixel>::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                                const std::shared_ptr<HeifPixelImage>& outimg,
+                                                const ColorState& input_state,
+                                                const ColorState& target_state,
+                                                const heif_color_conversion_options& options,
+                                                const heif_color_conversion_options_ext& options_ext,
+                                                uint32_t first_row, uint32_t end_row) const
+{
+  bool hdr = !std::is_same<Pixel, uint8_t>::value;
+
+  bool vertical_subsampling = (input->get_chroma_format() == heif_chroma_420);
+
+  int bpp_y = input->get_bits_per_pixel(heif_channel_Y);
+  int bpp_a = 0;
+
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+
+  if (has_alpha) {
+    bpp_a = input->get_bits_per_pixel(heif_channel_Alpha);
+  }
+
+  uint32_t width = input->get_width();
+  uint32_t chroma_height = input->get_height(heif_channel_Cb);
+
+  const Pixel* in_y, * in_cb, * in_cr;
+  size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0, in_a_stride = 0;
+
+  Pixel* out_r, * out_g, * out_b;
+  size_t out_r_stride = 0, out_g_stride = 0, out_b_stride = 0, out_a_stride = 0;
+
+  in_y = (const Pixel*) input->get_channel_memory(heif_channel_Y, &in_y_stride);
+  in_cb = (const Pixel*) input->get_channel_memory(heif_channel_Cb, &in_cb_stride);
+  in_cr = (const Pixel*) input->get_channel_memory(heif_channel_Cr, &in_cr_stride);
+  out_r = (Pixel*) outimg->get_channel_memory(heif_channel_R, &out_r_stride);
+  out_g = (Pixel*) outimg->get_channel_memory(heif_channel_G, &out_g_stride);
+  out_b = (Pixel*) outimg->get_channel_memory(heif_channel_B, &out_b_stride);
+
+  // We only copy the alpha, do not access it as 16 bit
+  const uint8_t* in_a = nullptr;
+  uint8_t* out_a = nullptr;
+
+  if (has_alpha) {
+    in_a = input->get_channel_memory(heif_channel_Alpha, &in_a_stride);
+    out_a = outimg->get_channel_memory(heif_channel_Alpha, &out_a_stride);
+  }
+
+  if (hdr) {
+    in_y_stride /= 2;
+    in_cb_stride /= 2;
+    in_cr_stride /= 2;
+    out_r_stride /= 2;
+    out_g_stride /= 2;
+    out_b_stride /= 2;
+  }
+
+  int matrix_coeffs = 2;
+  uint16_t colour_primaries = heif_color_primaries_unspecified;
+  bool full_range_flag = true;
+  YCbCr_to_RGB_coefficients coeffs = YCbCr_to_RGB_coefficients::defaults();
+  if (input->has_nclx_color_profile()) {
+    nclx_profile colorProfile = input->get_color_profile_nclx();
+
+    matrix_coeffs = colorProfile.get_matrix_coefficients();
+    colour_primaries = colorProfile.get_colour_primaries();
+    full_range_flag = colorProfile.get_full_range_flag();
+    coeffs = get_YCbCr_to_RGB_coefficients(colorProfile.get_matrix_coefficients(),
+                                           colorProfile.get_colour_primaries());
+  }
+
+  // The upsampled chroma rows are in 4:4:4 layout.
+  YCbCr_to_RGB_float_parameters params{};
+  params.r_cr = coeffs.r_cr;
+  params.g_cb = coeffs.g_cb;
+  params.g_cr = coeffs.g_cr;
+  params.b_cb = coeffs.b_cb;
+  params.full_range = full_range_flag;
+  params.limited_range_offset = static_cast<float>(16 << (bpp_y - 8));
+  params.chroma_offset = 1 << (bpp_y - 1);
+  params.max_value = (1 << bpp_y) - 1;
+  params.chroma_shift = 0;
+
+  // The fixed-point conversion is the default. The float conversion is used when explicitly requested.
+  bool use_fixed_point = !options_ext.use_float_arithmetic;
+
+  YCbCr_to_RGB_fixed_point_parameters fixed_point_params{};
+  if (use_fixed_point) {
+    fixed_point_params = get_YCbCr_to_RGB_fixed_point_parameters(static_cast<uint16_t>(matrix_coeffs), colour_primaries,
+                                                                 full_range_flag, bpp_y, 0);
+  }
+
+  std::vector<Pixel> cb_row(width);
+  std::vector<Pixel> cr_row(width);
+
+  for (uint32_t y = first_row; y < end_row; y++) {
+
+    // --- upsample the chroma of this row (see upsample_bilinear_stripe() in chroma_sampling.cc)
+
+    uint32_t cy0 = y;
+    uint32_t cy1 = y;
+
+    if (vertical_subsampling) {
+      cy0 = y / 2;
+
+      if (y % 2 == 0) {
+        cy1 = (cy0 > 0 ? cy0 - 1 : cy0);
+      }
+      else {
+        cy1 = std::min(cy0 + 1, chroma_height - 1);
+      }
+    }
+
+    if (hdr) {
+      m_kernels->upsample_chroma_bilinear_row_16((const uint16_t*) &in_cb[cy0 * in_cb_stride],
+                                                 (const uint16_t*) &in_cb[cy1 * in_cb_stride],
+                                                 (uint16_t*) cb_row.data(), width);
+      m_kernels->upsample_chroma_bilinear_row_16((const uint16_t*) &in_cr[cy0 * in_cr_stride],
+                                                 (const uint16_t*) &in_cr[cy1 * in_cr_stride],
+                                                 (uint16_t*) cr_row.data(), width);
+    }
+    else {
+      m_kernels->upsample_chroma_bilinear_row_8((const uint8_t*) &in_cb[cy0 * in_cb_stride],
+                                                (const uint8_t*) &in_cb[cy1 * in_cb_stride],
+                                                (uint8_t*) cb_row.data(), width);
+      m_kernels->upsample_chroma_bilinear_row_8((const uint8_t*) &in_cr[cy0 * in_cr_stride],
+                                                (const uint8_t*) &in_cr[cy1 * in_cr_stride],
+                                                (uint8_t*) cr_row.data(), width);
+    }
+
+    // --- convert to RGB
+
+    if (use_fixed_point) {
+      if (hdr) {
+        m_kernels->ycbcr_to_rgb_row_16_fixed_point((const uint16_t*) &in_y[y * in_y_stride],
+                                                   (const uint16_t*) cb_row.data(),
+                                                   (const uint16_t*) cr_row.data(),
+                                                   (uint16_t*) &out_r[y * out_r_stride],
+                                                   (uint16_t*) &out_g[y * out_g_stride],
+                                                   (uint16_t*) &out_b[y * out_b_stride],
+                                                   width, fixed_point_params);
+      }
+      else {
+        m_kernels->ycbcr_to_rgb_row_8_fixed_point((const uint8_t*) &in_y[y * in_y_stride],
+                                                  (const uint8_t*) cb_row.data(),
+                                                  (const uint8_t*) cr_row.data(),
+                                                  (uint8_t*) &out_r[y * out_r_stride],
+                                                  (uint8_t*) &out_g[y * out_g_stride],
+                                                  (uint8_t*) &out_b[y * out_b_stride],
+                                                  width, fixed_point_params);
+      }
+    }
+    else {
+      if (hdr) {
+        m_kernels->ycbcr_to_rgb_row_16((const uint16_t*) &in_y[y * in_y_stride],
+                                       (const uint16_t*) cb_row.data(),
+                                       (const uint16_t*) cr_row.data(),
+                                       (uint16_t*) &out_r[y * out_r_stride],
+                                       (uint16_t*) &out_g[y * out_g_stride],
+                                       (uint16_t*) &out_b[y * out_b_stride],
+                                       width, params);
+      }
+      else {
+        m_kernels->ycbcr_to_rgb_row_8((const uint8_t*) &in_y[y * in_y_stride],
+                                      (const uint8_t*) cb_row.data(),
+                                      (const uint8_t*) cr_row.data(),
+                                      (uint8_t*) &out_r[y * out_r_stride],
+                                      (uint8_t*) &out_g[y * out_g_stride],
+                                      (uint8_t*) &out_b[y * out_b_stride],
+                                      width, params);
+      }
+    }
+
+    if (has_alpha) {
+      uint32_t alphaCopyWidth = (bpp_a > 8 ? width * 2 : width);
+      memcpy(&out_a[y * out_a_stride], &in_a[y * in_a_stride], alphaCopyWidth);
+    }
+  }
+
+  return Error::Ok;
+}
+
+template class Op_YCbCr_bilinear_to_RGB<uint8_t>;
+template class Op_YCbCr_bilinear_to_RGB<uint16_t>;
+
+
 std::vector<ColorStateWithCost>
 Op_YCbCr420_to_RGB24::state_after_conversion(const ColorState& input_state,
                                              const ColorState& target_state,
@@ -336,19 +770,19 @@ Op_YCbCr420_to_RGB24::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = false;
   output_state.bits_per_pixel = 8;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr420_to_RGB24::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                         const ColorState& input_state,
-                                         const ColorState& target_state,
-                                         const heif_color_conversion_options& options,
-                                         const heif_color_conversion_options_ext& options_ext,
-                                         const heif_security_limits* limits) const
+Op_YCbCr420_to_RGB24::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                          const ColorState& input_state,
+                                          const ColorState& target_state,
+                                          const heif_color_conversion_options& options,
+                                          const heif_color_conversion_options_ext& options_ext,
+                                          const heif_security_limits* limits) const
 {
   if (input->get_bits_per_pixel(heif_channel_Y) != 8 ||
       input->get_bits_per_pixel(heif_channel_Cb) != 8 ||
@@ -367,6 +801,21 @@ Op_YCbCr420_to_RGB24::convert_colorspace(const std::shared_ptr<const HeifPixelIm
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_YCbCr420_to_RGB24::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                     const std::shared_ptr<HeifPixelImage>& outimg,
+                                     const ColorState& input_state,
+                                     const ColorState& target_state,
+                                     const heif_color_conversion_options& options,
+                                     const heif_color_conversion_options_ext& options_ext,
+                                     uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+
   YCbCr_to_RGB_coefficients coeffs = YCbCr_to_RGB_coefficients::defaults();
   if (input->has_nclx_color_profile()) {
     auto colorProfile = input->get_color_profile_nclx();
@@ -374,10 +823,11 @@ Op_YCbCr420_to_RGB24::convert_colorspace(const std::shared_ptr<const HeifPixelIm
                                            colorProfile.get_colour_primaries());
   }
 
-  int r_cr = static_cast<int>(std::lround(256 * coeffs.r_cr));
-  int g_cr = static_cast<int>(std::lround(256 * coeffs.g_cr));
-  int g_cb = static_cast<int>(std::lround(256 * coeffs.g_cb));
-  int b_cb = static_cast<int>(std::lround(256 * coeffs.b_cb));
+  YCbCr_to_RGB_int8_coefficients int_coeffs{};
+  int_coeffs.r_cr = static_cast<int>(std::lround(256 * coeffs.r_cr));
+  int_coeffs.g_cr = static_cast<int>(std::lround(256 * coeffs.g_cr));
+  int_coeffs.g_cb = static_cast<int>(std::lround(256 * coeffs.g_cb));
+  int_coeffs.b_cb = static_cast<int>(std::lround(256 * coeffs.b_cb));
 
   const uint8_t* in_y, * in_cb, * in_cr;
   size_t in_y_stride = 0, in_cb_stride = 0, in_cr_stride = 0;
@@ -390,39 +840,15 @@ Op_YCbCr420_to_RGB24::convert_colorspace(const std::shared_ptr<const HeifPixelIm
   in_cr = input->get_channel_memory(heif_channel_Cr, &in_cr_stride);
   out_p = outimg->get_channel_memory(heif_channel_interleaved, &out_p_stride);
 
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
-    // Row pointers for input and output
-    const uint8_t* y_row = &in_y[y * in_y_stride];
-    const uint8_t* cb_row = &in_cb[(y / 2) * in_cb_stride];
-    const uint8_t* cr_row = &in_cr[(y / 2) * in_cr_stride];
-    uint8_t* out_row = &out_p[y * out_p_stride];
-
-    int cb = 0;
-    int cr = 0;
-    int r_offset = 0;
-    int g_offset = 0;
-    int b_offset = 0;
-
-    for (x = 0; x < width; x++) {
-      // Update color offsets every other pixel
-      if ((x & 1) == 0) {
-        cb = cb_row[x / 2] - 128;
-        cr = cr_row[x / 2] - 128;
-        r_offset = ((r_cr * cr + 128) >> 8);
-        g_offset = ((g_cb * cb + g_cr * cr + 128) >> 8);
-        b_offset = ((b_cb * cb + 128) >> 8);
-      }
-
-      int yv = y_row[x];
-      uint8_t* rgb = &out_row[3 * x];
-      rgb[0] = clip_int_u8(yv + r_offset);
-      rgb[1] = clip_int_u8(yv + g_offset);
-      rgb[2] = clip_int_u8(yv + b_offset);
-    }
+  for (uint32_t y = first_row; y < end_row; y++) {
+    m_kernels->ycbcr420_to_rgb24_row(&in_y[y * in_y_stride],
+                                     &in_cb[(y / 2) * in_cb_stride],
+                                     &in_cr[(y / 2) * in_cr_stride],
+                                     &out_p[y * out_p_stride],
+                                     width, int_coeffs);
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -472,19 +898,19 @@ Op_YCbCr420_to_RGB32::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = true;
   output_state.bits_per_pixel = 8;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr420_to_RGB32::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                         const ColorState& input_state,
-                                         const ColorState& target_state,
-                                         const heif_color_conversion_options& options,
-                                         const heif_color_conversion_options_ext& options_ext,
-                                         const heif_security_limits* limits) const
+Op_YCbCr420_to_RGB32::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                          const ColorState& input_state,
+                                          const ColorState& target_state,
+                                          const heif_color_conversion_options& options,
+                                          const heif_color_conversion_options_ext& options_ext,
+                                          const heif_security_limits* limits) const
 {
   if (input->get_bits_per_pixel(heif_channel_Y) != 8 ||
       input->get_bits_per_pixel(heif_channel_Cb) != 8 ||
@@ -503,6 +929,20 @@ Op_YCbCr420_to_RGB32::convert_colorspace(const std::shared_ptr<const HeifPixelIm
     return err;
   }
 
+  return outimg;
+}
+
+
+Error
+Op_YCbCr420_to_RGB32::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                     const std::shared_ptr<HeifPixelImage>& outimg,
+                                     const ColorState& input_state,
+                                     const ColorState& target_state,
+                                     const heif_color_conversion_options& options,
+                                     const heif_color_conversion_options_ext& options_ext,
+                                     uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
 
   // --- get conversion coefficients
 
@@ -513,10 +953,11 @@ Op_YCbCr420_to_RGB32::convert_colorspace(const std::shared_ptr<const HeifPixelIm
                                            colorProfile.get_colour_primaries());
   }
 
-  int r_cr = static_cast<int>(std::lround(256 * coeffs.r_cr));
-  int g_cr = static_cast<int>(std::lround(256 * coeffs.g_cr));
-  int g_cb = static_cast<int>(std::lround(256 * coeffs.g_cb));
-  int b_cb = static_cast<int>(std::lround(256 * coeffs.b_cb));
+  YCbCr_to_RGB_int8_coefficients int_coeffs{};
+  int_coeffs.r_cr = static_cast<int>(std::lround(256 * coeffs.r_cr));
+  int_coeffs.g_cr = static_cast<int>(std::lround(256 * coeffs.g_cr));
+  int_coeffs.g_cb = static_cast<int>(std::lround(256 * coeffs.g_cb));
+  int_coeffs.b_cb = static_cast<int>(std::lround(256 * coeffs.b_cb));
 
 
   const bool with_alpha = input->has_channel(heif_channel_Alpha);
@@ -536,29 +977,16 @@ Op_YCbCr420_to_RGB32::convert_colorspace(const std::shared_ptr<const HeifPixelIm
 
   out_p = outimg->get_channel_memory(heif_channel_interleaved, &out_p_stride);
 
-  uint32_t x, y;
-  for (y = 0; y < height; y++) {
-    for (x = 0; x < width; x++) {
-
-      int yv = (in_y[y * in_y_stride + x]);
-      int cb = (in_cb[y / 2 * in_cb_stride + x / 2] - 128);
-      int cr = (in_cr[y / 2 * in_cr_stride + x / 2] - 128);
-
-      out_p[y * out_p_stride + 4 * x + 0] = clip_int_u8(yv + ((r_cr * cr + 128) >> 8));
-      out_p[y * out_p_stride + 4 * x + 1] = clip_int_u8(yv + ((g_cb * cb + g_cr * cr + 128) >> 8));
-      out_p[y * out_p_stride + 4 * x + 2] = clip_int_u8(yv + ((b_cb * cb + 128) >> 8));
-
-
-      if (with_alpha) {
-        out_p[y * out_p_stride + 4 * x + 3] = in_a[y * in_a_stride + x];
-      }
-      else {
-        out_p[y * out_p_stride + 4 * x + 3] = 0xFF;
-      }
-    }
+  for (uint32_t y = first_row; y < end_row; y++) {
+    m_kernels->ycbcr420_to_rgb32_row(&in_y[y * in_y_stride],
+                                     &in_cb[(y / 2) * in_cb_stride],
+                                     &in_cr[(y / 2) * in_cr_stride],
+                                     with_alpha ? &in_a[y * in_a_stride] : nullptr,
+                                     &out_p[y * out_p_stride],
+                                     width, int_coeffs);
   }
 
-  return outimg;
+  return Error::Ok;
 }
 
 
@@ -604,7 +1032,7 @@ Op_YCbCr420_to_RRGGBBaa::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = input_state.has_alpha;
   output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
 
   output_state.colorspace = heif_colorspace_RGB;
@@ -613,19 +1041,19 @@ Op_YCbCr420_to_RRGGBBaa::state_after_conversion(const ColorState& input_state,
   output_state.has_alpha = input_state.has_alpha;
   output_state.bits_per_pixel = input_state.bits_per_pixel;
 
-  states.emplace_back(output_state, SpeedCosts_Unoptimized);
+  states.emplace_back(output_state, m_kernels->speed_costs);
 
   return states;
 }
 
 
 Result<std::shared_ptr<HeifPixelImage>>
-Op_YCbCr420_to_RRGGBBaa::convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                                            const ColorState& input_state,
-                                            const ColorState& target_state,
-                                            const heif_color_conversion_options& options,
-                                            const heif_color_conversion_options_ext& options_ext,
-                                            const heif_security_limits* limits) const
+Op_YCbCr420_to_RRGGBBaa::create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                                             const ColorState& input_state,
+                                             const ColorState& target_state,
+                                             const heif_color_conversion_options& options,
+                                             const heif_color_conversion_options_ext& options_ext,
+                                             const heif_security_limits* limits) const
 {
   uint32_t width = input->get_width();
   uint32_t height = input->get_height();
@@ -633,14 +1061,9 @@ Op_YCbCr420_to_RRGGBBaa::convert_colorspace(const std::shared_ptr<const HeifPixe
   int bpp = input->get_bits_per_pixel(heif_channel_Y);
   bool has_alpha = input->has_channel(heif_channel_Alpha);
 
-  int le = (target_state.chroma == heif_chroma_interleaved_RRGGBB_LE ||
-            target_state.chroma == heif_chroma_interleaved_RRGGBBAA_LE) ? 1 : 0;
-
   auto outimg = std::make_shared<HeifPixelImage>();
   outimg->create(width, height, heif_colorspace_RGB, target_state.chroma);
 
-  int bytesPerPixel = has_alpha ? 8 : 6;
-
   if (auto err = outimg->add_channel(heif_channel_interleaved, width, height, bpp, limits)) {
     return err;
   }
@@ -668,6 +1091,29 @@ Op_YCbCr420_to_RRGGBBaa::convert_colorspace(const std::shared_ptr<const HeifPixe
     }
   }
 
+  return outimg;
+}
+
+
+Error
+Op_YCbCr420_to_RRGGBBaa::convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                                        const std::shared_ptr<HeifPixelImage>& outimg,
+                                        const ColorState& input_state,
+                                        const ColorState& target_state,
+                                        const heif_color_conversion_options& options,
+                                        const heif_color_conversion_options_ext& options_ext,
+                                        uint32_t first_row, uint32_t end_row) const
+{
+  uint32_t width = input->get_width();
+
+  int bpp = input->get_bits_per_pixel(heif_channel_Y);
+  bool has_alpha = input->has_channel(heif_channel_Alpha);
+
+  int le = (target_state.chroma == heif_chroma_interleaved_RRGGBB_LE ||
+            target_state.chroma == heif_chroma_interleaved_RRGGBBAA_LE) ? 1 : 0;
+
+  int bytesPerPixel = has_alpha ? 8 : 6;
+
   uint8_t* out_p;
   size_t out_p_stride = 0;
 
@@ -686,50 +1132,82 @@ Op_YCbCr420_to_RRGGBBaa::convert_colorspace(const std::shared_ptr<const HeifPixe
   int maxval = (1 << bpp) - 1;
 
   bool full_range_flag = true;
+  uint16_t matrix_coeffs = 2;
+  uint16_t colour_primaries = heif_color_primaries_unspecified;
   YCbCr_to_RGB_coefficients coeffs = YCbCr_to_RGB_coefficients::defaults();
 
   if (input->has_nclx_color_profile()) {
     nclx_profile colorProfile = input->get_color_profile_nclx();
     full_range_flag = colorProfile.get_full_range_flag();
+    matrix_coeffs = colorProfile.get_matrix_coefficients();
+    colour_primaries = colorProfile.get_colour_primaries();
     coeffs = get_YCbCr_to_RGB_coefficients(colorProfile.get_matrix_coefficients(),
                                            colorProfile.get_colour_primaries());
   }
 
-  float limited_range_offset = static_cast<float>(16 << (bpp - 8));
-
-  for (uint32_t y = 0; y < height; y++) {
-    for (uint32_t x = 0; x < width; x++) {
+  YCbCr_to_RGB_float_parameters params{};
+  params.r_cr = coeffs.r_cr;
+  params.g_cb = coeffs.g_cb;
+  params.g_cr = coeffs.g_cr;
+  params.b_cb = coeffs.b_cb;
+  params.full_range = full_range_flag;
+  params.limited_range_offset = static_cast<float>(16 << (bpp - 8));
+  params.chroma_offset = 1 << (bpp - 1);
+  params.max_value = maxval;
+  params.chroma_shift = 1;
+
+  // The fixed-point arithmetic does not have enough headroom for more than 14 bits.
+  bool use_fixed_point = (bpp <= 14 && !options_ext.use_float_arithmetic);
+
+  YCbCr_to_RGB_fixed_point_parameters fixed_point_params{};
+  if (use_fixed_point) {
+    fixed_point_params = get_YCbCr_to_RGB_fixed_point_parameters(matrix_coeffs, colour_primaries,
+                                                                 full_range_flag, bpp, 1);
+  }
 
-      float y_ = in_y[y * in_y_stride / 2 + x];
-      float cb = static_cast<float>(in_cb[y / 2 * in_cb_stride / 2 + x / 2] - (1 << (bpp - 1)));
-      float cr = static_cast<float>(in_cr[y / 2 * in_cr_stride / 2 + x / 2] - (1 << (bpp - 1)));
+  // The kernel outputs planar RGB rows, which are then interleaved.
+  std::vector<uint16_t> rgb_rows(size_t{3} * width);
+  uint16_t* row_r = rgb_rows.data();
+  uint16_t* row_g = row_r + width;
+  uint16_t* row_b = row_g + width;
+
+  for (uint32_t y = first_row; y < end_row; y++) {
+    if (use_fixed_point) {
+      m_kernels->ycbcr_to_rgb_row_16_fixed_point(&in_y[y * in_y_stride / 2],
+                                                 &in_cb[y / 2 * in_cb_stride / 2],
+                                                 &in_cr[y / 2 * in_cr_stride / 2],
+                                                 row_r, row_g, row_b, width, fixed_point_params);
+    }
+    else {
+      m_kernels->ycbcr_to_rgb_row_16(&in_y[y * in_y_stride / 2],
+                                     &in_cb[y / 2 * in_cb_stride / 2],
+                                     &in_cr[y / 2 * in_cr_stride / 2],
+                                     row_r, row_g, row_b, width, params);
+    }
 
-      if (!full_range_flag) {
-        y_ = (y_ - limited_range_offset) * 1.1689f;
-        cb = cb * 1.1429f;
-        cr = cr * 1.1429f;
-      }
+    uint8_t* out_row = &out_p[y * out_p_stride];
 
-      int r = clip_f_u16(y_ + coeffs.r_cr * cr, maxval);
-      int g = clip_f_u16(y_ + coeffs.g_cb * cb + coeffs.g_cr * cr, maxval);
-      int b = clip_f_u16(y_ + coeffs.b_cb * cb, maxval);
+    for (uint32_t x = 0; x < width; x++) {
+      uint16_t r = row_r[x];
+      uint16_t g = row_g[x];
+      uint16_t b = row_b[x];
 
-      out_p[y * out_p_stride + bytesPerPixel * x + 0 + le] = (uint8_t) (r >> 8);
-      out_p[y * out_p_stride + bytesPerPixel * x + 2 + le] = (uint8_t) (g >> 8);
-      out_p[y * out_p_stride + bytesPerPixel * x + 4 + le] = (uint8_t) (b >> 8);
+      out_row[bytesPerPixel * x + 0 + le] = (uint8_t) (r >> 8);
+      out_row[bytesPerPixel * x + 2 + le] = (uint8_t) (g >> 8);
+      out_row[bytesPerPixel * x + 4 + le] = (uint8_t) (b >> 8);
 
-      out_p[y * out_p_stride + bytesPerPixel * x + 1 - le] = (uint8_t) (r & 0xff);
-      out_p[y * out_p_stride + bytesPerPixel * x + 3 - le] = (uint8_t) (g & 0xff);
-      out_p[y * out_p_stride + bytesPerPixel * x + 5 - le] = (uint8_t) (b & 0xff);
+      out_row[bytesPerPixel * x + 1 - le] = (uint8_t) (r & 0xff);
+      out_row[bytesPerPixel * x + 3 - le] = (uint8_t) (g & 0xff);
+      out_row[bytesPerPixel * x + 5 - le] = (uint8_t) (b & 0xff);
 
       if (has_alpha) {
-        out_p[y * out_p_stride + 8 * x + 6 + le] = (uint8_t) (in_a[y * in_a_stride / 2 + x] >> 8);
-        out_p[y * out_p_stride + 8 * x + 7 - le] = (uint8_t) (in_a[y * in_a_stride / 2 + x] & 0xff);
+        out_row[8 * x + 6 + le] = (uint8_t) (in_a[y * in_a_stride / 2 + x] >> 8);
+        out_row[8 * x + 7 - le] = (uint8_t) (in_a[y * in_a_stride / 2 + x] & 0xff);
       }
     }
   }
 
 
-  return outimg;
+  return Error::Ok;
 }
 
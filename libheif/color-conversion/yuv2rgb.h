@@ -25,12 +25,62 @@
 #include <vector>
 #include <memory>
 #include "colorconversion.h"
+#include "yuv2rgb_kernels.h"
 
 
+// Returns the parameters of the fixed-point conversion. The coefficients of all matrices that do not
+// depend on the colour primaries are taken from a precomputed table.
+YCbCr_to_RGB_fixed_point_parameters get_YCbCr_to_RGB_fixed_point_parameters(uint16_t matrix_coefficients,
+                                                                            uint16_t colour_primaries,
+                                                                            bool full_range,
+                                                                            int bpp,
+                                                                            int chroma_shift);
+
+
+template<class Pixel>
+class Op_YCbCr_to_RGB : public StripedColorConversionOperation
+{
+public:
+  // The Op is registered once with the scalar kernels and once with the fastest vectorized kernels.
+  explicit Op_YCbCr_to_RGB(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
+  std::vector<ColorStateWithCost>
+  state_after_conversion(const ColorState& input_state,
+                         const ColorState& target_state,
+                         const heif_color_conversion_options& options,
+                         const heif_color_conversion_options_ext& options_ext) const override;
+
+  Result<std::shared_ptr<HeifPixelImage>>
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
+};
+
+
+// Bilinear chroma upsampling of 4:2:0 and 4:2:2 combined with the conversion to RGB.
+// The upsampled chroma rows are only kept in row buffers, the 4:4:4 image is never allocated.
+// The result is identical to Op_YCbCr420_bilinear_to_YCbCr444 / Op_YCbCr422_bilinear_to_YCbCr444 followed by Op_YCbCr_to_RGB.
 template<class Pixel>
-class Op_YCbCr_to_RGB : public ColorConversionOperation
+class Op_YCbCr_bilinear_to_RGB : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr_bilinear_to_RGB(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -38,18 +88,35 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+  // 4:2:0 chroma rows are interpolated vertically.
+  bool needs_neighboring_rows(const ColorState& input_state) const override { return input_state.chroma == heif_chroma_420; }
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 
-class Op_YCbCr420_to_RGB24 : public ColorConversionOperation
+class Op_YCbCr420_to_RGB24 : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr420_to_RGB24(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -57,18 +124,32 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 
-class Op_YCbCr420_to_RGB32 : public ColorConversionOperation
+class Op_YCbCr420_to_RGB32 : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr420_to_RGB32(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -76,18 +157,32 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 
-class Op_YCbCr420_to_RRGGBBaa : public ColorConversionOperation
+class Op_YCbCr420_to_RRGGBBaa : public StripedColorConversionOperation
 {
 public:
+  explicit Op_YCbCr420_to_RRGGBBaa(const YCbCr_to_RGB_kernels& kernels = get_scalar_YCbCr_to_RGB_kernels()) : m_kernels(&kernels) {}
+
   std::vector<ColorStateWithCost>
   state_after_conversion(const ColorState& input_state,
                          const ColorState& target_state,
@@ -95,12 +190,24 @@ public:
                          const heif_color_conversion_options_ext& options_ext) const override;
 
   Result<std::shared_ptr<HeifPixelImage>>
-  convert_colorspace(const std::shared_ptr<const HeifPixelImage>& input,
-                     const ColorState& input_state,
-                     const ColorState& target_state,
-                     const heif_color_conversion_options& options,
-                     const heif_color_conversion_options_ext& options_ext,
-                     const heif_security_limits* limits) const override;
+  create_output_image(const std::shared_ptr<const HeifPixelImage>& input,
+                      const ColorState& input_state,
+                      const ColorState& target_state,
+                      const heif_color_conversion_options& options,
+                      const heif_color_conversion_options_ext& options_ext,
+                      const heif_security_limits* limits) const override;
+
+  Error
+  convert_stripe(const std::shared_ptr<const HeifPixelImage>& input,
+                 const std::shared_ptr<HeifPixelImage>& output,
+                 const ColorState& input_state,
+                 const ColorState& target_state,
+                 const heif_color_conversion_options& options,
+                 const heif_color_conversion_options_ext& options_ext,
+                 uint32_t first_row, uint32_t end_row) const override;
+
+private:
+  const YCbCr_to_RGB_kernels* m_kernels;
 };
 
 #endif //LIBHEIF_COLORCONVERSION_YUV2RGB_H
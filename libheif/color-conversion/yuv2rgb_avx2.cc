@@ -0,0 +1,466 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with AVX2 enabled. See yuv2rgb_kernels.h.
+
+#include "yuv2rgb_kernels.h"
+#include "colorconversion.h"
+#include <immintrin.h>
+#include <cstring>
+
+
+static inline __m256i coefficient_pairs(int32_t c_cb, int32_t c_cr)
+{
+  return _mm256_set1_epi32((int32_t) (((uint32_t) (uint16_t) c_cr << 16) | (uint16_t) c_cb));
+}
+
+
+// Computes the RGB offsets (the chroma part of the conversion) of 16 chroma samples as 16-bit values.
+// _mm256_madd_epi16 computes the sums of the 32-bit products exactly, equal to the scalar integer code.
+static inline void chroma_offsets_16(const uint8_t* cb, const uint8_t* cr,
+                                     const YCbCr_to_RGB_int8_coefficients& coeffs,
+                                     __m256i& r_offset, __m256i& g_offset, __m256i& b_offset)
+{
+  const __m256i c128_16 = _mm256_set1_epi16(128);
+  const __m256i c128_32 = _mm256_set1_epi32(128);
+
+  __m256i cb16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) cb)), c128_16);
+  __m256i cr16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) cr)), c128_16);
+
+  // (cb,cr) pairs, lanes: [0..3 | 8..11] and [4..7 | 12..15]
+  __m256i cbcr_lo = _mm256_unpacklo_epi16(cb16, cr16);
+  __m256i cbcr_hi = _mm256_unpackhi_epi16(cb16, cr16);
+
+  auto offset = [&](const __m256i& c) {
+    __m256i lo = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cbcr_lo, c), c128_32), 8);
+    __m256i hi = _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(cbcr_hi, c), c128_32), 8);
+    return _mm256_packs_epi32(lo, hi); // back in sample order: [0..7 | 8..15]
+  };
+
+  r_offset = offset(coefficient_pairs(0, coeffs.r_cr));
+  g_offset = offset(coefficient_pairs(coeffs.g_cb, coeffs.g_cr));
+  b_offset = offset(coefficient_pairs(coeffs.b_cb, 0));
+}
+
+
+// Adds the chroma offsets of 16 chroma samples to 32 luma samples.
+// y_lo/y_hi hold the luma samples [0..7 | 16..23] and [8..15 | 24..31], which matches the upsampled offsets.
+static inline __m256i add_offsets_32(__m256i y_lo, __m256i y_hi, __m256i offset)
+{
+  __m256i lo = _mm256_add_epi16(y_lo, _mm256_unpacklo_epi16(offset, offset));
+  __m256i hi = _mm256_add_epi16(y_hi, _mm256_unpackhi_epi16(offset, offset));
+  return _mm256_packus_epi16(lo, hi);
+}
+
+
+// Interleaves 32 pixels into RGBA. The output lanes hold the pixels
+// q[0]: [0..3 | 16..19], q[1]: [4..7 | 20..23], q[2]: [8..11 | 24..27], q[3]: [12..15 | 28..31].
+static inline void interleave_rgba_32(__m256i r, __m256i g, __m256i b, __m256i a, __m256i q[4])
+{
+  __m256i rg_lo = _mm256_unpacklo_epi8(r, g);
+  __m256i rg_hi = _mm256_unpackhi_epi8(r, g);
+  __m256i ba_lo = _mm256_unpacklo_epi8(b, a);
+  __m256i ba_hi = _mm256_unpackhi_epi8(b, a);
+
+  q[0] = _mm256_unpacklo_epi16(rg_lo, ba_lo);
+  q[1] = _mm256_unpackhi_epi16(rg_lo, ba_lo);
+  q[2] = _mm256_unpacklo_epi16(rg_hi, ba_hi);
+  q[3] = _mm256_unpackhi_epi16(rg_hi, ba_hi);
+}
+
+
+// Stores four groups of 4 RGB pixels (12 bytes at the start of each vector) as 48 consecutive bytes.
+static inline void store_rgb_4x4(uint8_t* out, __m128i p0, __m128i p1, __m128i p2, __m128i p3)
+{
+  _mm_storeu_si128((__m128i*) (out + 0), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+  _mm_storeu_si128((__m128i*) (out + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+  _mm_storeu_si128((__m128i*) (out + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+}
+
+
+static void ycbcr420_to_rgb_row_avx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                     uint8_t* out, uint32_t width, bool rgba,
+                                     const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i opaque = _mm256_set1_epi8(-1);
+
+  // remove the 4th byte of each pixel, leaving 12 bytes per 128-bit lane
+  const __m256i drop_alpha = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                              0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i r_offset, g_offset, b_offset;
+    chroma_offsets_16(cb + x / 2, cr + x / 2, coeffs, r_offset, g_offset, b_offset);
+
+    __m256i y8 = _mm256_loadu_si256((const __m256i*) (y + x));
+    __m256i y_lo = _mm256_unpacklo_epi8(y8, zero);
+    __m256i y_hi = _mm256_unpackhi_epi8(y8, zero);
+
+    __m256i r = add_offsets_32(y_lo, y_hi, r_offset);
+    __m256i g = add_offsets_32(y_lo, y_hi, g_offset);
+    __m256i b = add_offsets_32(y_lo, y_hi, b_offset);
+
+    if (rgba) {
+      __m256i a = alpha ? _mm256_loadu_si256((const __m256i*) (alpha + x)) : opaque;
+
+      __m256i q[4];
+      interleave_rgba_32(r, g, b, a, q);
+
+      uint8_t* o = out + 4 * x;
+      _mm256_storeu_si256((__m256i*) (o + 0), _mm256_permute2x128_si256(q[0], q[1], 0x20));
+      _mm256_storeu_si256((__m256i*) (o + 32), _mm256_permute2x128_si256(q[2], q[3], 0x20));
+      _mm256_storeu_si256((__m256i*) (o + 64), _mm256_permute2x128_si256(q[0], q[1], 0x31));
+      _mm256_storeu_si256((__m256i*) (o + 96), _mm256_permute2x128_si256(q[2], q[3], 0x31));
+    }
+    else {
+      __m256i q[4];
+      interleave_rgba_32(r, g, b, zero, q);
+      for (auto& v : q) {
+        v = _mm256_shuffle_epi8(v, drop_alpha);
+      }
+
+      uint8_t* o = out + 3 * x;
+      store_rgb_4x4(o, _mm256_castsi256_si128(q[0]), _mm256_castsi256_si128(q[1]),
+                    _mm256_castsi256_si128(q[2]), _mm256_castsi256_si128(q[3]));
+      store_rgb_4x4(o + 48, _mm256_extracti128_si256(q[0], 1), _mm256_extracti128_si256(q[1], 1),
+                    _mm256_extracti128_si256(q[2], 1), _mm256_extracti128_si256(q[3], 1));
+    }
+  }
+
+  if (x < width) {
+    if (rgba) {
+      ycbcr420_to_rgb32_row_scalar(y + x, cb + x / 2, cr + x / 2, alpha ? alpha + x : nullptr,
+                                   out + 4 * x, width - x, coeffs);
+    }
+    else {
+      ycbcr420_to_rgb24_row_scalar(y + x, cb + x / 2, cr + x / 2, out + 3 * x, width - x, coeffs);
+    }
+  }
+}
+
+
+static void ycbcr420_to_rgb24_row_avx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                       uint8_t* out, uint32_t width,
+                                       const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_avx2(y, cb, cr, nullptr, out, width, false, coeffs);
+}
+
+
+static void ycbcr420_to_rgb32_row_avx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                       uint8_t* out, uint32_t width,
+                                       const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_avx2(y, cb, cr, alpha, out, width, true, coeffs);
+}
+
+
+// --- float kernels
+
+static inline __m256i load_8_as_epi32(const uint8_t* p)
+{
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) p));
+}
+
+static inline __m256i load_8_as_epi32(const uint16_t* p)
+{
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) p));
+}
+
+static inline __m128i load_4_as_epi32(const uint8_t* p)
+{
+  int32_t v;
+  memcpy(&v, p, 4);
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static inline __m128i load_4_as_epi32(const uint16_t* p)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) p));
+}
+
+static inline void store_8(uint8_t* p, __m256i v)
+{
+  __m128i v16 = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  _mm_storel_epi64((__m128i*) p, _mm_packus_epi16(v16, v16));
+}
+
+static inline void store_8(uint16_t* p, __m256i v)
+{
+  _mm_storeu_si128((__m128i*) p, _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+}
+
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_avx2(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                  Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                  const YCbCr_to_RGB_float_parameters& params)
+{
+  const __m256 r_cr = _mm256_set1_ps(params.r_cr);
+  const __m256 g_cb = _mm256_set1_ps(params.g_cb);
+  const __m256 g_cr = _mm256_set1_ps(params.g_cr);
+  const __m256 b_cb = _mm256_set1_ps(params.b_cb);
+  const __m256 luma_scale = _mm256_set1_ps(1.1689f);
+  const __m256 chroma_scale = _mm256_set1_ps(1.1429f);
+  const __m256 limited_range_offset = _mm256_set1_ps(params.limited_range_offset);
+  const __m256i chroma_offset = _mm256_set1_epi32(params.chroma_offset);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256i max_value = _mm256_set1_epi32(params.max_value);
+  const __m256i zero = _mm256_setzero_si256();
+
+  auto to_pixel = [&](__m256 v) {
+    __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+    return _mm256_min_epi32(_mm256_max_epi32(i, zero), max_value);
+  };
+
+  auto load_chroma = [&](const Pixel* c) {
+    if (params.chroma_shift) {
+      __m128 c4 = _mm_cvtepi32_ps(_mm_sub_epi32(load_4_as_epi32(c), _mm256_castsi256_si128(chroma_offset)));
+      return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_unpacklo_ps(c4, c4)), _mm_unpackhi_ps(c4, c4), 1);
+    }
+    else {
+      return _mm256_cvtepi32_ps(_mm256_sub_epi32(load_8_as_epi32(c), chroma_offset));
+    }
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    __m256 y_v = _mm256_cvtepi32_ps(load_8_as_epi32(y + x));
+    __m256 cb_v = load_chroma(cb + cx);
+    __m256 cr_v = load_chroma(cr + cx);
+
+    if (!params.full_range) {
+      y_v = _mm256_mul_ps(_mm256_sub_ps(y_v, limited_range_offset), luma_scale);
+      cb_v = _mm256_mul_ps(cb_v, chroma_scale);
+      cr_v = _mm256_mul_ps(cr_v, chroma_scale);
+    }
+
+    // Note: no fused multiply-add to get the same rounding as the scalar code
+    store_8(r + x, to_pixel(_mm256_add_ps(y_v, _mm256_mul_ps(r_cr, cr_v))));
+    store_8(g + x, to_pixel(_mm256_add_ps(_mm256_add_ps(y_v, _mm256_mul_ps(g_cb, cb_v)), _mm256_mul_ps(g_cr, cr_v))));
+    store_8(b + x, to_pixel(_mm256_add_ps(y_v, _mm256_mul_ps(b_cb, cb_v))));
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                 (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_avx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                    uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                    const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_avx2(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_avx2(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                     uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                     const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_avx2(y, cb, cr, r, g, b, width, params);
+}
+
+
+// --- fixed-point kernels
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_fixed_point_avx2(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                              Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                              const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  const __m256i y_scale = _mm256_set1_epi32(params.y_scale);
+  const __m256i r_cr = _mm256_set1_epi32(params.r_cr);
+  const __m256i g_cb = _mm256_set1_epi32(params.g_cb);
+  const __m256i g_cr = _mm256_set1_epi32(params.g_cr);
+  const __m256i b_cb = _mm256_set1_epi32(params.b_cb);
+  const __m256i y_offset = _mm256_set1_epi32(params.y_offset);
+  const __m256i chroma_offset = _mm256_set1_epi32(params.chroma_offset);
+  const __m256i rounding = _mm256_set1_epi32(1 << (YCbCr_to_RGB_fixed_point_precision - 1));
+  const __m256i max_value = _mm256_set1_epi32(params.max_value);
+  const __m256i zero = _mm256_setzero_si256();
+
+  auto to_pixel = [&](__m256i v) {
+    v = _mm256_srai_epi32(v, YCbCr_to_RGB_fixed_point_precision);
+    return _mm256_min_epi32(_mm256_max_epi32(v, zero), max_value);
+  };
+
+  // The chroma samples are loaded with duplication for horizontally subsampled chroma.
+  auto load_chroma = [&](const Pixel* c) {
+    if (params.chroma_shift) {
+      __m128i c4 = _mm_sub_epi32(load_4_as_epi32(c), _mm256_castsi256_si128(chroma_offset));
+      return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi32(c4, c4)), _mm_unpackhi_epi32(c4, c4), 1);
+    }
+    else {
+      return _mm256_sub_epi32(load_8_as_epi32(c), chroma_offset);
+    }
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    __m256i y_v = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(load_8_as_epi32(y + x), y_offset), y_scale), rounding);
+    __m256i cb_v = load_chroma(cb + cx);
+    __m256i cr_v = load_chroma(cr + cx);
+
+    store_8(r + x, to_pixel(_mm256_add_epi32(y_v, _mm256_mullo_epi32(r_cr, cr_v))));
+    store_8(g + x, to_pixel(_mm256_add_epi32(_mm256_add_epi32(y_v, _mm256_mullo_epi32(g_cb, cb_v)), _mm256_mullo_epi32(g_cr, cr_v))));
+    store_8(b + x, to_pixel(_mm256_add_epi32(y_v, _mm256_mullo_epi32(b_cb, cb_v))));
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_fixed_point_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                            (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_fixed_point_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                             (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_fixed_point_avx2(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                                uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                                const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_avx2(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_fixed_point_avx2(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                                 uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                                 const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_avx2(y, cb, cr, r, g, b, width, params);
+}
+
+
+// Vertical sums 3*row0 + row1 and the interpolated output samples, see upsample_chroma_bilinear_row_scalar().
+// The two output samples of each pair are interleaved by combining them into one wider lane.
+
+static void upsample_chroma_bilinear_row_8_avx2(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const __m256i rounding = _mm256_set1_epi16(8);
+
+  uint32_t i = 0;
+  for (; i + 16 <= num_pairs; i += 16) {
+    __m256i a0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (row0 + i)));
+    __m256i a1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (row0 + i + 1)));
+    __m256i b0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (row1 + i)));
+    __m256i b1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*) (row1 + i + 1)));
+
+    __m256i v0 = _mm256_add_epi16(_mm256_add_epi16(a0, _mm256_slli_epi16(a0, 1)), b0);
+    __m256i v1 = _mm256_add_epi16(_mm256_add_epi16(a1, _mm256_slli_epi16(a1, 1)), b1);
+
+    __m256i first = _mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(v0, _mm256_slli_epi16(v0, 1)), v1), rounding);
+    __m256i second = _mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(v1, _mm256_slli_epi16(v1, 1)), v0), rounding);
+
+    __m256i interleaved = _mm256_or_si256(_mm256_srli_epi16(first, 4),
+                                          _mm256_slli_epi16(_mm256_srli_epi16(second, 4), 8));
+
+    _mm256_storeu_si256((__m256i*) (out + 2 * i + 1), interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_8_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint8_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint8_t last = out[2 * i];
+  upsample_chroma_bilinear_row_8_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+static void upsample_chroma_bilinear_row_16_avx2(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const __m256i rounding = _mm256_set1_epi32(8);
+
+  uint32_t i = 0;
+  for (; i + 8 <= num_pairs; i += 8) {
+    __m256i a0 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (row0 + i)));
+    __m256i a1 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (row0 + i + 1)));
+    __m256i b0 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (row1 + i)));
+    __m256i b1 = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*) (row1 + i + 1)));
+
+    __m256i v0 = _mm256_add_epi32(_mm256_add_epi32(a0, _mm256_slli_epi32(a0, 1)), b0);
+    __m256i v1 = _mm256_add_epi32(_mm256_add_epi32(a1, _mm256_slli_epi32(a1, 1)), b1);
+
+    __m256i first = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(v0, _mm256_slli_epi32(v0, 1)), v1), rounding);
+    __m256i second = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(v1, _mm256_slli_epi32(v1, 1)), v0), rounding);
+
+    __m256i interleaved = _mm256_or_si256(_mm256_srli_epi32(first, 4),
+                                          _mm256_slli_epi32(_mm256_srli_epi32(second, 4), 16));
+
+    _mm256_storeu_si256((__m256i*) (out + 2 * i + 1), interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_16_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint16_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint16_t last = out[2 * i];
+  upsample_chroma_bilinear_row_16_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_avx2{
+  "avx2",
+  SpeedCosts_OptimizedSoftware,
+  ycbcr420_to_rgb24_row_avx2,
+  ycbcr420_to_rgb32_row_avx2,
+  ycbcr_to_rgb_row_8_avx2,
+  ycbcr_to_rgb_row_16_avx2,
+  ycbcr_to_rgb_row_8_fixed_point_avx2,
+  ycbcr_to_rgb_row_16_fixed_point_avx2,
+  upsample_chroma_bilinear_row_8_avx2,
+  upsample_chroma_bilinear_row_16_avx2
+};
@@ -0,0 +1,232 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "yuv2rgb_kernels.h"
+#include "cpu_features.h"
+#include "colorconversion.h"
+#include "common_utils.h"
+
+
+void ycbcr420_to_rgb24_row_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                  uint8_t* out, uint32_t width,
+                                  const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  int r_offset = 0;
+  int g_offset = 0;
+  int b_offset = 0;
+
+  for (uint32_t x = 0; x < width; x++) {
+    // Update color offsets every other pixel
+    if ((x & 1) == 0) {
+      int cb_v = cb[x / 2] - 128;
+      int cr_v = cr[x / 2] - 128;
+      r_offset = ((coeffs.r_cr * cr_v + 128) >> 8);
+      g_offset = ((coeffs.g_cb * cb_v + coeffs.g_cr * cr_v + 128) >> 8);
+      b_offset = ((coeffs.b_cb * cb_v + 128) >> 8);
+    }
+
+    int yv = y[x];
+    uint8_t* rgb = &out[3 * x];
+    rgb[0] = clip_int_u8(yv + r_offset);
+    rgb[1] = clip_int_u8(yv + g_offset);
+    rgb[2] = clip_int_u8(yv + b_offset);
+  }
+}
+
+
+void ycbcr420_to_rgb32_row_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                  uint8_t* out, uint32_t width,
+                                  const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  for (uint32_t x = 0; x < width; x++) {
+    int yv = y[x];
+    int cb_v = cb[x / 2] - 128;
+    int cr_v = cr[x / 2] - 128;
+
+    out[4 * x + 0] = clip_int_u8(yv + ((coeffs.r_cr * cr_v + 128) >> 8));
+    out[4 * x + 1] = clip_int_u8(yv + ((coeffs.g_cb * cb_v + coeffs.g_cr * cr_v + 128) >> 8));
+    out[4 * x + 2] = clip_int_u8(yv + ((coeffs.b_cb * cb_v + 128) >> 8));
+    out[4 * x + 3] = alpha ? alpha[x] : 0xFF;
+  }
+}
+
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_scalar(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                    Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                    const YCbCr_to_RGB_float_parameters& params)
+{
+  int shift = params.chroma_shift;
+
+  for (uint32_t x = 0; x < width; x++) {
+    float yv = static_cast<float>(y[x]);
+    float cb_v = static_cast<float>(cb[x >> shift] - params.chroma_offset);
+    float cr_v = static_cast<float>(cr[x >> shift] - params.chroma_offset);
+
+    if (!params.full_range) {
+      yv = (yv - params.limited_range_offset) * 1.1689f;
+      cb_v = cb_v * 1.1429f;
+      cr_v = cr_v * 1.1429f;
+    }
+
+    r[x] = static_cast<Pixel>(clip_f_u16(yv + params.r_cr * cr_v, params.max_value));
+    g[x] = static_cast<Pixel>(clip_f_u16(yv + params.g_cb * cb_v + params.g_cr * cr_v, params.max_value));
+    b[x] = static_cast<Pixel>(clip_f_u16(yv + params.b_cb * cb_v, params.max_value));
+  }
+}
+
+
+void ycbcr_to_rgb_row_8_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                               uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                               const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_scalar(y, cb, cr, r, g, b, width, params);
+}
+
+
+void ycbcr_to_rgb_row_16_scalar(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_scalar(y, cb, cr, r, g, b, width, params);
+}
+
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_fixed_point_scalar(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                                Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                                const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  const int precision = YCbCr_to_RGB_fixed_point_precision;
+  const int32_t rounding = 1 << (precision - 1);
+  const auto max_value = static_cast<uint16_t>(params.max_value);
+  int shift = params.chroma_shift;
+
+  for (uint32_t x = 0; x < width; x++) {
+    int32_t yv = (y[x] - params.y_offset) * params.y_scale + rounding;
+    int32_t cb_v = cb[x >> shift] - params.chroma_offset;
+    int32_t cr_v = cr[x >> shift] - params.chroma_offset;
+
+    r[x] = static_cast<Pixel>(clip_int_u16((yv + params.r_cr * cr_v) >> precision, max_value));
+    g[x] = static_cast<Pixel>(clip_int_u16((yv + params.g_cb * cb_v + params.g_cr * cr_v) >> precision, max_value));
+    b[x] = static_cast<Pixel>(clip_int_u16((yv + params.b_cb * cb_v) >> precision, max_value));
+  }
+}
+
+
+void ycbcr_to_rgb_row_8_fixed_point_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                           uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                           const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_scalar(y, cb, cr, r, g, b, width, params);
+}
+
+
+void ycbcr_to_rgb_row_16_fixed_point_scalar(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                            uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                            const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_scalar(y, cb, cr, r, g, b, width, params);
+}
+
+
+// The vertical interpolation is done first. With the vertical sums v = 3*row0 + row1, the output samples between
+// the chroma samples i and i+1 are (3*v[i] + v[i+1] + 8) >> 4 and (v[i] + 3*v[i+1] + 8) >> 4.
+// This is equal to the 2D bilinear weights 9/16, 3/16, 3/16, 1/16.
+template<class Pixel>
+static void upsample_chroma_bilinear_row_scalar(const Pixel* row0, const Pixel* row1, Pixel* out, uint32_t width)
+{
+  if (width == 0) {
+    return;
+  }
+
+  int v0 = 3 * row0[0] + row1[0];
+
+  // left border
+  out[0] = static_cast<Pixel>((v0 + 2) >> 2);
+
+  uint32_t num_pairs = (width - 1) / 2;
+  for (uint32_t i = 0; i < num_pairs; i++) {
+    int v1 = 3 * row0[i + 1] + row1[i + 1];
+    out[2 * i + 1] = static_cast<Pixel>((3 * v0 + v1 + 8) >> 4);
+    out[2 * i + 2] = static_cast<Pixel>((v0 + 3 * v1 + 8) >> 4);
+    v0 = v1;
+  }
+
+  // right border
+  if (width % 2 == 0) {
+    out[width - 1] = static_cast<Pixel>((v0 + 2) >> 2);
+  }
+}
+
+
+void upsample_chroma_bilinear_row_8_scalar(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width)
+{
+  upsample_chroma_bilinear_row_scalar(row0, row1, out, width);
+}
+
+
+void upsample_chroma_bilinear_row_16_scalar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width)
+{
+  upsample_chroma_bilinear_row_scalar(row0, row1, out, width);
+}
+
+
+static const YCbCr_to_RGB_kernels kernels_scalar{
+  "scalar",
+  SpeedCosts_Unoptimized,
+  ycbcr420_to_rgb24_row_scalar,
+  ycbcr420_to_rgb32_row_scalar,
+  ycbcr_to_rgb_row_8_scalar,
+  ycbcr_to_rgb_row_16_scalar,
+  ycbcr_to_rgb_row_8_fixed_point_scalar,
+  ycbcr_to_rgb_row_16_fixed_point_scalar,
+  upsample_chroma_bilinear_row_8_scalar,
+  upsample_chroma_bilinear_row_16_scalar
+};
+
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_sse41;
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_avx2;
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_neon;
+
+static const KernelDispatcher<YCbCr_to_RGB_kernels> dispatcher{
+  kernels_scalar,
+  SSE41_KERNELS(yuv2rgb_kernels_sse41),
+  AVX2_KERNELS(yuv2rgb_kernels_avx2),
+  NEON_KERNELS(yuv2rgb_kernels_neon)
+};
+
+
+const YCbCr_to_RGB_kernels& get_scalar_YCbCr_to_RGB_kernels()
+{
+  return dispatcher.get_scalar();
+}
+
+
+const YCbCr_to_RGB_kernels* get_simd_YCbCr_to_RGB_kernels()
+{
+  return dispatcher.get_simd();
+}
+
+
+std::vector<const YCbCr_to_RGB_kernels*> get_supported_YCbCr_to_RGB_kernels()
+{
+  return dispatcher.get_supported();
+}
@@ -0,0 +1,177 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_COLORCONVERSION_YUV2RGB_KERNELS_H
+#define LIBHEIF_COLORCONVERSION_YUV2RGB_KERNELS_H
+
+#include <cstdint>
+#include <vector>
+
+// Row kernels for the YCbCr -> RGB conversion operations.
+//
+// There is a scalar reference implementation of every kernel and vectorized implementations for
+// SSE4.1, AVX2 and NEON. The vectorized kernels live in their own translation units that are compiled with
+// the respective instruction set enabled. Hence, they must only be called when the CPU supports it.
+// Since these translation units are compiled with different compiler flags, this header must not
+// contain inline functions or templates that could be instantiated there. For the same reason, the
+// parameter structs are kept trivial (without default member initializers).
+//
+// The integer and fixed-point kernels are bit-exact to the scalar kernels.
+// The float kernels compute the same sequence of single precision operations as the scalar kernels.
+// They are bit-exact as long as the compiler does not contract the scalar code into fused multiply-adds.
+// This is the case on x86, but may not be on ARM, where results may then differ by 1 LSB.
+
+// Coefficients of the 8-bit integer YCbCr -> RGB conversion, scaled by 256.
+struct YCbCr_to_RGB_int8_coefficients
+{
+  int32_t r_cr;
+  int32_t g_cb;
+  int32_t g_cr;
+  int32_t b_cb;
+};
+
+
+struct YCbCr_to_RGB_float_parameters
+{
+  float r_cr;
+  float g_cb;
+  float g_cr;
+  float b_cb;
+
+  bool full_range;
+  float limited_range_offset; // 16 << (bpp-8)
+
+  int32_t chroma_offset; // 1 << (bpp-1)
+  int32_t max_value; // (1 << bpp) - 1
+
+  int chroma_shift; // 1 if the chroma planes are subsampled horizontally
+};
+
+
+// Parameters of the fixed-point YCbCr -> RGB conversion for 8 to 14 bits per pixel.
+// The coefficients are in Q14 format. For limited range input, the range expansion is included in the coefficients.
+// The results deviate by at most 1 LSB from the float conversion.
+//
+//   R = ((Y - y_offset) * y_scale + r_cr * (Cr - chroma_offset) + (1 << 13)) >> 14
+//
+// For 14-bit input, all intermediate values stay within the int32 range.
+
+constexpr int YCbCr_to_RGB_fixed_point_precision = 14;
+
+struct YCbCr_to_RGB_fixed_point_parameters
+{
+  int32_t y_scale;
+  int32_t r_cr;
+  int32_t g_cb;
+  int32_t g_cr;
+  int32_t b_cb;
+
+  int32_t y_offset; // 0 for full range, 16 << (bpp-8) for limited range
+  int32_t chroma_offset; // 1 << (bpp-1)
+  int32_t max_value; // (1 << bpp) - 1
+
+  int chroma_shift; // 1 if the chroma planes are subsampled horizontally
+};
+
+
+struct YCbCr_to_RGB_kernels
+{
+  const char* name;
+  int speed_costs;
+
+  // Converts one row of 8-bit YCbCr 4:2:0 into interleaved RGB. 'cb' and 'cr' point to the chroma row
+  // of the luma row.
+  void (*ycbcr420_to_rgb24_row)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                uint8_t* out, uint32_t width,
+                                const YCbCr_to_RGB_int8_coefficients& coeffs);
+
+  // As above, but outputs RGBA. When 'alpha' is nullptr, the output is opaque.
+  void (*ycbcr420_to_rgb32_row)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                uint8_t* out, uint32_t width,
+                                const YCbCr_to_RGB_int8_coefficients& coeffs);
+
+  // Converts one row of YCbCr into planar RGB with nearest-neighbor chroma upsampling.
+  void (*ycbcr_to_rgb_row_8)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                             uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                             const YCbCr_to_RGB_float_parameters& params);
+
+  void (*ycbcr_to_rgb_row_16)(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                              uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                              const YCbCr_to_RGB_float_parameters& params);
+
+  // As above, with fixed-point arithmetic.
+  void (*ycbcr_to_rgb_row_8_fixed_point)(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                         uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                         const YCbCr_to_RGB_fixed_point_parameters& params);
+
+  void (*ycbcr_to_rgb_row_16_fixed_point)(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                          uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                          const YCbCr_to_RGB_fixed_point_parameters& params);
+
+  // Bilinear upsampling of one chroma row to the full width 'width'. The chroma samples are located between
+  // two luma samples. 'row0' is the vertically closer chroma row (weight 3/4) and 'row1' the other neighboring
+  // chroma row (weight 1/4). For 4:2:2 and at the top and bottom image border, pass the same row twice.
+  // At the left and right image border, the chroma samples are only interpolated vertically.
+  void (*upsample_chroma_bilinear_row_8)(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width);
+
+  void (*upsample_chroma_bilinear_row_16)(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width);
+};
+
+
+// --- scalar reference kernels (also used for the remaining pixels at the end of a row by the vectorized kernels)
+
+void ycbcr420_to_rgb24_row_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                  uint8_t* out, uint32_t width,
+                                  const YCbCr_to_RGB_int8_coefficients& coeffs);
+
+void ycbcr420_to_rgb32_row_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                  uint8_t* out, uint32_t width,
+                                  const YCbCr_to_RGB_int8_coefficients& coeffs);
+
+void ycbcr_to_rgb_row_8_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                               uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                               const YCbCr_to_RGB_float_parameters& params);
+
+void ycbcr_to_rgb_row_16_scalar(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                const YCbCr_to_RGB_float_parameters& params);
+
+void ycbcr_to_rgb_row_8_fixed_point_scalar(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                           uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                           const YCbCr_to_RGB_fixed_point_parameters& params);
+
+void ycbcr_to_rgb_row_16_fixed_point_scalar(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                            uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                            const YCbCr_to_RGB_fixed_point_parameters& params);
+
+void upsample_chroma_bilinear_row_8_scalar(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width);
+
+void upsample_chroma_bilinear_row_16_scalar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width);
+
+
+const YCbCr_to_RGB_kernels& get_scalar_YCbCr_to_RGB_kernels();
+
+// Returns the fastest vectorized kernels that run on this CPU, or nullptr if there are none.
+const YCbCr_to_RGB_kernels* get_simd_YCbCr_to_RGB_kernels();
+
+// All kernels that run on this CPU, starting with the scalar reference kernels.
+std::vector<const YCbCr_to_RGB_kernels*> get_supported_YCbCr_to_RGB_kernels();
+
+#endif //LIBHEIF_COLORCONVERSION_YUV2RGB_KERNELS_H
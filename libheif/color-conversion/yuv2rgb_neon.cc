@@ -0,0 +1,430 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// NEON kernels for AArch64. See yuv2rgb_kernels.h.
+
+#include "yuv2rgb_kernels.h"
+#include "colorconversion.h"
+#include <arm_neon.h>
+#include <cstring>
+
+
+// Computes the RGB offset (the chroma part of the conversion) of 8 chroma samples
+// and upsamples it horizontally to 16 luma samples.
+static inline int16x8x2_t upsampled_offset(int32x4_t lo, int32x4_t hi)
+{
+  // (x + 128) >> 8, as in the scalar code
+  int16x8_t offset = vcombine_s16(vmovn_s32(vrshrq_n_s32(lo, 8)),
+                                  vmovn_s32(vrshrq_n_s32(hi, 8)));
+  return vzipq_s16(offset, offset);
+}
+
+
+static inline uint8x16_t add_offset(int16x8_t y_lo, int16x8_t y_hi, int16x8x2_t offset)
+{
+  return vcombine_u8(vqmovun_s16(vaddq_s16(y_lo, offset.val[0])),
+                     vqmovun_s16(vaddq_s16(y_hi, offset.val[1])));
+}
+
+
+static void ycbcr420_to_rgb_row_neon(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                     uint8_t* out, uint32_t width, bool rgba,
+                                     const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  const uint8x8_t c128 = vdup_n_u8(128);
+  const auto r_cr = static_cast<int16_t>(coeffs.r_cr);
+  const auto g_cb = static_cast<int16_t>(coeffs.g_cb);
+  const auto g_cr = static_cast<int16_t>(coeffs.g_cr);
+  const auto b_cb = static_cast<int16_t>(coeffs.b_cb);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    int16x8_t cb16 = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(cb + x / 2), c128));
+    int16x8_t cr16 = vreinterpretq_s16_u16(vsubl_u8(vld1_u8(cr + x / 2), c128));
+
+    int16x4_t cb_lo = vget_low_s16(cb16), cb_hi = vget_high_s16(cb16);
+    int16x4_t cr_lo = vget_low_s16(cr16), cr_hi = vget_high_s16(cr16);
+
+    int16x8x2_t r_offset = upsampled_offset(vmull_n_s16(cr_lo, r_cr), vmull_n_s16(cr_hi, r_cr));
+    int16x8x2_t g_offset = upsampled_offset(vmlal_n_s16(vmull_n_s16(cb_lo, g_cb), cr_lo, g_cr),
+                                            vmlal_n_s16(vmull_n_s16(cb_hi, g_cb), cr_hi, g_cr));
+    int16x8x2_t b_offset = upsampled_offset(vmull_n_s16(cb_lo, b_cb), vmull_n_s16(cb_hi, b_cb));
+
+    uint8x16_t y8 = vld1q_u8(y + x);
+    int16x8_t y_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y8)));
+    int16x8_t y_hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y8)));
+
+    uint8x16_t r = add_offset(y_lo, y_hi, r_offset);
+    uint8x16_t g = add_offset(y_lo, y_hi, g_offset);
+    uint8x16_t b = add_offset(y_lo, y_hi, b_offset);
+
+    if (rgba) {
+      uint8x16x4_t pixels;
+      pixels.val[0] = r;
+      pixels.val[1] = g;
+      pixels.val[2] = b;
+      pixels.val[3] = alpha ? vld1q_u8(alpha + x) : vdupq_n_u8(0xFF);
+      vst4q_u8(out + 4 * x, pixels);
+    }
+    else {
+      uint8x16x3_t pixels;
+      pixels.val[0] = r;
+      pixels.val[1] = g;
+      pixels.val[2] = b;
+      vst3q_u8(out + 3 * x, pixels);
+    }
+  }
+
+  if (x < width) {
+    if (rgba) {
+      ycbcr420_to_rgb32_row_scalar(y + x, cb + x / 2, cr + x / 2, alpha ? alpha + x : nullptr,
+                                   out + 4 * x, width - x, coeffs);
+    }
+    else {
+      ycbcr420_to_rgb24_row_scalar(y + x, cb + x / 2, cr + x / 2, out + 3 * x, width - x, coeffs);
+    }
+  }
+}
+
+
+static void ycbcr420_to_rgb24_row_neon(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                       uint8_t* out, uint32_t width,
+                                       const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_neon(y, cb, cr, nullptr, out, width, false, coeffs);
+}
+
+
+static void ycbcr420_to_rgb32_row_neon(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                       uint8_t* out, uint32_t width,
+                                       const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_neon(y, cb, cr, alpha, out, width, true, coeffs);
+}
+
+
+// --- float kernels
+
+static inline uint16x8_t load_8(const uint8_t* p)
+{
+  return vmovl_u8(vld1_u8(p));
+}
+
+static inline uint16x8_t load_8(const uint16_t* p)
+{
+  return vld1q_u16(p);
+}
+
+static inline uint16x4_t load_4(const uint8_t* p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return vget_low_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v))));
+}
+
+static inline uint16x4_t load_4(const uint16_t* p)
+{
+  return vld1_u16(p);
+}
+
+static inline void store_8(uint8_t* p, int32x4_t lo, int32x4_t hi)
+{
+  vst1_u8(p, vqmovn_u16(vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi))));
+}
+
+static inline void store_8(uint16_t* p, int32x4_t lo, int32x4_t hi)
+{
+  vst1q_u16(p, vcombine_u16(vqmovun_s32(lo), vqmovun_s32(hi)));
+}
+
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_neon(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                  Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                  const YCbCr_to_RGB_float_parameters& params)
+{
+  const float32x4_t r_cr = vdupq_n_f32(params.r_cr);
+  const float32x4_t g_cb = vdupq_n_f32(params.g_cb);
+  const float32x4_t g_cr = vdupq_n_f32(params.g_cr);
+  const float32x4_t b_cb = vdupq_n_f32(params.b_cb);
+  const float32x4_t luma_scale = vdupq_n_f32(1.1689f);
+  const float32x4_t chroma_scale = vdupq_n_f32(1.1429f);
+  const float32x4_t limited_range_offset = vdupq_n_f32(params.limited_range_offset);
+  const int32x4_t chroma_offset = vdupq_n_s32(params.chroma_offset);
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  const int32x4_t max_value = vdupq_n_s32(params.max_value);
+  const int32x4_t zero = vdupq_n_s32(0);
+
+  auto to_float = [&](uint16x4_t v) {
+    return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(v)), chroma_offset));
+  };
+
+  auto to_pixel = [&](float32x4_t v) {
+    int32x4_t i = vcvtq_s32_f32(vaddq_f32(v, half)); // truncates like the scalar cast
+    return vminq_s32(vmaxq_s32(i, zero), max_value);
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t y16 = load_8(y + x);
+    float32x4_t y_v[2] = {vcvtq_f32_u32(vmovl_u16(vget_low_u16(y16))),
+                          vcvtq_f32_u32(vmovl_u16(vget_high_u16(y16)))};
+    float32x4_t cb_v[2], cr_v[2];
+
+    if (params.chroma_shift) {
+      float32x4_t cb4 = to_float(load_4(cb + x / 2));
+      float32x4_t cr4 = to_float(load_4(cr + x / 2));
+      float32x4x2_t cb_z = vzipq_f32(cb4, cb4);
+      float32x4x2_t cr_z = vzipq_f32(cr4, cr4);
+      cb_v[0] = cb_z.val[0];
+      cb_v[1] = cb_z.val[1];
+      cr_v[0] = cr_z.val[0];
+      cr_v[1] = cr_z.val[1];
+    }
+    else {
+      uint16x8_t cb16 = load_8(cb + x);
+      uint16x8_t cr16 = load_8(cr + x);
+      cb_v[0] = to_float(vget_low_u16(cb16));
+      cb_v[1] = to_float(vget_high_u16(cb16));
+      cr_v[0] = to_float(vget_low_u16(cr16));
+      cr_v[1] = to_float(vget_high_u16(cr16));
+    }
+
+    int32x4_t r_i[2], g_i[2], b_i[2];
+
+    for (int i = 0; i < 2; i++) {
+      if (!params.full_range) {
+        y_v[i] = vmulq_f32(vsubq_f32(y_v[i], limited_range_offset), luma_scale);
+        cb_v[i] = vmulq_f32(cb_v[i], chroma_scale);
+        cr_v[i] = vmulq_f32(cr_v[i], chroma_scale);
+      }
+
+      r_i[i] = to_pixel(vaddq_f32(y_v[i], vmulq_f32(r_cr, cr_v[i])));
+      g_i[i] = to_pixel(vaddq_f32(vaddq_f32(y_v[i], vmulq_f32(g_cb, cb_v[i])), vmulq_f32(g_cr, cr_v[i])));
+      b_i[i] = to_pixel(vaddq_f32(y_v[i], vmulq_f32(b_cb, cb_v[i])));
+    }
+
+    store_8(r + x, r_i[0], r_i[1]);
+    store_8(g + x, g_i[0], g_i[1]);
+    store_8(b + x, b_i[0], b_i[1]);
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                 (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_neon(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                    uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                    const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_neon(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_neon(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                     uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                     const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_neon(y, cb, cr, r, g, b, width, params);
+}
+
+
+// --- fixed-point kernels
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_fixed_point_neon(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                              Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                              const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  const int32x4_t y_offset = vdupq_n_s32(params.y_offset);
+  const int32x4_t chroma_offset = vdupq_n_s32(params.chroma_offset);
+  const int32x4_t rounding = vdupq_n_s32(1 << (YCbCr_to_RGB_fixed_point_precision - 1));
+  const int32x4_t max_value = vdupq_n_s32(params.max_value);
+  const int32x4_t zero = vdupq_n_s32(0);
+
+  auto to_int = [&](uint16x4_t v, int32x4_t offset) {
+    return vsubq_s32(vreinterpretq_s32_u32(vmovl_u16(v)), offset);
+  };
+
+  auto to_pixel = [&](int32x4_t v) {
+    v = vshrq_n_s32(v, YCbCr_to_RGB_fixed_point_precision);
+    return vminq_s32(vmaxq_s32(v, zero), max_value);
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t y16 = load_8(y + x);
+    int32x4_t y_v[2] = {vmlaq_n_s32(rounding, to_int(vget_low_u16(y16), y_offset), params.y_scale),
+                        vmlaq_n_s32(rounding, to_int(vget_high_u16(y16), y_offset), params.y_scale)};
+    int32x4_t r_offset[2], g_offset[2], b_offset[2];
+
+    auto chroma_part = [&](int32x4_t cb4, int32x4_t cr4, int32x4_t& r4, int32x4_t& g4, int32x4_t& b4) {
+      r4 = vmulq_n_s32(cr4, params.r_cr);
+      g4 = vmlaq_n_s32(vmulq_n_s32(cb4, params.g_cb), cr4, params.g_cr);
+      b4 = vmulq_n_s32(cb4, params.b_cb);
+    };
+
+    if (params.chroma_shift) {
+      // compute the chroma part once for each chroma sample and duplicate it
+      int32x4_t r4, g4, b4;
+      chroma_part(to_int(load_4(cb + x / 2), chroma_offset), to_int(load_4(cr + x / 2), chroma_offset), r4, g4, b4);
+      int32x4x2_t r_z = vzipq_s32(r4, r4);
+      int32x4x2_t g_z = vzipq_s32(g4, g4);
+      int32x4x2_t b_z = vzipq_s32(b4, b4);
+      for (int i = 0; i < 2; i++) {
+        r_offset[i] = r_z.val[i];
+        g_offset[i] = g_z.val[i];
+        b_offset[i] = b_z.val[i];
+      }
+    }
+    else {
+      uint16x8_t cb16 = load_8(cb + x);
+      uint16x8_t cr16 = load_8(cr + x);
+      chroma_part(to_int(vget_low_u16(cb16), chroma_offset), to_int(vget_low_u16(cr16), chroma_offset),
+                  r_offset[0], g_offset[0], b_offset[0]);
+      chroma_part(to_int(vget_high_u16(cb16), chroma_offset), to_int(vget_high_u16(cr16), chroma_offset),
+                  r_offset[1], g_offset[1], b_offset[1]);
+    }
+
+    store_8(r + x, to_pixel(vaddq_s32(y_v[0], r_offset[0])), to_pixel(vaddq_s32(y_v[1], r_offset[1])));
+    store_8(g + x, to_pixel(vaddq_s32(y_v[0], g_offset[0])), to_pixel(vaddq_s32(y_v[1], g_offset[1])));
+    store_8(b + x, to_pixel(vaddq_s32(y_v[0], b_offset[0])), to_pixel(vaddq_s32(y_v[1], b_offset[1])));
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_fixed_point_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                            (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_fixed_point_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                             (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_fixed_point_neon(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                                uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                                const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_neon(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_fixed_point_neon(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                                 uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                                 const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_neon(y, cb, cr, r, g, b, width, params);
+}
+
+
+// Vertical sums 3*row0 + row1 and the interpolated output samples, see upsample_chroma_bilinear_row_scalar().
+
+static void upsample_chroma_bilinear_row_8_neon(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const uint8x8_t three = vdup_n_u8(3);
+
+  uint32_t i = 0;
+  for (; i + 8 <= num_pairs; i += 8) {
+    uint16x8_t v0 = vmlal_u8(vmovl_u8(vld1_u8(row1 + i)), vld1_u8(row0 + i), three);
+    uint16x8_t v1 = vmlal_u8(vmovl_u8(vld1_u8(row1 + i + 1)), vld1_u8(row0 + i + 1), three);
+
+    uint8x8x2_t interleaved;
+    interleaved.val[0] = vrshrn_n_u16(vmlaq_n_u16(v1, v0, 3), 4);
+    interleaved.val[1] = vrshrn_n_u16(vmlaq_n_u16(v0, v1, 3), 4);
+
+    vst2_u8(out + 2 * i + 1, interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_8_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint8_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint8_t last = out[2 * i];
+  upsample_chroma_bilinear_row_8_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+static void upsample_chroma_bilinear_row_16_neon(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const uint16x4_t three = vdup_n_u16(3);
+
+  uint32_t i = 0;
+  for (; i + 4 <= num_pairs; i += 4) {
+    uint32x4_t v0 = vmlal_u16(vmovl_u16(vld1_u16(row1 + i)), vld1_u16(row0 + i), three);
+    uint32x4_t v1 = vmlal_u16(vmovl_u16(vld1_u16(row1 + i + 1)), vld1_u16(row0 + i + 1), three);
+
+    uint16x4x2_t interleaved;
+    interleaved.val[0] = vrshrn_n_u32(vmlaq_n_u32(v1, v0, 3), 4);
+    interleaved.val[1] = vrshrn_n_u32(vmlaq_n_u32(v0, v1, 3), 4);
+
+    vst2_u16(out + 2 * i + 1, interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_16_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint16_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint16_t last = out[2 * i];
+  upsample_chroma_bilinear_row_16_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_neon{
+  "neon",
+  SpeedCosts_OptimizedSoftware,
+  ycbcr420_to_rgb24_row_neon,
+  ycbcr420_to_rgb32_row_neon,
+  ycbcr_to_rgb_row_8_neon,
+  ycbcr_to_rgb_row_16_neon,
+  ycbcr_to_rgb_row_8_fixed_point_neon,
+  ycbcr_to_rgb_row_16_fixed_point_neon,
+  upsample_chroma_bilinear_row_8_neon,
+  upsample_chroma_bilinear_row_16_neon
+};
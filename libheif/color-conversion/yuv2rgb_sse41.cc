@@ -0,0 +1,483 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is compiled with SSE4.1 enabled. See yuv2rgb_kernels.h.
+
+#include "yuv2rgb_kernels.h"
+#include "colorconversion.h"
+#include <smmintrin.h>
+#include <cstring>
+
+
+static inline __m128i coefficient_pairs(int32_t c_cb, int32_t c_cr)
+{
+  return _mm_set1_epi32((int32_t) (((uint32_t) (uint16_t) c_cr << 16) | (uint16_t) c_cb));
+}
+
+
+// Computes the RGB offsets (the chroma part of the conversion) of 8 chroma samples as 16-bit values.
+// _mm_madd_epi16 computes the sums of the 32-bit products exactly, equal to the scalar integer code.
+static inline void chroma_offsets_8(const uint8_t* cb, const uint8_t* cr,
+                                    const YCbCr_to_RGB_int8_coefficients& coeffs,
+                                    __m128i& r_offset, __m128i& g_offset, __m128i& b_offset)
+{
+  const __m128i c128_16 = _mm_set1_epi16(128);
+  const __m128i c128_32 = _mm_set1_epi32(128);
+
+  __m128i cb16 = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) cb)), c128_16);
+  __m128i cr16 = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) cr)), c128_16);
+
+  // (cb,cr) pairs
+  __m128i cbcr_lo = _mm_unpacklo_epi16(cb16, cr16);
+  __m128i cbcr_hi = _mm_unpackhi_epi16(cb16, cr16);
+
+  const __m128i r_coeffs = coefficient_pairs(0, coeffs.r_cr);
+  const __m128i g_coeffs = coefficient_pairs(coeffs.g_cb, coeffs.g_cr);
+  const __m128i b_coeffs = coefficient_pairs(coeffs.b_cb, 0);
+
+  auto offset = [&](const __m128i& c) {
+    __m128i lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cbcr_lo, c), c128_32), 8);
+    __m128i hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cbcr_hi, c), c128_32), 8);
+    return _mm_packs_epi32(lo, hi);
+  };
+
+  r_offset = offset(r_coeffs);
+  g_offset = offset(g_coeffs);
+  b_offset = offset(b_coeffs);
+}
+
+
+// Adds the (horizontally upsampled) chroma offsets of 8 chroma samples to 16 luma samples.
+static inline __m128i add_offsets_16(__m128i y_lo, __m128i y_hi, __m128i offset)
+{
+  __m128i lo = _mm_add_epi16(y_lo, _mm_unpacklo_epi16(offset, offset));
+  __m128i hi = _mm_add_epi16(y_hi, _mm_unpackhi_epi16(offset, offset));
+  return _mm_packus_epi16(lo, hi);
+}
+
+
+// Interleaves 16 pixels into four RGBA vectors.
+static inline void interleave_rgba_16(__m128i r, __m128i g, __m128i b, __m128i a, __m128i out[4])
+{
+  __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+  __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+  __m128i ba_lo = _mm_unpacklo_epi8(b, a);
+  __m128i ba_hi = _mm_unpackhi_epi8(b, a);
+
+  out[0] = _mm_unpacklo_epi16(rg_lo, ba_lo);
+  out[1] = _mm_unpackhi_epi16(rg_lo, ba_lo);
+  out[2] = _mm_unpacklo_epi16(rg_hi, ba_hi);
+  out[3] = _mm_unpackhi_epi16(rg_hi, ba_hi);
+}
+
+
+static inline void store_rgb_16(uint8_t* out, __m128i r, __m128i g, __m128i b)
+{
+  __m128i rgba[4];
+  interleave_rgba_16(r, g, b, _mm_setzero_si128(), rgba);
+
+  // remove the 4th byte of each pixel, leaving 12 bytes per vector
+  const __m128i drop_alpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  __m128i p0 = _mm_shuffle_epi8(rgba[0], drop_alpha);
+  __m128i p1 = _mm_shuffle_epi8(rgba[1], drop_alpha);
+  __m128i p2 = _mm_shuffle_epi8(rgba[2], drop_alpha);
+  __m128i p3 = _mm_shuffle_epi8(rgba[3], drop_alpha);
+
+  _mm_storeu_si128((__m128i*) (out + 0), _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+  _mm_storeu_si128((__m128i*) (out + 16), _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+  _mm_storeu_si128((__m128i*) (out + 32), _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+}
+
+
+static void ycbcr420_to_rgb_row_sse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                      uint8_t* out, uint32_t width, bool rgba,
+                                      const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i opaque = _mm_set1_epi8(-1);
+
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i r_offset, g_offset, b_offset;
+    chroma_offsets_8(cb + x / 2, cr + x / 2, coeffs, r_offset, g_offset, b_offset);
+
+    __m128i y8 = _mm_loadu_si128((const __m128i*) (y + x));
+    __m128i y_lo = _mm_unpacklo_epi8(y8, zero);
+    __m128i y_hi = _mm_unpackhi_epi8(y8, zero);
+
+    __m128i r = add_offsets_16(y_lo, y_hi, r_offset);
+    __m128i g = add_offsets_16(y_lo, y_hi, g_offset);
+    __m128i b = add_offsets_16(y_lo, y_hi, b_offset);
+
+    if (rgba) {
+      __m128i a = alpha ? _mm_loadu_si128((const __m128i*) (alpha + x)) : opaque;
+
+      __m128i pixels[4];
+      interleave_rgba_16(r, g, b, a, pixels);
+      for (int i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i*) (out + 4 * x + 16 * i), pixels[i]);
+      }
+    }
+    else {
+      store_rgb_16(out + 3 * x, r, g, b);
+    }
+  }
+
+  if (x < width) {
+    if (rgba) {
+      ycbcr420_to_rgb32_row_scalar(y + x, cb + x / 2, cr + x / 2, alpha ? alpha + x : nullptr,
+                                   out + 4 * x, width - x, coeffs);
+    }
+    else {
+      ycbcr420_to_rgb24_row_scalar(y + x, cb + x / 2, cr + x / 2, out + 3 * x, width - x, coeffs);
+    }
+  }
+}
+
+
+static void ycbcr420_to_rgb24_row_sse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                        uint8_t* out, uint32_t width,
+                                        const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_sse41(y, cb, cr, nullptr, out, width, false, coeffs);
+}
+
+
+static void ycbcr420_to_rgb32_row_sse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr, const uint8_t* alpha,
+                                        uint8_t* out, uint32_t width,
+                                        const YCbCr_to_RGB_int8_coefficients& coeffs)
+{
+  ycbcr420_to_rgb_row_sse41(y, cb, cr, alpha, out, width, true, coeffs);
+}
+
+
+// --- float kernels
+
+static inline __m128i load_4_as_epi32(const uint8_t* p)
+{
+  int32_t v;
+  memcpy(&v, p, 4);
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+static inline __m128i load_4_as_epi32(const uint16_t* p)
+{
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) p));
+}
+
+static inline void store_8(uint8_t* p, __m128i lo, __m128i hi)
+{
+  __m128i v16 = _mm_packus_epi32(lo, hi);
+  _mm_storel_epi64((__m128i*) p, _mm_packus_epi16(v16, v16));
+}
+
+static inline void store_8(uint16_t* p, __m128i lo, __m128i hi)
+{
+  _mm_storeu_si128((__m128i*) p, _mm_packus_epi32(lo, hi));
+}
+
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_sse41(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                   Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                   const YCbCr_to_RGB_float_parameters& params)
+{
+  const __m128 r_cr = _mm_set1_ps(params.r_cr);
+  const __m128 g_cb = _mm_set1_ps(params.g_cb);
+  const __m128 g_cr = _mm_set1_ps(params.g_cr);
+  const __m128 b_cb = _mm_set1_ps(params.b_cb);
+  const __m128 luma_scale = _mm_set1_ps(1.1689f);
+  const __m128 chroma_scale = _mm_set1_ps(1.1429f);
+  const __m128 limited_range_offset = _mm_set1_ps(params.limited_range_offset);
+  const __m128i chroma_offset = _mm_set1_epi32(params.chroma_offset);
+  const __m128 half = _mm_set1_ps(0.5f);
+  const __m128i max_value = _mm_set1_epi32(params.max_value);
+  const __m128i zero = _mm_setzero_si128();
+
+  auto to_pixel = [&](__m128 v) {
+    __m128i i = _mm_cvttps_epi32(_mm_add_ps(v, half));
+    return _mm_min_epi32(_mm_max_epi32(i, zero), max_value);
+  };
+
+  auto load_chroma = [&](const Pixel* c) {
+    return _mm_cvtepi32_ps(_mm_sub_epi32(load_4_as_epi32(c), chroma_offset));
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128 y_v[2] = {_mm_cvtepi32_ps(load_4_as_epi32(y + x)),
+                     _mm_cvtepi32_ps(load_4_as_epi32(y + x + 4))};
+    __m128 cb_v[2], cr_v[2];
+
+    if (params.chroma_shift) {
+      __m128 cb4 = load_chroma(cb + x / 2);
+      __m128 cr4 = load_chroma(cr + x / 2);
+      cb_v[0] = _mm_unpacklo_ps(cb4, cb4);
+      cb_v[1] = _mm_unpackhi_ps(cb4, cb4);
+      cr_v[0] = _mm_unpacklo_ps(cr4, cr4);
+      cr_v[1] = _mm_unpackhi_ps(cr4, cr4);
+    }
+    else {
+      cb_v[0] = load_chroma(cb + x);
+      cb_v[1] = load_chroma(cb + x + 4);
+      cr_v[0] = load_chroma(cr + x);
+      cr_v[1] = load_chroma(cr + x + 4);
+    }
+
+    __m128i r_i[2], g_i[2], b_i[2];
+
+    for (int i = 0; i < 2; i++) {
+      if (!params.full_range) {
+        y_v[i] = _mm_mul_ps(_mm_sub_ps(y_v[i], limited_range_offset), luma_scale);
+        cb_v[i] = _mm_mul_ps(cb_v[i], chroma_scale);
+        cr_v[i] = _mm_mul_ps(cr_v[i], chroma_scale);
+      }
+
+      r_i[i] = to_pixel(_mm_add_ps(y_v[i], _mm_mul_ps(r_cr, cr_v[i])));
+      g_i[i] = to_pixel(_mm_add_ps(_mm_add_ps(y_v[i], _mm_mul_ps(g_cb, cb_v[i])), _mm_mul_ps(g_cr, cr_v[i])));
+      b_i[i] = to_pixel(_mm_add_ps(y_v[i], _mm_mul_ps(b_cb, cb_v[i])));
+    }
+
+    store_8(r + x, r_i[0], r_i[1]);
+    store_8(g + x, g_i[0], g_i[1]);
+    store_8(b + x, b_i[0], b_i[1]);
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                 (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_sse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                     uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                     const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_sse41(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_sse41(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                      uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                      const YCbCr_to_RGB_float_parameters& params)
+{
+  ycbcr_to_rgb_row_sse41(y, cb, cr, r, g, b, width, params);
+}
+
+
+// --- fixed-point kernels
+
+template<class Pixel>
+static void ycbcr_to_rgb_row_fixed_point_sse41(const Pixel* y, const Pixel* cb, const Pixel* cr,
+                                               Pixel* r, Pixel* g, Pixel* b, uint32_t width,
+                                               const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  const __m128i y_scale = _mm_set1_epi32(params.y_scale);
+  const __m128i r_cr = _mm_set1_epi32(params.r_cr);
+  const __m128i g_cb = _mm_set1_epi32(params.g_cb);
+  const __m128i g_cr = _mm_set1_epi32(params.g_cr);
+  const __m128i b_cb = _mm_set1_epi32(params.b_cb);
+  const __m128i y_offset = _mm_set1_epi32(params.y_offset);
+  const __m128i chroma_offset = _mm_set1_epi32(params.chroma_offset);
+  const __m128i rounding = _mm_set1_epi32(1 << (YCbCr_to_RGB_fixed_point_precision - 1));
+  const __m128i max_value = _mm_set1_epi32(params.max_value);
+  const __m128i zero = _mm_setzero_si128();
+
+  auto to_pixel = [&](__m128i v) {
+    v = _mm_srai_epi32(v, YCbCr_to_RGB_fixed_point_precision);
+    return _mm_min_epi32(_mm_max_epi32(v, zero), max_value);
+  };
+
+  auto load_chroma = [&](const Pixel* c) {
+    return _mm_sub_epi32(load_4_as_epi32(c), chroma_offset);
+  };
+
+  auto load_luma = [&](const Pixel* p) {
+    return _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(load_4_as_epi32(p), y_offset), y_scale), rounding);
+  };
+
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i y_v[2] = {load_luma(y + x),
+                      load_luma(y + x + 4)};
+    __m128i r_offset[2], g_offset[2], b_offset[2];
+
+    if (params.chroma_shift) {
+      // compute the chroma part once for each chroma sample and duplicate it
+      __m128i cb4 = load_chroma(cb + x / 2);
+      __m128i cr4 = load_chroma(cr + x / 2);
+      __m128i r4 = _mm_mullo_epi32(r_cr, cr4);
+      __m128i g4 = _mm_add_epi32(_mm_mullo_epi32(g_cb, cb4), _mm_mullo_epi32(g_cr, cr4));
+      __m128i b4 = _mm_mullo_epi32(b_cb, cb4);
+      r_offset[0] = _mm_unpacklo_epi32(r4, r4);
+      r_offset[1] = _mm_unpackhi_epi32(r4, r4);
+      g_offset[0] = _mm_unpacklo_epi32(g4, g4);
+      g_offset[1] = _mm_unpackhi_epi32(g4, g4);
+      b_offset[0] = _mm_unpacklo_epi32(b4, b4);
+      b_offset[1] = _mm_unpackhi_epi32(b4, b4);
+    }
+    else {
+      for (int i = 0; i < 2; i++) {
+        __m128i cb4 = load_chroma(cb + x + 4 * i);
+        __m128i cr4 = load_chroma(cr + x + 4 * i);
+        r_offset[i] = _mm_mullo_epi32(r_cr, cr4);
+        g_offset[i] = _mm_add_epi32(_mm_mullo_epi32(g_cb, cb4), _mm_mullo_epi32(g_cr, cr4));
+        b_offset[i] = _mm_mullo_epi32(b_cb, cb4);
+      }
+    }
+
+    store_8(r + x, to_pixel(_mm_add_epi32(y_v[0], r_offset[0])), to_pixel(_mm_add_epi32(y_v[1], r_offset[1])));
+    store_8(g + x, to_pixel(_mm_add_epi32(y_v[0], g_offset[0])), to_pixel(_mm_add_epi32(y_v[1], g_offset[1])));
+    store_8(b + x, to_pixel(_mm_add_epi32(y_v[0], b_offset[0])), to_pixel(_mm_add_epi32(y_v[1], b_offset[1])));
+  }
+
+  if (x < width) {
+    uint32_t cx = x >> params.chroma_shift;
+
+    if (sizeof(Pixel) == 1) {
+      ycbcr_to_rgb_row_8_fixed_point_scalar((const uint8_t*) y + x, (const uint8_t*) cb + cx, (const uint8_t*) cr + cx,
+                                            (uint8_t*) r + x, (uint8_t*) g + x, (uint8_t*) b + x, width - x, params);
+    }
+    else {
+      ycbcr_to_rgb_row_16_fixed_point_scalar((const uint16_t*) y + x, (const uint16_t*) cb + cx, (const uint16_t*) cr + cx,
+                                             (uint16_t*) r + x, (uint16_t*) g + x, (uint16_t*) b + x, width - x, params);
+    }
+  }
+}
+
+
+static void ycbcr_to_rgb_row_8_fixed_point_sse41(const uint8_t* y, const uint8_t* cb, const uint8_t* cr,
+                                                 uint8_t* r, uint8_t* g, uint8_t* b, uint32_t width,
+                                                 const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_sse41(y, cb, cr, r, g, b, width, params);
+}
+
+
+static void ycbcr_to_rgb_row_16_fixed_point_sse41(const uint16_t* y, const uint16_t* cb, const uint16_t* cr,
+                                                  uint16_t* r, uint16_t* g, uint16_t* b, uint32_t width,
+                                                  const YCbCr_to_RGB_fixed_point_parameters& params)
+{
+  ycbcr_to_rgb_row_fixed_point_sse41(y, cb, cr, r, g, b, width, params);
+}
+
+
+// Vertical sums 3*row0 + row1 and the interpolated output samples, see upsample_chroma_bilinear_row_scalar().
+// The two output samples of each pair are interleaved by combining them into one wider lane.
+
+static void upsample_chroma_bilinear_row_8_sse41(const uint8_t* row0, const uint8_t* row1, uint8_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const __m128i rounding = _mm_set1_epi16(8);
+
+  uint32_t i = 0;
+  for (; i + 8 <= num_pairs; i += 8) {
+    __m128i a0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) (row0 + i)));
+    __m128i a1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) (row0 + i + 1)));
+    __m128i b0 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) (row1 + i)));
+    __m128i b1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*) (row1 + i + 1)));
+
+    __m128i v0 = _mm_add_epi16(_mm_add_epi16(a0, _mm_slli_epi16(a0, 1)), b0);
+    __m128i v1 = _mm_add_epi16(_mm_add_epi16(a1, _mm_slli_epi16(a1, 1)), b1);
+
+    __m128i first = _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(v0, _mm_slli_epi16(v0, 1)), v1), rounding);
+    __m128i second = _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(v1, _mm_slli_epi16(v1, 1)), v0), rounding);
+
+    __m128i interleaved = _mm_or_si128(_mm_srli_epi16(first, 4),
+                                       _mm_slli_epi16(_mm_srli_epi16(second, 4), 8));
+
+    _mm_storeu_si128((__m128i*) (out + 2 * i + 1), interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_8_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint8_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint8_t last = out[2 * i];
+  upsample_chroma_bilinear_row_8_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+static void upsample_chroma_bilinear_row_16_sse41(const uint16_t* row0, const uint16_t* row1, uint16_t* out, uint32_t width)
+{
+  uint32_t num_pairs = (width > 0 ? (width - 1) / 2 : 0);
+
+  const __m128i rounding = _mm_set1_epi32(8);
+
+  uint32_t i = 0;
+  for (; i + 4 <= num_pairs; i += 4) {
+    __m128i a0 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) (row0 + i)));
+    __m128i a1 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) (row0 + i + 1)));
+    __m128i b0 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) (row1 + i)));
+    __m128i b1 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*) (row1 + i + 1)));
+
+    __m128i v0 = _mm_add_epi32(_mm_add_epi32(a0, _mm_slli_epi32(a0, 1)), b0);
+    __m128i v1 = _mm_add_epi32(_mm_add_epi32(a1, _mm_slli_epi32(a1, 1)), b1);
+
+    __m128i first = _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(v0, _mm_slli_epi32(v0, 1)), v1), rounding);
+    __m128i second = _mm_add_epi32(_mm_add_epi32(_mm_add_epi32(v1, _mm_slli_epi32(v1, 1)), v0), rounding);
+
+    __m128i interleaved = _mm_or_si128(_mm_srli_epi32(first, 4),
+                                       _mm_slli_epi32(_mm_srli_epi32(second, 4), 16));
+
+    _mm_storeu_si128((__m128i*) (out + 2 * i + 1), interleaved);
+  }
+
+  if (i == 0) {
+    upsample_chroma_bilinear_row_16_scalar(row0, row1, out, width);
+    return;
+  }
+
+  out[0] = static_cast<uint16_t>((3 * row0[0] + row1[0] + 2) >> 2);
+
+  // The scalar kernel treats its first output sample as the left border. Keep the value computed above.
+  uint16_t last = out[2 * i];
+  upsample_chroma_bilinear_row_16_scalar(row0 + i, row1 + i, out + 2 * i, width - 2 * i);
+  out[2 * i] = last;
+}
+
+
+extern const YCbCr_to_RGB_kernels yuv2rgb_kernels_sse41{
+  "sse4.1",
+  SpeedCosts_OptimizedSoftware,
+  ycbcr420_to_rgb24_row_sse41,
+  ycbcr420_to_rgb32_row_sse41,
+  ycbcr_to_rgb_row_8_sse41,
+  ycbcr_to_rgb_row_16_sse41,
+  ycbcr_to_rgb_row_8_fixed_point_sse41,
+  ycbcr_to_rgb_row_16_fixed_point_sse41,
+  upsample_chroma_bilinear_row_8_sse41,
+  upsample_chroma_bilinear_row_16_sse41
+};
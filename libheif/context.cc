@@ -50,6 +50,7 @@
 #include "security_limits.h"
 #include "compression.h"
 #include "color-conversion/colorconversion.h"
+#include "deadline.h"
 #include "plugin_registry.h"
 #include "image-items/hevc.h"
 #include "image-items/vvc.h"
@@ -144,19 +145,24 @@ void heif_encoder::copy_parameters_from(const heif_encoder& src)
 }
 
 
-HeifContext::HeifContext()
-    : m_memory_tracker(&m_limits)
+static heif_security_limits get_initial_security_limits()
 {
   const char* security_limits_variable = getenv("LIBHEIF_SECURITY_LIMITS");
 
   if (security_limits_variable && (strcmp(security_limits_variable, "off") == 0 ||
                                    strcmp(security_limits_variable, "OFF") == 0)) {
-    m_limits = disabled_security_limits;
+    return disabled_security_limits;
   }
   else {
-    m_limits = global_security_limits;
+    return global_security_limits;
   }
+}
+
 
+HeifContext::HeifContext()
+    : m_limits(get_initial_security_limits()),
+      m_memory_tracker(&m_limits) // registers a memory usage counter for m_limits
+{
   reset_to_empty_heif();
 }
 
@@ -1427,8 +1433,11 @@ Result<std::shared_ptr<HeifPixelImage>> HeifContext::decode_image(heif_item_id I
                                                                   heif_chroma out_chroma,
                                                                   const heif_decoding_options& options,
                                                                   bool decode_only_tile, uint32_t tx, uint32_t ty,
-                                                                  std::set<heif_item_id> processed_ids) const
+                                                                  std::set<heif_item_id> processed_ids,
+                                                                  std::vector<ExternalPlaneBuffer>* output_buffers) const
 {
+  MemoryUsageScope memory_usage_scope(&m_limits, get_memory_usage());
+
   std::shared_ptr<ImageItem> imgitem;
   if (m_all_images.contains(ID)) {
     imgitem = m_all_images.find(ID)->second;
@@ -1461,7 +1470,7 @@ Result<std::shared_ptr<HeifPixelImage>> HeifContext::decode_image(heif_item_id I
 
   // --- convert to output chroma format
 
-  auto img_result = convert_to_output_colorspace(img, out_colorspace, out_chroma, options);
+  auto img_result = convert_to_output_colorspace(std::move(img), out_colorspace, out_chroma, options, output_buffers);
   if (!img_result) {
     return img_result.error();
   }
@@ -1515,7 +1524,8 @@ bool nclx_color_profile_equal(std::optional<nclx_profile> a,
 Result<std::shared_ptr<HeifPixelImage>> HeifContext::convert_to_output_colorspace(std::shared_ptr<HeifPixelImage> img,
                                                                                   heif_colorspace out_colorspace,
                                                                                   heif_chroma out_chroma,
-                                                                                  const heif_decoding_options& options) const
+                                                                                  const heif_decoding_options& options,
+                                                                                  std::vector<ExternalPlaneBuffer>* output_buffers) const
 {
   heif_colorspace target_colorspace = (out_colorspace == heif_colorspace_undefined ?
                                        img->get_colorspace() :
@@ -1542,11 +1552,20 @@ Result<std::shared_ptr<HeifPixelImage>> HeifContext::convert_to_output_colorspac
       different_nclx ||
       (img->has_alpha() && options.color_conversion_options_ext && options.color_conversion_options_ext->alpha_composition_mode != heif_alpha_composition_mode_none)) {
 
+    // An explicitly requested output nclx profile also converts the transfer characteristics and primaries.
+
+    std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+        options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+    heif_color_conversion_options_ext_copy(options_ext.get(), options.color_conversion_options_ext);
+
     nclx_profile output_profile;
     if (options.output_image_nclx_profile) {
       output_profile.set_matrix_coefficients(options.output_image_nclx_profile->matrix_coefficients);
       output_profile.set_colour_primaries(options.output_image_nclx_profile->color_primaries);
+      output_profile.set_transfer_characteristics(options.output_image_nclx_profile->transfer_characteristics);
       output_profile.set_full_range_flag(options.output_image_nclx_profile->full_range_flag);
+
+      options_ext->convert_transfer_and_primaries = true;
     }
     else if (nclx_passthrough) {
       // Keep input image's NCLX as the conversion target so a chroma/colorspace
@@ -1557,9 +1576,12 @@ Result<std::shared_ptr<HeifPixelImage>> HeifContext::convert_to_output_colorspac
       output_profile.set_sRGB_defaults();
     }
 
-    return convert_colorspace(img, target_colorspace, target_chroma, output_profile, converted_output_bpp,
-                                         options.color_conversion_options, options.color_conversion_options_ext,
-                                         get_security_limits());
+    return convert_colorspace(std::move(img), target_colorspace, target_chroma, output_profile, converted_output_bpp,
+                                         options.color_conversion_options, options_ext.get(),
+                                         get_security_limits(),
+                                         [&options]() { return is_decoding_canceled(options); },
+                                         output_buffers,
+                                         options.num_library_threads > 0 ? options.num_library_threads : get_max_decoding_threads());
   }
   else {
     return img;
@@ -1643,7 +1665,9 @@ Result<std::shared_ptr<ImageItem>> HeifContext::encode_image(const std::shared_p
                                                                                        encoder,
                                                                                        options.output_nclx_profile,
                                                                                        &options.color_conversion_options,
-                                                                                       get_security_limits());
+                                                                                       options.color_conversion_options_ext,
+                                                                                       get_security_limits(),
+                                                                                       options.num_library_threads > 0 ? options.num_library_threads : get_max_decoding_threads());
     if (!srcImageResult) {
       return srcImageResult.error();
     }
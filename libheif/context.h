@@ -45,6 +45,8 @@ class HeifFile;
 
 class HeifPixelImage;
 
+struct ExternalPlaneBuffer;
+
 class StreamWriter;
 
 class ImageItem;
@@ -81,6 +83,10 @@ public:
 
   [[nodiscard]] const heif_security_limits* get_security_limits() const { return &m_limits; }
 
+  // Counter of the memory that is allocated with this context's security limits.
+  // Open a MemoryUsageScope with it around decoding, so that allocations do not have to look it up.
+  [[nodiscard]] const std::shared_ptr<MemoryUsage>& get_memory_usage() const { return m_memory_tracker.get_memory_usage(); }
+
   Error read(const std::shared_ptr<StreamReader>& reader);
 
   Error read_from_file(const char* input_filename);
@@ -124,12 +130,15 @@ public:
                                                        heif_chroma out_chroma,
                                                        const heif_decoding_options& options,
                                                        bool decode_only_tile, uint32_t tx, uint32_t ty,
-                                                       std::set<heif_item_id> processed_ids) const;
+                                                       std::set<heif_item_id> processed_ids,
+                                                       std::vector<ExternalPlaneBuffer>* output_buffers = nullptr) const;
 
+  // If 'output_buffers' is set, the final color conversion step places its output planes into these buffers.
   Result<std::shared_ptr<HeifPixelImage>> convert_to_output_colorspace(std::shared_ptr<HeifPixelImage> img,
                                                                        heif_colorspace out_colorspace,
                                                                        heif_chroma out_chroma,
-                                                                       const heif_decoding_options& options) const;
+                                                                       const heif_decoding_options& options,
+                                                                       std::vector<ExternalPlaneBuffer>* output_buffers = nullptr) const;
 
   Result<heif_item_id> find_first_coded_image_id(heif_item_id in) const;
 
@@ -0,0 +1,107 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "deadline.h"
+
+#include <chrono>
+
+
+uint64_t get_monotonic_time_ms()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+
+bool decoding_deadline_exceeded(const heif_decoding_options& options)
+{
+  if (options.decoding_deadline_ms == 0) {
+    return false;
+  }
+
+  return get_monotonic_time_ms() >= options.decoding_deadline_ms;
+}
+
+
+bool is_decoding_canceled(const heif_decoding_options& options)
+{
+  if (options.cancel_decoding && options.cancel_decoding(options.progress_user_data)) {
+    return true;
+  }
+
+  return decoding_deadline_exceeded(options);
+}
+
+
+Error decoding_canceled_error(const heif_decoding_options& options)
+{
+  if (decoding_deadline_exceeded(options)) {
+    return Error{heif_error_Canceled, heif_suberror_Unspecified, "Decoding deadline exceeded"};
+  }
+
+  return Error{heif_error_Canceled, heif_suberror_Unspecified, "Decoding the image was canceled"};
+}
+
+
+DecodingCancelRelay::DecodingCancelRelay(const heif_decoding_options& options)
+    : m_options(options),
+      m_worker_options(options),
+      m_poller([&options]() { return is_decoding_canceled(options); })
+{
+  m_worker_options.progress_user_data = this;
+  m_worker_options.cancel_decoding = cancel_trampoline;
+  m_worker_options.start_progress = options.start_progress ? start_progress_trampoline : nullptr;
+  m_worker_options.on_progress = options.on_progress ? on_progress_trampoline : nullptr;
+  m_worker_options.end_progress = options.end_progress ? end_progress_trampoline : nullptr;
+}
+
+
+int DecodingCancelRelay::cancel_trampoline(void* relay_ptr)
+{
+  auto* relay = static_cast<DecodingCancelRelay*>(relay_ptr);
+  return relay->poll();
+}
+
+
+void DecodingCancelRelay::start_progress_trampoline(heif_progress_step step, int max_progress, void* relay_ptr)
+{
+  auto* relay = static_cast<DecodingCancelRelay*>(relay_ptr);
+  if (relay->m_poller.on_polling_thread()) {
+    relay->m_options.start_progress(step, max_progress, relay->m_options.progress_user_data);
+  }
+}
+
+
+void DecodingCancelRelay::on_progress_trampoline(heif_progress_step step, int progress, void* relay_ptr)
+{
+  auto* relay = static_cast<DecodingCancelRelay*>(relay_ptr);
+  if (relay->m_poller.on_polling_thread()) {
+    relay->m_options.on_progress(step, progress, relay->m_options.progress_user_data);
+  }
+}
+
+
+void DecodingCancelRelay::end_progress_trampoline(heif_progress_step step, void* relay_ptr)
+{
+  auto* relay = static_cast<DecodingCancelRelay*>(relay_ptr);
+  if (relay->m_poller.on_polling_thread()) {
+    relay->m_options.end_progress(step, relay->m_options.progress_user_data);
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_DEADLINE_H
+#define LIBHEIF_DEADLINE_H
+
+#include "error.h"
+#include "libheif/heif_decoding.h"
+
+#include "parallel.h"
+
+#include <cstdint>
+
+
+// Monotonic clock in milliseconds, as used for heif_decoding_options::decoding_deadline_ms.
+uint64_t get_monotonic_time_ms();
+
+bool decoding_deadline_exceeded(const heif_decoding_options& options);
+
+// Returns true when either the user canceled the decoding through cancel_decoding()
+// or the decoding deadline has passed.
+bool is_decoding_canceled(const heif_decoding_options& options);
+
+// The error to return when is_decoding_canceled() returned true.
+Error decoding_canceled_error(const heif_decoding_options& options);
+
+
+// Decoding options to hand to jobs that run on worker threads.
+//
+// The user callbacks (cancel_decoding() and the progress callbacks) are only forwarded when
+// they are invoked from the thread that constructed the relay. On other threads, the progress
+// callbacks are dropped and cancel_decoding() returns whether a previous poll detected the cancellation.
+// The constructing thread should call poll() while it waits for the workers (see parallel_for()).
+class DecodingCancelRelay
+{
+public:
+  explicit DecodingCancelRelay(const heif_decoding_options& options);
+
+  DecodingCancelRelay(const DecodingCancelRelay&) = delete;
+  DecodingCancelRelay& operator=(const DecodingCancelRelay&) = delete;
+
+  const heif_decoding_options& worker_options() const { return m_worker_options; }
+
+  bool poll() { return m_poller.is_canceled(); }
+
+  void set_canceled() { m_poller.set_canceled(); }
+
+  bool is_canceled() const { return m_poller.was_canceled(); }
+
+private:
+  const heif_decoding_options& m_options;
+  heif_decoding_options m_worker_options;
+  CancelPoller m_poller;
+
+  static int cancel_trampoline(void* relay);
+  static void start_progress_trampoline(heif_progress_step step, int max_progress, void* relay);
+  static void on_progress_trampoline(heif_progress_step step, int progress, void* relay);
+  static void end_progress_trampoline(heif_progress_step step, void* relay);
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "grid.h"
 #include "context.h"
 #include "file.h"
+#include <chrono>
 #include <cstring>
 #include <deque>
 #include <future>
@@ -29,6 +30,7 @@
 #include <algorithm>
 #include "api_structs.h"
 #include "security_limits.h"
+#include "deadline.h"
 
 
 Error ImageGrid::parse(const std::vector<uint8_t>& data)
@@ -235,7 +237,7 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_compressed_image(
 // which is the meaningful cross-check (grid-header size vs signaled size).
 
 #if ENABLE_PARALLEL_TILE_DECODING
-static void wait_for_jobs(std::deque<std::future<Error> >* jobs) {
+static void wait_for_jobs(std::deque<std::future<ImageItem_Grid::TileDecodingResult> >* jobs) {
   if (jobs->empty()) {
     return;
   }
@@ -249,8 +251,6 @@ static void wait_for_jobs(std::deque<std::future<Error> >* jobs) {
 
 Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(const heif_decoding_options& options, std::set<heif_item_id> processed_ids) const
 {
-  std::shared_ptr<HeifPixelImage> img; // the decoded image
-
   const ImageGrid& grid = get_grid_spec();
 
 
@@ -294,7 +294,10 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
   if (get_context()->get_max_decoding_threads() > 0)
     tiles.resize(static_cast<size_t>(grid.get_rows()) * static_cast<size_t>(grid.get_columns()));
 
-  std::deque<std::future<Error> > errs;
+  std::deque<std::future<TileDecodingResult> > jobs;
+
+  // The tile jobs call the user callbacks through this relay, so that they are only called from this thread.
+  DecodingCancelRelay cancel_relay(options);
 #endif
 
   uint32_t tile_width = 0;
@@ -307,9 +310,55 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
     options.on_progress(heif_progress_step_total, 0, options.progress_user_data);
   }
 
-  int progress_counter = 0;
+  GridDecodingState state;
+  uint32_t reported_progress = 0;
+
   bool cancelled = false;
-  std::shared_ptr<std::vector<Error> > warnings(new std::vector<Error>());
+  std::vector<Error> warnings;
+
+  // Origins of the tiles that could not be pasted into the canvas. The canvas is not zero-initialized,
+  // hence, these areas are cleared after all tiles have been decoded.
+  std::vector<std::pair<uint32_t, uint32_t> > missing_tiles;
+
+  // The progress is only reported from the calling thread, such that the progress callback is never called concurrently.
+  // Skipped tiles are counted as done.
+  auto report_progress = [&]() {
+    uint32_t num_tiles_done = state.num_tiles_done;
+    if (options.on_progress && num_tiles_done > reported_progress) {
+      reported_progress = num_tiles_done;
+      options.on_progress(heif_progress_step_total, static_cast<int>(num_tiles_done), options.progress_user_data);
+    }
+  };
+
+  // The results of the tile jobs are merged in the calling thread.
+  auto merge_tile_result = [&](TileDecodingResult&& result) {
+    warnings.insert(warnings.end(),
+                    std::make_move_iterator(result.warnings.begin()),
+                    std::make_move_iterator(result.warnings.end()));
+
+    if (!result.error && !result.pasted) {
+      missing_tiles.emplace_back(result.x0, result.y0);
+    }
+
+    report_progress();
+
+    return result.error;
+  };
+
+#if ENABLE_PARALLEL_TILE_DECODING
+  // Waits for the oldest job. While waiting, the progress of the other jobs is reported and the cancel callback is polled.
+  auto merge_first_job = [&]() {
+    std::future<TileDecodingResult>& job = jobs.front();
+    while (job.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+      report_progress();
+      cancel_relay.poll();
+    }
+
+    Error e = merge_tile_result(job.get());
+    jobs.pop_front();
+    return e;
+  };
+#endif
 
   for (uint32_t y = 0; y < grid.get_rows() && !cancelled; y++) {
     uint32_t x0 = 0;
@@ -322,10 +371,12 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
       if (!tileImg) {
         if (!options.strict_decoding && reference_idx != 0) {
           // Skip missing tiles (unless it's the first one).
-          warnings->push_back(Error{
+          warnings.push_back(Error{
             heif_error_Invalid_input,
             heif_suberror_Missing_grid_images,
           });
+          missing_tiles.emplace_back(x0, y0);
+          state.num_tiles_done++;
           reference_idx++;
           x0 += tile_width;
           continue;
@@ -338,7 +389,9 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
       if (auto error = tileImg->get_item_error()) {
         if (!options.strict_decoding && reference_idx != 0) {
           // Skip missing tiles (unless it's the first one).
-          warnings->push_back(error);
+          warnings.push_back(error);
+          missing_tiles.emplace_back(x0, y0);
+          state.num_tiles_done++;
           reference_idx++;
           x0 += tile_width;
           continue;
@@ -382,15 +435,18 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
         if (1)
 #endif
       {
-        if (options.cancel_decoding) {
-          if (options.cancel_decoding(options.progress_user_data)) {
-            cancelled = true;
-          }
+        if (!cancelled && is_decoding_canceled(options)) {
+          cancelled = true;
         }
 
-        err = decode_and_paste_tile_image(tileID, x0, y0, img, options, progress_counter, warnings, processed_ids);
-        if (err) {
-          return err;
+        if (!cancelled) {
+          TileDecodingResult result = decode_and_paste_tile_image(tileID, x0, y0, state, options, processed_ids);
+          state.num_tiles_done++;
+
+          err = merge_tile_result(std::move(result));
+          if (err) {
+            return err;
+          }
         }
       }
 
@@ -411,20 +467,18 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
 
       // If maximum number of threads running, wait until first thread finishes
 
-      if (errs.size() >= (size_t) get_context()->get_max_decoding_threads()) {
-        Error e = errs.front().get();
-        errs.pop_front();
+      if (jobs.size() >= (size_t) get_context()->get_max_decoding_threads()) {
+        Error e = merge_first_job();
         if (e) {
-          wait_for_jobs(&errs);
+          wait_for_jobs(&jobs);
           return e;
         }
       }
 
 
-      if (options.cancel_decoding) {
-        if (options.cancel_decoding(options.progress_user_data)) {
-          cancelled = true;
-        }
+      if (cancel_relay.poll()) {
+        cancelled = true;
+        break;
       }
 
 
@@ -433,19 +487,23 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
       tile_data data = tiles.front();
       tiles.pop_front();
 
-      errs.push_back(std::async(std::launch::async,
-                                &ImageItem_Grid::decode_and_paste_tile_image, this,
-                                data.tileID, data.x_origin, data.y_origin, std::ref(img), options,
-                                std::ref(progress_counter), warnings, processed_ids));
+      jobs.push_back(std::async(std::launch::async, [this, data, &state, worker_options = cancel_relay.worker_options(),
+                                                     processed_ids, memory_usage_scope = MemoryUsageScope::current()]() {
+        MemoryUsageScope worker_scope(memory_usage_scope);
+
+        TileDecodingResult result = decode_and_paste_tile_image(data.tileID, data.x_origin, data.y_origin,
+                                                                state, worker_options, processed_ids);
+        state.num_tiles_done++;
+        return result;
+      }));
     }
 
     // check for decoding errors in remaining tiles
 
-    while (!errs.empty()) {
-      Error e = errs.front().get();
-      errs.pop_front();
+    while (!jobs.empty()) {
+      Error e = merge_first_job();
       if (e) {
-        wait_for_jobs(&errs);
+        wait_for_jobs(&jobs);
         return e;
       }
     }
@@ -457,91 +515,90 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Grid::decode_full_grid_image(c
   }
 
   if (cancelled) {
-    return Error{heif_error_Canceled, heif_suberror_Unspecified, "Decoding the image was canceled"};
+    return decoding_canceled_error(options);
   }
 
+  std::shared_ptr<HeifPixelImage> img = state.canvas;
+
   if (img) {
-    img->add_warnings(*warnings.get());
+    for (const auto& [tile_x0, tile_y0] : missing_tiles) {
+      for (heif_channel channel : img->get_channel_set()) {
+        // the alpha channel has been filled with opaque values
+        if (channel != heif_channel_Alpha) {
+          img->zero_channel_area(channel, tile_x0, tile_y0, tile_width, tile_height);
+        }
+      }
+    }
+
+    img->add_warnings(warnings);
   }
 
   return img;
 }
 
-static Error progress_and_return_ok(const heif_decoding_options& options, int& progress_counter) {
-  if (options.on_progress) {
-#if ENABLE_PARALLEL_TILE_DECODING
-    static std::mutex progressMutex;
-    std::lock_guard<std::mutex> lock(progressMutex);
-#endif
-
-    options.on_progress(heif_progress_step_total, ++progress_counter, options.progress_user_data);
-  }
-  return Error::Ok;
-}
 
-Error ImageItem_Grid::decode_and_paste_tile_image(heif_item_id tileID, uint32_t x0, uint32_t y0,
-                                                  std::shared_ptr<HeifPixelImage>& inout_image,
-                                                  const heif_decoding_options& options,
-                                                  int& progress_counter,
-                                                  std::shared_ptr<std::vector<Error> > warnings,
-                                                  std::set<heif_item_id> processed_ids) const
+ImageItem_Grid::TileDecodingResult
+ImageItem_Grid::decode_and_paste_tile_image(heif_item_id tileID, uint32_t x0, uint32_t y0,
+                                            GridDecodingState& state,
+                                            const heif_decoding_options& options,
+                                            std::set<heif_item_id> processed_ids) const
 {
-  std::shared_ptr<HeifPixelImage> tile_img;
-#if ENABLE_PARALLEL_TILE_DECODING
-  static std::mutex warningsMutex;
-#endif
+  TileDecodingResult result;
+  result.x0 = x0;
+  result.y0 = y0;
 
   auto tileItem = get_context()->get_image(tileID, true);
   if (!tileItem && !options.strict_decoding) {
-    // We ignore missing images. The un-pasted canvas region stays zero from calloc().
-#if ENABLE_PARALLEL_TILE_DECODING
-    std::lock_guard<std::mutex> lock(warningsMutex);
-#endif
-    warnings->emplace_back(
+    // We ignore missing images. The un-pasted canvas region is cleared at the end.
+    result.warnings.emplace_back(
       heif_error_Invalid_input,
       heif_suberror_Missing_grid_images,
       "Missing grid image"
     );
-    return progress_and_return_ok(options, progress_counter);
+    return result;
   }
 
   assert(tileItem);
   if (auto error = tileItem->get_item_error()) {
-    return error;
+    result.error = error;
+    return result;
   }
 
   auto decodeResult = tileItem->decode_image(options, false, 0, 0, processed_ids);
   if (!decodeResult) {
     if (!options.strict_decoding) {
-      // We ignore broken tiles. The un-pasted canvas region stays zero from calloc().
-#if ENABLE_PARALLEL_TILE_DECODING
-      std::lock_guard<std::mutex> lock(warningsMutex);
-#endif
-      warnings->push_back(decodeResult.error());
-      return progress_and_return_ok(options, progress_counter);
+      // We ignore broken tiles. The un-pasted canvas region is cleared at the end.
+      result.warnings.push_back(decodeResult.error());
+      return result;
     }
 
-    return decodeResult.error();
+    result.error = decodeResult.error();
+    return result;
   }
 
-  tile_img = *decodeResult;
+  std::shared_ptr<HeifPixelImage> tile_img = *decodeResult;
 
   uint32_t w = get_grid_spec().get_width();
   uint32_t h = get_grid_spec().get_height();
 
   // --- generate the image canvas for combining all the tiles
 
-  if (!inout_image) { // this avoids that we normally have to lock a mutex
+  std::shared_ptr<HeifPixelImage> canvas;
+
+  {
 #if ENABLE_PARALLEL_TILE_DECODING
-    static std::mutex createImageMutex;
-    std::lock_guard<std::mutex> lock(createImageMutex);
+    std::lock_guard<std::mutex> lock(state.canvas_mutex);
 #endif
 
-    if (!inout_image) {
+    if (!state.canvas) {
       auto grid_image = std::make_shared<HeifPixelImage>();
-      auto err = grid_image->create_clone_image_at_new_size(tile_img, w, h, get_context()->get_security_limits());
+      // The tiles cover the whole canvas and the areas of missing tiles are cleared at the end.
+      // Hence, we can skip zero-initializing the canvas.
+      auto err = grid_image->create_clone_image_at_new_size(tile_img, w, h, get_context()->get_security_limits(),
+                                                            false);
       if (err) {
-        return err;
+        result.error = err;
+        return result;
       }
 
       // Fill alpha plane with opaque in case not all tiles have alpha planes
@@ -556,24 +613,44 @@ Error ImageItem_Grid::decode_and_paste_tile_image(heif_item_id tileID, uint32_t
 
       grid_image->copy_metadata_from(*tile_img);
 
-      inout_image = grid_image; // We have to set this at the very end because of the unlocked check to `inout_image` above.
+      state.canvas = grid_image;
     }
+
+    canvas = state.canvas;
   }
 
   // --- copy tile into output image
 
-  heif_chroma chroma = inout_image->get_chroma_format();
+  heif_chroma chroma = canvas->get_chroma_format();
 
   if (chroma != tile_img->get_chroma_format()) {
-    return {heif_error_Invalid_input,
-            heif_suberror_Wrong_tile_image_chroma_format,
-            "Image tile has different chroma format than combined image"};
+    result.error = {heif_error_Invalid_input,
+                    heif_suberror_Wrong_tile_image_chroma_format,
+                    "Image tile has different chroma format than combined image"};
+    return result;
   }
 
 
-  inout_image->copy_image_to(tile_img, x0, y0);
+  if (Error err = canvas->copy_image_to(tile_img, x0, y0)) {
+    if (options.strict_decoding) {
+      result.error = err;
+      return result;
+    }
+
+    result.warnings.push_back(err);
+    return result;
+  }
+
+  // clear canvas channels that are not contained in this tile
+
+  for (heif_channel channel : canvas->get_channel_set()) {
+    if (channel != heif_channel_Alpha && !tile_img->has_channel(channel)) {
+      canvas->zero_channel_area(channel, x0, y0, tile_img->get_width(), tile_img->get_height());
+    }
+  }
 
-  return progress_and_return_ok(options, progress_counter);
+  result.pasted = true;
+  return result;
 }
 
 
@@ -26,6 +26,9 @@
 #include <string>
 #include <memory>
 #include <set>
+#include <atomic>
+#include <mutex>
+#include <utility>
 
 
 class ImageGrid
@@ -170,11 +173,30 @@ private:
 
   Result<std::shared_ptr<HeifPixelImage>> decode_grid_tile(const heif_decoding_options& options, uint32_t tx, uint32_t ty, std::set<heif_item_id> processed_ids) const;
 
-  Error decode_and_paste_tile_image(heif_item_id tileID, uint32_t x0, uint32_t y0,
-                                    std::shared_ptr<HeifPixelImage>& inout_image,
-                                    const heif_decoding_options& options, int& progress_counter,
-                                    std::shared_ptr<std::vector<Error> > warnings,
-                                    std::set<heif_item_id> processed_ids) const;
+  // State of a full grid decode that is shared by its tile decoding jobs.
+  struct GridDecodingState
+  {
+    std::shared_ptr<HeifPixelImage> canvas;
+    std::mutex canvas_mutex; // protects the creation of the canvas
+
+    std::atomic<uint32_t> num_tiles_done{0};
+  };
+
+public:
+  // Result of decoding one tile. Each job collects its own warnings. They are merged at the end.
+  struct TileDecodingResult
+  {
+    Error error;
+    std::vector<Error> warnings;
+    uint32_t x0 = 0, y0 = 0;
+    bool pasted = false; // false if the tile was skipped in non-strict mode
+  };
+
+private:
+  TileDecodingResult decode_and_paste_tile_image(heif_item_id tileID, uint32_t x0, uint32_t y0,
+                                                 GridDecodingState& state,
+                                                 const heif_decoding_options& options,
+                                                 std::set<heif_item_id> processed_ids) const;
 };
 
 
@@ -506,7 +506,13 @@ Error ImageItem::get_coded_image_colorspace(heif_colorspace* out_colorspace, hei
 
   auto decoder = *decoderResult;
 
-  Error err = decoder->get_coded_image_colorspace(out_colorspace, out_chroma);
+  Error err;
+
+  {
+    std::lock_guard<std::mutex> lock(decoder->get_decoding_mutex());
+    err = decoder->get_coded_image_colorspace(out_colorspace, out_chroma);
+  }
+
   if (err) {
     return err;
   }
@@ -526,6 +532,7 @@ int ImageItem::get_luma_bits_per_pixel() const
 
   auto decoder = *decoderResult;
 
+  std::lock_guard<std::mutex> lock(decoder->get_decoding_mutex());
   return decoder->get_luma_bits_per_pixel();
 }
 
@@ -539,6 +546,7 @@ int ImageItem::get_chroma_bits_per_pixel() const
 
   auto decoder = *decoderResult;
 
+  std::lock_guard<std::mutex> lock(decoder->get_decoding_mutex());
   return decoder->get_chroma_bits_per_pixel();
 }
 
@@ -883,12 +891,14 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem::decode_image(const heif_decod
                                                                 bool decode_tile_only, uint32_t tile_x0, uint32_t tile_y0,
                                                                 std::set<heif_item_id> processed_ids) const
 {
-  // Check for cycles before taking m_decode_mutex: a derived item that
-  // (transitively) references itself would otherwise re-enter decode_image()
-  // on the same ImageItem and self-deadlock on the non-recursive mutex.
+  // Check for cycles: a derived item that (transitively) references itself
+  // would otherwise recurse endlessly.
   // The matching insert lives inside decode_compressed_image() of derived
   // items (grid/overlay/iden), so the current item is in processed_ids only
   // when called from one of its own descendants.
+  //
+  // Note: there is no lock for the whole decode. Several threads may decode (tiles of) the same item
+  // concurrently. The shared state is protected where it is used (decoder instances, offset tables, warnings).
   if (processed_ids.contains(m_id)) {
     return Error{heif_error_Invalid_input,
                  heif_suberror_Unspecified,
@@ -899,8 +909,6 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem::decode_image(const heif_decod
     return m_item_error;
   }
 
-  std::lock_guard<std::mutex> lock(m_decode_mutex);
-
   // --- check whether image size (according to 'ispe') exceeds maximum
 
   if (!decode_tile_only) {
@@ -1263,6 +1271,8 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem::decode_compressed_image(const
 
   auto decoder = *decoderResult;
 
+  std::lock_guard<std::mutex> lock(decoder->get_decoding_mutex());
+
   decoder->set_data_extent(std::move(extent));
 
   // Tighten max_image_size_pixels for this decode so a decoder plugin (e.g.
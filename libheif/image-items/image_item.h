@@ -424,9 +424,17 @@ public:
   const std::vector<heif_item_id>& get_region_item_ids() const { return m_region_item_ids; }
 
 
-  void add_decoding_warning(Error err) const { m_decoding_warnings.emplace_back(std::move(err)); }
+  void add_decoding_warning(Error err) const
+  {
+    std::lock_guard<std::mutex> lock(m_decoding_warnings_mutex);
+    m_decoding_warnings.emplace_back(std::move(err));
+  }
 
-  const std::vector<Error>& get_decoding_warnings() const { return m_decoding_warnings; }
+  std::vector<Error> get_decoding_warnings() const
+  {
+    std::lock_guard<std::mutex> lock(m_decoding_warnings_mutex);
+    return m_decoding_warnings;
+  }
 
   virtual heif_image_tiling get_heif_image_tiling() const;
 
@@ -492,8 +500,7 @@ private:
   Box_cmex::ExtrinsicMatrix m_extrinsic_matrix{};
 
   mutable std::vector<Error> m_decoding_warnings;
-
-  mutable std::mutex m_decode_mutex;
+  mutable std::mutex m_decoding_warnings_mutex;
 
   std::vector<heif_item_id> m_text_item_ids;
 
@@ -23,8 +23,11 @@
 #include "file.h"
 #include "color-conversion/colorconversion.h"
 #include "security_limits.h"
+#include "parallel.h"
+#include "deadline.h"
 
 #include <utility>
+#include <vector>
 
 
 template<typename I>
@@ -309,18 +312,24 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Overlay::decode_overlay_image(
     return err;
   }
 
+  // The layers are composited at the bit depth that is reported for the overlay image (that of the first layer).
+  int bpp = get_luma_bits_per_pixel();
+  if (bpp < 8 || bpp > 16) {
+    bpp = 8;
+  }
+
   // TODO: seems we always have to compose this in RGB since the background color is an RGB value
   img = std::make_shared<HeifPixelImage>();
   img->create(w, h,
               heif_colorspace_RGB,
               heif_chroma_444);
-  if (auto error = img->add_channel(heif_channel_R, w, h, 8, get_context()->get_security_limits())) { // TODO: other bit depths
+  if (auto error = img->add_channel(heif_channel_R, w, h, bpp, get_context()->get_security_limits())) {
     return error;
   }
-  if (auto error = img->add_channel(heif_channel_G, w, h, 8, get_context()->get_security_limits())) { // TODO: other bit depths
+  if (auto error = img->add_channel(heif_channel_G, w, h, bpp, get_context()->get_security_limits())) {
     return error;
   }
-  if (auto error = img->add_channel(heif_channel_B, w, h, 8, get_context()->get_security_limits())) { // TODO: other bit depths
+  if (auto error = img->add_channel(heif_channel_B, w, h, bpp, get_context()->get_security_limits())) {
     return error;
   }
 
@@ -332,17 +341,21 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Overlay::decode_overlay_image(
     return err;
   }
 
-  for (size_t i = 0; i < m_overlay_image_ids.size(); i++) {
+  // --- check the references before starting any decoding
+
+  std::vector<std::shared_ptr<const ImageItem>> layer_items;
+
+  for (heif_item_id layer_id : m_overlay_image_ids) {
 
     // detect if 'iovl' is referencing itself
 
-    if (m_overlay_image_ids[i] == get_id()) {
+    if (layer_id == get_id()) {
       return Error{heif_error_Invalid_input,
                    heif_suberror_Unspecified,
                    "Self-reference in 'iovl' image item."};
     }
 
-    auto imgItem = get_context()->get_image(m_overlay_image_ids[i], true);
+    auto imgItem = get_context()->get_image(layer_id, true);
     if (!imgItem) {
       return Error(heif_error_Invalid_input, heif_suberror_Nonexisting_item_referenced, "'iovl' image references a non-existing item.");
     }
@@ -350,9 +363,39 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Overlay::decode_overlay_image(
       return error;
     }
 
-    auto decodeResult = imgItem->decode_image(options, false, 0,0, processed_ids);
+    layer_items.push_back(imgItem);
+  }
+
+
+  // --- decode all layers concurrently and convert them to the canvas format
+
+  const auto num_layers = static_cast<uint32_t>(layer_items.size());
+
+  std::vector<std::shared_ptr<HeifPixelImage>> layer_images(num_layers);
+  std::vector<Error> layer_errors(num_layers);
+
+  // The layers are decoded on worker threads. The user callbacks are only called from this
+  // thread, the workers see the state of the last poll.
+  DecodingCancelRelay cancel_relay(options);
+  const heif_decoding_options& layer_options = cancel_relay.worker_options();
+
+  if (cancel_relay.poll()) {
+    return decoding_canceled_error(options);
+  }
+
+  parallel_for(num_layers, get_context()->get_max_decoding_threads(), [&](uint32_t i) {
+    if (is_decoding_canceled(layer_options)) {
+      cancel_relay.set_canceled();
+      return;
+    }
+
+    auto decodeResult = layer_items[i]->decode_image(layer_options, false, 0, 0, processed_ids);
     if (!decodeResult) {
-      return decodeResult.error();
+      if (decodeResult.error().error_code == heif_error_Canceled) {
+        cancel_relay.set_canceled();
+      }
+      layer_errors[i] = decodeResult.error();
+      return;
     }
 
     std::shared_ptr<HeifPixelImage> overlay_img = *decodeResult;
@@ -361,23 +404,41 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Overlay::decode_overlay_image(
     // process overlay in RGB space
 
     if (overlay_img->get_colorspace() != heif_colorspace_RGB ||
-        overlay_img->get_chroma_format() != heif_chroma_444) {
+        overlay_img->get_chroma_format() != heif_chroma_444 ||
+        overlay_img->get_bits_per_pixel(heif_channel_R) != bpp) {
       auto overlay_img_result = convert_colorspace(overlay_img, heif_colorspace_RGB, heif_chroma_444,
                                                    nclx_profile::undefined(),
-                                                   0, options.color_conversion_options, options.color_conversion_options_ext,
+                                                   bpp, options.color_conversion_options, options.color_conversion_options_ext,
                                                    get_context()->get_security_limits());
       if (!overlay_img_result) {
-        return overlay_img_result.error();
-      }
-      else {
-        overlay_img = *overlay_img_result;
+        layer_errors[i] = overlay_img_result.error();
+        return;
       }
+
+      overlay_img = *overlay_img_result;
+    }
+
+    layer_images[i] = std::move(overlay_img);
+  }, [&cancel_relay]() { cancel_relay.poll(); });
+
+  if (cancel_relay.is_canceled()) {
+    return decoding_canceled_error(options);
+  }
+
+  for (const Error& layer_error : layer_errors) {
+    if (layer_error) {
+      return layer_error;
     }
+  }
 
+
+  // --- composite the layers in their stacking order
+
+  for (uint32_t i = 0; i < num_layers; i++) {
     int32_t dx, dy;
     m_overlay_spec.get_offset(i, &dx, &dy);
 
-    err = img->overlay(overlay_img, dx, dy);
+    err = img->overlay(layer_images[i], dx, dy);
     if (err) {
       if (err.error_code == heif_error_Invalid_input &&
           err.sub_error_code == heif_suberror_Overlay_image_outside_of_canvas) {
@@ -387,6 +448,9 @@ Result<std::shared_ptr<HeifPixelImage>> ImageItem_Overlay::decode_overlay_image(
         return err;
       }
     }
+
+    // release the layer as early as possible to limit the memory peak
+    layer_images[i].reset();
   }
 
   return img;
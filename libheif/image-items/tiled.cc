@@ -840,7 +840,11 @@ Error ImageItem_Tiled::add_image_tile(uint32_t tile_x, uint32_t tile_y,
   colorConversionResult = item->get_encoder()->convert_colorspace_for_encoding(image, encoder,
                                                                                m_tile_encoding_options->output_nclx_profile,
                                                                                &m_tile_encoding_options->color_conversion_options,
-                                                                               get_context()->get_security_limits());
+                                                                               m_tile_encoding_options->color_conversion_options_ext,
+                                                                               get_context()->get_security_limits(),
+                                                                               m_tile_encoding_options->num_library_threads > 0 ?
+                                                                               m_tile_encoding_options->num_library_threads :
+                                                                               get_context()->get_max_decoding_threads());
   if (!colorConversionResult) {
     return colorConversionResult.error();
   }
@@ -980,15 +984,21 @@ Error ImageItem_Tiled::append_compressed_tile_data(std::vector<uint8_t>& data, u
   }
   auto idx = static_cast<uint32_t>(idx64);
 
-  if (!m_tild_header.is_tile_offset_known(idx)) {
-    Error err = const_cast<ImageItem_Tiled*>(this)->load_tile_offset_entry(idx);
-    if (err) {
-      return err;
+  uint64_t offset, size;
+
+  {
+    std::lock_guard<std::mutex> lock(m_tile_offsets_mutex);
+
+    if (!m_tild_header.is_tile_offset_known(idx)) {
+      Error err = const_cast<ImageItem_Tiled*>(this)->load_tile_offset_entry(idx);
+      if (err) {
+        return err;
+      }
     }
-  }
 
-  uint64_t offset = m_tild_header.get_tile_offset(idx);
-  uint64_t size = m_tild_header.get_tile_size(idx);
+    offset = m_tild_header.get_tile_offset(idx);
+    size = m_tild_header.get_tile_size(idx);
+  }
 
   Error err = get_file()->append_data_from_iloc(get_id(), data, offset, size);
   if (err.error_code) {
@@ -1004,18 +1014,29 @@ ImageItem_Tiled::get_compressed_data_for_tile(uint32_t tx, uint32_t ty) const
 {
   // --- get compressed data
 
-  Error err = m_tile_item->initialize_decoder();
-  if (err) {
-    return err;
+  Result<std::vector<uint8_t>> dataResult;
+
+  {
+    std::lock_guard<std::mutex> lock(m_tile_item_mutex);
+
+    if (!m_tile_item_decoder_initialized) {
+      Error err = m_tile_item->initialize_decoder();
+      if (err) {
+        return err;
+      }
+
+      m_tile_item_decoder_initialized = true;
+    }
+
+    dataResult = m_tile_item->read_bitstream_configuration_data();
   }
 
-  Result<std::vector<uint8_t>> dataResult = m_tile_item->read_bitstream_configuration_data();
   if (!dataResult) {
     return dataResult.error();
   }
 
   std::vector<uint8_t> data = std::move(*dataResult);
-  err = append_compressed_tile_data(data, tx, ty);
+  Error err = append_compressed_tile_data(data, tx, ty);
   if (err) {
     return err;
   }
@@ -1037,15 +1058,50 @@ ImageItem_Tiled::decode_grid_tile(const heif_decoding_options& options, uint32_t
     return extentResult.error();
   }
 
-  m_tile_decoder->set_data_extent(std::move(*extentResult));
+  std::shared_ptr<Decoder> decoder = acquire_tile_decoder();
+  if (!decoder) {
+    return Error{heif_error_Unsupported_feature,
+                 heif_suberror_Unsupported_codec,
+                 "'tili' image with unsupported compression format."};
+  }
+
+  decoder->set_data_extent(std::move(*extentResult));
 
   uint32_t tw = 0, th = 0;
   get_tile_size(tw, th);
   heif_security_limits tightened = tighten_image_size_limit_for_ispe(
       get_context()->get_security_limits(), tw, th,
-      max_coding_unit_size_for_codec(m_tile_decoder->get_compression_format()));
+      max_coding_unit_size_for_codec(decoder->get_compression_format()));
+
+  auto decodeResult = decoder->decode_single_frame_from_compressed_data(options, &tightened);
+
+  release_tile_decoder(std::move(decoder));
 
-  return m_tile_decoder->decode_single_frame_from_compressed_data(options, &tightened);
+  return decodeResult;
+}
+
+
+std::shared_ptr<Decoder> ImageItem_Tiled::acquire_tile_decoder() const
+{
+  {
+    std::lock_guard<std::mutex> lock(m_tile_decoders_mutex);
+
+    if (!m_idle_tile_decoders.empty()) {
+      std::shared_ptr<Decoder> decoder = std::move(m_idle_tile_decoders.back());
+      m_idle_tile_decoders.pop_back();
+      return decoder;
+    }
+  }
+
+  // The decoder plugin instance is created when decoding. Hence, a new decoder is cheap.
+  return Decoder::alloc_for_infe_type(m_tile_item.get());
+}
+
+
+void ImageItem_Tiled::release_tile_decoder(std::shared_ptr<Decoder> decoder) const
+{
+  std::lock_guard<std::mutex> lock(m_tile_decoders_mutex);
+  m_idle_tile_decoders.push_back(std::move(decoder));
 }
 
 
@@ -1095,9 +1151,15 @@ Error ImageItem_Tiled::get_coded_image_colorspace(heif_colorspace* out_colorspac
     return extentResult.error();
   }
 
-  m_tile_decoder->set_data_extent(std::move(*extentResult));
+  Error err;
+
+  {
+    std::lock_guard<std::mutex> lock(m_tile_decoder->get_decoding_mutex());
+
+    m_tile_decoder->set_data_extent(std::move(*extentResult));
+    err = m_tile_decoder->get_coded_image_colorspace(out_colorspace, out_chroma);
+  }
 
-  Error err = m_tile_decoder->get_coded_image_colorspace(out_colorspace, out_chroma);
   if (err) {
     return err;
   }
@@ -1112,6 +1174,8 @@ int ImageItem_Tiled::get_luma_bits_per_pixel() const
 {
   DataExtent any_tile_extent;
   append_compressed_tile_data(any_tile_extent.m_raw, 0,0); // TODO: use tile that is already loaded
+
+  std::lock_guard<std::mutex> lock(m_tile_decoder->get_decoding_mutex());
   m_tile_decoder->set_data_extent(std::move(any_tile_extent));
 
   return m_tile_decoder->get_luma_bits_per_pixel();
@@ -1121,6 +1185,8 @@ int ImageItem_Tiled::get_chroma_bits_per_pixel() const
 {
   DataExtent any_tile_extent;
   append_compressed_tile_data(any_tile_extent.m_raw, 0,0); // TODO: use tile that is already loaded
+
+  std::lock_guard<std::mutex> lock(m_tile_decoder->get_decoding_mutex());
   m_tile_decoder->set_data_extent(std::move(any_tile_extent));
 
   return m_tile_decoder->get_chroma_bits_per_pixel();
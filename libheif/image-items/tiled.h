@@ -27,6 +27,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <utility>
 #include "libheif/heif_experimental.h"
 #include "libheif/heif_encoding.h"
@@ -226,8 +227,23 @@ private:
   bool m_preload_offset_table = false;
 
   std::shared_ptr<ImageItem> m_tile_item;
+  mutable bool m_tile_item_decoder_initialized = false;
+  mutable std::mutex m_tile_item_mutex;
+
+  // Decoder for querying the tile format. Tiles are decoded with decoders from the pool below.
   std::shared_ptr<Decoder> m_tile_decoder;
 
+  // Unused tile decoders. Each concurrent tile decode takes its own decoder from this pool.
+  mutable std::vector<std::shared_ptr<Decoder>> m_idle_tile_decoders;
+  mutable std::mutex m_tile_decoders_mutex;
+
+  // Protects loading the offset table entries on demand.
+  mutable std::mutex m_tile_offsets_mutex;
+
+  std::shared_ptr<Decoder> acquire_tile_decoder() const;
+
+  void release_tile_decoder(std::shared_ptr<Decoder> decoder) const;
+
   Result<DataExtent>
   get_compressed_data_for_tile(uint32_t tx, uint32_t ty) const;
 
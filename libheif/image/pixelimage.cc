@@ -22,6 +22,7 @@
 #include "pixelimage.h"
 #include "common_utils.h"
 #include "security_limits.h"
+#include "plane_allocator.h"
 
 #include <cassert>
 #include <cstdlib>
@@ -31,6 +32,7 @@
 #include <algorithm>
 #include <map>
 #include <color-conversion/colorconversion.h>
+#include "color-conversion/blend_kernels.h"
 
 #include "codecs/uncompressed/unc_types.h"
 
@@ -157,7 +159,7 @@ static std::vector<uint16_t> map_channel_to_component_type(heif_channel channel,
 HeifPixelImage::~HeifPixelImage()
 {
   for (auto& component : m_storage) {
-    std::free(component.allocated_mem);
+    free_plane_memory(component.allocated_mem, component.allocation_size);
   }
 }
 
@@ -297,6 +299,60 @@ static uint32_t rounded_size(uint32_t s)
   return s;
 }
 
+
+static thread_local std::vector<ExternalPlaneBuffer>* tExternalPlaneBuffers = nullptr;
+
+
+ScopedExternalPlaneBuffers::ScopedExternalPlaneBuffers(std::vector<ExternalPlaneBuffer>* buffers)
+    : m_previous_buffers(tExternalPlaneBuffers)
+{
+  tExternalPlaneBuffers = buffers;
+}
+
+
+ScopedExternalPlaneBuffers::~ScopedExternalPlaneBuffers()
+{
+  tExternalPlaneBuffers = m_previous_buffers;
+}
+
+
+bool ExternalPlaneBuffer::can_hold(uint64_t row_size, uint32_t height) const
+{
+  if (stride == 0 || stride < row_size) {
+    return false;
+  }
+
+  if (height == 0) {
+    return true;
+  }
+
+  return size / stride >= height - 1 &&
+         size - (height - 1) * static_cast<uint64_t>(stride) >= row_size;
+}
+
+
+static ExternalPlaneBuffer* find_external_plane_buffer(heif_channel channel, uint32_t width, uint32_t height,
+                                                       int bytes_per_pixel)
+{
+  if (tExternalPlaneBuffers == nullptr) {
+    return nullptr;
+  }
+
+  uint64_t row_size = static_cast<uint64_t>(width) * bytes_per_pixel;
+
+  for (auto& buffer : *tExternalPlaneBuffers) {
+    if (!buffer.used &&
+        buffer.channel == channel &&
+        buffer.data != nullptr &&
+        buffer.can_hold(row_size, height)) {
+      return &buffer;
+    }
+  }
+
+  return nullptr;
+}
+
+
 void HeifPixelImage::register_component_descriptions(ComponentStorage& plane,
                                                  const std::vector<uint16_t>& component_types)
 {
@@ -389,7 +445,8 @@ Error HeifPixelImage::add_channel(heif_channel channel, uint32_t width, uint32_t
 Error HeifPixelImage::ComponentStorage::alloc(uint32_t width, uint32_t height, heif_component_datatype datatype, int bit_depth,
                                         int num_interleaved_components,
                                         const heif_security_limits* limits,
-                                        MemoryHandle& memory_handle)
+                                        MemoryHandle& memory_handle,
+                                        bool zero_initialize)
 {
   assert(bit_depth >= 1);
   assert(bit_depth <= 128);
@@ -456,6 +513,21 @@ Error HeifPixelImage::ComponentStorage::alloc(uint32_t width, uint32_t height, h
             sstr.str()};
   }
 
+  // --- place the plane into caller-provided memory if available (see ScopedExternalPlaneBuffers)
+
+  if (ExternalPlaneBuffer* buffer = find_external_plane_buffer(m_channel, width, height, bytes_per_pixel)) {
+    buffer->used = true;
+
+    m_mem_width = width;
+    m_mem_height = height;
+    stride = buffer->stride;
+    allocated_mem = nullptr;
+    allocation_size = 0;
+    mem = buffer->data;
+
+    return Error::Ok;
+  }
+
   // Check for allocation size overflow using 64-bit arithmetic
   // Test case was an overlay image with size 1x134217727.
   // Width 1 gets aligned to 64 and then width * height overflows 32 bit systems.
@@ -465,7 +537,7 @@ Error HeifPixelImage::ComponentStorage::alloc(uint32_t width, uint32_t height, h
             heif_suberror_Security_limit_exceeded,
             "Image allocation size overflow"};
   }
-  allocation_size = static_cast<size_t>(alloc_64);
+  allocation_size = get_plane_allocation_size(static_cast<size_t>(alloc_64));
 
   if (auto err = memory_handle.alloc(allocation_size, limits, "image data")) {
     return err;
@@ -475,7 +547,8 @@ Error HeifPixelImage::ComponentStorage::alloc(uint32_t width, uint32_t height, h
 
   // Must zero-initialize: padding regions (stride, rounded_size(), alignment slack) are not
   // written by decoders, so uninitialized contents would leak across decoded images.
-  allocated_mem = static_cast<uint8_t*>(std::calloc(1, allocation_size));
+  // When the caller overwrites the whole image area, only the padding is cleared below.
+  allocated_mem = alloc_plane_memory(allocation_size, zero_initialize);
   if (allocated_mem == nullptr) {
     std::stringstream sstr;
     sstr << "Allocating " << allocation_size << " bytes failed";
@@ -497,6 +570,15 @@ Error HeifPixelImage::ComponentStorage::alloc(uint32_t width, uint32_t height, h
 
   mem = mem_8;
 
+  if (!zero_initialize) {
+    size_t row_bytes = static_cast<size_t>(width) * bytes_per_pixel;
+    for (uint32_t y = 0; y < height; y++) {
+      memset(mem_8 + y * stride + row_bytes, 0, stride - row_bytes);
+    }
+
+    memset(mem_8 + height * stride, 0, (m_mem_height - height) * stride);
+  }
+
   return Error::Ok;
 }
 
@@ -556,7 +638,7 @@ Error HeifPixelImage::extend_padding_to_size(uint32_t width, uint32_t height, bo
       // --- release the old plane before replacing it with the reallocated plane
 
       m_memory_handle.free(component.allocation_size);
-      std::free(component.allocated_mem);
+      free_plane_memory(component.allocated_mem, component.allocation_size);
 
       component = newPlane;
     }
@@ -647,7 +729,7 @@ Error HeifPixelImage::extend_to_size_with_zero(uint32_t width, uint32_t height,
       // --- release the old plane before replacing it with the reallocated plane
 
       m_memory_handle.free(component.allocation_size);
-      std::free(component.allocated_mem);
+      free_plane_memory(component.allocated_mem, component.allocation_size);
 
       component = newPlane;
     }
@@ -1088,6 +1170,24 @@ void HeifPixelImage::transfer_channel_from_image_as(const std::shared_ptr<HeifPi
 }
 
 
+void HeifPixelImage::remove_channel(heif_channel channel)
+{
+  for (auto it = m_storage.begin(); it != m_storage.end(); ++it) {
+    if (it->m_channel == channel) {
+      for (uint32_t id : it->m_component_ids) {
+        remove_component_description(id);
+      }
+
+      m_memory_handle.free(it->allocation_size);
+      free_plane_memory(it->allocated_mem, it->allocation_size);
+
+      m_storage.erase(it);
+      return;
+    }
+  }
+}
+
+
 bool is_interleaved_with_alpha(heif_chroma chroma)
 {
   switch (chroma) {
@@ -1172,6 +1272,33 @@ Error HeifPixelImage::copy_image_to(const std::shared_ptr<const HeifPixelImage>&
 }
 
 
+void HeifPixelImage::zero_channel_area(heif_channel channel, uint32_t x0, uint32_t y0, uint32_t w, uint32_t h)
+{
+  if (!has_channel(channel) || x0 >= get_width() || y0 >= get_height()) {
+    return;
+  }
+
+  heif_chroma chroma = get_chroma_format();
+
+  size_t stride;
+  uint8_t* data = get_channel_memory(channel, &stride);
+
+  uint32_t xs = channel_width(x0, chroma, channel);
+  uint32_t ys = channel_height(y0, chroma, channel);
+
+  // see copy_image_to() for the chroma rounding
+  uint32_t area_width = std::min(channel_width(w, chroma, channel), get_width(channel) - xs);
+  uint32_t area_height = std::min(channel_height(h, chroma, channel), get_height(channel) - ys);
+
+  uint32_t bytes_per_pixel = get_storage_bits_per_pixel(channel) / 8;
+
+  for (uint32_t py = 0; py < area_height; py++) {
+    memset(data + xs * bytes_per_pixel + (ys + py) * stride, 0,
+           static_cast<size_t>(area_width) * bytes_per_pixel);
+  }
+}
+
+
 Result<std::shared_ptr<HeifPixelImage>> HeifPixelImage::rotate_ccw(int angle_degrees, const heif_security_limits* limits)
 {
   // TODO: Bayer pattern, polarization patterns and sensor maps reference
@@ -1565,10 +1692,10 @@ Error HeifPixelImage::fill_RGB_16bit(uint16_t r, uint16_t g, uint16_t b, uint16_
 
     ComponentStorage& plane = *comp;
 
-    if (plane.m_bit_depth != 8) {
+    if (plane.m_bit_depth < 8 || plane.m_bit_depth > 16 || plane.m_datatype != heif_component_datatype_unsigned_integer) {
       return {heif_error_Unsupported_feature,
               heif_suberror_Unspecified,
-              "Can currently only fill images with 8 bits per pixel"};
+              "Can currently only fill images with 8 to 16 bits per pixel"};
     }
 
     size_t h = plane.m_height;
@@ -1597,6 +1724,17 @@ Error HeifPixelImage::fill_RGB_16bit(uint16_t r, uint16_t g, uint16_t b, uint16_
         assert(false);
     }
 
+    if (plane.m_bit_depth > 8) {
+      auto value = static_cast<uint16_t>(val16 >> (16 - plane.m_bit_depth));
+
+      for (size_t y = 0; y < h; y++) {
+        auto* p = reinterpret_cast<uint16_t*>(data + y * stride);
+        std::fill(p, p + plane.m_width, value);
+      }
+
+      continue;
+    }
+
     auto val8 = static_cast<uint8_t>(val16 >> 8U);
 
 
@@ -1658,9 +1796,33 @@ Error HeifPixelImage::overlay(std::shared_ptr<HeifPixelImage>& overlay, int32_t
   //bool has_alpha_me = has_channel(heif_channel_Alpha);
 
   size_t alpha_stride = 0;
-  uint8_t* alpha_p;
+  const uint8_t* alpha_p;
   alpha_p = overlay->get_channel_memory(heif_channel_Alpha, &alpha_stride);
 
+  uint16_t alpha_max = 0;
+  if (has_alpha) {
+    alpha_max = static_cast<uint16_t>((1U << overlay->get_bits_per_pixel(heif_channel_Alpha)) - 1);
+  }
+
+  // The row kernels below work on pixels of equal storage size in both images.
+  // An alpha plane has to be stored in the same format as the color planes it is applied to.
+
+  for (heif_channel channel : channels) {
+    if (!has_channel(channel)) {
+      continue;
+    }
+
+    uint16_t in_bits = overlay->get_storage_bits_per_pixel(channel);
+    if ((in_bits != 8 && in_bits != 16) ||
+        get_storage_bits_per_pixel(channel) != in_bits ||
+        (has_alpha && overlay->get_storage_bits_per_pixel(heif_channel_Alpha) != in_bits) ||
+        overlay->get_number_of_interleaved_components(channel) != 1) {
+      return {heif_error_Unsupported_feature,
+              heif_suberror_Unspecified,
+              "Overlaying images requires planar 8 or 16 bit images with matching bit depths"};
+    }
+  }
+
   for (heif_channel channel : channels) {
     if (!has_channel(channel)) {
       continue;
@@ -1675,6 +1837,8 @@ Error HeifPixelImage::overlay(std::shared_ptr<HeifPixelImage>& overlay, int32_t
     in_p = overlay->get_channel_memory(channel, &in_stride);
     out_p = get_channel_memory(channel, &out_stride);
 
+    uint16_t storage_bits = overlay->get_storage_bits_per_pixel(channel);
+
     uint32_t in_w = overlay->get_width(channel);
     uint32_t in_h = overlay->get_height(channel);
 
@@ -1756,21 +1920,37 @@ Error HeifPixelImage::overlay(std::shared_ptr<HeifPixelImage>& overlay, int32_t
       out_y0 = static_cast<uint32_t>(dy);
     }
 
-    // --- computer overlay in overlapping area
+    // --- compute overlay in overlapping area
+
+    const Alpha_blending_kernels* blend = get_simd_Alpha_blending_kernels();
+    if (!blend) {
+      blend = &get_scalar_Alpha_blending_kernels();
+    }
+
+    if (storage_bits == 8) {
+      for (uint32_t y = 0; y < in_h; y++) {
+        uint8_t* out_row = out_p + (out_y0 + y) * out_stride + out_x0;
+        const uint8_t* in_row = in_p + (in_y0 + y) * in_stride + in_x0;
 
-    for (uint32_t y = in_y0; y < in_h; y++) {
-      if (!has_alpha) {
-        memcpy(out_p + out_x0 + (out_y0 + y - in_y0) * out_stride,
-               in_p + in_x0 + y * in_stride,
-               in_w);
+        if (!has_alpha) {
+          memcpy(out_row, in_row, in_w);
+        }
+        else {
+          blend->blend_row_8(out_row, in_row, alpha_p + (in_y0 + y) * alpha_stride + in_x0, in_w);
+        }
       }
-      else {
-        for (uint32_t x = in_x0; x < in_w; x++) {
-          uint8_t* outptr = &out_p[out_x0 + (out_y0 + y - in_y0) * out_stride + x];
-          uint8_t in_val = in_p[in_x0 + y * in_stride + x];
-          uint8_t alpha_val = alpha_p[in_x0 + y * alpha_stride + x];
+    }
+    else {
+      for (uint32_t y = 0; y < in_h; y++) {
+        auto* out_row = reinterpret_cast<uint16_t*>(out_p + (out_y0 + y) * out_stride) + out_x0;
+        auto* in_row = reinterpret_cast<const uint16_t*>(in_p + (in_y0 + y) * in_stride) + in_x0;
 
-          *outptr = (uint8_t) ((in_val * alpha_val + *outptr * (255 - alpha_val)) / 255);
+        if (!has_alpha) {
+          memcpy(out_row, in_row, in_w * sizeof(uint16_t));
+        }
+        else {
+          auto* alpha_row = reinterpret_cast<const uint16_t*>(alpha_p + (in_y0 + y) * alpha_stride) + in_x0;
+          blend->blend_row_16(out_row, in_row, alpha_row, in_w, alpha_max);
         }
       }
     }
@@ -1993,7 +2173,8 @@ void HeifPixelImage::debug_dump() const
 }
 
 Error HeifPixelImage::create_clone_image_at_new_size(const std::shared_ptr<const HeifPixelImage>& source, uint32_t w, uint32_t h,
-                                                     const heif_security_limits* limits)
+                                                     const heif_security_limits* limits,
+                                                     bool zero_initialize)
 {
   heif_colorspace colorspace = source->get_colorspace();
   heif_chroma chroma = source->get_chroma_format();
@@ -2011,7 +2192,8 @@ Error HeifPixelImage::create_clone_image_at_new_size(const std::shared_ptr<const
     plane.m_component_ids = src_plane.m_component_ids;
 
     if (auto err = plane.alloc(plane_w, plane_h, src_plane.m_datatype, src_plane.m_bit_depth,
-                               src_plane.m_num_interleaved_components, limits, m_memory_handle)) {
+                               src_plane.m_num_interleaved_components, limits, m_memory_handle,
+                               zero_initialize)) {
       return err;
     }
 
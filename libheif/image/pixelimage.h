@@ -56,6 +56,41 @@ bool is_integer_multiple_of_chroma_size(uint32_t width,
 std::vector<heif_chroma> get_valid_chroma_values_for_colorspace(heif_colorspace colorspace);
 
 
+// Caller-owned memory into which an image plane can be placed instead of allocating it.
+struct ExternalPlaneBuffer
+{
+  heif_channel channel = heif_channel_Y;
+  uint8_t* data = nullptr;
+  size_t stride = 0;
+  size_t size = 0;
+
+  bool used = false;
+
+  // Whether 'height' rows of 'row_size' bytes fit into the buffer with its stride.
+  bool can_hold(uint64_t row_size, uint32_t height) const;
+};
+
+// While an object of this class exists, planes that are allocated in the current thread are placed into
+// the first unused buffer with the same channel that is large enough to hold the plane.
+// These planes are not owned by the image and are not counted against the memory limits.
+// Keep the scope as small as possible: it should only enclose the allocation of the final output image,
+// so that no temporary image takes the buffers.
+class ScopedExternalPlaneBuffers
+{
+public:
+  explicit ScopedExternalPlaneBuffers(std::vector<ExternalPlaneBuffer>* buffers);
+
+  ~ScopedExternalPlaneBuffers();
+
+  ScopedExternalPlaneBuffers(const ScopedExternalPlaneBuffers&) = delete;
+
+  ScopedExternalPlaneBuffers& operator=(const ScopedExternalPlaneBuffers&) = delete;
+
+private:
+  std::vector<ExternalPlaneBuffer>* m_previous_buffers;
+};
+
+
 
 class HeifPixelImage : public std::enable_shared_from_this<HeifPixelImage>,
                        public ImageDescription,
@@ -68,8 +103,11 @@ public:
 
   void create(uint32_t width, uint32_t height, heif_colorspace colorspace, heif_chroma chroma);
 
+  // If 'zero_initialize' is false, the image area of the planes is left uninitialized and the caller
+  // has to write every pixel (only the padding is cleared).
   Error create_clone_image_at_new_size(const std::shared_ptr<const HeifPixelImage>& source, uint32_t w, uint32_t h,
-                                       const heif_security_limits* limits);
+                                       const heif_security_limits* limits,
+                                       bool zero_initialize = true);
 
   Error add_channel(heif_channel channel, uint32_t width, uint32_t height, int bit_depth,
                   const heif_security_limits* limits,
@@ -109,6 +147,9 @@ public:
 
   heif_chroma get_chroma_format() const { return m_chroma; }
 
+  // Only for conversions that keep the plane layout, e.g. swapping the byte order of RRGGBB(AA) images in place.
+  void set_chroma_format(heif_chroma chroma) { m_chroma = chroma; }
+
   heif_colorspace get_colorspace() const { return m_colorspace; }
 
   std::set<heif_channel> get_channel_set() const;
@@ -272,8 +313,14 @@ public:
                                     heif_channel src_channel,
                                     heif_channel dst_channel);
 
+  // Removes the channel and releases its memory.
+  void remove_channel(heif_channel channel);
+
   Error copy_image_to(const std::shared_ptr<const HeifPixelImage>& source, uint32_t x0, uint32_t y0);
 
+  // Sets the area of a channel to zero. The area is given in image coordinates and clipped to the image size.
+  void zero_channel_area(heif_channel channel, uint32_t x0, uint32_t y0, uint32_t w, uint32_t h);
+
   Result<std::shared_ptr<HeifPixelImage>> rotate_ccw(int angle_degrees, const heif_security_limits* limits);
 
   Result<std::shared_ptr<HeifPixelImage>> mirror_inplace(heif_transform_mirror_direction, const heif_security_limits* limits);
@@ -321,7 +368,8 @@ private:
     Error alloc(uint32_t width, uint32_t height, heif_component_datatype datatype, int bit_depth,
                 int num_interleaved_components,
                 const heif_security_limits* limits,
-                MemoryHandle& memory_handle);
+                MemoryHandle& memory_handle,
+                bool zero_initialize = true);
 
     heif_component_datatype m_datatype = heif_component_datatype_unsigned_integer;
 
@@ -0,0 +1,204 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plane_allocator.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+// The allocator must not be changed while images exist (see heif_set_allocator()).
+// Hence, we do not need to synchronize the access to it.
+static heif_allocator sAllocator{};
+static bool sHaveAllocator = false;
+
+static std::atomic<size_t> sMaxPooledBytes{0};
+
+// Free blocks, indexed by their size class.
+static std::map<size_t, std::vector<uint8_t*>> sPool;
+static size_t sPooledBytes = 0;
+
+static std::mutex& get_pool_mutex()
+{
+  static std::mutex sMutex;
+  return sMutex;
+}
+
+
+static uint8_t* base_alloc(size_t size, bool zero_initialize)
+{
+  if (sHaveAllocator) {
+    auto* mem = static_cast<uint8_t*>(sAllocator.alloc(sAllocator.user_data, size));
+    if (mem && zero_initialize) {
+      memset(mem, 0, size);
+    }
+    return mem;
+  }
+  else if (zero_initialize) {
+    return static_cast<uint8_t*>(std::calloc(1, size));
+  }
+  else {
+    return static_cast<uint8_t*>(std::malloc(size));
+  }
+}
+
+
+static void base_free(uint8_t* mem, size_t size)
+{
+  if (sHaveAllocator) {
+    sAllocator.free(sAllocator.user_data, mem, size);
+  }
+  else {
+    std::free(mem);
+  }
+}
+
+
+// Small blocks are rounded to multiples of 64 bytes. Larger blocks have four size classes
+// per power of two, which wastes at most 25% of the memory.
+static size_t get_size_class(size_t size)
+{
+  if (size <= 4096) {
+    return (size + 63) & ~static_cast<size_t>(63);
+  }
+
+  size_t power = 4096;
+  while (power <= size / 2) {
+    power *= 2;
+  }
+
+  size_t step = power / 4;
+  if (size > std::numeric_limits<size_t>::max() - step) {
+    return size;
+  }
+
+  return (size + step - 1) / step * step;
+}
+
+
+size_t get_plane_allocation_size(size_t size)
+{
+  if (sMaxPooledBytes == 0) {
+    return size;
+  }
+
+  return get_size_class(size);
+}
+
+
+uint8_t* alloc_plane_memory(size_t size, bool zero_initialize)
+{
+  if (sMaxPooledBytes != 0) {
+    uint8_t* mem = nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(get_pool_mutex());
+
+      auto it = sPool.find(size);
+      if (it != sPool.end() && !it->second.empty()) {
+        mem = it->second.back();
+        it->second.pop_back();
+        sPooledBytes -= size;
+      }
+    }
+
+    if (mem) {
+      // Must zero-initialize, see HeifPixelImage::ComponentStorage::alloc().
+      if (zero_initialize) {
+        memset(mem, 0, size);
+      }
+      return mem;
+    }
+  }
+
+  return base_alloc(size, zero_initialize);
+}
+
+
+void free_plane_memory(uint8_t* mem, size_t size)
+{
+  if (mem == nullptr) {
+    return;
+  }
+
+  // Only keep blocks that have exactly the size of their size class.
+  // Other blocks were allocated while the pool was disabled and cannot be handed out for other sizes.
+
+  size_t max_pooled_bytes = sMaxPooledBytes;
+  if (max_pooled_bytes != 0 && size == get_size_class(size)) {
+    std::lock_guard<std::mutex> lock(get_pool_mutex());
+
+    if (sPooledBytes + size <= max_pooled_bytes) {
+      sPool[size].push_back(mem);
+      sPooledBytes += size;
+      return;
+    }
+  }
+
+  base_free(mem, size);
+}
+
+
+void set_plane_allocator(const heif_allocator* allocator)
+{
+  // The pooled blocks belong to the previous allocator.
+  release_plane_buffer_pool();
+
+  if (allocator) {
+    sAllocator = *allocator;
+    sHaveAllocator = true;
+  }
+  else {
+    sAllocator = {};
+    sHaveAllocator = false;
+  }
+}
+
+
+void set_plane_buffer_pool_size(size_t max_pooled_bytes)
+{
+  sMaxPooledBytes = max_pooled_bytes;
+
+  release_plane_buffer_pool();
+}
+
+
+void release_plane_buffer_pool()
+{
+  std::map<size_t, std::vector<uint8_t*>> pool;
+
+  {
+    std::lock_guard<std::mutex> lock(get_pool_mutex());
+    std::swap(pool, sPool);
+    sPooledBytes = 0;
+  }
+
+  for (auto& [size, blocks] : pool) {
+    for (uint8_t* mem : blocks) {
+      base_free(mem, size);
+    }
+  }
+}
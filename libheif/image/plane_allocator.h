@@ -0,0 +1,52 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_PLANE_ALLOCATOR_H
+#define LIBHEIF_PLANE_ALLOCATOR_H
+
+#include "libheif/heif_library.h"
+
+#include <cstddef>
+#include <cstdint>
+
+
+// Memory for the pixel data of image planes.
+// It is allocated through the user allocator (heif_set_allocator()) and recycled through
+// the plane buffer pool when that is enabled (heif_set_plane_buffer_pool_size()).
+
+// The number of bytes that alloc_plane_memory() should be called with for a plane that needs 'size' bytes.
+// When the pool is enabled, this is rounded up to the next size class so that the block can be reused.
+// Use this size for the memory accounting (MemoryHandle) and pass it to free_plane_memory() again.
+size_t get_plane_allocation_size(size_t size);
+
+// Returns memory that is zero-initialized unless 'zero_initialize' is false, or nullptr if the allocation failed.
+uint8_t* alloc_plane_memory(size_t size, bool zero_initialize = true);
+
+// 'size' must be the size that was passed to alloc_plane_memory(). 'mem' may be nullptr.
+void free_plane_memory(uint8_t* mem, size_t size);
+
+void set_plane_allocator(const heif_allocator* allocator);
+
+void set_plane_buffer_pool_size(size_t max_pooled_bytes);
+
+// Frees all memory that is currently kept in the pool.
+void release_plane_buffer_pool();
+
+#endif
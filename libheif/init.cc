@@ -24,6 +24,7 @@
 #include "plugin_registry.h"
 #include "common_utils.h"
 #include "color-conversion/colorconversion.h"
+#include "image/plane_allocator.h"
 
 #if ENABLE_MULTITHREADING_SUPPORT
 
@@ -105,7 +106,7 @@ void load_plugins_if_not_initialized_yet()
 }
 
 
-heif_error heif_init(heif_init_params*)
+heif_error heif_init(heif_init_params* params)
 {
 #if ENABLE_MULTITHREADING_SUPPORT
   std::lock_guard<std::recursive_mutex> lock(heif_init_mutex());
@@ -115,6 +116,10 @@ heif_error heif_init(heif_init_params*)
 
     ColorConversionPipeline::init_ops();
 
+    if (params && params->version >= 2 && params->calibrate_color_conversion) {
+      ColorConversionPipeline::calibrate_costs();
+    }
+
     // --- initialize builtin plugins
 
     if (!default_plugins_registered) {
@@ -161,6 +166,8 @@ void heif_deinit()
     heif_unload_all_plugins();
 
     ColorConversionPipeline::release_ops();
+
+    release_plane_buffer_pool();
   }
 
   // Note: contrary to heif_init() I think it does not matter whether we decrease the counter before or after deinitialization.
@@ -0,0 +1,133 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "parallel.h"
+#include "security_limits.h"
+
+#include <algorithm>
+#include <utility>
+
+#if ENABLE_MULTITHREADING_SUPPORT
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#endif
+
+
+int get_default_number_of_worker_threads()
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  unsigned int n = std::thread::hardware_concurrency();
+  return n > 0 ? static_cast<int>(n) : 1;
+#else
+  return 1;
+#endif
+}
+
+
+void parallel_for(uint32_t num_jobs, int max_threads, const std::function<void(uint32_t job_idx)>& job,
+                  const std::function<void()>& idle_poll)
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  uint32_t num_threads = std::min(num_jobs, static_cast<uint32_t>(std::max(max_threads, 1)));
+
+  if (num_threads > 1) {
+    std::atomic<uint32_t> next_job{0};
+
+    // Allocations in the jobs are counted like those of the calling thread.
+    const MemoryUsageScope* memory_usage_scope = MemoryUsageScope::current();
+
+    auto worker = [&next_job, num_jobs, &job, memory_usage_scope]() {
+      MemoryUsageScope worker_scope(memory_usage_scope);
+
+      for (;;) {
+        uint32_t idx = next_job.fetch_add(1, std::memory_order_relaxed);
+        if (idx >= num_jobs) {
+          return;
+        }
+
+        job(idx);
+      }
+    };
+
+    // The calling thread is one of the workers.
+
+    std::vector<std::future<void>> workers;
+    for (uint32_t i = 1; i < num_threads; i++) {
+      workers.push_back(std::async(std::launch::async, worker));
+    }
+
+    worker();
+
+    for (auto& w : workers) {
+      if (idle_poll) {
+        while (w.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready) {
+          idle_poll();
+        }
+      }
+
+      w.get();
+    }
+
+    return;
+  }
+#else
+  (void) max_threads;
+#endif
+
+  (void) idle_poll;
+
+  for (uint32_t i = 0; i < num_jobs; i++) {
+    job(i);
+  }
+}
+
+
+CancelPoller::CancelPoller(std::function<bool()> is_canceled)
+    : m_callback(std::move(is_canceled))
+#if ENABLE_MULTITHREADING_SUPPORT
+    , m_polling_thread(std::this_thread::get_id())
+#endif
+{
+}
+
+
+bool CancelPoller::on_polling_thread() const
+{
+#if ENABLE_MULTITHREADING_SUPPORT
+  return std::this_thread::get_id() == m_polling_thread;
+#else
+  return true;
+#endif
+}
+
+
+bool CancelPoller::is_canceled()
+{
+  if (!m_canceled && m_callback && on_polling_thread() && m_callback()) {
+    m_canceled = true;
+  }
+
+  return m_canceled;
+}
@@ -0,0 +1,79 @@
+/*
+ * HEIF codec.
+ * Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+ *
+ * This file is part of libheif.
+ *
+ * libheif is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * libheif is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libheif.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBHEIF_PARALLEL_H
+#define LIBHEIF_PARALLEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#if ENABLE_MULTITHREADING_SUPPORT
+#include <thread>
+#endif
+
+
+// Number of worker threads that libheif uses when the user did not specify a thread count.
+// This is the number of hardware threads, or 1 if this is unknown or multithreading is disabled.
+int get_default_number_of_worker_threads();
+
+// Calls job(i) for all i in [0, num_jobs).
+// The jobs are distributed over up to 'max_threads' threads (including the calling thread).
+// Each thread takes the next unprocessed job index when it finished its previous job.
+// If 'max_threads' is <= 1, or when libheif is compiled without multithreading support,
+// all jobs are processed sequentially in the calling thread.
+//
+// The function returns after all jobs have been processed. Jobs must be independent of each other.
+//
+// If 'idle_poll' is set, the calling thread calls it regularly while it waits for the other
+// threads to finish their jobs (e.g. to check for cancellation on the calling thread).
+//
+// The jobs run in the MemoryUsageScope of the calling thread.
+void parallel_for(uint32_t num_jobs, int max_threads, const std::function<void(uint32_t job_idx)>& job,
+                  const std::function<void()>& idle_poll = nullptr);
+
+
+// Makes a cancellation callback usable from parallel jobs when the callback itself may only be
+// called from one thread (e.g. a user callback).
+// is_canceled() calls the callback only on the thread that constructed the poller. On other
+// threads, it returns whether one of the previous calls detected the cancellation.
+class CancelPoller
+{
+public:
+  explicit CancelPoller(std::function<bool()> is_canceled);
+
+  bool is_canceled();
+
+  void set_canceled() { m_canceled = true; }
+
+  bool was_canceled() const { return m_canceled; }
+
+  bool on_polling_thread() const;
+
+private:
+  std::function<bool()> m_callback;
+  std::atomic<bool> m_canceled{false};
+
+#if ENABLE_MULTITHREADING_SUPPORT
+  std::thread::id m_polling_thread;
+#endif
+};
+
+#endif
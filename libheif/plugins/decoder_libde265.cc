@@ -36,6 +36,9 @@ struct libde265_decoder
   de265_decoder_context* ctx;
   bool strict_decoding = false;
   std::string error_message;
+
+  int (* is_canceled)(void* cancel_user_data) = nullptr;
+  void* cancel_user_data = nullptr;
 };
 
 static const char kEmptyString[] = "";
@@ -383,6 +386,15 @@ static heif_error libde265_flush_data(void* decoder_raw)
 
 
 
+static void libde265_set_cancel_callback(void* decoder_raw, int (* is_canceled)(void*), void* cancel_user_data)
+{
+  libde265_decoder* decoder = (libde265_decoder*) decoder_raw;
+
+  decoder->is_canceled = is_canceled;
+  decoder->cancel_user_data = cancel_user_data;
+}
+
+
 static heif_error libde265_v1_decode_next_image2(void* decoder_raw,
                                                  heif_image** out_img,
                                                  uintptr_t* out_user_data,
@@ -398,6 +410,11 @@ static heif_error libde265_v1_decode_next_image2(void* decoder_raw,
   de265_error decode_err;
   *out_img = nullptr;
   do {
+    // de265_decode() processes one NAL at a time. Check between the NALs whether we should stop.
+    if (decoder->is_canceled && decoder->is_canceled(decoder->cancel_user_data)) {
+      return {heif_error_Canceled, heif_suberror_Unspecified, "Decoding was canceled"};
+    }
+
     more = 0;
     decode_err = de265_decode(decoder->ctx, &more);
     if (decode_err != DE265_OK) {
@@ -496,7 +513,7 @@ static const heif_decoder_plugin decoder_libde265
 
 static const heif_decoder_plugin decoder_libde265
     {
-        5,
+        7,
         libde265_plugin_name,
         libde265_init_plugin,
         libde265_deinit_plugin,
@@ -513,7 +530,8 @@ static const heif_decoder_plugin decoder_libde265
         libde265_new_decoder2,
         libde265_v1_push_data2,
         libde265_flush_data,
-        libde265_v1_decode_next_image2
+        libde265_v1_decode_next_image2,
+        libde265_set_cancel_callback
     };
 
 #endif
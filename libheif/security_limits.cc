@@ -20,8 +20,10 @@
 
 #include "security_limits.h"
 #include <limits>
+#include <algorithm>
 #include <map>
 #include <mutex>
+#include <shared_mutex>
 
 
 heif_security_limits global_security_limits{
@@ -95,8 +97,8 @@ heif_security_limits tighten_image_size_limit_for_ispe(const heif_security_limit
   heif_security_limits result = *base;
 
   // The returned struct is a stack-local derived copy. Point parent at the
-  // registered context so MemoryHandle::alloc() can still find the entry in
-  // sMemoryUsage for total-memory accounting. If base is itself derived, walk
+  // registered context so MemoryHandle::alloc() can still find its memory
+  // usage counter for total-memory accounting. If base is itself derived, walk
   // to the root so we keep the parent chain at one hop.
   result.parent = (base->version >= 4 && base->parent) ? base->parent : base;
   result.version = 4;
@@ -153,46 +155,100 @@ Error check_for_valid_image_size(const heif_security_limits* limits, uint32_t wi
 }
 
 
-struct memory_stats {
-  size_t total_memory_usage = 0;
-  size_t max_memory_usage = 0;
-};
+// The memory usage counters of all contexts, indexed by the address of the context's security limits.
+// This is only used for allocations outside of a MemoryUsageScope, e.g. when the application allocates an image
+// with the limits of a context. Only the registered limits of a living context are found. Copies of the limits and
+// limits of freed contexts are not tracked.
 
-std::mutex& get_memory_usage_mutex()
+static std::shared_mutex& get_memory_usage_mutex()
 {
-  static std::mutex sMutex;
+  static std::shared_mutex sMutex;
   return sMutex;
 }
 
-static std::map<const heif_security_limits*, memory_stats> sMemoryUsage;
+static std::map<const heif_security_limits*, std::shared_ptr<MemoryUsage>> sMemoryUsage;
 
-TotalMemoryTracker::TotalMemoryTracker(const heif_security_limits* limits)
+
+static std::shared_ptr<MemoryUsage> find_registered_memory_usage(const heif_security_limits* limits)
+{
+  std::shared_lock<std::shared_mutex> lock(get_memory_usage_mutex());
+
+  auto it = sMemoryUsage.find(limits);
+  if (it == sMemoryUsage.end()) {
+    return nullptr;
+  }
+
+  return it->second;
+}
+
+
+static thread_local const MemoryUsageScope* tCurrentMemoryUsageScope = nullptr;
+
+
+MemoryUsageScope::MemoryUsageScope(const heif_security_limits* limits, std::shared_ptr<MemoryUsage> usage)
+    : m_limits(limits),
+      m_memory_usage(std::move(usage)),
+      m_outer(tCurrentMemoryUsageScope)
+{
+  tCurrentMemoryUsageScope = this;
+}
+
+
+MemoryUsageScope::MemoryUsageScope(const MemoryUsageScope* scope)
+    : m_outer(tCurrentMemoryUsageScope)
+{
+  if (scope) {
+    m_limits = scope->m_limits;
+    m_memory_usage = scope->m_memory_usage;
+  }
+
+  tCurrentMemoryUsageScope = this;
+}
+
+
+MemoryUsageScope::~MemoryUsageScope()
+{
+  assert(tCurrentMemoryUsageScope == this);
+  tCurrentMemoryUsageScope = m_outer;
+}
+
+
+const MemoryUsageScope* MemoryUsageScope::current()
+{
+  return tCurrentMemoryUsageScope;
+}
+
+
+std::shared_ptr<MemoryUsage> MemoryUsageScope::find(const heif_security_limits* limits)
 {
-  std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
+  for (const MemoryUsageScope* scope = tCurrentMemoryUsageScope; scope; scope = scope->m_outer) {
+    if (scope->m_limits == limits) {
+      return scope->m_memory_usage;
+    }
+  }
+
+  return nullptr;
+}
+
 
-  sMemoryUsage[limits] = {};
-  m_limits_context = limits;
+TotalMemoryTracker::TotalMemoryTracker(const heif_security_limits* limits)
+    : m_limits_context(limits),
+      m_memory_usage(std::make_shared<MemoryUsage>())
+{
+  std::unique_lock<std::shared_mutex> lock(get_memory_usage_mutex());
+  sMemoryUsage[limits] = m_memory_usage;
 }
 
 TotalMemoryTracker::~TotalMemoryTracker()
 {
-  std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
+  std::unique_lock<std::shared_mutex> lock(get_memory_usage_mutex());
   sMemoryUsage.erase(m_limits_context);
 }
 
 
 size_t TotalMemoryTracker::get_max_total_memory_used() const
 {
-  std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
-
-  auto it = sMemoryUsage.find(m_limits_context);
-  if (it != sMemoryUsage.end()) {
-    return it->second.max_memory_usage;
-  }
-  else {
-    assert(false);
-    return 0;
-  }
+  return m_memory_usage->max_memory_usage;
 }
 
 
@@ -259,52 +315,62 @@ Error MemoryHandle::alloc(size_t memory_amount, const heif_security_limits* limi
     assert(m_limits_context == root_limits);
   }
 
-  if (root_limits == &global_security_limits ||
-      root_limits == &disabled_security_limits) {
-    return Error::Ok;
+  // Further allocations on the same handle reuse the counter, which is kept alive by the handle.
+  // Otherwise, take it from the scope of the decoding context and only search the registry without a scope.
+  std::shared_ptr<MemoryUsage> usage = m_memory_usage;
+  if (!usage) {
+    usage = MemoryUsageScope::find(root_limits);
   }
-
-  std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
-  auto it = sMemoryUsage.find(root_limits);
-  if (it == sMemoryUsage.end()) {
-    // Unregistered limits context with no resolvable parent — total-memory
+  if (!usage) {
+    usage = find_registered_memory_usage(root_limits);
+  }
+  if (!usage) {
+    // Unregistered limits context with no resolvable parent (or the global limits) — total-memory
     // tracking is not available, but the per-block check above still applies.
     return Error::Ok;
   }
 
-  // check against maximum total memory usage
+  // --- check against maximum total memory usage and register the memory usage
 
-  if (limits_context->max_total_memory != 0 &&
-      it->second.total_memory_usage + memory_amount > limits_context->max_total_memory) {
-    std::stringstream sstr;
+  size_t max_total_memory = static_cast<size_t>(std::min(limits_context->max_total_memory,
+                                                         static_cast<uint64_t>(SIZE_MAX)));
 
-    if (reason_description) {
-      sstr << "Memory usage of " << it->second.total_memory_usage + memory_amount
-           << " bytes for " << reason_description << " exceeds the security limit of "
-           << limits_context->max_total_memory << " bytes of total memory usage";
-    }
-    else {
-      sstr << "Memory usage of " << it->second.total_memory_usage + memory_amount
-           << " bytes exceeds the security limit of "
-           << limits_context->max_total_memory << " bytes of total memory usage";
-    }
+  size_t total_memory_usage = usage->total_memory_usage.load(std::memory_order_relaxed);
+  do {
+    if (max_total_memory != 0 &&
+        (total_memory_usage > max_total_memory ||
+         memory_amount > max_total_memory - total_memory_usage)) {
+      std::stringstream sstr;
 
-    return {heif_error_Memory_allocation_error,
-            heif_suberror_Security_limit_exceeded,
-            sstr.str()};
-  }
+      if (reason_description) {
+        sstr << "Memory usage of " << static_cast<uint64_t>(total_memory_usage) + memory_amount
+             << " bytes for " << reason_description << " exceeds the security limit of "
+             << limits_context->max_total_memory << " bytes of total memory usage";
+      }
+      else {
+        sstr << "Memory usage of " << static_cast<uint64_t>(total_memory_usage) + memory_amount
+             << " bytes exceeds the security limit of "
+             << limits_context->max_total_memory << " bytes of total memory usage";
+      }
 
+      return {heif_error_Memory_allocation_error,
+              heif_suberror_Security_limit_exceeded,
+              sstr.str()};
+    }
+  } while (!usage->total_memory_usage.compare_exchange_weak(total_memory_usage, total_memory_usage + memory_amount,
+                                                            std::memory_order_relaxed));
 
-  // --- register memory usage
+  m_memory_usage = usage;
 
   m_limits_context = root_limits;
   m_memory_amount += memory_amount;
 
-  it->second.total_memory_usage += memory_amount;
-
   // remember maximum memory usage (for informational purpose)
-  if (it->second.total_memory_usage > it->second.max_memory_usage) {
-    it->second.max_memory_usage = it->second.total_memory_usage;
+
+  size_t new_total = total_memory_usage + memory_amount;
+  size_t max_memory_usage = usage->max_memory_usage.load(std::memory_order_relaxed);
+  while (new_total > max_memory_usage &&
+         !usage->max_memory_usage.compare_exchange_weak(max_memory_usage, new_total, std::memory_order_relaxed)) {
   }
 
   return Error::Ok;
@@ -314,14 +380,12 @@ Error MemoryHandle::alloc(size_t memory_amount, const heif_security_limits* limi
 void MemoryHandle::free()
 {
   if (m_limits_context) {
-    std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
-
-    auto it = sMemoryUsage.find(m_limits_context);
-    if (it != sMemoryUsage.end()) {
-      it->second.total_memory_usage -= m_memory_amount;
+    if (m_memory_usage) {
+      m_memory_usage->total_memory_usage.fetch_sub(m_memory_amount, std::memory_order_relaxed);
     }
 
     m_limits_context = nullptr;
+    m_memory_usage.reset();
     m_memory_amount = 0;
   }
 }
@@ -330,14 +394,10 @@ void MemoryHandle::free()
 void MemoryHandle::free(size_t memory_amount)
 {
   if (m_limits_context) {
-    std::lock_guard<std::mutex> lock(get_memory_usage_mutex());
-
-    auto it = sMemoryUsage.find(m_limits_context);
-    if (it != sMemoryUsage.end()) {
-      it->second.total_memory_usage -= memory_amount;
+    if (m_memory_usage) {
+      m_memory_usage->total_memory_usage.fetch_sub(memory_amount, std::memory_order_relaxed);
     }
 
     m_memory_amount -= memory_amount;
   }
 }
-
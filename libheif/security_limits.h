@@ -21,8 +21,10 @@
 #define LIBHEIF_SECURITY_LIMITS_H
 
 #include "libheif/heif.h"
+#include <atomic>
 #include <cinttypes>
 #include <cstddef>
+#include <memory>
 #include "error.h"
 
 
@@ -62,6 +64,16 @@ heif_security_limits tighten_image_size_limit_for_ispe(const heif_security_limit
                                                        uint32_t coding_unit_size);
 
 
+// Total memory usage of one heif_context. It is owned by the context's TotalMemoryTracker.
+// The counters are updated without locks, so that allocations in different threads do not serialize.
+// MemoryHandles keep the counter alive, because images may outlive their context.
+struct MemoryUsage
+{
+  std::atomic<size_t> total_memory_usage{0};
+  std::atomic<size_t> max_memory_usage{0};
+};
+
+
 class TotalMemoryTracker
 {
 public:
@@ -70,11 +82,47 @@ public:
 
   size_t get_max_total_memory_used() const;
 
+  const std::shared_ptr<MemoryUsage>& get_memory_usage() const { return m_memory_usage; }
+
   void operator=(const TotalMemoryTracker&) = delete;
   TotalMemoryTracker(const TotalMemoryTracker&) = delete;
 
 private:
   const heif_security_limits* m_limits_context = nullptr;
+  std::shared_ptr<MemoryUsage> m_memory_usage;
+};
+
+
+// Passes the memory usage counter of a context down to all allocations of the current thread that use the
+// context's security limits (or limits derived from them through 'parent'). This also covers the images that
+// decoder plugins allocate through the public API, which only hands over the security limits.
+// Allocations outside of a scope fall back to a global registry of the contexts' limits, which needs a lock.
+// Scopes can be nested. They are not inherited by other threads, see parallel_for().
+class MemoryUsageScope
+{
+public:
+  MemoryUsageScope(const heif_security_limits* limits, std::shared_ptr<MemoryUsage> usage);
+
+  // Opens a copy of 'scope' (which may be nullptr) in a worker thread.
+  explicit MemoryUsageScope(const MemoryUsageScope* scope);
+
+  ~MemoryUsageScope();
+
+  // The innermost scope of the current thread or nullptr.
+  static const MemoryUsageScope* current();
+
+  MemoryUsageScope(const MemoryUsageScope&) = delete;
+  MemoryUsageScope& operator=(const MemoryUsageScope&) = delete;
+
+private:
+  friend class MemoryHandle;
+
+  // Searches the scopes of the current thread for the counter of the (root) 'limits'.
+  static std::shared_ptr<MemoryUsage> find(const heif_security_limits* limits);
+
+  const heif_security_limits* m_limits = nullptr;
+  std::shared_ptr<MemoryUsage> m_memory_usage;
+  const MemoryUsageScope* m_outer = nullptr;
 };
 
 
@@ -102,7 +150,9 @@ public:
   MemoryHandle& operator=(const MemoryHandle&) = delete;
 
   MemoryHandle(MemoryHandle&& other) noexcept
-      : m_limits_context(other.m_limits_context), m_memory_amount(other.m_memory_amount)
+      : m_limits_context(other.m_limits_context),
+        m_memory_usage(std::move(other.m_memory_usage)),
+        m_memory_amount(other.m_memory_amount)
   {
     other.m_limits_context = nullptr;
     other.m_memory_amount = 0;
@@ -113,6 +163,7 @@ public:
     if (this != &other) {
       free();
       m_limits_context = other.m_limits_context;
+      m_memory_usage = std::move(other.m_memory_usage);
       m_memory_amount = other.m_memory_amount;
       other.m_limits_context = nullptr;
       other.m_memory_amount = 0;
@@ -122,6 +173,7 @@ public:
 
 private:
   const heif_security_limits* m_limits_context = nullptr;
+  std::shared_ptr<MemoryUsage> m_memory_usage;
   size_t m_memory_amount = 0;
 };
 
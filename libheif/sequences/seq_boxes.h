@@ -543,6 +543,9 @@ public:
 
   void add_sync_sample(uint32_t sample_idx) { m_sync_samples.push_back(sample_idx); }
 
+  // Sample numbers are 1-based as stored in the box.
+  const std::vector<uint32_t>& get_sync_samples() const { return m_sync_samples; }
+
   // when this is set, the Box will compute whether it can be skipped
   void set_total_number_of_samples(uint32_t num_samples);
 
@@ -26,6 +26,8 @@
 #include "sequences/track_visual.h"
 #include "sequences/track_metadata.h"
 #include "api_structs.h"
+#include "codecs/decoder.h"
+#include <algorithm>
 #include <limits>
 
 
@@ -336,6 +338,8 @@ Error Track::load(const std::shared_ptr<Box_trak>& trak_box)
 
   m_ctts = stbl->get_child_box<Box_ctts>();
 
+  m_stss = stbl->get_child_box<Box_stss>(); // optional, all samples are sync samples if missing
+
   // --- check that number of samples in various boxes are consistent
 
   if (m_stts->get_number_of_samples() != m_stsz->num_samples()) {
@@ -1081,6 +1085,29 @@ Error Track::init_sample_timing_table()
     media_timeline.push_back(timing);
   }
 
+  // --- build sync sample index for seeking
+
+  m_sync_samples.clear();
+
+  if (m_stss) {
+    for (uint32_t sample_number : m_stss->get_sync_samples()) {
+      if (sample_number == 0 || sample_number > m_num_samples) {
+        return {
+          heif_error_Invalid_input,
+          heif_suberror_Unspecified,
+          "'stss' box references a non-existing sample."
+        };
+      }
+
+      // 'stss' sample numbers are 1-based
+      m_sync_samples.push_back(sample_number - 1);
+    }
+
+    // The standard requires strictly increasing sample numbers. Sort anyway to be robust against broken files.
+    std::sort(m_sync_samples.begin(), m_sync_samples.end());
+    m_sync_samples.erase(std::unique(m_sync_samples.begin(), m_sync_samples.end()), m_sync_samples.end());
+  }
+
   // --- build presentation timeline from editlist
 
   bool fallback = false;
@@ -1214,6 +1241,115 @@ Result<heif_raw_sequence_sample*> Track::get_next_sample_raw_data(const heif_dec
 }
 
 
+uint32_t Track::find_preceding_sync_sample(uint32_t sample_idx) const
+{
+  // no 'stss' box -> every sample is a sync sample
+  if (m_sync_samples.empty()) {
+    return sample_idx;
+  }
+
+  auto iter = std::upper_bound(m_sync_samples.begin(), m_sync_samples.end(), sample_idx);
+  if (iter == m_sync_samples.begin()) {
+    // There is no sync sample before the requested sample. The first sample of a track
+    // should always be a sync sample, so we assume it is.
+    return 0;
+  }
+
+  return *(iter - 1);
+}
+
+
+Error Track::seek_to_sample(uint32_t sample_idx)
+{
+  if (sample_idx >= m_num_output_samples) {
+    return {
+      heif_error_Usage_error,
+      heif_suberror_Invalid_parameter_value,
+      "Seek position is beyond the end of the sequence."
+    };
+  }
+
+  // split the output index into edit-list repetition and media sample
+
+  const uint32_t num_media_samples = static_cast<uint32_t>(m_presentation_timeline.size());
+  uint32_t repetition_start = sample_idx - sample_idx % num_media_samples;
+  uint32_t media_sample_idx = sample_idx % num_media_samples;
+
+  uint32_t sync_sample_idx = find_preceding_sync_sample(media_sample_idx);
+
+  // --- restart all decoders. Chunks may share decoders, but releasing a decoder twice is safe.
+
+  for (const auto& chunk : m_chunks) {
+    if (auto decoder = chunk->get_decoder()) {
+      decoder->release_decoder();
+    }
+  }
+
+  m_next_sample_to_be_decoded = repetition_start + sync_sample_idx;
+  m_next_sample_to_be_output = repetition_start + sync_sample_idx;
+  m_seek_target_sample = sample_idx;
+  m_decoder_is_flushed = false;
+  m_upload_configuration_with_next_sample = true;
+
+  return {};
+}
+
+
+Result<uint32_t> Track::get_sample_at_time(uint64_t time) const
+{
+  if (m_presentation_timeline.empty()) {
+    return Error{
+      heif_error_Usage_error,
+      heif_suberror_Invalid_parameter_value,
+      "Cannot seek in a track without samples."
+    };
+  }
+
+  const SampleTiming& last = m_presentation_timeline.back();
+  uint64_t media_duration = last.media_decoding_time + last.sample_duration_media_time;
+  if (media_duration == 0) {
+    return Error{
+      heif_error_Invalid_input,
+      heif_suberror_Unspecified,
+      "Track duration is zero."
+    };
+  }
+
+  uint64_t repetition = time / media_duration;
+  uint64_t media_time = time % media_duration;
+
+  // The timeline is sorted by decoding time. Find the last sample that starts at or before 'media_time'.
+  auto iter = std::upper_bound(m_presentation_timeline.begin(), m_presentation_timeline.end(), media_time,
+                               [](uint64_t t, const SampleTiming& timing) {
+                                 return t < timing.media_decoding_time;
+                               });
+  assert(iter != m_presentation_timeline.begin()); // first sample starts at time 0
+  uint64_t media_sample_idx = static_cast<uint64_t>(iter - m_presentation_timeline.begin()) - 1;
+
+  uint64_t sample_idx = repetition * m_presentation_timeline.size() + media_sample_idx;
+  if (sample_idx >= m_num_output_samples) {
+    return Error{
+      heif_error_Usage_error,
+      heif_suberror_Invalid_parameter_value,
+      "Seek position is beyond the end of the sequence."
+    };
+  }
+
+  return static_cast<uint32_t>(sample_idx);
+}
+
+
+Error Track::seek_to_time(uint64_t time)
+{
+  Result<uint32_t> sampleResult = get_sample_at_time(time);
+  if (!sampleResult) {
+    return sampleResult.error();
+  }
+
+  return seek_to_sample(*sampleResult);
+}
+
+
 std::vector<heif_sample_aux_info_type> Track::get_sample_aux_info_types() const
 {
   std::vector<heif_sample_aux_info_type> types;
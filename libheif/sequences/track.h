@@ -198,6 +198,25 @@ public:
 
   Result<heif_raw_sequence_sample*> get_next_sample_raw_data(const heif_decoding_options* options);
 
+  // --- random access
+
+  // Position the track such that the next decoded image is the output sample `sample_idx`
+  // (counted through all edit-list repetitions).
+  // Decoding restarts at the nearest preceding sync sample. Raw sample reading continues
+  // at that sync sample, because the caller has to decode from there to reconstruct the target sample.
+  virtual Error seek_to_sample(uint32_t sample_idx);
+
+  // Seek to the sample that is decoded at `time` (in track timescale units, counted through all
+  // edit-list repetitions). This is the decoding time, 'ctts' composition offsets are not applied.
+  Error seek_to_time(uint64_t time);
+
+  // Returns the output sample index whose decoding time span contains `time`.
+  Result<uint32_t> get_sample_at_time(uint64_t time) const;
+
+  // Returns the media sample index of the nearest sync sample at or before `sample_idx`.
+  // This is a binary search in the sync-sample index, i.e. O(log n).
+  uint32_t find_preceding_sync_sample(uint32_t sample_idx) const;
+
   std::vector<heif_sample_aux_info_type> get_sample_aux_info_types() const;
 
 protected:
@@ -238,6 +257,17 @@ protected:
   uint32_t m_next_sample_to_be_output = 0;
   bool     m_decoder_is_flushed = false;
 
+  // After a seek, all decoded samples before this output index are only decoded as reference
+  // frames for the target sample, but are not returned.
+  uint32_t m_seek_target_sample = 0;
+
+  // Set after a seek, because the restarted decoder has to receive the codec configuration again.
+  bool     m_upload_configuration_with_next_sample = false;
+
+  // Sorted media sample indices (0-based) of all sync samples.
+  // Empty if there is no 'stss' box, which means that all samples are sync samples.
+  std::vector<uint32_t> m_sync_samples;
+
   Error init_sample_timing_table();
 
   std::vector<std::shared_ptr<Chunk>> m_chunks;
@@ -197,9 +197,109 @@ Result<std::shared_ptr<HeifPixelImage> > Track_Visual::decode_next_image_sample(
   uint32_t sample_idx_in_chunk;
   uintptr_t decoded_sample_idx = 0; // TODO: map this to sample idx + chunk
 
+  for (;;) {
+    auto frameResult = receive_next_decoded_frame(options, &sample_idx_in_chunk, &decoded_sample_idx);
+    if (!frameResult) {
+      return frameResult.error();
+    }
+
+    // After a seek, skip the frames between the sync sample and the seek target.
+    // They were only needed as references.
+    if (m_next_sample_to_be_output < m_seek_target_sample) {
+      m_next_sample_to_be_output++;
+      continue;
+    }
+
+    image = *frameResult;
+    break;
+  }
+
+
+  // --- We have received a new decoded image.
+  //     Postprocess decoded image, attach metadata.
+
+  if (m_stts) {
+    image->set_sample_duration(m_stts->get_sample_duration(sample_idx_in_chunk));
+  }
+
+  // --- assign alpha if we have an assigned alpha track
+
+  if (m_aux_alpha_track) {
+    auto alphaResult = m_aux_alpha_track->decode_next_image_sample(options);
+    if (!alphaResult) {
+      return alphaResult.error();
+    }
+
+    auto alphaImage = *alphaResult;
+
+    // The alpha auxiliary track may have a different size than the main track. Nothing in the
+    // standard forbids this. We scale it to the main image size so that downstream consumers can
+    // rely on the alpha plane matching the color planes. This mirrors what the still-image decoder
+    // does in ImageItem (see image_item.cc). As noted there, we may later add a decoding option to
+    // turn this automatic scaling off, but that requires that libheif no longer assumes everywhere
+    // that the alpha channel has the same resolution as the color channels.
+    if (alphaImage->get_width() != image->get_width() ||
+        alphaImage->get_height() != image->get_height()) {
+      std::shared_ptr<HeifPixelImage> scaled_alpha;
+      Error err = alphaImage->scale_nearest_neighbor(scaled_alpha, image->get_width(), image->get_height(),
+                                                     m_heif_context->get_security_limits());
+      if (err) {
+        return err;
+      }
+      alphaImage = std::move(scaled_alpha);
+    }
+
+    image->transfer_channel_from_image_as(alphaImage, heif_channel_Y, heif_channel_Alpha);
+  }
+
+
+  // --- read sample auxiliary data
+
+  if (m_aux_reader_content_ids) {
+    auto readResult = m_aux_reader_content_ids->get_sample_info(get_file().get(), (uint32_t)decoded_sample_idx);
+    if (!readResult) {
+      return readResult.error();
+    }
+
+    Result<std::string> convResult = vector_to_string(*readResult);
+    if (!convResult) {
+      return convResult.error();
+    }
+
+    image->set_gimi_sample_content_id(*convResult);
+  }
+
+  if (m_aux_reader_tai_timestamps) {
+    auto readResult = m_aux_reader_tai_timestamps->get_sample_info(get_file().get(), (uint32_t)decoded_sample_idx);
+    if (!readResult) {
+      return readResult.error();
+    }
+
+    std::vector<uint8_t>& tai_data = *readResult;
+    if (!tai_data.empty()) {
+      auto resultTai = Box_itai::decode_tai_from_vector(tai_data);
+      if (!resultTai) {
+        return resultTai.error();
+      }
+
+      image->set_tai_timestamp(&*resultTai);
+    }
+  }
+
+  m_next_sample_to_be_output++;
+
+  return image;
+}
+
+
+Result<std::shared_ptr<HeifPixelImage> > Track_Visual::receive_next_decoded_frame(const heif_decoding_options& options,
+                                                                                  uint32_t* out_sample_idx,
+                                                                                  uintptr_t* out_decoded_sample_idx)
+{
   for (;;) {
     const SampleTiming& sampleTiming = m_presentation_timeline[m_next_sample_to_be_decoded % m_presentation_timeline.size()];
-    sample_idx_in_chunk = sampleTiming.sampleIdx;
+    uint32_t sample_idx_in_chunk = sampleTiming.sampleIdx;
+    *out_sample_idx = sample_idx_in_chunk;
     uint32_t chunk_idx = sampleTiming.chunkIdx;
 
     const std::shared_ptr<Chunk>& chunk = m_chunks[chunk_idx];
@@ -210,7 +310,7 @@ Result<std::shared_ptr<HeifPixelImage> > Track_Visual::decode_next_image_sample(
     // avoid calling get_decoded_frame() before starting the decoder.
     if (m_next_sample_to_be_decoded != 0) {
       Result<std::shared_ptr<HeifPixelImage> > getFrameResult = decoder->get_decoded_frame(options,
-                                                                                           &decoded_sample_idx,
+                                                                                           out_decoded_sample_idx,
                                                                                            m_heif_context->get_security_limits());
       if (getFrameResult.error()) {
         return getFrameResult.error();
@@ -220,15 +320,13 @@ Result<std::shared_ptr<HeifPixelImage> > Track_Visual::decode_next_image_sample(
       // We received a decoded frame. Exit "push data" / "decode" loop.
 
       if (*getFrameResult != nullptr) {
-        image = *getFrameResult;
-
         // If this was the last frame in the EditList segment, reset the 'flushed' flag
         // in case we have to restart the decoder for another repetition of the segment.
         if ((m_next_sample_to_be_output + 1) % m_presentation_timeline.size() == 0) {
           m_decoder_is_flushed = false;
         }
 
-        break;
+        return getFrameResult;
       }
 
       // If the sequence has ended and the decoder was flushed, but we still did not receive
@@ -257,7 +355,9 @@ Result<std::shared_ptr<HeifPixelImage> > Track_Visual::decode_next_image_sample(
 
       // Send the decoder configuration when we send the first sample of the chunk.
       // The configuration NALs might change for each chunk.
-      const bool is_first_sample = (sample_idx_in_chunk == 0);
+      // After a seek, the restarted decoder also needs the configuration.
+      const bool is_first_sample = (sample_idx_in_chunk == 0 || m_upload_configuration_with_next_sample);
+      m_upload_configuration_with_next_sample = false;
 
       // --- Push data into the decoder.
       Error decodingError = decoder->decode_sequence_frame_from_compressed_data(is_first_sample,
@@ -280,82 +380,25 @@ Result<std::shared_ptr<HeifPixelImage> > Track_Visual::decode_next_image_sample(
       m_decoder_is_flushed = true;
     }
   }
+}
 
 
-  // --- We have received a new decoded image.
-  //     Postprocess decoded image, attach metadata.
-
-  if (m_stts) {
-    image->set_sample_duration(m_stts->get_sample_duration(sample_idx_in_chunk));
+Error Track_Visual::seek_to_sample(uint32_t sample_idx)
+{
+  Error err = Track::seek_to_sample(sample_idx);
+  if (err) {
+    return err;
   }
 
-  // --- assign alpha if we have an assigned alpha track
-
+  // Keep the alpha track in sync. It may have different sync samples.
   if (m_aux_alpha_track) {
-    auto alphaResult = m_aux_alpha_track->decode_next_image_sample(options);
-    if (!alphaResult) {
-      return alphaResult.error();
-    }
-
-    auto alphaImage = *alphaResult;
-
-    // The alpha auxiliary track may have a different size than the main track. Nothing in the
-    // standard forbids this. We scale it to the main image size so that downstream consumers can
-    // rely on the alpha plane matching the color planes. This mirrors what the still-image decoder
-    // does in ImageItem (see image_item.cc). As noted there, we may later add a decoding option to
-    // turn this automatic scaling off, but that requires that libheif no longer assumes everywhere
-    // that the alpha channel has the same resolution as the color channels.
-    if (alphaImage->get_width() != image->get_width() ||
-        alphaImage->get_height() != image->get_height()) {
-      std::shared_ptr<HeifPixelImage> scaled_alpha;
-      Error err = alphaImage->scale_nearest_neighbor(scaled_alpha, image->get_width(), image->get_height(),
-                                                     m_heif_context->get_security_limits());
-      if (err) {
-        return err;
-      }
-      alphaImage = std::move(scaled_alpha);
-    }
-
-    image->transfer_channel_from_image_as(alphaImage, heif_channel_Y, heif_channel_Alpha);
-  }
-
-
-  // --- read sample auxiliary data
-
-  if (m_aux_reader_content_ids) {
-    auto readResult = m_aux_reader_content_ids->get_sample_info(get_file().get(), (uint32_t)decoded_sample_idx);
-    if (!readResult) {
-      return readResult.error();
-    }
-
-    Result<std::string> convResult = vector_to_string(*readResult);
-    if (!convResult) {
-      return convResult.error();
-    }
-
-    image->set_gimi_sample_content_id(*convResult);
-  }
-
-  if (m_aux_reader_tai_timestamps) {
-    auto readResult = m_aux_reader_tai_timestamps->get_sample_info(get_file().get(), (uint32_t)decoded_sample_idx);
-    if (!readResult) {
-      return readResult.error();
-    }
-
-    std::vector<uint8_t>& tai_data = *readResult;
-    if (!tai_data.empty()) {
-      auto resultTai = Box_itai::decode_tai_from_vector(tai_data);
-      if (!resultTai) {
-        return resultTai.error();
-      }
-
-      image->set_tai_timestamp(&*resultTai);
+    err = m_aux_alpha_track->seek_to_sample(sample_idx);
+    if (err) {
+      return err;
     }
   }
 
-  m_next_sample_to_be_output++;
-
-  return image;
+  return {};
 }
 
 
@@ -519,7 +562,9 @@ Error Track_Visual::encode_image(std::shared_ptr<HeifPixelImage> image,
                                                                                                      h_encoder,
                                                                                                      output_nclx,
                                                                                                      in_options ? &in_options->color_conversion_options : nullptr,
-                                                                                                     m_heif_context->get_security_limits());
+                                                                                                     nullptr,
+                                                                                                     m_heif_context->get_security_limits(),
+                                                                                                     m_heif_context->get_max_decoding_threads());
   if (!srcImageResult) {
     return srcImageResult.error();
   }
@@ -52,6 +52,8 @@ public:
 
   Result<std::shared_ptr<HeifPixelImage>> decode_next_image_sample(const heif_decoding_options& options);
 
+  Error seek_to_sample(uint32_t sample_idx) override;
+
   Error encode_image(std::shared_ptr<HeifPixelImage> image,
                      heif_encoder* encoder,
                      const heif_sequence_encoding_options* options,
@@ -97,6 +99,11 @@ private:
   std::unique_ptr<heif_encoder> m_alpha_track_encoder;
 
   Result<bool> process_encoded_data(heif_encoder* encoder);
+
+  // Push compressed samples into the decoder until it outputs the next frame.
+  Result<std::shared_ptr<HeifPixelImage>> receive_next_decoded_frame(const heif_decoding_options& options,
+                                                                     uint32_t* out_sample_idx,
+                                                                     uintptr_t* out_decoded_sample_idx);
 };
 
 
@@ -27,8 +27,16 @@
 #include <iomanip>
 #include "catch_amalgamated.hpp"
 #include "color-conversion/colorconversion.h"
+#include "color-conversion/alpha.h"
+#include "color-conversion/rgb2rgb.h"
 #include "image/pixelimage.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
+#include <sstream>
+#include <tuple>
+#include <thread>
 
 // Enable for more verbose test output.
 constexpr bool kEnableDebugOutput = false;
@@ -647,6 +655,85 @@ TEST_CASE("Sharp yuv conversion", "[heif_image]") {
 }
 
 
+#ifdef HAVE_LIBSHARPYUV
+TEST_CASE("Multithreaded sharp yuv conversion", "[heif_image]")
+{
+  // Large enough for several stripes.
+  const uint32_t width = 97;
+  const uint32_t height = 700;
+
+  heif_color_conversion_options options{};
+  options.preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_sharp_yuv;
+  options.only_use_preferred_chroma_algorithm = true;
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  auto input = std::make_shared<HeifPixelImage>();
+  input->create(width, height, heif_colorspace_RGB, heif_chroma_interleaved_RGB);
+  REQUIRE(!input->add_channel(heif_channel_interleaved, width, height, 8, nullptr));
+
+  size_t in_stride;
+  uint8_t* in = input->get_channel_memory(heif_channel_interleaved, &in_stride);
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width * 3; x++) {
+      // Sharp color edges, where sharp yuv differs most from the plain downsampling.
+      in[y * in_stride + x] = static_cast<uint8_t>(((x / 3 + y / 5) % 7 < 3) ? (x % 3) * 120 : 255 - (y % 256));
+    }
+  }
+
+  auto convert = [&](int num_threads) {
+    auto result = convert_colorspace(input, heif_colorspace_YCbCr, heif_chroma_420, nclx_profile::defaults(), 8,
+                                     options, options_ext.get(), heif_get_disabled_security_limits(),
+                                     nullptr, nullptr, num_threads);
+    REQUIRE(result);
+    return *result;
+  };
+
+  // By default, the whole image is converted at once, independent of the number of threads.
+  auto reference = convert(1);
+  auto whole = convert(4);
+
+  // Stripes are only used when enabled. They do not depend on the number of threads.
+  options_ext->max_sharp_yuv_threads = 4;
+  auto striped1 = convert(1);
+  auto striped4 = convert(4);
+
+  options_ext->max_sharp_yuv_threads = 2;
+  auto limited = convert(4);
+
+  for (heif_channel channel : {heif_channel_Y, heif_channel_Cb, heif_channel_Cr}) {
+    INFO("channel: " << channel);
+    uint32_t w = reference->get_width(channel);
+    uint32_t h = reference->get_height(channel);
+
+    size_t ref_stride, whole_stride, stride1, stride4, limited_stride;
+    const uint8_t* ref = reference->get_channel_memory(channel, &ref_stride);
+    const uint8_t* p = whole->get_channel_memory(channel, &whole_stride);
+    const uint8_t* p1 = striped1->get_channel_memory(channel, &stride1);
+    const uint8_t* p4 = striped4->get_channel_memory(channel, &stride4);
+    const uint8_t* lim = limited->get_channel_memory(channel, &limited_stride);
+
+    int max_difference = 0;
+    for (uint32_t y = 0; y < h; y++) {
+      INFO("row: " << y);
+      REQUIRE(memcmp(p + y * whole_stride, ref + y * ref_stride, w) == 0);
+      REQUIRE(memcmp(p1 + y * stride1, p4 + y * stride4, w) == 0);
+      REQUIRE(memcmp(lim + y * limited_stride, p4 + y * stride4, w) == 0);
+
+      for (uint32_t x = 0; x < w; x++) {
+        max_difference = std::max(max_difference, std::abs(p4[y * stride4 + x] - ref[y * ref_stride + x]));
+      }
+    }
+
+    // The iterative optimization of sharp yuv runs on each stripe separately (with overlapping rows).
+    // With 16 overlapping rows, this image differed by 3 code values.
+    REQUIRE(max_difference <= 2);
+  }
+}
+#endif
+
+
 static void fill_plane(std::shared_ptr<HeifPixelImage>& img, heif_channel channel, int w, int h, const std::vector<uint8_t>& pixels)
 {
   auto error = img->add_channel(channel, w, h, 8, nullptr);
@@ -724,6 +811,50 @@ TEST_CASE("Bilinear upsampling", "[heif_image]")
                });
 }
 
+TEST_CASE("Bilinear upsampling at the image border", "[heif_image]")
+{
+  heif_color_conversion_options options = {
+      .preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear,
+      .only_use_preferred_chroma_algorithm = true};
+
+  // 4:2:0 image with odd width and height. The chroma samples only change horizontally in Cb and
+  // only vertically in Cr. Hence, the borders are interpolated in one direction only.
+  std::shared_ptr<HeifPixelImage> img = std::make_shared<HeifPixelImage>();
+  img->create(7, 5, heif_colorspace_YCbCr, heif_chroma_420);
+
+  auto error = img->fill_new_channel(heif_channel_Y, 128, 7, 5, 8, nullptr);
+  REQUIRE(!error);
+
+  fill_plane(img, heif_channel_Cb, 4, 3,
+             {0, 40, 80, 120,
+              0, 40, 80, 120,
+              0, 40, 80, 120});
+  fill_plane(img, heif_channel_Cr, 4, 3,
+             {0, 0, 0, 0,
+              80, 80, 80, 80,
+              160, 160, 160, 160});
+
+  auto conversionResult = convert_colorspace(img, heif_colorspace_YCbCr, heif_chroma_444,
+                                             nclx_profile::defaults(), 8, options, nullptr, heif_get_disabled_security_limits());
+  REQUIRE(conversionResult);
+  std::shared_ptr<HeifPixelImage> out = *conversionResult;
+
+  std::vector<uint8_t> cb_row{0, 10, 30, 50, 70, 90, 110};
+  std::vector<uint8_t> expected_cb;
+  for (int y = 0; y < 5; y++) {
+    expected_cb.insert(expected_cb.end(), cb_row.begin(), cb_row.end());
+  }
+
+  assert_plane(out, heif_channel_Cb, expected_cb);
+
+  std::vector<uint8_t> expected_cr;
+  for (int v : {0, 20, 60, 100, 140}) {
+    expected_cr.insert(expected_cr.end(), 7, static_cast<uint8_t>(v));
+  }
+
+  assert_plane(out, heif_channel_Cr, expected_cr);
+}
+
 TEST_CASE("RGB 5-6-5 to RGB")
 {
   heif_color_conversion_options options = {};
@@ -894,3 +1025,955 @@ TEST_CASE("Mismatched alpha bit depth - conversion correctness") {
     CHECK(p[3] == 200);  // A (10-bit 800 >> 2 = 200)
   }
 }
+
+
+static void fill_plane_with_noise(std::shared_ptr<HeifPixelImage>& img, heif_channel channel, uint32_t w, uint32_t h, int bpp, uint32_t seed)
+{
+  auto error = img->add_channel(channel, w, h, bpp, nullptr);
+  REQUIRE(!error);
+
+  size_t stride;
+  uint8_t* p = img->get_channel_memory(channel, &stride);
+  uint32_t row_bytes = w * img->get_storage_bits_per_pixel(channel) / 8;
+
+  for (uint32_t y = 0; y < h; y++) {
+    for (uint32_t x = 0; x < row_bytes; x++) {
+      seed = seed * 1103515245 + 12345;
+      p[y * stride + x] = static_cast<uint8_t>(seed >> 16);
+    }
+  }
+}
+
+
+static void assert_images_equal(const std::shared_ptr<HeifPixelImage>& a, const std::shared_ptr<HeifPixelImage>& b)
+{
+  REQUIRE(a->get_chroma_format() == b->get_chroma_format());
+
+  for (heif_channel channel : {heif_channel_Y, heif_channel_Cb, heif_channel_Cr,
+                               heif_channel_R, heif_channel_G, heif_channel_B,
+                               heif_channel_Alpha, heif_channel_interleaved}) {
+    INFO("channel: " << channel);
+    REQUIRE(a->has_channel(channel) == b->has_channel(channel));
+    if (!a->has_channel(channel)) {
+      continue;
+    }
+
+    size_t stride_a, stride_b;
+    const uint8_t* pa = a->get_channel_memory(channel, &stride_a);
+    const uint8_t* pb = b->get_channel_memory(channel, &stride_b);
+    uint32_t row_bytes = a->get_width(channel) * a->get_storage_bits_per_pixel(channel) / 8;
+
+    for (uint32_t y = 0; y < a->get_height(channel); y++) {
+      INFO("row: " << y);
+      REQUIRE(memcmp(pa + y * stride_a, pb + y * stride_b, row_bytes) == 0);
+    }
+  }
+}
+
+
+TEST_CASE("Striped conversion matches single-threaded conversion", "[heif_image]")
+{
+  heif_color_conversion_options options = {
+      .preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_average,
+      .preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear,
+      .only_use_preferred_chroma_algorithm = false};
+
+  heif_color_conversion_options_ext options_ext = {
+      .alpha_composition_mode = heif_alpha_composition_mode_none
+  };
+
+  // Odd sizes so that the 4:2:0 edge handling is covered. The height is large enough for several stripes.
+  const uint32_t width = 131;
+  const uint32_t height = 333;
+
+  nclx_profile nclx = nclx_profile::defaults();
+  nclx.set_matrix_coefficients(1);
+
+  SECTION("YCbCr -> RGB") {
+    heif_chroma chroma = GENERATE(heif_chroma_420, heif_chroma_422, heif_chroma_444);
+    int bpp = GENERATE(8, 10);
+    heif_chroma target_chroma = GENERATE(heif_chroma_interleaved_RGB, heif_chroma_interleaved_RGBA,
+                                         heif_chroma_interleaved_RRGGBB_LE, heif_chroma_444);
+    INFO("chroma: " << chroma << " bpp: " << bpp << " target: " << target_chroma);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, chroma);
+    img->set_color_profile_nclx(nclx);
+
+    uint32_t cw = chroma == heif_chroma_444 ? width : (width + 1) / 2;
+    uint32_t ch = chroma == heif_chroma_420 ? (height + 1) / 2 : height;
+    fill_plane_with_noise(img, heif_channel_Y, width, height, bpp, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, cw, ch, bpp, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, cw, ch, bpp, 3);
+    fill_plane_with_noise(img, heif_channel_Alpha, width, height, bpp, 4);
+
+    // Noise in the upper bits of high bit depth samples is clipped by the conversion, but that is the same for both runs.
+    int target_bpp = (target_chroma == heif_chroma_interleaved_RGB || target_chroma == heif_chroma_interleaved_RGBA) ? 8 : bpp;
+
+    auto single = convert_colorspace(img, heif_colorspace_RGB, target_chroma, nclx_profile::defaults(), target_bpp,
+                                     options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    auto striped = convert_colorspace(img, heif_colorspace_RGB, target_chroma, nclx_profile::defaults(), target_bpp,
+                                      options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 4);
+    REQUIRE(single);
+    REQUIRE(striped);
+    assert_images_equal(*single, *striped);
+  }
+
+  SECTION("RGB -> YCbCr") {
+    heif_chroma input_chroma = GENERATE(heif_chroma_interleaved_RGB, heif_chroma_interleaved_RGBA, heif_chroma_444);
+    heif_chroma chroma = GENERATE(heif_chroma_420, heif_chroma_422, heif_chroma_444);
+    INFO("input: " << input_chroma << " chroma: " << chroma);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_RGB, input_chroma);
+    if (input_chroma == heif_chroma_444) {
+      fill_plane_with_noise(img, heif_channel_R, width, height, 8, 1);
+      fill_plane_with_noise(img, heif_channel_G, width, height, 8, 2);
+      fill_plane_with_noise(img, heif_channel_B, width, height, 8, 3);
+    }
+    else {
+      fill_plane_with_noise(img, heif_channel_interleaved, width, height, 8, 1);
+    }
+
+    auto single = convert_colorspace(img, heif_colorspace_YCbCr, chroma, nclx, 8,
+                                     options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    auto striped = convert_colorspace(img, heif_colorspace_YCbCr, chroma, nclx, 8,
+                                      options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 4);
+    REQUIRE(single);
+    REQUIRE(striped);
+    assert_images_equal(*single, *striped);
+  }
+
+#ifdef HAVE_LIBSHARPYUV
+  SECTION("RGB -> YCbCr 420 with sharp YUV") {
+    int bpp = GENERATE(8, 10);
+    INFO("bpp: " << bpp);
+
+    heif_color_conversion_options sharp_yuv_options = options;
+    sharp_yuv_options.preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_sharp_yuv;
+    sharp_yuv_options.only_use_preferred_chroma_algorithm = true;
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_RGB, heif_chroma_444);
+    fill_plane_with_noise(img, heif_channel_R, width, height, bpp, 1);
+    fill_plane_with_noise(img, heif_channel_G, width, height, bpp, 2);
+    fill_plane_with_noise(img, heif_channel_B, width, height, bpp, 3);
+
+    // libsharpyuv reads out of bounds when the samples exceed their bit depth.
+    if (bpp > 8) {
+      for (heif_channel channel : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+        size_t stride;
+        auto* p = reinterpret_cast<uint16_t*>(img->get_channel_memory(channel, &stride));
+        stride /= 2;
+        for (uint32_t y = 0; y < height; y++) {
+          for (uint32_t x = 0; x < width; x++) {
+            p[y * stride + x] &= static_cast<uint16_t>((1 << bpp) - 1);
+          }
+        }
+      }
+    }
+
+    heif_color_conversion_options_ext striped_options_ext = options_ext;
+    striped_options_ext.version = 5;
+    striped_options_ext.max_sharp_yuv_threads = 4;
+
+    // By default, the whole image is converted at once, independent of the number of threads.
+    auto single = convert_colorspace(img, heif_colorspace_YCbCr, heif_chroma_420, nclx, bpp,
+                                     sharp_yuv_options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    auto multi = convert_colorspace(img, heif_colorspace_YCbCr, heif_chroma_420, nclx, bpp,
+                                    sharp_yuv_options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 4);
+
+    // The stripes do not depend on the number of threads either.
+    auto striped_single = convert_colorspace(img, heif_colorspace_YCbCr, heif_chroma_420, nclx, bpp,
+                                             sharp_yuv_options, &striped_options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    auto striped = convert_colorspace(img, heif_colorspace_YCbCr, heif_chroma_420, nclx, bpp,
+                                      sharp_yuv_options, &striped_options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 4);
+    REQUIRE(single);
+    REQUIRE(multi);
+    REQUIRE(striped_single);
+    REQUIRE(striped);
+    assert_images_equal(*single, *multi);
+    assert_images_equal(*striped_single, *striped);
+  }
+#endif
+
+  SECTION("Bayer filter array -> RGB") {
+    int bpp = GENERATE(8, 12);
+    INFO("bpp: " << bpp);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_filter_array, heif_chroma_planar);
+    fill_plane_with_noise(img, heif_channel_filter_array, width, height, bpp, 1);
+
+    uint32_t r_id = img->add_component_without_data(heif_cmpd_component_type_red);
+    uint32_t g_id = img->add_component_without_data(heif_cmpd_component_type_green);
+    uint32_t b_id = img->add_component_without_data(heif_cmpd_component_type_blue);
+
+    BayerPattern pattern;
+    pattern.pattern_width = 2;
+    pattern.pattern_height = 2;
+    pattern.pixels = {{g_id, 1.0f}, {r_id, 1.0f}, {b_id, 1.0f}, {g_id, 1.0f}};
+    img->set_bayer_pattern(pattern);
+
+    heif_chroma target_chroma = (bpp == 8) ? heif_chroma_interleaved_RGB : heif_chroma_interleaved_RRGGBB_LE;
+
+    auto single = convert_colorspace(img, heif_colorspace_RGB, target_chroma, nclx_profile::defaults(), bpp,
+                                     options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    auto striped = convert_colorspace(img, heif_colorspace_RGB, target_chroma, nclx_profile::defaults(), bpp,
+                                      options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 4);
+    REQUIRE(single);
+    REQUIRE(striped);
+    assert_images_equal(*single, *striped);
+  }
+
+  SECTION("Bayer filter array -> YCbCr") {
+    // The demosaicing needs the rows above and below each stripe. It must not be fused with the RGB -> YCbCr step.
+    heif_chroma target_chroma = GENERATE(heif_chroma_444, heif_chroma_420);
+    int num_threads = GENERATE(1, 4);
+    INFO("chroma: " << target_chroma << ", threads: " << num_threads);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_filter_array, heif_chroma_planar);
+    fill_plane_with_noise(img, heif_channel_filter_array, width, height, 8, 1);
+
+    uint32_t r_id = img->add_component_without_data(heif_cmpd_component_type_red);
+    uint32_t g_id = img->add_component_without_data(heif_cmpd_component_type_green);
+    uint32_t b_id = img->add_component_without_data(heif_cmpd_component_type_blue);
+
+    BayerPattern pattern;
+    pattern.pattern_width = 2;
+    pattern.pattern_height = 2;
+    pattern.pixels = {{r_id, 1.0f}, {g_id, 1.0f}, {g_id, 1.0f}, {b_id, 1.0f}};
+    img->set_bayer_pattern(pattern);
+
+    nclx_profile ycbcr_nclx = nclx_profile::defaults();
+    ycbcr_nclx.set_matrix_coefficients(1);
+
+    auto direct = convert_colorspace(img, heif_colorspace_YCbCr, target_chroma, ycbcr_nclx, 8,
+                                     options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, num_threads);
+    REQUIRE(direct);
+
+    auto rgb = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nclx_profile::defaults(), 8,
+                                  options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    REQUIRE(rgb);
+    auto via_rgb = convert_colorspace(*rgb, heif_colorspace_YCbCr, target_chroma, ycbcr_nclx, 8,
+                                      options, &options_ext, heif_get_disabled_security_limits(), nullptr, nullptr, 1);
+    REQUIRE(via_rgb);
+
+    assert_images_equal(*direct, *via_rgb);
+  }
+}
+
+
+TEST_CASE("In-place conversion matches conversion into a new image", "[heif_image]")
+{
+  heif_color_conversion_options options;
+  heif_color_conversion_options_set_defaults(&options);
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  const uint32_t width = 33;
+  const uint32_t height = 17;
+
+  std::shared_ptr<ColorConversionOperation> op;
+  ColorState input_state;
+  ColorState output_state;
+
+  SECTION("swap endianness") {
+    op = std::make_shared<Op_RRGGBBaa_swap_endianness>();
+    bool alpha = GENERATE(false, true);
+    input_state = {heif_colorspace_RGB, alpha ? heif_chroma_interleaved_RRGGBBAA_LE : heif_chroma_interleaved_RRGGBB_LE, alpha, 10};
+    output_state = {heif_colorspace_RGB, alpha ? heif_chroma_interleaved_RRGGBBAA_BE : heif_chroma_interleaved_RRGGBB_BE, alpha, 10};
+  }
+
+  SECTION("drop alpha plane") {
+    op = std::make_shared<Op_drop_alpha_plane>();
+    input_state = {heif_colorspace_YCbCr, heif_chroma_420, true, 8};
+    output_state = {heif_colorspace_YCbCr, heif_chroma_420, false, 8};
+  }
+
+  SECTION("adjust alpha bit depth") {
+    op = std::make_shared<Op_adjust_alpha_bit_depth>();
+    int alpha_bpp = GENERATE(8, 12);
+    input_state = {heif_colorspace_YCbCr, heif_chroma_444, true, 10};
+    input_state.alpha_bits_per_pixel = alpha_bpp;
+    output_state = {heif_colorspace_YCbCr, heif_chroma_444, true, 10};
+  }
+
+  INFO("from: " << input_state << " to: " << output_state);
+  REQUIRE(op->supports_inplace_conversion());
+
+  auto create_image = [&]() {
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, input_state.colorspace, input_state.chroma);
+
+    if (input_state.colorspace == heif_colorspace_RGB) {
+      fill_plane_with_noise(img, heif_channel_interleaved, width, height, input_state.bits_per_pixel, 1);
+    }
+    else {
+      uint32_t cw = input_state.chroma == heif_chroma_444 ? width : (width + 1) / 2;
+      uint32_t ch = input_state.chroma == heif_chroma_444 ? height : (height + 1) / 2;
+      fill_plane_with_noise(img, heif_channel_Y, width, height, input_state.bits_per_pixel, 1);
+      fill_plane_with_noise(img, heif_channel_Cb, cw, ch, input_state.bits_per_pixel, 2);
+      fill_plane_with_noise(img, heif_channel_Cr, cw, ch, input_state.bits_per_pixel, 3);
+      fill_plane_with_noise(img, heif_channel_Alpha, width, height, input_state.get_alpha_bits_per_pixel(), 4);
+    }
+
+    return img;
+  };
+
+  auto expected = op->convert_colorspace(create_image(), input_state, output_state, options, *options_ext, nullptr);
+  REQUIRE(expected);
+
+  auto img = create_image();
+  REQUIRE(!op->convert_colorspace_inplace(img, input_state, output_state, options, *options_ext, nullptr));
+
+  CHECK(img->get_colorspace() == (*expected)->get_colorspace());
+  assert_images_equal(*expected, img);
+
+  if (output_state.has_alpha) {
+    CHECK(img->get_bits_per_pixel(heif_channel_Alpha) == (*expected)->get_bits_per_pixel(heif_channel_Alpha));
+  }
+}
+
+TEST_CASE("Conversion of a moved input image is done in place", "[heif_image]")
+{
+  heif_color_conversion_options options;
+  heif_color_conversion_options_set_defaults(&options);
+
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(33, 17, heif_colorspace_RGB, heif_chroma_interleaved_RRGGBBAA_LE);
+  fill_plane_with_noise(img, heif_channel_interleaved, 33, 17, 10, 1);
+
+  // The image is not modified while the caller holds a reference to it.
+
+  auto copied = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_interleaved_RRGGBBAA_BE, nclx_profile::defaults(), 10,
+                                   options, nullptr, heif_get_disabled_security_limits());
+  REQUIRE(copied);
+  CHECK(copied->get() != img.get());
+  CHECK((*copied)->get_chroma_format() == heif_chroma_interleaved_RRGGBBAA_BE);
+  CHECK(img->get_chroma_format() == heif_chroma_interleaved_RRGGBBAA_LE);
+
+  // With the only reference, the byte order of the input image is swapped.
+
+  const HeifPixelImage* input_image = img.get();
+  auto moved = convert_colorspace(std::move(img), heif_colorspace_RGB, heif_chroma_interleaved_RRGGBBAA_BE, nclx_profile::defaults(), 10,
+                                  options, nullptr, heif_get_disabled_security_limits());
+  REQUIRE(moved);
+  CHECK(moved->get() == input_image);
+  assert_images_equal(*copied, *moved);
+}
+
+
+TEST_CASE("Fused conversion steps match step-by-step conversion", "[heif_image]")
+{
+  heif_color_conversion_options options = {
+      .preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_average,
+      .preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear,
+      .only_use_preferred_chroma_algorithm = false};
+
+  heif_color_conversion_options_ext options_ext = {
+      .alpha_composition_mode = heif_alpha_composition_mode_none
+  };
+
+  // Wide enough that the fused steps are executed in many strips.
+  const uint32_t width = 1001;
+  const uint32_t height = 333;
+
+  int num_threads = GENERATE(1, 3);
+
+  nclx_profile nclx = nclx_profile::defaults();
+  nclx.set_matrix_coefficients(1);
+
+  // The reference conversion goes through the intermediate formats with separate single-step conversions.
+  auto convert_via = [&](std::shared_ptr<HeifPixelImage> img,
+                         const std::vector<std::tuple<heif_colorspace, heif_chroma, int>>& formats) {
+    for (const auto& [colorspace, chroma, bpp] : formats) {
+      auto result = convert_colorspace(img, colorspace, chroma, nclx, bpp, options, &options_ext,
+                                       heif_get_disabled_security_limits(), nullptr, nullptr, num_threads);
+      REQUIRE(result);
+      img = *result;
+    }
+    return img;
+  };
+
+  SECTION("YCbCr 4:2:0 10 bit -> RGB24") {
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_420);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 10, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, (width + 1) / 2, (height + 1) / 2, 10, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, (width + 1) / 2, (height + 1) / 2, 10, 3);
+
+    auto fused = convert_via(img, {{heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    auto reference = convert_via(img, {{heif_colorspace_YCbCr, heif_chroma_420, 8},
+                                       {heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    assert_images_equal(fused, reference);
+  }
+
+  SECTION("YCbCr 4:2:2 8 bit -> planar RGB") {
+    // With bilinear upsampling enforced, upsampling and RGB conversion are done by one combined operation.
+    options.only_use_preferred_chroma_algorithm = true;
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_422);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 8, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, (width + 1) / 2, height, 8, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, (width + 1) / 2, height, 8, 3);
+
+    auto fused = convert_via(img, {{heif_colorspace_RGB, heif_chroma_444, 8}});
+    auto reference = convert_via(img, {{heif_colorspace_YCbCr, heif_chroma_444, 8},
+                                       {heif_colorspace_RGB, heif_chroma_444, 8}});
+    assert_images_equal(fused, reference);
+  }
+
+  SECTION("YCbCr 4:2:0 8 bit -> RGB24 with bilinear upsampling") {
+    // The vertical chroma interpolation needs the rows above and below each strip.
+    options.only_use_preferred_chroma_algorithm = true;
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_420);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 8, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, (width + 1) / 2, (height + 1) / 2, 8, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, (width + 1) / 2, (height + 1) / 2, 8, 3);
+
+    auto fused = convert_via(img, {{heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    auto reference = convert_via(img, {{heif_colorspace_YCbCr, heif_chroma_444, 8},
+                                       {heif_colorspace_RGB, heif_chroma_444, 8},
+                                       {heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    assert_images_equal(fused, reference);
+  }
+
+  SECTION("YCbCr 4:4:4 10 bit -> RGB24") {
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_444);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 10, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, width, height, 10, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, width, height, 10, 3);
+
+    auto fused = convert_via(img, {{heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    auto reference = convert_via(img, {{heif_colorspace_RGB, heif_chroma_444, 10},
+                                       {heif_colorspace_RGB, heif_chroma_444, 8},
+                                       {heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8}});
+    assert_images_equal(fused, reference);
+  }
+
+  SECTION("RGBA -> YCbCr 4:2:0 10 bit") {
+    // Otherwise, sharp YUV may be chosen for one of the conversions when libsharpyuv is compiled in.
+    options.only_use_preferred_chroma_algorithm = true;
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_RGB, heif_chroma_interleaved_RGBA);
+    fill_plane_with_noise(img, heif_channel_interleaved, width, height, 8, 1);
+
+    auto fused = convert_via(img, {{heif_colorspace_YCbCr, heif_chroma_420, 10}});
+    auto reference = convert_via(img, {{heif_colorspace_YCbCr, heif_chroma_420, 8},
+                                       {heif_colorspace_YCbCr, heif_chroma_420, 10}});
+    assert_images_equal(fused, reference);
+  }
+}
+
+
+TEST_CASE("Color conversion is canceled between stripes", "[heif_image]")
+{
+  heif_color_conversion_options options = {
+      .preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_average,
+      .preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear,
+      .only_use_preferred_chroma_algorithm = false};
+
+  heif_color_conversion_options_ext options_ext = {
+      .alpha_composition_mode = heif_alpha_composition_mode_none
+  };
+
+  const uint32_t width = 1001;
+  const uint32_t height = 333;
+
+  nclx_profile nclx = nclx_profile::defaults();
+  nclx.set_matrix_coefficients(1);
+
+  // The first poll is done before the first conversion step. All later polls cancel the conversion.
+  int num_polls = 0;
+  bool polled_from_other_thread = false;
+  std::thread::id calling_thread = std::this_thread::get_id();
+
+  auto is_canceled = [&]() {
+    if (std::this_thread::get_id() != calling_thread) {
+      polled_from_other_thread = true;
+    }
+    return ++num_polls > 1;
+  };
+
+  // Single-threaded, the strips are converted in the calling thread, which polls before each strip.
+  // With more threads, the stripes may all be finished before the calling thread polls again.
+  // Then, the conversion is not canceled, but the callback must still only be called from the calling thread.
+
+  auto require_canceled = [](const Result<std::shared_ptr<HeifPixelImage>>& result, bool must_be_canceled) {
+    if (must_be_canceled) {
+      REQUIRE(!result);
+    }
+    if (!result) {
+      REQUIRE(result.error().error_code == heif_error_Canceled);
+    }
+  };
+
+  SECTION("fused steps") {
+    int num_threads = GENERATE(1, 3);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_420);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 10, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, (width + 1) / 2, (height + 1) / 2, 10, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, (width + 1) / 2, (height + 1) / 2, 10, 3);
+
+    auto result = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nclx, 8, options, &options_ext,
+                                     heif_get_disabled_security_limits(), is_canceled, nullptr, num_threads);
+    require_canceled(result, num_threads == 1);
+  }
+
+  SECTION("stripes of a single step") {
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_444);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 8, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, width, height, 8, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, width, height, 8, 3);
+
+    auto result = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_444, nclx, 8, options, &options_ext,
+                                     heif_get_disabled_security_limits(), is_canceled, nullptr, 4);
+    require_canceled(result, false);
+  }
+
+  REQUIRE(!polled_from_other_thread);
+}
+
+
+TEST_CASE("Cached pipeline planning", "[heif_image]")
+{
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  heif_color_conversion_options options{};
+  options.preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear;
+  options.only_use_preferred_chroma_algorithm = true;
+
+  ColorState input_state(heif_colorspace_YCbCr, heif_chroma_420, false, 8);
+  nclx_default_if_undefined(input_state);
+  ColorState target_state(heif_colorspace_RGB, heif_chroma_interleaved_RGB, false, 8);
+
+  ColorConversionPipeline first;
+  REQUIRE(first.construct_pipeline(input_state, target_state, options, *options_ext));
+
+  ColorConversionPipeline second;
+  REQUIRE(second.construct_pipeline(input_state, target_state, options, *options_ext));
+  REQUIRE(second.debug_dump_pipeline() == first.debug_dump_pipeline());
+
+  // Different options must not reuse the cached pipeline.
+
+  options.preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_nearest_neighbor;
+
+  ColorConversionPipeline nearest;
+  REQUIRE(nearest.construct_pipeline(input_state, target_state, options, *options_ext));
+  INFO("bilinear: " << first.debug_dump_pipeline() << "\nnearest neighbor: " << nearest.debug_dump_pipeline());
+  REQUIRE(nearest.debug_dump_pipeline() != first.debug_dump_pipeline());
+
+  // Unsupported conversions are also cached and have to fail again.
+
+  ColorState unsupported_state(heif_colorspace_RGB, heif_chroma_420, false, 8);
+
+  for (int i = 0; i < 2; i++) {
+    ColorConversionPipeline pipeline;
+    REQUIRE_FALSE(pipeline.construct_pipeline(input_state, unsupported_state, options, *options_ext));
+  }
+
+  // Conversions that only differ in the target nclx profile must not reuse the cached pipeline.
+  // Otherwise, the output is tagged with the nclx profile of the first conversion.
+
+  auto rgb = std::make_shared<HeifPixelImage>();
+  rgb->create(16, 16, heif_colorspace_RGB, heif_chroma_444);
+  for (heif_channel channel : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+    REQUIRE(!rgb->add_channel(channel, 16, 16, 8, heif_get_disabled_security_limits()));
+  }
+
+  for (auto transfer : {heif_transfer_characteristic_ITU_R_BT_2100_0_PQ,
+                        heif_transfer_characteristic_IEC_61966_2_1,
+                        heif_transfer_characteristic_ITU_R_BT_709_5}) {
+    nclx_profile target = nclx_profile::defaults();
+    target.set_transfer_characteristics(transfer);
+
+    auto result = convert_colorspace(rgb, heif_colorspace_YCbCr, heif_chroma_420, target, 8, heif_color_conversion_options{},
+                                     options_ext.get(), heif_get_disabled_security_limits());
+    REQUIRE(result);
+    REQUIRE((*result)->get_color_profile_nclx().get_transfer_characteristics() == transfer);
+  }
+}
+
+
+TEST_CASE("Alpha premultiplication", "[heif_image]")
+{
+  heif_color_conversion_options options = {
+      .preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_average,
+      .preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear,
+      .only_use_preferred_chroma_algorithm = false};
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  const uint32_t width = 131;
+  const uint32_t height = 333;
+
+  nclx_profile nclx = nclx_profile::defaults();
+  nclx.set_matrix_coefficients(1);
+
+  heif_chroma target_chroma = GENERATE(heif_chroma_interleaved_RGBA, heif_chroma_interleaved_RRGGBBAA_LE);
+  int bpp = (target_chroma == heif_chroma_interleaved_RGBA) ? 8 : 10;
+  INFO("target: " << target_chroma);
+
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(width, height, heif_colorspace_YCbCr, heif_chroma_420);
+  img->set_color_profile_nclx(nclx);
+
+  // Clip the noise to the bit depth, so that the premultiplication can be checked against the exact formula.
+  for (heif_channel channel : {heif_channel_Y, heif_channel_Cb, heif_channel_Cr, heif_channel_Alpha}) {
+    bool chroma = (channel == heif_channel_Cb || channel == heif_channel_Cr);
+    uint32_t w = chroma ? (width + 1) / 2 : width;
+    uint32_t h = chroma ? (height + 1) / 2 : height;
+    fill_plane_with_noise(img, channel, w, h, bpp, static_cast<uint32_t>(channel) + 1);
+
+    if (bpp > 8) {
+      size_t stride;
+      auto* p = reinterpret_cast<uint16_t*>(img->get_channel_memory(channel, &stride));
+      for (uint32_t y = 0; y < h; y++) {
+        for (uint32_t x = 0; x < w; x++) {
+          p[y * stride / 2 + x] = static_cast<uint16_t>(p[y * stride / 2 + x] & ((1 << bpp) - 1));
+        }
+      }
+    }
+  }
+
+  auto convert = [&](const std::shared_ptr<HeifPixelImage>& input, heif_chroma chroma,
+                     heif_alpha_premultiplication premultiplication, int num_threads) {
+    options_ext->alpha_premultiplication = premultiplication;
+    auto result = convert_colorspace(input, chroma == heif_chroma_444 ? heif_colorspace_YCbCr : heif_colorspace_RGB,
+                                     chroma, nclx, bpp, options, options_ext.get(),
+                                     heif_get_disabled_security_limits(), nullptr, nullptr, num_threads);
+    REQUIRE(result);
+    return *result;
+  };
+
+  auto sample = [&](const std::shared_ptr<HeifPixelImage>& image, uint32_t x, uint32_t y, int c) -> uint32_t {
+    size_t stride;
+    const uint8_t* p = image->get_channel_memory(heif_channel_interleaved, &stride);
+    if (bpp == 8) {
+      return p[y * stride + 4 * x + c];
+    }
+    else {
+      const uint8_t* s = &p[y * stride + 8 * x + 2 * c];
+      return s[0] | (s[1] << 8);
+    }
+  };
+
+  auto straight = convert(img, target_chroma, heif_alpha_premultiplication_keep, 1);
+  REQUIRE(!straight->is_premultiplied_alpha());
+
+  auto premultiplied = convert(img, target_chroma, heif_alpha_premultiplication_premultiplied, 1);
+  REQUIRE(premultiplied->is_premultiplied_alpha());
+
+  uint32_t max_value = (1 << bpp) - 1;
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t a = sample(straight, x, y, 3);
+      REQUIRE(sample(premultiplied, x, y, 3) == a);
+
+      for (int c = 0; c < 3; c++) {
+        REQUIRE(sample(premultiplied, x, y, c) == (sample(straight, x, y, c) * a + max_value / 2) / max_value);
+      }
+    }
+  }
+
+  // The premultiplication is fused with the conversion to RGB. It converts in stripes.
+  auto striped = convert(img, target_chroma, heif_alpha_premultiplication_premultiplied, 4);
+  assert_images_equal(premultiplied, striped);
+
+  // The premultiplied alpha is kept by default.
+  auto kept = convert(premultiplied, heif_chroma_444, heif_alpha_premultiplication_keep, 1);
+  REQUIRE(kept->is_premultiplied_alpha());
+
+  // Back to straight alpha. Only fully opaque pixels are exactly restored.
+  auto unpremultiplied = convert(premultiplied, target_chroma, heif_alpha_premultiplication_straight, 1);
+  REQUIRE(!unpremultiplied->is_premultiplied_alpha());
+
+  for (uint32_t y = 0; y < height; y++) {
+    for (uint32_t x = 0; x < width; x++) {
+      if (sample(straight, x, y, 3) == max_value) {
+        for (int c = 0; c < 3; c++) {
+          REQUIRE(sample(unpremultiplied, x, y, c) == sample(straight, x, y, c));
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Transfer characteristics and primaries conversion", "[heif_image]")
+{
+  heif_color_conversion_options options{};
+  options.preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear;
+  options.only_use_preferred_chroma_algorithm = true;
+
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  auto create_rgb_image = [](uint32_t width, uint32_t height, int bpp, heif_transfer_characteristics transfer,
+                             heif_color_primaries primaries) {
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_RGB, heif_chroma_444);
+    for (heif_channel channel : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+      REQUIRE(!img->add_channel(channel, width, height, bpp, heif_get_disabled_security_limits()));
+    }
+
+    nclx_profile nclx = nclx_profile::defaults();
+    nclx.set_transfer_characteristics(transfer);
+    nclx.set_colour_primaries(primaries);
+    img->set_color_profile_nclx(nclx);
+    return img;
+  };
+
+  auto set_pixel = [](const std::shared_ptr<HeifPixelImage>& img, uint32_t x, uint32_t y, std::array<uint16_t, 3> rgb) {
+    int c = 0;
+    for (heif_channel channel : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+      size_t stride;
+      auto* p = reinterpret_cast<uint16_t*>(img->get_channel_memory(channel, &stride));
+      p[y * stride / 2 + x] = rgb[c++];
+    }
+  };
+
+  auto get_pixel = [](const std::shared_ptr<HeifPixelImage>& img, uint32_t x, uint32_t y) {
+    std::array<int, 3> rgb{};
+    int c = 0;
+    for (heif_channel channel : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+      size_t stride;
+      auto* p = reinterpret_cast<uint16_t*>(img->get_channel_memory(channel, &stride));
+      rgb[c++] = p[y * stride / 2 + x];
+    }
+    return rgb;
+  };
+
+  auto convert = [&](const std::shared_ptr<HeifPixelImage>& input, heif_transfer_characteristics transfer,
+                     heif_color_primaries primaries, bool convert_transfer_and_primaries, int num_threads = 1) {
+    nclx_profile target = nclx_profile::defaults();
+    target.set_transfer_characteristics(transfer);
+    target.set_colour_primaries(primaries);
+
+    options_ext->convert_transfer_and_primaries = convert_transfer_and_primaries;
+    auto result = convert_colorspace(input, heif_colorspace_RGB, heif_chroma_444, target,
+                                     input->get_bits_per_pixel(heif_channel_R), options, options_ext.get(),
+                                     heif_get_disabled_security_limits(), nullptr, nullptr, num_threads);
+    REQUIRE(result);
+    return *result;
+  };
+
+  SECTION("BT.2020 primaries to BT.709") {
+    // BT.709 red, green, blue and white in linear BT.2020
+    auto img = create_rgb_image(4, 1, 16, heif_transfer_characteristic_linear, heif_color_primaries_ITU_R_BT_2020_2_and_2100_0);
+    set_pixel(img, 0, 0, {41116, 4528, 1075});
+    set_pixel(img, 1, 0, {21581, 60259, 5767});
+    set_pixel(img, 2, 0, {2838, 747, 58693});
+    set_pixel(img, 3, 0, {65535, 65535, 65535});
+
+    // Only tagged with the output nclx by default.
+    auto tagged = convert(img, heif_transfer_characteristic_linear, heif_color_primaries_ITU_R_BT_709_5, false);
+    REQUIRE(tagged == img);
+
+    auto converted = convert(img, heif_transfer_characteristic_linear, heif_color_primaries_ITU_R_BT_709_5, true);
+    REQUIRE(converted->get_color_profile_nclx().get_colour_primaries() == heif_color_primaries_ITU_R_BT_709_5);
+
+    for (uint32_t x = 0; x < 4; x++) {
+      auto rgb = get_pixel(converted, x, 0);
+      INFO("x=" << x << " RGB=" << rgb[0] << ";" << rgb[1] << ";" << rgb[2]);
+      for (uint32_t c = 0; c < 3; c++) {
+        int expected = (c == x || x == 3) ? 65535 : 0;
+        REQUIRE(std::abs(rgb[c] - expected) <= 64);
+      }
+    }
+  }
+
+  SECTION("PQ to sRGB with tone mapping") {
+    const int bpp = 10;
+    const int max_value = (1 << bpp) - 1;
+
+    auto img = create_rgb_image(max_value + 1, 1, bpp, heif_transfer_characteristic_ITU_R_BT_2100_0_PQ,
+                                heif_color_primaries_ITU_R_BT_709_5);
+    for (uint16_t x = 0; x <= max_value; x++) {
+      set_pixel(img, x, 0, {x, x, x});
+    }
+
+    auto converted = convert(img, heif_transfer_characteristic_IEC_61966_2_1, heif_color_primaries_ITU_R_BT_709_5, true);
+    REQUIRE(converted->get_color_profile_nclx().get_transfer_characteristics() == heif_transfer_characteristic_IEC_61966_2_1);
+
+    auto pq_to_nits = [](double v) {
+      double p = std::pow(v, 4096.0 / (2523 * 128));
+      return 10000 * std::pow(std::max(p - 3424.0 / 4096, 0.0) / (2413.0 / 128 - 2392.0 / 128 * p), 16384.0 / 2610);
+    };
+
+    auto srgb_encode = [](double linear) {
+      return linear <= 0.0031308 ? 12.92 * linear : 1.055 * std::pow(linear, 1 / 2.4) - 0.055;
+    };
+
+    int previous = 0;
+    for (uint32_t x = 0; x <= max_value; x++) {
+      auto rgb = get_pixel(converted, x, 0);
+      INFO("PQ=" << x << " sRGB=" << rgb[0]);
+
+      // gray stays gray
+      REQUIRE(rgb[0] == rgb[1]);
+      REQUIRE(rgb[0] == rgb[2]);
+
+      REQUIRE(rgb[0] >= previous);
+      previous = rgb[0];
+
+      double nits = pq_to_nits(x / double(max_value));
+      if (nits <= 100) {
+        // Below the knee of the tone mapping curve, the luminance is kept (reference white at 203 cd/m^2).
+        REQUIRE(std::abs(rgb[0] - srgb_encode(nits / 203) * max_value) <= 1.0);
+      }
+      else if (nits >= 1000) {
+        // PQ content is assumed to be mastered at 1000 cd/m^2.
+        REQUIRE(rgb[0] == max_value);
+      }
+      else if (nits <= 500) {
+        REQUIRE(rgb[0] < max_value);
+      }
+    }
+
+    // Convert in stripes.
+    auto striped = convert(img, heif_transfer_characteristic_IEC_61966_2_1, heif_color_primaries_ITU_R_BT_709_5, true, 4);
+    assert_images_equal(converted, striped);
+  }
+
+  SECTION("HLG YCbCr 4:2:0 to 8-bit sRGB") {
+    const uint32_t width = 65;
+    const uint32_t height = 33;
+
+    nclx_profile nclx = nclx_profile::defaults();
+    nclx.set_matrix_coefficients(heif_matrix_coefficients_ITU_R_BT_2020_2_non_constant_luminance);
+    nclx.set_colour_primaries(heif_color_primaries_ITU_R_BT_2020_2_and_2100_0);
+    nclx.set_transfer_characteristics(heif_transfer_characteristic_ITU_R_BT_2100_0_HLG);
+
+    auto img = std::make_shared<HeifPixelImage>();
+    img->create(width, height, heif_colorspace_YCbCr, heif_chroma_420);
+    img->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(img, heif_channel_Y, width, height, 10, 1);
+    fill_plane_with_noise(img, heif_channel_Cb, (width + 1) / 2, (height + 1) / 2, 10, 2);
+    fill_plane_with_noise(img, heif_channel_Cr, (width + 1) / 2, (height + 1) / 2, 10, 3);
+
+    nclx_profile target;
+    target.set_sRGB_defaults();
+
+    options_ext->convert_transfer_and_primaries = true;
+    auto result = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_interleaved_RGB, target, 8,
+                                     options, options_ext.get(), heif_get_disabled_security_limits());
+    REQUIRE(result);
+    REQUIRE((*result)->get_chroma_format() == heif_chroma_interleaved_RGB);
+
+    options_ext->convert_transfer_and_primaries = false;
+    auto tagged = convert_colorspace(img, heif_colorspace_RGB, heif_chroma_interleaved_RGB, target, 8,
+                                     options, options_ext.get(), heif_get_disabled_security_limits());
+    REQUIRE(tagged);
+
+    size_t stride, tagged_stride;
+    const uint8_t* p = (*result)->get_channel_memory(heif_channel_interleaved, &stride);
+    const uint8_t* p_tagged = (*tagged)->get_channel_memory(heif_channel_interleaved, &tagged_stride);
+    REQUIRE(memcmp(p, p_tagged, width * 3) != 0);
+
+    options_ext->convert_transfer_and_primaries = true;
+
+    // There is no conversion path from monochrome to monochrome through RGB. The pixel values are kept.
+    auto mono = std::make_shared<HeifPixelImage>();
+    mono->create(width, height, heif_colorspace_monochrome, heif_chroma_monochrome);
+    mono->set_color_profile_nclx(nclx);
+    fill_plane_with_noise(mono, heif_channel_Y, width, height, 8, 4);
+
+    auto mono_result = convert_colorspace(mono, heif_colorspace_monochrome, heif_chroma_monochrome, target, 8,
+                                          options, options_ext.get(), heif_get_disabled_security_limits());
+    REQUIRE(mono_result);
+    REQUIRE(*mono_result == mono);
+  }
+}
+
+
+TEST_CASE("Color conversion cost calibration", "[heif_image]")
+{
+  std::unique_ptr<heif_color_conversion_options_ext, void(*)(heif_color_conversion_options_ext*)>
+      options_ext(heif_color_conversion_options_ext_alloc(), heif_color_conversion_options_ext_free);
+
+  heif_color_conversion_options options{};
+  options.preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear;
+  options.only_use_preferred_chroma_algorithm = true;
+
+  ColorState input_state(heif_colorspace_YCbCr, heif_chroma_420, false, 10);
+  nclx_default_if_undefined(input_state);
+  ColorState target_state(heif_colorspace_RGB, heif_chroma_interleaved_RGB, false, 8);
+
+  auto plan = [&]() {
+    ColorConversionPipeline pipeline;
+    REQUIRE(pipeline.construct_pipeline(input_state, target_state, options, *options_ext));
+    return pipeline.debug_dump_pipeline();
+  };
+
+  std::string static_plan = plan();
+
+  ColorConversionPipeline::calibrate_costs();
+  plan();
+
+  std::string table = ColorConversionPipeline::export_cost_calibration();
+  REQUIRE(table.rfind("libheif-color-conversion-costs\t", 0) == 0);
+  REQUIRE(std::count(table.begin(), table.end(), '\n') > 10);
+
+  // Export and import give the same table.
+  REQUIRE(!ColorConversionPipeline::import_cost_calibration(table));
+  REQUIRE(ColorConversionPipeline::export_cost_calibration() == table);
+
+  // Invalid tables are rejected and do not change the calibration.
+  REQUIRE(ColorConversionPipeline::import_cost_calibration("some text"));
+  REQUIRE(ColorConversionPipeline::import_cost_calibration(table.substr(0, table.find('\n')) + "\nnot-a-key\tx\n"));
+  REQUIRE(ColorConversionPipeline::export_cost_calibration() == table);
+
+  // Make the first operation of the static pipeline very expensive. The cached pipeline must not be reused.
+  std::string first_op = static_plan.substr(static_plan.find("> ") + 2);
+  first_op = first_op.substr(0, first_op.find('\n'));
+
+  std::istringstream lines(table);
+  std::string line;
+  std::getline(lines, line);
+  std::string expensive_table = line + "\n";
+  while (std::getline(lines, line)) {
+    if (line.rfind(first_op + "#", 0) == 0) {
+      expensive_table += line.substr(0, line.rfind('\t')) + "\t1000000\n";
+    }
+  }
+
+  REQUIRE(!ColorConversionPipeline::import_cost_calibration(expensive_table));
+  std::string expensive_plan = plan();
+  std::string expensive_export = ColorConversionPipeline::export_cost_calibration();
+  INFO("static: " << static_plan << "\nexpensive first operation: " << expensive_plan);
+  REQUIRE(expensive_plan.find("> " + first_op + "\n") == std::string::npos);
+
+  // Huge costs are limited such that the costs of the pipelines do not overflow.
+  std::string huge_table = expensive_table;
+  for (size_t pos = 0; (pos = huge_table.find("\t1000000\n", pos)) != std::string::npos; pos++) {
+    huge_table.replace(pos, 9, "\t2147483647\n");
+  }
+
+  REQUIRE(!ColorConversionPipeline::import_cost_calibration(huge_table));
+  REQUIRE(ColorConversionPipeline::export_cost_calibration() == expensive_export);
+  REQUIRE(plan() == expensive_plan);
+
+  // Back to the static costs.
+  ColorConversionPipeline::reset_cost_calibration();
+  REQUIRE(plan() == static_plan);
+}
@@ -29,9 +29,13 @@
 #include "libheif/heif_tiling.h"
 #include "test_utils.h"
 
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -485,3 +489,290 @@ TEST_CASE("grid encoding tile-by-tile - uncompressed YCbCr 4:2:0 (extract_area e
   heif_image_handle_release(rhandle);
   heif_context_free(rctx);
 }
+
+
+namespace {
+
+// Writes a grid of uncompressed tiles and returns the file data without its last byte,
+// such that the data of the last tile is incomplete.
+std::vector<uint8_t> write_grid_with_truncated_last_tile(const char* filename)
+{
+  heif_encoder* encoder = get_encoder_or_skip_test(heif_compression_uncompressed);
+  REQUIRE(encoder != nullptr);
+
+  heif_image* src = create_source_image_YCbCr_420();
+  REQUIRE(src != nullptr);
+
+  std::vector<heif_image*> tiles = extract_tiles(src);
+
+  heif_context* ctx = heif_context_alloc();
+  heif_image_handle* grid_handle = nullptr;
+  REQUIRE(heif_context_add_grid_image(ctx,
+                                      kCols * kTileSize, kRows * kTileSize,
+                                      kCols, kRows,
+                                      nullptr, &grid_handle).code == heif_error_Ok);
+
+  for (uint32_t ty = 0; ty < kRows; ++ty) {
+    for (uint32_t tx = 0; tx < kCols; ++tx) {
+      REQUIRE(heif_context_add_image_tile(ctx, grid_handle, tx, ty, tiles[ty * kCols + tx], encoder).code == heif_error_Ok);
+    }
+  }
+
+  std::string out_path = get_tests_output_file_path(filename);
+  REQUIRE(heif_context_write_to_file(ctx, out_path.c_str()).code == heif_error_Ok);
+
+  heif_image_handle_release(grid_handle);
+  for (heif_image* t : tiles) {
+    heif_image_release(t);
+  }
+  heif_encoder_release(encoder);
+  heif_context_free(ctx);
+  heif_image_release(src);
+
+  std::ifstream istr(out_path, std::ios::binary);
+  std::vector<uint8_t> file_data((std::istreambuf_iterator<char>(istr)), std::istreambuf_iterator<char>());
+  file_data.resize(file_data.size() - 1);
+  return file_data;
+}
+
+}  // namespace
+
+
+TEST_CASE("grid with missing tile - uncompressed YCbCr 4:2:0",
+          "[heif_context_add_image_tile]")
+{
+  // The grid canvas is not zero-initialized. Only the area of tiles that are missing
+  // (or failed to decode) is cleared when decoding in non-strict mode.
+  // We truncate the file such that the data of the last tile is incomplete.
+
+  constexpr uint32_t kMissingX = kCols - 1;
+  constexpr uint32_t kMissingY = kRows - 1;
+
+  std::vector<uint8_t> file_data = write_grid_with_truncated_last_tile("encode_grid_missing_tile.heif");
+
+  // --- decode the truncated file
+
+  heif_context* rctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_memory_without_copy(rctx, file_data.data(), file_data.size(), nullptr).code == heif_error_Ok);
+
+  heif_image_handle* rhandle = nullptr;
+  REQUIRE(heif_context_get_primary_image_handle(rctx, &rhandle).code == heif_error_Ok);
+
+  heif_image* dec = nullptr;
+  REQUIRE(heif_decode_image(rhandle, &dec,
+                            heif_colorspace_YCbCr, heif_chroma_420,
+                            nullptr).code == heif_error_Ok);
+  REQUIRE(dec != nullptr);
+
+  heif_error warning;
+  REQUIRE(heif_image_get_decoding_warnings(dec, 0, &warning, 1) == 1);
+  REQUIRE(warning.subcode == heif_suberror_End_of_data);
+
+  size_t stride_y = 0, stride_cb = 0;
+  const uint8_t* dec_y = heif_image_get_plane_readonly2(dec, heif_channel_Y, &stride_y);
+  const uint8_t* dec_cb = heif_image_get_plane_readonly2(dec, heif_channel_Cb, &stride_cb);
+
+  for (uint32_t y = 0; y < kSourceHeight; y += 7) {
+    for (uint32_t x = 0; x < kSourceWidth; x += 7) {
+      bool in_missing_tile = (x / kTileSize == kMissingX && y / kTileSize == kMissingY);
+      uint8_t expected_Y = in_missing_tile ? 0 : static_cast<uint8_t>(30u + x * 200u / kSourceWidth);
+      uint8_t expected_Cb = in_missing_tile ? 0 : 80u;
+
+      INFO("at (" << x << "," << y << ")");
+      REQUIRE(dec_y[y * stride_y + x] == expected_Y);
+      REQUIRE(dec_cb[y / 2 * stride_cb + x / 2] == expected_Cb);
+    }
+  }
+
+  heif_image_release(dec);
+  heif_image_handle_release(rhandle);
+  heif_context_free(rctx);
+}
+
+
+namespace {
+
+struct GridProgress
+{
+  std::thread::id caller;
+  int max_progress = 0;
+  std::atomic<int> num_start{0}, num_end{0}, num_total_reached{0}, num_regressions{0}, num_foreign_calls{0};
+  int last_progress = -1;
+
+  void check_thread()
+  {
+    if (std::this_thread::get_id() != caller) {
+      num_foreign_calls++;
+    }
+  }
+};
+
+}  // namespace
+
+
+TEST_CASE("grid decoding reports the progress and the warnings once - uncompressed",
+          "[heif_decode_image]")
+{
+  std::vector<uint8_t> file_data = write_grid_with_truncated_last_tile("encode_grid_progress.heif");
+
+  heif_context* rctx = heif_context_alloc();
+  heif_context_set_max_decoding_threads(rctx, GENERATE(0, 1, 4));
+  REQUIRE(heif_context_read_from_memory_without_copy(rctx, file_data.data(), file_data.size(), nullptr).code == heif_error_Ok);
+
+  heif_image_handle* rhandle = nullptr;
+  REQUIRE(heif_context_get_primary_image_handle(rctx, &rhandle).code == heif_error_Ok);
+
+  GridProgress progress;
+  progress.caller = std::this_thread::get_id();
+
+  heif_decoding_options* options = heif_decoding_options_alloc();
+  options->progress_user_data = &progress;
+  options->start_progress = [](heif_progress_step step, int max_progress, void* user_data) {
+    auto* p = static_cast<GridProgress*>(user_data);
+    p->check_thread();
+    if (step == heif_progress_step_total) {
+      p->num_start++;
+      p->max_progress = max_progress;
+    }
+  };
+  options->on_progress = [](heif_progress_step step, int progress, void* user_data) {
+    auto* p = static_cast<GridProgress*>(user_data);
+    p->check_thread();
+    if (step == heif_progress_step_total) {
+      if (progress < p->last_progress) {
+        p->num_regressions++;
+      }
+      p->last_progress = progress;
+      if (progress == p->max_progress) {
+        p->num_total_reached++;
+      }
+    }
+  };
+  options->end_progress = [](heif_progress_step step, void* user_data) {
+    auto* p = static_cast<GridProgress*>(user_data);
+    p->check_thread();
+    if (step == heif_progress_step_total) {
+      p->num_end++;
+    }
+  };
+
+  heif_image* dec = nullptr;
+  REQUIRE(heif_decode_image(rhandle, &dec,
+                            heif_colorspace_YCbCr, heif_chroma_420,
+                            options).code == heif_error_Ok);
+  REQUIRE(dec != nullptr);
+
+  REQUIRE(heif_image_get_decoding_warnings(dec, 0, nullptr, 0) == 1);
+
+  REQUIRE(progress.num_start == 1);
+  REQUIRE(progress.max_progress == kRows * kCols);
+  REQUIRE(progress.num_total_reached == 1);
+  REQUIRE(progress.num_regressions == 0);
+  REQUIRE(progress.num_end == 1);
+  REQUIRE(progress.num_foreign_calls == 0);
+
+  heif_decoding_options_free(options);
+  heif_image_release(dec);
+  heif_image_handle_release(rhandle);
+  heif_context_free(rctx);
+}
+
+
+namespace {
+
+// Tiles of the same grid image are decoded from several threads at once.
+// Each thread must get the same result as a single-threaded decode.
+void run_concurrent_tile_decoding(heif_compression_format format)
+{
+  heif_encoder* encoder = get_encoder_or_skip_test(format);
+  REQUIRE(encoder != nullptr);
+
+  heif_image* src = create_source_image();
+  std::vector<heif_image*> tiles = extract_tiles(src);
+
+  heif_context* ctx = heif_context_alloc();
+  heif_image_handle* grid_handle = nullptr;
+  REQUIRE(heif_context_encode_grid(ctx, tiles.data(), kRows, kCols,
+                                   encoder, nullptr, &grid_handle).code == heif_error_Ok);
+
+  std::string out_path = get_tests_output_file_path("encode_grid_concurrent_tiles.heif");
+  REQUIRE(heif_context_write_to_file(ctx, out_path.c_str()).code == heif_error_Ok);
+
+  heif_image_handle_release(grid_handle);
+  for (heif_image* t : tiles) {
+    heif_image_release(t);
+  }
+  heif_encoder_release(encoder);
+  heif_context_free(ctx);
+  heif_image_release(src);
+
+  heif_context* rctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_file(rctx, out_path.c_str(), nullptr).code == heif_error_Ok);
+
+  heif_image_handle* rhandle = nullptr;
+  REQUIRE(heif_context_get_primary_image_handle(rctx, &rhandle).code == heif_error_Ok);
+
+  auto decode_tile = [rhandle](uint32_t tx, uint32_t ty) {
+    heif_image* img = nullptr;
+    heif_error err = heif_image_handle_decode_image_tile(rhandle, &img,
+                                                         heif_colorspace_RGB, heif_chroma_interleaved_RGB,
+                                                         nullptr, tx, ty);
+    std::vector<uint8_t> pixels;
+    if (err.code != heif_error_Ok) {
+      return pixels;
+    }
+
+    size_t stride = 0;
+    const uint8_t* p = heif_image_get_plane_readonly2(img, heif_channel_interleaved, &stride);
+    int h = heif_image_get_height(img, heif_channel_interleaved);
+    pixels.assign(p, p + stride * h);
+    heif_image_release(img);
+    return pixels;
+  };
+
+  std::vector<std::vector<uint8_t>> reference;
+  for (uint32_t i = 0; i < kRows * kCols; i++) {
+    reference.push_back(decode_tile(i % kCols, i / kCols));
+    REQUIRE(!reference.back().empty());
+  }
+
+  constexpr int kNumThreads = 4;
+  std::vector<std::thread> threads;
+  std::atomic<int> num_mismatches{0};
+
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (uint32_t n = 0; n < kRows * kCols; n++) {
+        uint32_t i = (n + t * 3) % (kRows * kCols);
+        if (decode_tile(i % kCols, i / kCols) != reference[i]) {
+          num_mismatches++;
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(num_mismatches == 0);
+
+  heif_image_handle_release(rhandle);
+  heif_context_free(rctx);
+}
+
+}  // namespace
+
+
+TEST_CASE("concurrent tile decoding - uncompressed",
+          "[heif_image_handle_decode_image_tile]")
+{
+  run_concurrent_tile_decoding(heif_compression_uncompressed);
+}
+
+
+TEST_CASE("concurrent tile decoding - HEVC",
+          "[heif_image_handle_decode_image_tile]")
+{
+  run_concurrent_tile_decoding(heif_compression_HEVC);
+}
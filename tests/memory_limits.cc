@@ -0,0 +1,140 @@
+/*
+  libheif unit tests for the total memory limit of a heif_context.
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "catch_amalgamated.hpp"
+#include "libheif/heif.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// A 256x256 8-bit plane is allocated with 16 bytes of alignment slack.
+constexpr size_t cPlaneSize = 256 * 256 + 15;
+
+
+heif_image* create_image(const heif_security_limits* limits)
+{
+  heif_image* img = nullptr;
+  REQUIRE(heif_image_create(256, 256, heif_colorspace_monochrome, heif_chroma_monochrome, &img).code == heif_error_Ok);
+
+  heif_error err = heif_image_add_plane_safe(img, heif_channel_Y, 256, 256, 8, limits);
+  if (err.code != heif_error_Ok) {
+    REQUIRE(err.code == heif_error_Memory_allocation_error);
+    REQUIRE(err.subcode == heif_suberror_Security_limit_exceeded);
+    heif_image_release(img);
+    return nullptr;
+  }
+
+  return img;
+}
+
+}
+
+
+TEST_CASE("total memory limit with concurrent allocations")
+{
+  constexpr int cNumThreads = 4;
+  constexpr int cImagesPerThread = 50;
+  constexpr int cMaxImages = 100;
+
+  heif_context* ctx = heif_context_alloc();
+  heif_security_limits* limits = heif_context_get_security_limits(ctx);
+  limits->max_total_memory = cMaxImages * cPlaneSize;
+
+  std::vector<std::vector<heif_image*>> images(cNumThreads);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < cNumThreads; t++) {
+    threads.emplace_back([t, limits, &images]() {
+      for (int i = 0; i < cImagesPerThread; i++) {
+        if (heif_image* img = create_image(limits)) {
+          images[t].push_back(img);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  size_t num_images = 0;
+  for (const auto& thread_images : images) {
+    num_images += thread_images.size();
+  }
+
+  // exactly as many images as fit into the limit
+
+  REQUIRE(num_images == cMaxImages);
+
+  // after releasing one image, there is space for exactly one more
+
+  heif_image_release(images[0].back());
+  images[0].pop_back();
+
+  heif_image* img = create_image(limits);
+  REQUIRE(img != nullptr);
+  REQUIRE(create_image(limits) == nullptr);
+  heif_image_release(img);
+
+  // Images may outlive their context.
+
+  heif_context_free(ctx);
+
+  for (const auto& thread_images : images) {
+    for (heif_image* thread_image : thread_images) {
+      heif_image_release(thread_image);
+    }
+  }
+}
+
+
+TEST_CASE("copies of the context security limits")
+{
+  heif_context* ctx = heif_context_alloc();
+
+  // A copy of the limits is not registered: only the limits that apply to single allocations are checked.
+  heif_security_limits copy = *heif_context_get_security_limits(ctx);
+  copy.max_total_memory = cPlaneSize;
+
+  heif_image* img1 = create_image(&copy);
+  heif_image* img2 = create_image(&copy);
+  REQUIRE(img1 != nullptr);
+  REQUIRE(img2 != nullptr);
+
+  // The copy can still be used after its context has been freed.
+
+  heif_context_free(ctx);
+
+  heif_image* img3 = create_image(&copy);
+  REQUIRE(img3 != nullptr);
+
+  heif_image_release(img1);
+  heif_image_release(img2);
+  heif_image_release(img3);
+}
@@ -0,0 +1,430 @@
+/*
+  libheif unit tests for overlay ('iovl') compositing.
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "catch_amalgamated.hpp"
+#include "libheif/heif.h"
+#include "image/pixelimage.h"
+#include "test_utils.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const heif_channel cRGB[] = {heif_channel_R, heif_channel_G, heif_channel_B};
+
+
+template<typename T>
+void fill_pattern(HeifPixelImage& img, heif_channel channel, uint32_t seed, uint32_t max_value)
+{
+  size_t stride;
+  T* p = img.get_channel_memory<T>(channel, &stride);
+  stride /= sizeof(T);
+
+  for (uint32_t y = 0; y < img.get_height(channel); y++)
+    for (uint32_t x = 0; x < img.get_width(channel); x++) {
+      p[y * stride + x] = static_cast<T>((x * 7 + y * 13 + seed * 31) % (max_value + 1));
+    }
+}
+
+
+template<typename T>
+std::shared_ptr<HeifPixelImage> create_rgb(uint32_t w, uint32_t h, int bpp, bool with_alpha, uint32_t seed)
+{
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(w, h, heif_colorspace_RGB, heif_chroma_444);
+
+  uint32_t max_value = (1U << bpp) - 1;
+
+  for (heif_channel c : cRGB) {
+    REQUIRE(!img->add_channel(c, w, h, bpp, heif_get_global_security_limits()));
+    fill_pattern<T>(*img, c, seed + c, max_value);
+  }
+
+  if (with_alpha) {
+    REQUIRE(!img->add_channel(heif_channel_Alpha, w, h, bpp, heif_get_global_security_limits()));
+    fill_pattern<T>(*img, heif_channel_Alpha, seed * 3, max_value);
+  }
+
+  return img;
+}
+
+
+template<typename T>
+T pixel(const std::shared_ptr<HeifPixelImage>& img, heif_channel c, uint32_t x, uint32_t y)
+{
+  size_t stride;
+  const T* p = img->get_channel_memory<T>(c, &stride);
+  return p[y * (stride / sizeof(T)) + x];
+}
+
+}
+
+
+TEST_CASE("overlay 8 bit opaque with clipping")
+{
+  auto canvas = create_rgb<uint8_t>(20, 16, 8, false, 1);
+  auto reference = create_rgb<uint8_t>(20, 16, 8, false, 1);
+  auto layer = create_rgb<uint8_t>(10, 9, 8, false, 2);
+
+  // layer sticks out at the top-left corner
+
+  REQUIRE(!canvas->overlay(layer, -3, -4));
+
+  for (heif_channel c : cRGB)
+    for (uint32_t y = 0; y < 16; y++)
+      for (uint32_t x = 0; x < 20; x++) {
+        bool inside = (x < 7 && y < 5);
+        uint8_t expected = inside ? pixel<uint8_t>(layer, c, x + 3, y + 4) : pixel<uint8_t>(reference, c, x, y);
+        REQUIRE(pixel<uint8_t>(canvas, c, x, y) == expected);
+      }
+}
+
+
+TEST_CASE("overlay 8 bit with alpha")
+{
+  auto canvas = create_rgb<uint8_t>(37, 11, 8, false, 1);
+  auto reference = create_rgb<uint8_t>(37, 11, 8, false, 1);
+  auto layer = create_rgb<uint8_t>(40, 8, 8, true, 5);
+
+  REQUIRE(!canvas->overlay(layer, 2, 3));
+
+  for (heif_channel c : cRGB)
+    for (uint32_t y = 0; y < 11; y++)
+      for (uint32_t x = 0; x < 37; x++) {
+        uint8_t expected = pixel<uint8_t>(reference, c, x, y);
+        if (x >= 2 && y >= 3) {
+          uint32_t in = pixel<uint8_t>(layer, c, x - 2, y - 3);
+          uint32_t a = pixel<uint8_t>(layer, heif_channel_Alpha, x - 2, y - 3);
+          expected = static_cast<uint8_t>((in * a + expected * (255 - a)) / 255);
+        }
+        REQUIRE(pixel<uint8_t>(canvas, c, x, y) == expected);
+      }
+}
+
+
+TEST_CASE("overlay 16 bit with alpha")
+{
+  auto canvas = create_rgb<uint16_t>(33, 10, 12, false, 1);
+  auto reference = create_rgb<uint16_t>(33, 10, 12, false, 1);
+  auto layer = create_rgb<uint16_t>(30, 12, 12, true, 9);
+
+  REQUIRE(!canvas->overlay(layer, 5, -2));
+
+  for (heif_channel c : cRGB)
+    for (uint32_t y = 0; y < 10; y++)
+      for (uint32_t x = 0; x < 33; x++) {
+        double expected = pixel<uint16_t>(reference, c, x, y);
+        if (x >= 5) {
+          double in = pixel<uint16_t>(layer, c, x - 5, y + 2);
+          double a = pixel<uint16_t>(layer, heif_channel_Alpha, x - 5, y + 2) / 4095.0;
+          expected = in * a + expected * (1 - a);
+        }
+        REQUIRE(pixel<uint16_t>(canvas, c, x, y) == Catch::Approx(expected).margin(1.0));
+      }
+}
+
+
+TEST_CASE("overlay with mismatching bit depths")
+{
+  auto canvas = create_rgb<uint8_t>(8, 8, 8, false, 1);
+  auto layer = create_rgb<uint16_t>(8, 8, 10, false, 2);
+
+  Error err = canvas->overlay(layer, 0, 0);
+  REQUIRE(err.error_code == heif_error_Unsupported_feature);
+}
+
+
+TEST_CASE("overlay decoding calls the user callbacks from the calling thread only")
+{
+  if (!heif_have_encoder_for_format(heif_compression_uncompressed) ||
+      !heif_have_decoder_for_format(heif_compression_uncompressed)) {
+    SKIP("Skipping because uncompressed codec is not compiled.");
+  }
+
+  constexpr uint32_t cSize = 64;
+  constexpr int cNumLayers = 8;
+
+  heif_context* ctx = heif_context_alloc();
+  heif_encoder* encoder = nullptr;
+  REQUIRE(heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder).code == heif_error_Ok);
+
+  std::vector<heif_item_id> ids;
+  std::vector<int32_t> offsets;
+
+  for (int i = 0; i < cNumLayers; i++) {
+    heif_image* img = nullptr;
+    REQUIRE(heif_image_create(cSize, cSize, heif_colorspace_RGB, heif_chroma_444, &img).code == heif_error_Ok);
+    for (heif_channel c : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+      REQUIRE(heif_image_add_plane(img, c, cSize, cSize, 8).code == heif_error_Ok);
+    }
+
+    heif_image_handle* handle = nullptr;
+    REQUIRE(heif_context_encode_image(ctx, img, encoder, nullptr, &handle).code == heif_error_Ok);
+    ids.push_back(heif_image_handle_get_item_id(handle));
+    offsets.push_back(i * 8);
+    offsets.push_back(i * 4);
+
+    heif_image_handle_release(handle);
+    heif_image_release(img);
+  }
+
+  heif_encoder_release(encoder);
+
+  heif_image_handle* iovl = nullptr;
+  REQUIRE(heif_context_add_overlay_image(ctx, 2 * cSize, 2 * cSize, cNumLayers, ids.data(), offsets.data(), nullptr, &iovl).code == heif_error_Ok);
+  REQUIRE(heif_context_set_primary_image(ctx, iovl).code == heif_error_Ok);
+  heif_image_handle_release(iovl);
+
+  std::string out_path = get_tests_output_file_path("overlay_callback_threads.heif");
+  REQUIRE(heif_context_write_to_file(ctx, out_path.c_str()).code == heif_error_Ok);
+  heif_context_free(ctx);
+
+  ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_file(ctx, out_path.c_str(), nullptr).code == heif_error_Ok);
+  REQUIRE(heif_context_get_primary_image_handle(ctx, &iovl).code == heif_error_Ok);
+  heif_context_set_max_decoding_threads(ctx, 4);
+
+  struct CallbackState
+  {
+    std::thread::id calling_thread = std::this_thread::get_id();
+    std::atomic<bool> called_from_other_thread{false};
+    bool cancel = false;
+  } state;
+
+  heif_decoding_options* options = heif_decoding_options_alloc();
+  options->progress_user_data = &state;
+  options->cancel_decoding = [](void* user_data) {
+    auto* s = static_cast<CallbackState*>(user_data);
+    if (std::this_thread::get_id() != s->calling_thread) {
+      s->called_from_other_thread = true;
+    }
+    return s->cancel ? 1 : 0;
+  };
+
+  heif_image* out = nullptr;
+  heif_error err = heif_decode_image(iovl, &out, heif_colorspace_RGB, heif_chroma_interleaved_RGB, options);
+  REQUIRE(err.code == heif_error_Ok);
+  heif_image_release(out);
+
+  state.cancel = true;
+  out = nullptr;
+  err = heif_decode_image(iovl, &out, heif_colorspace_RGB, heif_chroma_interleaved_RGB, options);
+  REQUIRE(err.code == heif_error_Canceled);
+  REQUIRE(out == nullptr);
+
+  REQUIRE(!state.called_from_other_thread);
+
+  heif_decoding_options_free(options);
+  heif_image_handle_release(iovl);
+  heif_context_free(ctx);
+}
+
+
+TEST_CASE("overlay image is composited at the bit depth of its layers")
+{
+  if (!heif_have_encoder_for_format(heif_compression_uncompressed) ||
+      !heif_have_decoder_for_format(heif_compression_uncompressed)) {
+    SKIP("Skipping because uncompressed codec is not compiled.");
+  }
+
+  constexpr uint32_t cSize = 16;
+  constexpr int cBpp = 10;
+  constexpr uint16_t cMax = (1 << cBpp) - 1;
+
+  auto layer_value = [](heif_channel c, uint32_t x, uint32_t y) {
+    return static_cast<uint16_t>((x * 61 + y * 17 + c * 300) % (cMax + 1));
+  };
+
+  heif_context* ctx = heif_context_alloc();
+  heif_encoder* encoder = nullptr;
+  REQUIRE(heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder).code == heif_error_Ok);
+
+  std::vector<heif_item_id> ids;
+
+  for (bool with_alpha : {false, true}) {
+    heif_image* img = nullptr;
+    REQUIRE(heif_image_create(cSize, cSize, heif_colorspace_RGB, heif_chroma_444, &img).code == heif_error_Ok);
+    for (heif_channel c : {heif_channel_R, heif_channel_G, heif_channel_B, heif_channel_Alpha}) {
+      if (c == heif_channel_Alpha && !with_alpha) {
+        continue;
+      }
+
+      REQUIRE(heif_image_add_plane(img, c, cSize, cSize, cBpp).code == heif_error_Ok);
+
+      size_t stride;
+      uint8_t* p = heif_image_get_plane2(img, c, &stride);
+      for (uint32_t y = 0; y < cSize; y++) {
+        for (uint32_t x = 0; x < cSize; x++) {
+          // half transparent alpha
+          uint16_t v = (c == heif_channel_Alpha) ? (cMax + 1) / 2 : layer_value(c, x, y);
+          reinterpret_cast<uint16_t*>(p + y * stride)[x] = v;
+        }
+      }
+    }
+
+    heif_image_handle* handle = nullptr;
+    REQUIRE(heif_context_encode_image(ctx, img, encoder, nullptr, &handle).code == heif_error_Ok);
+    ids.push_back(heif_image_handle_get_item_id(handle));
+
+    heif_image_handle_release(handle);
+    heif_image_release(img);
+  }
+
+  heif_encoder_release(encoder);
+
+  // The second (half transparent) layer covers the right half of the first layer and the black background.
+  int32_t offsets[] = {0, 0, cSize / 2, 0};
+  const uint16_t background[4] = {0, 0, 0, 0xFFFF};
+
+  heif_image_handle* iovl = nullptr;
+  REQUIRE(heif_context_add_overlay_image(ctx, 2 * cSize, cSize, 2, ids.data(), offsets, background, &iovl).code == heif_error_Ok);
+  REQUIRE(heif_context_set_primary_image(ctx, iovl).code == heif_error_Ok);
+  heif_image_handle_release(iovl);
+
+  std::string out_path = get_tests_output_file_path("overlay_10bit.heif");
+  REQUIRE(heif_context_write_to_file(ctx, out_path.c_str()).code == heif_error_Ok);
+  heif_context_free(ctx);
+
+  ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_file(ctx, out_path.c_str(), nullptr).code == heif_error_Ok);
+  REQUIRE(heif_context_get_primary_image_handle(ctx, &iovl).code == heif_error_Ok);
+
+  heif_image* out = nullptr;
+  REQUIRE(heif_decode_image(iovl, &out, heif_colorspace_RGB, heif_chroma_444, nullptr).code == heif_error_Ok);
+  REQUIRE(heif_image_get_bits_per_pixel_range(out, heif_channel_R) == cBpp);
+
+  for (heif_channel c : {heif_channel_R, heif_channel_G, heif_channel_B}) {
+    size_t stride;
+    const uint8_t* p = heif_image_get_plane_readonly2(out, c, &stride);
+
+    for (uint32_t y = 0; y < cSize; y++) {
+      for (uint32_t x = 0; x < 2 * cSize; x++) {
+        double below = (x < cSize) ? layer_value(c, x, y) : 0;
+        double expected = below;
+        if (x >= cSize / 2 && x < cSize / 2 + cSize) {
+          double a = ((cMax + 1) / 2) / static_cast<double>(cMax);
+          expected = layer_value(c, x - cSize / 2, y) * a + below * (1 - a);
+        }
+
+        INFO("channel " << c << ", x " << x << ", y " << y);
+        REQUIRE(reinterpret_cast<const uint16_t*>(p + y * stride)[x] == Catch::Approx(expected).margin(1.0));
+      }
+    }
+  }
+
+  heif_image_release(out);
+  heif_image_handle_release(iovl);
+  heif_context_free(ctx);
+}
+
+
+// Not run by default. Start with: ./overlay "[benchmark]"
+TEST_CASE("overlay 32 layers", "[.][benchmark]")
+{
+  constexpr uint32_t cSize = 1024;
+  constexpr int cNumLayers = 32;
+
+  std::vector<std::shared_ptr<HeifPixelImage>> layers;
+  for (int i = 0; i < cNumLayers; i++) {
+    layers.push_back(create_rgb<uint8_t>(cSize / 2, cSize / 2, 8, true, i));
+  }
+
+  auto canvas = create_rgb<uint8_t>(cSize, cSize, 8, false, 0);
+
+  BENCHMARK("composite 32 layers") {
+    for (int i = 0; i < cNumLayers; i++) {
+      (void) canvas->overlay(layers[i], (i * 37) % (cSize / 2), (i * 53) % (cSize / 2));
+    }
+    return canvas->get_width();
+  };
+
+
+  // --- decode an 'iovl' image with 32 layers, serially and with multiple threads
+
+  if (!heif_have_encoder_for_format(heif_compression_uncompressed) ||
+      !heif_have_decoder_for_format(heif_compression_uncompressed)) {
+    SKIP("Skipping decoding benchmark because uncompressed codec is not compiled.");
+  }
+
+  heif_context* ctx = heif_context_alloc();
+  heif_encoder* encoder = nullptr;
+  REQUIRE(heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder).code == heif_error_Ok);
+
+  std::vector<heif_item_id> ids;
+  std::vector<int32_t> offsets;
+
+  for (int i = 0; i < cNumLayers; i++) {
+    heif_image* img = nullptr;
+    REQUIRE(heif_image_create(cSize / 2, cSize / 2, heif_colorspace_RGB, heif_chroma_444, &img).code == heif_error_Ok);
+    for (heif_channel c : {heif_channel_R, heif_channel_G, heif_channel_B, heif_channel_Alpha}) {
+      REQUIRE(heif_image_add_plane(img, c, cSize / 2, cSize / 2, 8).code == heif_error_Ok);
+    }
+
+    heif_image_handle* handle = nullptr;
+    REQUIRE(heif_context_encode_image(ctx, img, encoder, nullptr, &handle).code == heif_error_Ok);
+    ids.push_back(heif_image_handle_get_item_id(handle));
+    offsets.push_back((i * 37) % (cSize / 2));
+    offsets.push_back((i * 53) % (cSize / 2));
+
+    heif_image_handle_release(handle);
+    heif_image_release(img);
+  }
+
+  heif_encoder_release(encoder);
+
+  heif_image_handle* iovl = nullptr;
+  REQUIRE(heif_context_add_overlay_image(ctx, cSize, cSize, cNumLayers, ids.data(), offsets.data(), nullptr, &iovl).code == heif_error_Ok);
+  REQUIRE(heif_context_set_primary_image(ctx, iovl).code == heif_error_Ok);
+  heif_image_handle_release(iovl);
+
+  std::string out_path = get_tests_output_file_path("overlay_32_layers.heif");
+  REQUIRE(heif_context_write_to_file(ctx, out_path.c_str()).code == heif_error_Ok);
+  heif_context_free(ctx);
+
+  ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_file(ctx, out_path.c_str(), nullptr).code == heif_error_Ok);
+  REQUIRE(heif_context_get_primary_image_handle(ctx, &iovl).code == heif_error_Ok);
+
+  for (int threads : {0, 4}) {
+    heif_context_set_max_decoding_threads(ctx, threads);
+
+    BENCHMARK("decode 32 layers, max_decoding_threads=" + std::to_string(threads)) {
+      heif_image* out = nullptr;
+      heif_error err = heif_decode_image(iovl, &out, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr);
+      REQUIRE(err.code == heif_error_Ok);
+      heif_image_release(out);
+      return err.code;
+    };
+  }
+
+  heif_image_handle_release(iovl);
+  heif_context_free(ctx);
+}
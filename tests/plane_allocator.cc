@@ -0,0 +1,174 @@
+/*
+  libheif unit tests for the image memory allocator and plane buffer pool.
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "catch_amalgamated.hpp"
+#include "libheif/heif.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+struct AllocationCounter
+{
+  int num_allocs = 0;
+  int num_frees = 0;
+  size_t bytes_in_use = 0;
+};
+
+
+void* counting_alloc(void* user_data, size_t size)
+{
+  auto* counter = static_cast<AllocationCounter*>(user_data);
+  counter->num_allocs++;
+  counter->bytes_in_use += size;
+
+  // fill with garbage to check that libheif clears the memory
+  void* mem = malloc(size);
+  memset(mem, 0x5A, size);
+  return mem;
+}
+
+
+void counting_free(void* user_data, void* mem, size_t size)
+{
+  auto* counter = static_cast<AllocationCounter*>(user_data);
+  counter->num_frees++;
+  counter->bytes_in_use -= size;
+
+  free(mem);
+}
+
+
+heif_image* create_image(int width, int height)
+{
+  heif_image* img = nullptr;
+  REQUIRE(heif_image_create(width, height, heif_colorspace_YCbCr, heif_chroma_420, &img).code == heif_error_Ok);
+  REQUIRE(heif_image_add_plane(img, heif_channel_Y, width, height, 8).code == heif_error_Ok);
+  REQUIRE(heif_image_add_plane(img, heif_channel_Cb, (width + 1) / 2, (height + 1) / 2, 8).code == heif_error_Ok);
+  REQUIRE(heif_image_add_plane(img, heif_channel_Cr, (width + 1) / 2, (height + 1) / 2, 8).code == heif_error_Ok);
+  return img;
+}
+
+
+bool plane_is_zero(const heif_image* img, heif_channel channel)
+{
+  size_t stride;
+  const uint8_t* p = heif_image_get_plane_readonly2(img, channel, &stride);
+  int w = heif_image_get_width(img, channel);
+  int h = heif_image_get_height(img, channel);
+
+  for (int y = 0; y < h; y++)
+    for (int x = 0; x < w; x++) {
+      if (p[y * stride + x] != 0) {
+        return false;
+      }
+    }
+
+  return true;
+}
+
+}
+
+
+TEST_CASE("user allocator")
+{
+  AllocationCounter counter;
+
+  heif_allocator allocator{};
+  allocator.version = 1;
+  allocator.alloc = counting_alloc;
+  allocator.free = counting_free;
+  allocator.user_data = &counter;
+
+  REQUIRE(heif_set_allocator(&allocator).code == heif_error_Ok);
+
+  heif_image* img = create_image(300, 200);
+  REQUIRE(counter.num_allocs == 3);
+  REQUIRE(counter.num_frees == 0);
+  REQUIRE(plane_is_zero(img, heif_channel_Y));
+  REQUIRE(plane_is_zero(img, heif_channel_Cb));
+
+  heif_image_release(img);
+  REQUIRE(counter.num_frees == 3);
+  REQUIRE(counter.bytes_in_use == 0);
+
+  REQUIRE(heif_set_allocator(nullptr).code == heif_error_Ok);
+
+  allocator.free = nullptr;
+  REQUIRE(heif_set_allocator(&allocator).code == heif_error_Usage_error);
+}
+
+
+TEST_CASE("plane buffer pool")
+{
+  AllocationCounter counter;
+
+  heif_allocator allocator{};
+  allocator.version = 1;
+  allocator.alloc = counting_alloc;
+  allocator.free = counting_free;
+  allocator.user_data = &counter;
+
+  REQUIRE(heif_set_allocator(&allocator).code == heif_error_Ok);
+  heif_set_plane_buffer_pool_size(16 * 1024 * 1024);
+
+  heif_image* img = create_image(640, 480);
+  REQUIRE(counter.num_allocs == 3);
+
+  // write into the planes so that we can check that they are cleared when they are reused
+
+  size_t stride;
+  uint8_t* p = heif_image_get_plane2(img, heif_channel_Y, &stride);
+  memset(p, 0xFF, stride * 480);
+
+  heif_image_release(img);
+  REQUIRE(counter.num_frees == 0);
+
+  // An image of the same size and one that is slightly smaller fall into the same size classes.
+
+  for (int width : {640, 632}) {
+    img = create_image(width, 480);
+    REQUIRE(counter.num_allocs == 3);
+    REQUIRE(plane_is_zero(img, heif_channel_Y));
+    heif_image_release(img);
+  }
+
+  // a much larger image needs new memory
+
+  img = create_image(1920, 1080);
+  REQUIRE(counter.num_allocs == 6);
+  heif_image_release(img);
+
+  // disabling the pool releases all pooled memory
+
+  heif_set_plane_buffer_pool_size(0);
+  REQUIRE(counter.num_frees == counter.num_allocs);
+  REQUIRE(counter.bytes_in_use == 0);
+
+  REQUIRE(heif_set_allocator(nullptr).code == heif_error_Ok);
+}
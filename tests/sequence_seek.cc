@@ -0,0 +1,371 @@
+/*
+  libheif unit tests for random access in sequence tracks.
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "catch_amalgamated.hpp"
+#include "libheif/heif.h"
+#include "libheif/heif_sequences.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t cNumSamples = 50;
+constexpr uint32_t cSampleDuration = 100;
+
+heif_error mem_writer(heif_context*, const void* data, size_t size, void* userdata)
+{
+  auto* out = static_cast<std::vector<uint8_t>*>(userdata);
+  const auto* p = static_cast<const uint8_t*>(data);
+  out->insert(out->end(), p, p + size);
+  return heif_error{heif_error_Ok, heif_suberror_Unspecified, nullptr};
+}
+
+
+// Write a metadata track in which each sample contains its own index as a single byte.
+std::vector<uint8_t> create_metadata_sequence()
+{
+  heif_context* ctx = heif_context_alloc();
+  heif_context_set_sequence_timescale(ctx, 1000);
+
+  heif_track_options* options = heif_track_options_alloc();
+  heif_track_options_set_timescale(options, 1000);
+
+  heif_track* track = nullptr;
+  REQUIRE(heif_context_add_uri_metadata_sequence_track(ctx, "urn:libheif:test", options, &track).code == heif_error_Ok);
+  heif_track_options_release(options);
+
+  for (uint32_t i = 0; i < cNumSamples; i++) {
+    uint8_t data = static_cast<uint8_t>(i);
+
+    heif_raw_sequence_sample* sample = heif_raw_sequence_sample_alloc();
+    REQUIRE(heif_raw_sequence_sample_set_data(sample, &data, 1).code == heif_error_Ok);
+    heif_raw_sequence_sample_set_duration(sample, cSampleDuration);
+    REQUIRE(heif_track_add_raw_sequence_sample(track, sample).code == heif_error_Ok);
+    heif_raw_sequence_sample_release(sample);
+  }
+
+  heif_track_release(track);
+
+  std::vector<uint8_t> file;
+  heif_writer writer{};
+  writer.writer_api_version = 1;
+  writer.write = mem_writer;
+  REQUIRE(heif_context_write(ctx, &writer, &file).code == heif_error_Ok);
+
+  heif_context_free(ctx);
+
+  return file;
+}
+
+
+uint8_t read_next_sample_value(heif_track* track)
+{
+  heif_raw_sequence_sample* sample = nullptr;
+  REQUIRE(heif_track_get_next_raw_sequence_sample(track, &sample).code == heif_error_Ok);
+  REQUIRE(heif_raw_sequence_sample_get_data_size(sample) == 1);
+  uint8_t value = heif_raw_sequence_sample_get_data(sample, nullptr)[0];
+  heif_raw_sequence_sample_release(sample);
+
+  return value;
+}
+
+
+#if WITH_UNCOMPRESSED_CODEC
+
+constexpr uint32_t cSyncSampleDistance = 10;
+
+uint32_t read32(const std::vector<uint8_t>& data, size_t pos)
+{
+  return (uint32_t(data[pos]) << 24) | (uint32_t(data[pos + 1]) << 16) | (uint32_t(data[pos + 2]) << 8) | data[pos + 3];
+}
+
+
+void write32(std::vector<uint8_t>& data, size_t pos, uint32_t value)
+{
+  data[pos] = static_cast<uint8_t>(value >> 24);
+  data[pos + 1] = static_cast<uint8_t>(value >> 16);
+  data[pos + 2] = static_cast<uint8_t>(value >> 8);
+  data[pos + 3] = static_cast<uint8_t>(value);
+}
+
+
+// Returns the offset of the first box of the given type in [begin, end), or 'end' if there is none.
+size_t find_box(const std::vector<uint8_t>& data, size_t begin, size_t end, const char* type)
+{
+  for (size_t pos = begin; pos + 8 <= end;) {
+    uint32_t size = read32(data, pos);
+    REQUIRE(size >= 8);
+
+    if (memcmp(&data[pos + 4], type, 4) == 0) {
+      return pos;
+    }
+
+    pos += size;
+  }
+
+  return end;
+}
+
+
+// The libheif encoders for sequences without inter-frame prediction mark all samples as sync samples
+// and omit the 'stss' box. To test seeking to non-sync samples, we insert an 'stss' box that only
+// lists every cSyncSampleDistance-th sample.
+std::vector<uint8_t> insert_stss_box(std::vector<uint8_t> file, uint32_t num_samples)
+{
+  // --- find the 'stbl' box and remember its parents, whose sizes have to be adjusted
+
+  std::vector<size_t> parents;
+  size_t begin = 0;
+  size_t end = file.size();
+  for (const char* type : {"moov", "trak", "mdia", "minf", "stbl"}) {
+    size_t pos = find_box(file, begin, end, type);
+    REQUIRE(pos != end);
+
+    parents.push_back(pos);
+    begin = pos + 8;
+    end = pos + read32(file, pos);
+  }
+
+  size_t stbl_end = end;
+  REQUIRE(find_box(file, begin, end, "stss") == end);
+
+  // --- create the box and insert it at the end of 'stbl'
+
+  std::vector<uint8_t> stss(16);
+  memcpy(&stss[4], "stss", 4);
+  for (uint32_t sample = 0; sample < num_samples; sample += cSyncSampleDistance) {
+    stss.resize(stss.size() + 4);
+    write32(stss, stss.size() - 4, sample + 1); // 1-based sample numbers
+  }
+  write32(stss, 0, static_cast<uint32_t>(stss.size()));
+  write32(stss, 12, static_cast<uint32_t>((stss.size() - 16) / 4));
+
+  auto delta = static_cast<uint32_t>(stss.size());
+
+  // The chunk offsets have to be shifted if the sample data follows the 'moov' box.
+  size_t stco = find_box(file, begin, end, "stco");
+  REQUIRE(stco != end);
+  for (uint32_t i = 0; i < read32(file, stco + 12); i++) {
+    size_t entry = stco + 16 + 4 * i;
+    uint32_t offset = read32(file, entry);
+    if (offset >= stbl_end) {
+      write32(file, entry, offset + delta);
+    }
+  }
+
+  for (size_t pos : parents) {
+    write32(file, pos, read32(file, pos) + delta);
+  }
+
+  file.insert(file.begin() + static_cast<std::ptrdiff_t>(stbl_end), stss.begin(), stss.end());
+
+  return file;
+}
+
+
+// Write a visual track in which each image is filled with its own index.
+std::vector<uint8_t> create_visual_sequence()
+{
+  heif_context* ctx = heif_context_alloc();
+  heif_context_set_sequence_timescale(ctx, 1000);
+
+  heif_encoder* encoder = nullptr;
+  REQUIRE(heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder).code == heif_error_Ok);
+
+  heif_track_options* options = heif_track_options_alloc();
+  heif_track_options_set_timescale(options, 1000);
+
+  heif_sequence_encoding_options* encoding_options = heif_sequence_encoding_options_alloc();
+
+  heif_track* track = nullptr;
+  REQUIRE(heif_context_add_visual_sequence_track(ctx, 8, 8, heif_track_type_image_sequence, options, encoding_options,
+                                                 &track).code == heif_error_Ok);
+  heif_track_options_release(options);
+
+  for (uint32_t i = 0; i < cNumSamples; i++) {
+    heif_image* image = nullptr;
+    REQUIRE(heif_image_create(8, 8, heif_colorspace_monochrome, heif_chroma_monochrome, &image).code == heif_error_Ok);
+    REQUIRE(heif_image_add_plane(image, heif_channel_Y, 8, 8, 8).code == heif_error_Ok);
+
+    size_t stride;
+    uint8_t* p = heif_image_get_plane2(image, heif_channel_Y, &stride);
+    for (uint32_t y = 0; y < 8; y++) {
+      memset(p + y * stride, static_cast<int>(i), 8);
+    }
+
+    heif_image_set_duration(image, cSampleDuration);
+    REQUIRE(heif_track_encode_sequence_image(track, image, encoder, encoding_options).code == heif_error_Ok);
+    heif_image_release(image);
+  }
+
+  REQUIRE(heif_track_encode_end_of_sequence(track, encoder).code == heif_error_Ok);
+  heif_sequence_encoding_options_release(encoding_options);
+  heif_encoder_release(encoder);
+  heif_track_release(track);
+
+  std::vector<uint8_t> file;
+  heif_writer writer{};
+  writer.writer_api_version = 1;
+  writer.write = mem_writer;
+  REQUIRE(heif_context_write(ctx, &writer, &file).code == heif_error_Ok);
+
+  heif_context_free(ctx);
+
+  return insert_stss_box(file, cNumSamples);
+}
+
+
+uint8_t decode_next_image_value(heif_track* track)
+{
+  heif_image* image = nullptr;
+  REQUIRE(heif_track_decode_next_image(track, &image, heif_colorspace_monochrome, heif_chroma_monochrome,
+                                       nullptr).code == heif_error_Ok);
+
+  size_t stride;
+  const uint8_t* p = heif_image_get_plane_readonly2(image, heif_channel_Y, &stride);
+  uint8_t value = p[0];
+  heif_image_release(image);
+
+  return value;
+}
+
+#endif
+
+}
+
+
+TEST_CASE("seek in metadata track")
+{
+  std::vector<uint8_t> file = create_metadata_sequence();
+
+  heif_context* ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_memory(ctx, file.data(), file.size(), nullptr).code == heif_error_Ok);
+
+  heif_track* track = heif_context_get_track(ctx, 1);
+  REQUIRE(track != nullptr);
+
+  REQUIRE(read_next_sample_value(track) == 0);
+
+  // All samples of a metadata track are sync samples, so we land exactly on the target.
+
+  REQUIRE(heif_track_seek_to_sample(track, 37).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == 37);
+  REQUIRE(read_next_sample_value(track) == 38);
+
+  REQUIRE(heif_track_seek_to_sample(track, 3).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == 3);
+
+  REQUIRE(heif_track_seek_to_sample(track, cNumSamples - 1).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == cNumSamples - 1);
+
+  heif_raw_sequence_sample* sample = nullptr;
+  REQUIRE(heif_track_get_next_raw_sequence_sample(track, &sample).code == heif_error_End_of_sequence);
+
+  REQUIRE(heif_track_seek_to_sample(track, cNumSamples).code == heif_error_Usage_error);
+
+  heif_track_release(track);
+  heif_context_free(ctx);
+}
+
+
+TEST_CASE("seek to time in metadata track")
+{
+  std::vector<uint8_t> file = create_metadata_sequence();
+
+  heif_context* ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_memory(ctx, file.data(), file.size(), nullptr).code == heif_error_Ok);
+
+  heif_track* track = heif_context_get_track(ctx, 1);
+  REQUIRE(track != nullptr);
+
+  // exactly at the start of a sample
+  REQUIRE(heif_track_seek_to_time(track, 12 * cSampleDuration).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == 12);
+
+  // within a sample
+  REQUIRE(heif_track_seek_to_time(track, 20 * cSampleDuration + cSampleDuration / 2).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == 20);
+
+  REQUIRE(heif_track_seek_to_time(track, 0).code == heif_error_Ok);
+  REQUIRE(read_next_sample_value(track) == 0);
+
+  REQUIRE(heif_track_seek_to_time(track, cNumSamples * cSampleDuration).code == heif_error_Usage_error);
+
+  heif_track_release(track);
+  heif_context_free(ctx);
+}
+
+
+#if WITH_UNCOMPRESSED_CODEC
+
+TEST_CASE("seek in visual track to non-sync samples")
+{
+  std::vector<uint8_t> file = create_visual_sequence();
+
+  heif_context* ctx = heif_context_alloc();
+  REQUIRE(heif_context_read_from_memory(ctx, file.data(), file.size(), nullptr).code == heif_error_Ok);
+
+  heif_track* track = heif_context_get_track(ctx, 0);
+  REQUIRE(track != nullptr);
+
+  REQUIRE(decode_next_image_value(track) == 0);
+
+  // Raw sample reading restarts at the preceding sync sample, where the decoder has to start.
+
+  REQUIRE(heif_track_seek_to_sample(track, 27).code == heif_error_Ok);
+
+  heif_raw_sequence_sample* sample = nullptr;
+  REQUIRE(heif_track_get_next_raw_sequence_sample(track, &sample).code == heif_error_Ok);
+  size_t size = 0;
+  const uint8_t* data = heif_raw_sequence_sample_get_data(sample, &size);
+  REQUIRE(size > 0);
+  REQUIRE(data[0] == 20);
+  heif_raw_sequence_sample_release(sample);
+
+  // Decoding restarts at the sync sample, but the skipped frames are not returned.
+
+  REQUIRE(heif_track_seek_to_sample(track, 27).code == heif_error_Ok);
+  REQUIRE(decode_next_image_value(track) == 27);
+  REQUIRE(decode_next_image_value(track) == 28);
+
+  // seek backwards onto a sync sample
+  REQUIRE(heif_track_seek_to_sample(track, 10).code == heif_error_Ok);
+  REQUIRE(decode_next_image_value(track) == 10);
+
+  // seek backwards into the first group
+  REQUIRE(heif_track_seek_to_sample(track, 3).code == heif_error_Ok);
+  REQUIRE(decode_next_image_value(track) == 3);
+
+  REQUIRE(heif_track_seek_to_time(track, 45 * cSampleDuration + 1).code == heif_error_Ok);
+  REQUIRE(decode_next_image_value(track) == 45);
+
+  heif_track_release(track);
+  heif_context_free(ctx);
+}
+
+#endif
@@ -0,0 +1,1312 @@
+/*
+  libheif unit tests for the vectorized color conversion kernels.
+
+  MIT License
+
+  Copyright (c) 2026 Dirk Farin <dirk.farin@gmail.com>
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "catch_amalgamated.hpp"
+#include "color-conversion/yuv2rgb.h"
+#include "color-conversion/yuv2rgb_kernels.h"
+#include "color-conversion/rgb2yuv.h"
+#include "color-conversion/rgb2yuv_kernels.h"
+#include "color-conversion/chroma_sampling.h"
+#include "color-conversion/alpha.h"
+#include "color-conversion/bayer_bilinear.h"
+#include "color-conversion/bayer_bilinear_kernels.h"
+#include "color-conversion/interleave_kernels.h"
+#include "color-conversion/blend_kernels.h"
+#include "color-conversion/monochrome.h"
+#include "color-conversion/rgb2rgb.h"
+#include "image/pixelimage.h"
+#include "common_utils.h"
+#include "nclx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// On ARM, the compiler may contract the scalar float code into fused multiply-adds.
+#if defined(__aarch64__) || defined(_M_ARM64)
+constexpr int cFloatTolerance = 1;
+#else
+constexpr int cFloatTolerance = 0;
+#endif
+
+const uint32_t cWidths[] = {1, 2, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 64, 100};
+
+
+template<class T>
+std::vector<T> random_samples(size_t n, int bpp, std::mt19937& rng)
+{
+  std::uniform_int_distribution<int> dist(0, (1 << bpp) - 1);
+
+  std::vector<T> v(n);
+  for (auto& s : v) {
+    s = static_cast<T>(dist(rng));
+  }
+
+  // include the extreme values to check the clipping
+  if (n >= 2) {
+    v[0] = 0;
+    v[n - 1] = static_cast<T>((1 << bpp) - 1);
+  }
+
+  return v;
+}
+
+
+YCbCr_to_RGB_int8_coefficients int8_coefficients(uint16_t matrix)
+{
+  YCbCr_to_RGB_coefficients coeffs = get_YCbCr_to_RGB_coefficients(matrix, 1);
+
+  YCbCr_to_RGB_int8_coefficients c{};
+  c.r_cr = static_cast<int>(std::lround(256 * coeffs.r_cr));
+  c.g_cr = static_cast<int>(std::lround(256 * coeffs.g_cr));
+  c.g_cb = static_cast<int>(std::lround(256 * coeffs.g_cb));
+  c.b_cb = static_cast<int>(std::lround(256 * coeffs.b_cb));
+  return c;
+}
+
+
+YCbCr_to_RGB_float_parameters float_parameters(uint16_t matrix, int bpp, bool full_range, int chroma_shift)
+{
+  YCbCr_to_RGB_coefficients coeffs = get_YCbCr_to_RGB_coefficients(matrix, 1);
+
+  YCbCr_to_RGB_float_parameters p{};
+  p.r_cr = coeffs.r_cr;
+  p.g_cb = coeffs.g_cb;
+  p.g_cr = coeffs.g_cr;
+  p.b_cb = coeffs.b_cb;
+  p.full_range = full_range;
+  p.limited_range_offset = static_cast<float>(16 << (bpp - 8));
+  p.chroma_offset = 1 << (bpp - 1);
+  p.max_value = (1 << bpp) - 1;
+  p.chroma_shift = chroma_shift;
+  return p;
+}
+
+
+RGB_to_YCbCr_float_parameters rgb_to_ycbcr_parameters(uint16_t matrix, int bpp, bool full_range)
+{
+  RGB_to_YCbCr_coefficients coeffs = get_RGB_to_YCbCr_coefficients(matrix, 1);
+
+  RGB_to_YCbCr_float_parameters p{};
+  memcpy(p.c, coeffs.c, sizeof(p.c));
+  p.full_range = full_range;
+  p.limited_range_offset = static_cast<float>(16 << (bpp - 8));
+  p.chroma_offset = 1 << (bpp - 1);
+  p.max_value = (1 << bpp) - 1;
+  return p;
+}
+
+
+template<class T>
+void require_equal(const std::vector<T>& a, const std::vector<T>& b, int tolerance)
+{
+  REQUIRE(a.size() == b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    INFO("index " << i);
+    REQUIRE(std::abs(int(a[i]) - int(b[i])) <= tolerance);
+  }
+}
+
+
+template<class Pixel>
+using float_row_kernel = void (*)(const Pixel*, const Pixel*, const Pixel*, Pixel*, Pixel*, Pixel*, uint32_t,
+                                  const YCbCr_to_RGB_float_parameters&);
+
+
+template<class Pixel>
+void compare_float_kernel(float_row_kernel<Pixel> kernel, float_row_kernel<Pixel> reference, int bpp)
+{
+  std::mt19937 rng(bpp);
+
+  for (uint16_t matrix : {uint16_t(1), uint16_t(5), uint16_t(9)}) {
+    for (bool full_range : {true, false}) {
+      for (int chroma_shift : {0, 1}) {
+        for (uint32_t width : cWidths) {
+          INFO("matrix " << matrix << ", full range " << full_range << ", chroma shift " << chroma_shift
+                         << ", width " << width);
+
+          uint32_t chroma_width = (width + chroma_shift) >> chroma_shift;
+
+          auto y = random_samples<Pixel>(width, bpp, rng);
+          auto cb = random_samples<Pixel>(chroma_width, bpp, rng);
+          auto cr = random_samples<Pixel>(chroma_width, bpp, rng);
+
+          auto params = float_parameters(matrix, bpp, full_range, chroma_shift);
+
+          std::vector<Pixel> r(width), g(width), b(width);
+          std::vector<Pixel> r_ref(width), g_ref(width), b_ref(width);
+
+          kernel(y.data(), cb.data(), cr.data(), r.data(), g.data(), b.data(), width, params);
+          reference(y.data(), cb.data(), cr.data(), r_ref.data(), g_ref.data(), b_ref.data(), width, params);
+
+          require_equal(r, r_ref, cFloatTolerance);
+          require_equal(g, g_ref, cFloatTolerance);
+          require_equal(b, b_ref, cFloatTolerance);
+        }
+      }
+    }
+  }
+}
+
+
+template<class Pixel>
+using fixed_point_row_kernel = void (*)(const Pixel*, const Pixel*, const Pixel*, Pixel*, Pixel*, Pixel*, uint32_t,
+                                        const YCbCr_to_RGB_fixed_point_parameters&);
+
+
+template<class Pixel>
+void compare_fixed_point_kernel(fixed_point_row_kernel<Pixel> kernel, fixed_point_row_kernel<Pixel> reference, int bpp)
+{
+  std::mt19937 rng(bpp);
+
+  for (uint16_t matrix : {uint16_t(1), uint16_t(5), uint16_t(9)}) {
+    for (bool full_range : {true, false}) {
+      for (int chroma_shift : {0, 1}) {
+        for (uint32_t width : cWidths) {
+          INFO("matrix " << matrix << ", full range " << full_range << ", chroma shift " << chroma_shift
+                         << ", width " << width);
+
+          uint32_t chroma_width = (width + chroma_shift) >> chroma_shift;
+
+          auto y = random_samples<Pixel>(width, bpp, rng);
+          auto cb = random_samples<Pixel>(chroma_width, bpp, rng);
+          auto cr = random_samples<Pixel>(chroma_width, bpp, rng);
+
+          auto params = get_YCbCr_to_RGB_fixed_point_parameters(matrix, 1, full_range, bpp, chroma_shift);
+
+          std::vector<Pixel> r(width), g(width), b(width);
+          std::vector<Pixel> r_ref(width), g_ref(width), b_ref(width);
+
+          kernel(y.data(), cb.data(), cr.data(), r.data(), g.data(), b.data(), width, params);
+          reference(y.data(), cb.data(), cr.data(), r_ref.data(), g_ref.data(), b_ref.data(), width, params);
+
+          require_equal(r, r_ref, 0);
+          require_equal(g, g_ref, 0);
+          require_equal(b, b_ref, 0);
+        }
+      }
+    }
+  }
+}
+
+
+// Compares the scalar fixed-point conversion against the scalar float conversion.
+template<class Pixel>
+void compare_fixed_point_to_float(uint16_t matrix, uint16_t primaries, bool full_range, int bpp)
+{
+  const YCbCr_to_RGB_kernels& scalar = get_scalar_YCbCr_to_RGB_kernels();
+
+  std::mt19937 rng(bpp * 100 + matrix);
+
+  const uint32_t width = 4096;
+
+  auto y = random_samples<Pixel>(width, bpp, rng);
+  auto cb = random_samples<Pixel>(width, bpp, rng);
+  auto cr = random_samples<Pixel>(width, bpp, rng);
+
+  // the corners of the YCbCr cube, where the products are largest
+  const Pixel max_value = static_cast<Pixel>((1 << bpp) - 1);
+  for (uint32_t i = 0; i < 8; i++) {
+    y[i] = (i & 1) ? max_value : 0;
+    cb[i] = (i & 2) ? max_value : 0;
+    cr[i] = (i & 4) ? max_value : 0;
+  }
+
+  YCbCr_to_RGB_coefficients coeffs = get_YCbCr_to_RGB_coefficients(matrix, primaries);
+
+  YCbCr_to_RGB_float_parameters float_params{};
+  float_params.r_cr = coeffs.r_cr;
+  float_params.g_cb = coeffs.g_cb;
+  float_params.g_cr = coeffs.g_cr;
+  float_params.b_cb = coeffs.b_cb;
+  float_params.full_range = full_range;
+  float_params.limited_range_offset = static_cast<float>(16 << (bpp - 8));
+  float_params.chroma_offset = 1 << (bpp - 1);
+  float_params.max_value = (1 << bpp) - 1;
+  float_params.chroma_shift = 0;
+
+  auto fixed_point_params = get_YCbCr_to_RGB_fixed_point_parameters(matrix, primaries, full_range, bpp, 0);
+
+  std::vector<Pixel> r(width), g(width), b(width);
+  std::vector<Pixel> r_ref(width), g_ref(width), b_ref(width);
+
+  if constexpr (sizeof(Pixel) == 1) {
+    scalar.ycbcr_to_rgb_row_8_fixed_point(y.data(), cb.data(), cr.data(), r.data(), g.data(), b.data(), width, fixed_point_params);
+    scalar.ycbcr_to_rgb_row_8(y.data(), cb.data(), cr.data(), r_ref.data(), g_ref.data(), b_ref.data(), width, float_params);
+  }
+  else {
+    scalar.ycbcr_to_rgb_row_16_fixed_point(y.data(), cb.data(), cr.data(), r.data(), g.data(), b.data(), width, fixed_point_params);
+    scalar.ycbcr_to_rgb_row_16(y.data(), cb.data(), cr.data(), r_ref.data(), g_ref.data(), b_ref.data(), width, float_params);
+  }
+
+  require_equal(r, r_ref, 1);
+  require_equal(g, g_ref, 1);
+  require_equal(b, b_ref, 1);
+}
+
+
+template<class Pixel>
+void compare_planar_rgb_kernels(const RGB_to_YCbCr_kernels& kernels, const RGB_to_YCbCr_kernels& scalar, int bpp)
+{
+  std::mt19937 rng(bpp);
+
+  auto y_row = [](const RGB_to_YCbCr_kernels& k) {
+    if constexpr (sizeof(Pixel) == 1) return k.rgb_to_y_row_8; else return k.rgb_to_y_row_16;
+  };
+  auto cbcr_row = [](const RGB_to_YCbCr_kernels& k) {
+    if constexpr (sizeof(Pixel) == 1) return k.rgb_to_cbcr_row_8; else return k.rgb_to_cbcr_row_16;
+  };
+  auto cbcr420_row = [](const RGB_to_YCbCr_kernels& k) {
+    if constexpr (sizeof(Pixel) == 1) return k.rgb_to_cbcr420_row_8; else return k.rgb_to_cbcr420_row_16;
+  };
+  auto average_row = [](const RGB_to_YCbCr_kernels& k) {
+    if constexpr (sizeof(Pixel) == 1) return k.average_420_row_8; else return k.average_420_row_16;
+  };
+
+  for (uint16_t matrix : {uint16_t(1), uint16_t(5), uint16_t(9)}) {
+    for (bool full_range : {true, false}) {
+      for (uint32_t width : cWidths) {
+        INFO("matrix " << matrix << ", full range " << full_range << ", width " << width);
+
+        auto params = rgb_to_ycbcr_parameters(matrix, bpp, full_range);
+
+        std::vector<std::vector<Pixel>> rgb;
+        for (int i = 0; i < 6; i++) {
+          rgb.push_back(random_samples<Pixel>(width, bpp, rng));
+        }
+
+        std::vector<Pixel> y(width), y_ref(width);
+        y_row(kernels)(rgb[0].data(), rgb[1].data(), rgb[2].data(), y.data(), width, params);
+        y_row(scalar)(rgb[0].data(), rgb[1].data(), rgb[2].data(), y_ref.data(), width, params);
+        require_equal(y, y_ref, cFloatTolerance);
+
+        std::vector<Pixel> cb(width), cr(width), cb_ref(width), cr_ref(width);
+        cbcr_row(kernels)(rgb[0].data(), rgb[1].data(), rgb[2].data(), cb.data(), cr.data(), width, params);
+        cbcr_row(scalar)(rgb[0].data(), rgb[1].data(), rgb[2].data(), cb_ref.data(), cr_ref.data(), width, params);
+        require_equal(cb, cb_ref, cFloatTolerance);
+        require_equal(cr, cr_ref, cFloatTolerance);
+
+        uint32_t chroma_width = (width + 1) / 2;
+        std::vector<Pixel> cb420(chroma_width), cr420(chroma_width), cb420_ref(chroma_width), cr420_ref(chroma_width);
+        cbcr420_row(kernels)(rgb[0].data(), rgb[1].data(), rgb[2].data(), rgb[3].data(), rgb[4].data(), rgb[5].data(),
+                             cb420.data(), cr420.data(), width, params);
+        cbcr420_row(scalar)(rgb[0].data(), rgb[1].data(), rgb[2].data(), rgb[3].data(), rgb[4].data(), rgb[5].data(),
+                            cb420_ref.data(), cr420_ref.data(), width, params);
+        require_equal(cb420, cb420_ref, cFloatTolerance);
+        require_equal(cr420, cr420_ref, cFloatTolerance);
+
+        std::vector<Pixel> avg(width / 2), avg_ref(width / 2);
+        average_row(kernels)(rgb[0].data(), rgb[1].data(), avg.data(), width / 2);
+        average_row(scalar)(rgb[0].data(), rgb[1].data(), avg_ref.data(), width / 2);
+        require_equal(avg, avg_ref, 0);
+      }
+    }
+  }
+}
+
+
+std::shared_ptr<HeifPixelImage> create_random_image(uint32_t w, uint32_t h, heif_colorspace colorspace, heif_chroma chroma,
+                                                    int bpp, bool alpha)
+{
+  std::mt19937 rng(w * h + bpp);
+
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(w, h, colorspace, chroma);
+
+  if (chroma == heif_chroma_interleaved_RRGGBBAA_LE || chroma == heif_chroma_interleaved_RRGGBBAA_BE) {
+    REQUIRE(!img->add_channel(heif_channel_interleaved, w, h, bpp, nullptr));
+
+    size_t stride;
+    uint8_t* p = img->get_channel_memory(heif_channel_interleaved, &stride);
+    for (uint32_t y = 0; y < h; y++) {
+      auto row = random_samples<uint16_t>(w * 4, bpp, rng);
+      for (uint32_t i = 0; i < w * 4; i++) {
+        int first = (chroma == heif_chroma_interleaved_RRGGBBAA_BE) ? 8 : 0;
+        p[y * stride + 2 * i] = static_cast<uint8_t>(row[i] >> first);
+        p[y * stride + 2 * i + 1] = static_cast<uint8_t>(row[i] >> (8 - first));
+      }
+    }
+
+    return img;
+  }
+
+  if (chroma == heif_chroma_interleaved_RGB || chroma == heif_chroma_interleaved_RGBA) {
+    REQUIRE(!img->add_channel(heif_channel_interleaved, w, h, 8, nullptr));
+
+    size_t stride;
+    uint8_t* p = img->get_channel_memory(heif_channel_interleaved, &stride);
+    uint32_t row_bytes = w * (chroma == heif_chroma_interleaved_RGB ? 3 : 4);
+    for (uint32_t y = 0; y < h; y++) {
+      auto row = random_samples<uint8_t>(row_bytes, 8, rng);
+      memcpy(p + y * stride, row.data(), row_bytes);
+    }
+
+    return img;
+  }
+
+  std::vector<heif_channel> channels;
+  if (colorspace == heif_colorspace_RGB) {
+    channels = {heif_channel_R, heif_channel_G, heif_channel_B};
+  }
+  else if (colorspace == heif_colorspace_monochrome) {
+    channels = {heif_channel_Y};
+  }
+  else {
+    channels = {heif_channel_Y, heif_channel_Cb, heif_channel_Cr};
+  }
+
+  if (alpha) {
+    channels.push_back(heif_channel_Alpha);
+  }
+
+  for (heif_channel c : channels) {
+    bool subsampled = (c == heif_channel_Cb || c == heif_channel_Cr);
+    uint32_t cw = subsampled ? (w + chroma_h_subsampling(chroma) - 1) / chroma_h_subsampling(chroma) : w;
+    uint32_t ch = subsampled ? (h + chroma_v_subsampling(chroma) - 1) / chroma_v_subsampling(chroma) : h;
+    REQUIRE(!img->add_channel(c, cw, ch, bpp, nullptr));
+
+    size_t stride;
+    uint8_t* p = img->get_channel_memory(c, &stride);
+    for (uint32_t y = 0; y < ch; y++) {
+      if (bpp > 8) {
+        auto row = random_samples<uint16_t>(cw, bpp, rng);
+        memcpy(p + y * stride, row.data(), cw * 2);
+      }
+      else {
+        auto row = random_samples<uint8_t>(cw, bpp, rng);
+        memcpy(p + y * stride, row.data(), cw);
+      }
+    }
+  }
+
+  return img;
+}
+
+
+void require_equal_images(const std::shared_ptr<HeifPixelImage>& a, const std::shared_ptr<HeifPixelImage>& b)
+{
+  REQUIRE(a->get_channel_set() == b->get_channel_set());
+
+  for (heif_channel c : a->get_channel_set()) {
+    size_t stride_a, stride_b;
+    const uint8_t* pa = a->get_channel_memory(c, &stride_a);
+    const uint8_t* pb = b->get_channel_memory(c, &stride_b);
+
+    size_t row_bytes = a->get_width(c) * ((a->get_storage_bits_per_pixel(c) + 7) / 8);
+
+    for (uint32_t y = 0; y < a->get_height(c); y++) {
+      INFO("channel " << c << ", row " << y);
+      REQUIRE(memcmp(pa + y * stride_a, pb + y * stride_b, row_bytes) == 0);
+    }
+  }
+}
+
+
+ColorState color_state(heif_colorspace colorspace, heif_chroma chroma, bool alpha, int bpp, bool full_range = true)
+{
+  ColorState state(colorspace, chroma, alpha, bpp);
+  state.nclx = nclx_profile::defaults();
+  state.nclx.set_full_range_flag(full_range);
+  return state;
+}
+
+
+template<class Op, class Kernels>
+void compare_op(const std::vector<const Kernels*>& kernel_sets,
+                const std::shared_ptr<HeifPixelImage>& input, const ColorState& input_state,
+                const ColorState& output_state, const heif_color_conversion_options& options = {},
+                const heif_color_conversion_options_ext& options_ext = {})
+{
+  Op reference_op;
+  auto reference = reference_op.convert_colorspace(input, input_state, output_state, options, options_ext, nullptr);
+  REQUIRE(reference);
+
+  for (const Kernels* kernels : kernel_sets) {
+    INFO("kernels: " << kernels->name);
+
+    Op op(*kernels);
+    REQUIRE(!op.state_after_conversion(input_state, output_state, options, options_ext).empty());
+
+    auto result = op.convert_colorspace(input, input_state, output_state, options, options_ext, nullptr);
+    REQUIRE(result);
+
+    require_equal_images(*reference, *result);
+  }
+}
+
+
+// The 2x2 Bayer patterns as RGB channel indices (0=R, 1=G, 2=B).
+const int cBayerPatterns[4][4] = {
+    {0, 1, 1, 2}, // RGGB
+    {2, 1, 1, 0}, // BGGR
+    {1, 0, 2, 1}, // GRBG
+    {1, 2, 0, 1}, // GBRG
+};
+
+
+std::shared_ptr<HeifPixelImage> create_random_bayer_image(uint32_t w, uint32_t h, int bpp, const int pattern_channels[4])
+{
+  std::mt19937 rng(w * h + bpp);
+
+  auto img = std::make_shared<HeifPixelImage>();
+  img->create(w, h, heif_colorspace_filter_array, heif_chroma_planar);
+  REQUIRE(!img->add_channel(heif_channel_filter_array, w, h, bpp, nullptr));
+
+  size_t stride;
+  uint8_t* p = img->get_channel_memory(heif_channel_filter_array, &stride);
+  for (uint32_t y = 0; y < h; y++) {
+    if (bpp > 8) {
+      auto row = random_samples<uint16_t>(w, bpp, rng);
+      memcpy(p + y * stride, row.data(), w * 2);
+    }
+    else {
+      auto row = random_samples<uint8_t>(w, bpp, rng);
+      memcpy(p + y * stride, row.data(), w);
+    }
+  }
+
+  const uint16_t component_types[3] = {heif_cmpd_component_type_red,
+                                       heif_cmpd_component_type_green,
+                                       heif_cmpd_component_type_blue};
+  uint32_t component_ids[3];
+  for (int c = 0; c < 3; c++) {
+    component_ids[c] = img->add_component_without_data(component_types[c]);
+  }
+
+  BayerPattern pattern;
+  pattern.pattern_width = 2;
+  pattern.pattern_height = 2;
+  for (int i = 0; i < 4; i++) {
+    pattern.pixels.push_back({component_ids[pattern_channels[i]], 1.0f});
+  }
+  img->set_bayer_pattern(pattern);
+
+  return img;
+}
+
+}
+
+
+TEST_CASE("YCbCr 4:2:0 to RGB24/RGB32 kernels are bit-exact")
+{
+  const YCbCr_to_RGB_kernels& scalar = get_scalar_YCbCr_to_RGB_kernels();
+  std::mt19937 rng(0);
+
+  for (const YCbCr_to_RGB_kernels* kernels : get_supported_YCbCr_to_RGB_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    for (uint16_t matrix : {uint16_t(1), uint16_t(5), uint16_t(9)}) {
+      auto coeffs = int8_coefficients(matrix);
+
+      for (uint32_t width : cWidths) {
+        INFO("matrix " << matrix << ", width " << width);
+
+        auto y = random_samples<uint8_t>(width, 8, rng);
+        auto cb = random_samples<uint8_t>((width + 1) / 2, 8, rng);
+        auto cr = random_samples<uint8_t>((width + 1) / 2, 8, rng);
+        auto alpha = random_samples<uint8_t>(width, 8, rng);
+
+        std::vector<uint8_t> rgb(width * 3), rgb_ref(width * 3);
+        kernels->ycbcr420_to_rgb24_row(y.data(), cb.data(), cr.data(), rgb.data(), width, coeffs);
+        scalar.ycbcr420_to_rgb24_row(y.data(), cb.data(), cr.data(), rgb_ref.data(), width, coeffs);
+        require_equal(rgb, rgb_ref, 0);
+
+        for (const uint8_t* a : {(const uint8_t*) nullptr, (const uint8_t*) alpha.data()}) {
+          std::vector<uint8_t> rgba(width * 4), rgba_ref(width * 4);
+          kernels->ycbcr420_to_rgb32_row(y.data(), cb.data(), cr.data(), a, rgba.data(), width, coeffs);
+          scalar.ycbcr420_to_rgb32_row(y.data(), cb.data(), cr.data(), a, rgba_ref.data(), width, coeffs);
+          require_equal(rgba, rgba_ref, 0);
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("YCbCr to RGB float kernels")
+{
+  const YCbCr_to_RGB_kernels& scalar = get_scalar_YCbCr_to_RGB_kernels();
+
+  for (const YCbCr_to_RGB_kernels* kernels : get_supported_YCbCr_to_RGB_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    compare_float_kernel<uint8_t>(kernels->ycbcr_to_rgb_row_8, scalar.ycbcr_to_rgb_row_8, 8);
+
+    for (int bpp : {10, 12, 14}) {
+      INFO("bpp " << bpp);
+      compare_float_kernel<uint16_t>(kernels->ycbcr_to_rgb_row_16, scalar.ycbcr_to_rgb_row_16, bpp);
+    }
+  }
+}
+
+
+TEST_CASE("YCbCr to RGB fixed-point kernels are bit-exact")
+{
+  const YCbCr_to_RGB_kernels& scalar = get_scalar_YCbCr_to_RGB_kernels();
+
+  for (const YCbCr_to_RGB_kernels* kernels : get_supported_YCbCr_to_RGB_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    compare_fixed_point_kernel<uint8_t>(kernels->ycbcr_to_rgb_row_8_fixed_point, scalar.ycbcr_to_rgb_row_8_fixed_point, 8);
+
+    for (int bpp : {9, 10, 12, 14}) {
+      INFO("bpp " << bpp);
+      compare_fixed_point_kernel<uint16_t>(kernels->ycbcr_to_rgb_row_16_fixed_point,
+                                           scalar.ycbcr_to_rgb_row_16_fixed_point, bpp);
+    }
+  }
+}
+
+
+TEST_CASE("YCbCr to RGB fixed-point conversion is within 1 LSB of float")
+{
+  for (uint16_t matrix = 1; matrix <= 13; matrix++) {
+    if (matrix == 2 || matrix == 3 || matrix == 8 || matrix == 11) {
+      continue;
+    }
+
+    // matrices 12 and 13 depend on the colour primaries
+    std::vector<uint16_t> primaries{heif_color_primaries_ITU_R_BT_709_5};
+    if (matrix == 12 || matrix == 13) {
+      primaries.push_back(heif_color_primaries_ITU_R_BT_2020_2_and_2100_0);
+      primaries.push_back(heif_color_primaries_SMPTE_EG_432_1);
+    }
+
+    for (uint16_t p : primaries) {
+      for (bool full_range : {true, false}) {
+        INFO("matrix " << matrix << ", primaries " << p << ", full range " << full_range);
+
+        compare_fixed_point_to_float<uint8_t>(matrix, p, full_range, 8);
+
+        for (int bpp = 9; bpp <= 14; bpp++) {
+          INFO("bpp " << bpp);
+          compare_fixed_point_to_float<uint16_t>(matrix, p, full_range, bpp);
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("YCbCr to RGB ops with vectorized kernels")
+{
+  heif_color_conversion_options_ext options_ext{};
+  options_ext.use_float_arithmetic = GENERATE(false, true);
+  INFO("float arithmetic " << int(options_ext.use_float_arithmetic));
+
+  SECTION("4:2:0 8-bit to RGB24") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 8, false);
+    compare_op<Op_YCbCr420_to_RGB24>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                     color_state(heif_colorspace_YCbCr, heif_chroma_420, false, 8),
+                                     ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RGB, false, 8));
+  }
+
+  SECTION("4:2:0 8-bit with alpha to RGB32") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 8, true);
+    compare_op<Op_YCbCr420_to_RGB32>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                     color_state(heif_colorspace_YCbCr, heif_chroma_420, true, 8),
+                                     ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RGBA, true, 8));
+  }
+
+  SECTION("4:2:0 10-bit with alpha to RRGGBBAA") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 10, true);
+    compare_op<Op_YCbCr420_to_RRGGBBaa>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                        color_state(heif_colorspace_YCbCr, heif_chroma_420, true, 10),
+                                        ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RRGGBBAA_LE, true, 10),
+                                        {}, options_ext);
+  }
+
+  SECTION("4:2:0 12-bit to planar RGB") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 12, false);
+    compare_op<Op_YCbCr_to_RGB<uint16_t>>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                          color_state(heif_colorspace_YCbCr, heif_chroma_420, false, 12),
+                                          ColorState(heif_colorspace_RGB, heif_chroma_444, false, 12),
+                                          {}, options_ext);
+  }
+}
+
+
+TEST_CASE("Bilinear chroma upsampling kernels are bit-exact")
+{
+  std::mt19937 rng(0);
+
+  auto check = [&](const YCbCr_to_RGB_kernels& kernels, auto pixel, int bpp, uint32_t width) {
+    using Pixel = decltype(pixel);
+
+    uint32_t chroma_width = (width + 1) / 2;
+    auto row0 = random_samples<Pixel>(chroma_width, bpp, rng);
+    auto row1 = random_samples<Pixel>(chroma_width, bpp, rng);
+
+    // Direct evaluation of the bilinear weights. At the left and right border, the chroma sample is repeated.
+    std::vector<Pixel> expected(width);
+    for (uint32_t x = 0; x < width; x++) {
+      uint32_t cx0 = x / 2;
+      uint32_t cx1 = (x % 2 == 1) ? std::min(cx0 + 1, chroma_width - 1) : (cx0 > 0 ? cx0 - 1 : 0);
+      int v0 = 3 * row0[cx0] + row1[cx0];
+      int v1 = 3 * row0[cx1] + row1[cx1];
+      expected[x] = static_cast<Pixel>((3 * v0 + v1 + 8) >> 4);
+    }
+
+    std::vector<Pixel> out(width);
+    if constexpr (sizeof(Pixel) == 1) {
+      kernels.upsample_chroma_bilinear_row_8(row0.data(), row1.data(), out.data(), width);
+    }
+    else {
+      kernels.upsample_chroma_bilinear_row_16(row0.data(), row1.data(), out.data(), width);
+    }
+
+    require_equal(out, expected, 0);
+  };
+
+  for (const YCbCr_to_RGB_kernels* kernels : get_supported_YCbCr_to_RGB_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    for (uint32_t width : cWidths) {
+      INFO("width " << width);
+
+      check(*kernels, uint8_t{}, 8, width);
+
+      for (int bpp : {10, 12, 16}) {
+        INFO("bpp " << bpp);
+        check(*kernels, uint16_t{}, bpp, width);
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Bilinear upsampling ops with vectorized kernels")
+{
+  heif_color_conversion_options options{};
+  options.preferred_chroma_upsampling_algorithm = heif_chroma_upsampling_bilinear;
+
+  heif_color_conversion_options_ext options_ext{};
+  options_ext.use_float_arithmetic = GENERATE(false, true);
+  INFO("float arithmetic " << int(options_ext.use_float_arithmetic));
+
+  SECTION("4:2:0 8-bit with alpha to 4:4:4") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 8, true);
+    compare_op<Op_YCbCr420_bilinear_to_YCbCr444<uint8_t>>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                                          color_state(heif_colorspace_YCbCr, heif_chroma_420, true, 8),
+                                                          color_state(heif_colorspace_YCbCr, heif_chroma_444, true, 8),
+                                                          options, options_ext);
+  }
+
+  SECTION("4:2:2 16-bit to 4:4:4") {
+    auto input = create_random_image(38, 9, heif_colorspace_YCbCr, heif_chroma_422, 16, false);
+    compare_op<Op_YCbCr422_bilinear_to_YCbCr444<uint16_t>>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                                           color_state(heif_colorspace_YCbCr, heif_chroma_422, false, 16),
+                                                           color_state(heif_colorspace_YCbCr, heif_chroma_444, false, 16),
+                                                           options, options_ext);
+  }
+
+  SECTION("4:2:0 10-bit to planar RGB") {
+    auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_420, 10, false);
+    compare_op<Op_YCbCr_bilinear_to_RGB<uint16_t>>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                                   color_state(heif_colorspace_YCbCr, heif_chroma_420, false, 10),
+                                                   ColorState(heif_colorspace_RGB, heif_chroma_444, false, 10),
+                                                   options, options_ext);
+  }
+
+  SECTION("4:2:2 8-bit with alpha to planar RGB") {
+    auto input = create_random_image(38, 10, heif_colorspace_YCbCr, heif_chroma_422, 8, true);
+    compare_op<Op_YCbCr_bilinear_to_RGB<uint8_t>>(get_supported_YCbCr_to_RGB_kernels(), input,
+                                                  color_state(heif_colorspace_YCbCr, heif_chroma_422, true, 8),
+                                                  ColorState(heif_colorspace_RGB, heif_chroma_444, true, 8),
+                                                  options, options_ext);
+  }
+}
+
+
+TEST_CASE("RGB to YCbCr kernels")
+{
+  const RGB_to_YCbCr_kernels& scalar = get_scalar_RGB_to_YCbCr_kernels();
+  std::mt19937 rng(0);
+
+  for (const RGB_to_YCbCr_kernels* kernels : get_supported_RGB_to_YCbCr_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    for (uint16_t matrix : {uint16_t(1), uint16_t(5), uint16_t(9)}) {
+      for (bool full_range : {true, false}) {
+        auto params = rgb_to_ycbcr_parameters(matrix, 8, full_range);
+
+        for (int bytes_per_pixel : {3, 4}) {
+          for (uint32_t width : cWidths) {
+            INFO("matrix " << matrix << ", full range " << full_range << ", bytes per pixel " << bytes_per_pixel
+                           << ", width " << width);
+
+            auto rgb0 = random_samples<uint8_t>(width * bytes_per_pixel, 8, rng);
+            auto rgb1 = random_samples<uint8_t>(width * bytes_per_pixel, 8, rng);
+
+            std::vector<uint8_t> y(width), y_ref(width);
+            kernels->rgb_interleaved_to_y_row(rgb0.data(), bytes_per_pixel, y.data(), width, params);
+            scalar.rgb_interleaved_to_y_row(rgb0.data(), bytes_per_pixel, y_ref.data(), width, params);
+            require_equal(y, y_ref, cFloatTolerance);
+
+            uint32_t chroma_width = width / 2;
+            std::vector<uint8_t> cb(chroma_width), cr(chroma_width), cb_ref(chroma_width), cr_ref(chroma_width);
+            kernels->rgb_interleaved_to_cbcr420_row(rgb0.data(), rgb1.data(), bytes_per_pixel,
+                                                    cb.data(), cr.data(), chroma_width, params);
+            scalar.rgb_interleaved_to_cbcr420_row(rgb0.data(), rgb1.data(), bytes_per_pixel,
+                                                  cb_ref.data(), cr_ref.data(), chroma_width, params);
+            require_equal(cb, cb_ref, cFloatTolerance);
+            require_equal(cr, cr_ref, cFloatTolerance);
+          }
+        }
+      }
+    }
+
+    compare_planar_rgb_kernels<uint8_t>(*kernels, scalar, 8);
+
+    for (int bpp : {10, 12, 16}) {
+      INFO("bpp " << bpp);
+      compare_planar_rgb_kernels<uint16_t>(*kernels, scalar, bpp);
+    }
+  }
+}
+
+
+TEST_CASE("RGB to YCbCr ops with vectorized kernels")
+{
+  bool full_range = GENERATE(true, false);
+  INFO("full range " << full_range);
+
+  SECTION("RGB24 to 4:2:0") {
+    auto input = create_random_image(37, 9, heif_colorspace_RGB, heif_chroma_interleaved_RGB, 8, false);
+    compare_op<Op_RGB24_32_to_YCbCr>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                     color_state(heif_colorspace_RGB, heif_chroma_interleaved_RGB, false, 8),
+                                     color_state(heif_colorspace_YCbCr, heif_chroma_420, false, 8, full_range));
+  }
+
+  SECTION("RGBA to 4:2:0 with alpha") {
+    auto input = create_random_image(38, 10, heif_colorspace_RGB, heif_chroma_interleaved_RGBA, 8, true);
+    compare_op<Op_RGB24_32_to_YCbCr>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                     color_state(heif_colorspace_RGB, heif_chroma_interleaved_RGBA, true, 8),
+                                     color_state(heif_colorspace_YCbCr, heif_chroma_420, true, 8, full_range));
+  }
+
+  SECTION("planar 8-bit RGB to 4:4:4") {
+    auto input = create_random_image(37, 9, heif_colorspace_RGB, heif_chroma_444, 8, true);
+    compare_op<Op_RGB_to_YCbCr<uint8_t>>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                         color_state(heif_colorspace_RGB, heif_chroma_444, true, 8),
+                                         color_state(heif_colorspace_YCbCr, heif_chroma_444, true, 8, full_range));
+  }
+
+  SECTION("planar 10-bit RGB to 4:2:0") {
+    auto input = create_random_image(37, 9, heif_colorspace_RGB, heif_chroma_444, 10, false);
+    compare_op<Op_RGB_to_YCbCr<uint16_t>>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                          color_state(heif_colorspace_RGB, heif_chroma_444, false, 10),
+                                          color_state(heif_colorspace_YCbCr, heif_chroma_420, false, 10, full_range));
+  }
+
+  SECTION("4:4:4 to 4:2:0 averaging") {
+    for (int bpp : {8, 10}) {
+      INFO("bpp " << bpp);
+
+      auto input = create_random_image(37, 9, heif_colorspace_YCbCr, heif_chroma_444, bpp, false);
+      auto input_state = color_state(heif_colorspace_YCbCr, heif_chroma_444, false, bpp);
+      auto output_state = color_state(heif_colorspace_YCbCr, heif_chroma_420, false, bpp);
+
+      heif_color_conversion_options options{};
+      options.preferred_chroma_downsampling_algorithm = heif_chroma_downsampling_average;
+
+      if (bpp == 8) {
+        compare_op<Op_YCbCr444_to_YCbCr420_average<uint8_t>>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                                             input_state, output_state, options);
+      }
+      else {
+        compare_op<Op_YCbCr444_to_YCbCr420_average<uint16_t>>(get_supported_RGB_to_YCbCr_kernels(), input,
+                                                              input_state, output_state, options);
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Bayer demosaicing kernels")
+{
+  std::mt19937 rng(0);
+
+  // One row of each 2x2 pattern. The rows above and below belong to the other row of the pattern.
+  auto check = [&](const Bayer_demosaic_kernels& kernels, auto pixel, int bpp, uint32_t width,
+                   int even_channel, int odd_channel) {
+    using Pixel = decltype(pixel);
+
+    auto above = random_samples<Pixel>(width, bpp, rng);
+    auto row = random_samples<Pixel>(width, bpp, rng);
+    auto below = random_samples<Pixel>(width, bpp, rng);
+
+    int other_even_channel = (even_channel == 1) ? 2 - odd_channel : 1;
+    int other_odd_channel = (even_channel == 1) ? 1 : 2 - even_channel;
+
+    auto channel_at = [&](int dy, uint32_t x) {
+      if (dy == 0) {
+        return (x % 2 == 0) ? even_channel : odd_channel;
+      }
+      return (x % 2 == 0) ? other_even_channel : other_odd_channel;
+    };
+
+    // Direct evaluation: the average of all samples of the channel in the 3x3 neighborhood.
+    // The first and last pixel are not written by the kernels.
+    std::vector<Pixel> expected(width * 3, 0);
+    for (uint32_t x = 1; x + 1 < width; x++) {
+      for (int ch = 0; ch < 3; ch++) {
+        int sum = 0;
+        int count = 0;
+        for (int dy = -1; dy <= 1; dy++) {
+          const auto& r = (dy < 0) ? above : (dy == 0 ? row : below);
+          for (uint32_t nx = x - 1; nx <= x + 1; nx++) {
+            if (channel_at(dy, nx) == ch) {
+              sum += r[nx];
+              count++;
+            }
+          }
+        }
+
+        // The pixel's own sample is used directly, its neighbors are not averaged with it.
+        if (channel_at(0, x) == ch) {
+          sum = row[x];
+          count = 1;
+        }
+
+        expected[x * 3 + ch] = static_cast<Pixel>((sum + count / 2) / count);
+      }
+    }
+
+    std::vector<Pixel> out(width * 3, 0);
+    if constexpr (sizeof(Pixel) == 1) {
+      kernels.demosaic_row_8(above.data(), row.data(), below.data(), out.data(), width, even_channel, odd_channel);
+    }
+    else {
+      kernels.demosaic_row_16(above.data(), row.data(), below.data(), out.data(), width, even_channel, odd_channel);
+    }
+
+    require_equal(out, expected, 0);
+  };
+
+  for (const Bayer_demosaic_kernels* kernels : get_supported_Bayer_demosaic_kernels()) {
+    INFO("kernels: " << kernels->name);
+
+    for (const auto& pattern : cBayerPatterns) {
+      for (int pattern_row = 0; pattern_row < 2; pattern_row++) {
+        int even_channel = pattern[pattern_row * 2];
+        int odd_channel = pattern[pattern_row * 2 + 1];
+        INFO("channels " << even_channel << odd_channel);
+
+        for (uint32_t width : cWidths) {
+          if (width < 3) {
+            continue;
+          }
+
+          INFO("width " << width);
+
+          check(*kernels, uint8_t{}, 8, width, even_channel, odd_channel);
+
+          for (int bpp : {10, 12, 16}) {
+            INFO("bpp " << bpp);
+            check(*kernels, uint16_t{}, bpp, width, even_channel, odd_channel);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Bayer demosaicing op with vectorized kernels")
+{
+  for (const auto& pattern : cBayerPatterns) {
+    INFO("pattern " << pattern[0] << pattern[1] << pattern[2] << pattern[3]);
+
+    for (int bpp : {8, 10, 16}) {
+      INFO("bpp " << bpp);
+
+      for (uint32_t size : {37u, 38u}) {
+        auto input = create_random_bayer_image(size, size / 4, bpp, pattern);
+
+        ColorState output_state(heif_colorspace_RGB,
+                                bpp == 8 ? heif_chroma_interleaved_RGB : heif_chroma_interleaved_RRGGBB_LE,
+                                false, bpp);
+
+        compare_op<Op_bayer_bilinear_to_RGB24_32>(get_supported_Bayer_demosaic_kernels(), input,
+                                                  ColorState(heif_colorspace_filter_array, heif_chroma_planar, false, bpp),
+                                                  output_state);
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Alpha premultiplication kernels")
+{
+  const Alpha_premultiplication_kernels& scalar = get_scalar_Alpha_premultiplication_kernels();
+  std::mt19937 rng(0);
+
+  // Reference: premultiplication is rounded exactly, unpremultiplication deviates by at most 1.
+  auto check_scalar = [](const std::vector<uint16_t>& in, const std::vector<uint16_t>& premultiplied,
+                         const std::vector<uint16_t>& unpremultiplied, int bpp) {
+    uint32_t max_value = (1u << bpp) - 1;
+
+    for (size_t i = 0; i < in.size(); i++) {
+      INFO("index " << i);
+      uint32_t a = in[i | 3];
+
+      if (i % 4 == 3) {
+        REQUIRE(premultiplied[i] == in[i]);
+        REQUIRE(unpremultiplied[i] == in[i]);
+      }
+      else {
+        REQUIRE(premultiplied[i] == (in[i] * a + max_value / 2) / max_value);
+
+        if (a == 0) {
+          REQUIRE(unpremultiplied[i] == 0);
+        }
+        else {
+          double expected = std::min(std::round(double(in[i]) * max_value / a), double(max_value));
+          REQUIRE(std::abs(unpremultiplied[i] - expected) <= 1);
+        }
+      }
+    }
+  };
+
+  SECTION("RGBA") {
+    for (uint32_t width : cWidths) {
+      INFO("width " << width);
+
+      auto in = random_samples<uint8_t>(width * 4, 8, rng);
+
+      std::vector<uint8_t> premultiplied_ref(width * 4), unpremultiplied_ref(width * 4);
+      scalar.premultiply_rgba_row(in.data(), premultiplied_ref.data(), width);
+      scalar.unpremultiply_rgba_row(in.data(), unpremultiplied_ref.data(), width);
+
+      check_scalar(std::vector<uint16_t>(in.begin(), in.end()),
+                   std::vector<uint16_t>(premultiplied_ref.begin(), premultiplied_ref.end()),
+                   std::vector<uint16_t>(unpremultiplied_ref.begin(), unpremultiplied_ref.end()), 8);
+
+      for (const Alpha_premultiplication_kernels* kernels : get_supported_Alpha_premultiplication_kernels()) {
+        INFO("kernels: " << kernels->name);
+
+        std::vector<uint8_t> out(width * 4);
+        kernels->premultiply_rgba_row(in.data(), out.data(), width);
+        require_equal(out, premultiplied_ref, 0);
+
+        kernels->unpremultiply_rgba_row(in.data(), out.data(), width);
+        require_equal(out, unpremultiplied_ref, 0);
+
+        // in-place
+        out = in;
+        kernels->premultiply_rgba_row(out.data(), out.data(), width);
+        require_equal(out, premultiplied_ref, 0);
+      }
+    }
+  }
+
+  SECTION("RRGGBBAA") {
+    for (int bpp : {10, 12, 16}) {
+      for (bool big_endian : {false, true}) {
+        for (uint32_t width : cWidths) {
+          INFO("bpp " << bpp << ", big endian " << big_endian << ", width " << width);
+
+          auto samples = random_samples<uint16_t>(width * 4, bpp, rng);
+
+          auto to_bytes = [&](const std::vector<uint16_t>& v) {
+            std::vector<uint8_t> bytes(v.size() * 2);
+            for (size_t i = 0; i < v.size(); i++) {
+              bytes[2 * i + (big_endian ? 1 : 0)] = static_cast<uint8_t>(v[i]);
+              bytes[2 * i + (big_endian ? 0 : 1)] = static_cast<uint8_t>(v[i] >> 8);
+            }
+            return bytes;
+          };
+
+          auto from_bytes = [&](const std::vector<uint8_t>& bytes) {
+            std::vector<uint16_t> v(bytes.size() / 2);
+            for (size_t i = 0; i < v.size(); i++) {
+              v[i] = static_cast<uint16_t>(big_endian ? (bytes[2 * i] << 8 | bytes[2 * i + 1]) :
+                                           (bytes[2 * i + 1] << 8 | bytes[2 * i]));
+            }
+            return v;
+          };
+
+          auto in = to_bytes(samples);
+
+          std::vector<uint8_t> premultiplied_ref(width * 8), unpremultiplied_ref(width * 8);
+          scalar.premultiply_rrggbbaa_row(in.data(), premultiplied_ref.data(), width, bpp, big_endian);
+          scalar.unpremultiply_rrggbbaa_row(in.data(), unpremultiplied_ref.data(), width, bpp, big_endian);
+
+          check_scalar(samples, from_bytes(premultiplied_ref), from_bytes(unpremultiplied_ref), bpp);
+
+          for (const Alpha_premultiplication_kernels* kernels : get_supported_Alpha_premultiplication_kernels()) {
+            INFO("kernels: " << kernels->name);
+
+            std::vector<uint8_t> out(width * 8);
+            kernels->premultiply_rrggbbaa_row(in.data(), out.data(), width, bpp, big_endian);
+            require_equal(out, premultiplied_ref, 0);
+
+            kernels->unpremultiply_rrggbbaa_row(in.data(), out.data(), width, bpp, big_endian);
+            require_equal(out, unpremultiplied_ref, 0);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Alpha premultiplication ops with vectorized kernels")
+{
+  auto state = [](heif_chroma chroma, int bpp, bool premultiplied) {
+    ColorState s(heif_colorspace_RGB, chroma, true, bpp);
+    s.premultiplied_alpha = premultiplied;
+    return s;
+  };
+
+  SECTION("RGBA") {
+    auto input = create_random_image(37, 9, heif_colorspace_RGB, heif_chroma_interleaved_RGBA, 8, true);
+    compare_op<Op_premultiply_alpha>(get_supported_Alpha_premultiplication_kernels(), input,
+                                     state(heif_chroma_interleaved_RGBA, 8, false),
+                                     state(heif_chroma_interleaved_RGBA, 8, true));
+    compare_op<Op_unpremultiply_alpha>(get_supported_Alpha_premultiplication_kernels(), input,
+                                       state(heif_chroma_interleaved_RGBA, 8, true),
+                                       state(heif_chroma_interleaved_RGBA, 8, false));
+  }
+
+  SECTION("RRGGBBAA") {
+    for (heif_chroma chroma : {heif_chroma_interleaved_RRGGBBAA_LE, heif_chroma_interleaved_RRGGBBAA_BE}) {
+      INFO("chroma " << chroma);
+
+      auto input = create_random_image(37, 9, heif_colorspace_RGB, chroma, 10, true);
+      compare_op<Op_premultiply_alpha>(get_supported_Alpha_premultiplication_kernels(), input,
+                                       state(chroma, 10, false), state(chroma, 10, true));
+      compare_op<Op_unpremultiply_alpha>(get_supported_Alpha_premultiplication_kernels(), input,
+                                         state(chroma, 10, true), state(chroma, 10, false));
+    }
+  }
+}
+
+
+TEST_CASE("Interleaving kernels")
+{
+  const Interleaving_kernels& scalar = get_scalar_Interleaving_kernels();
+  std::mt19937 rng(0);
+
+  SECTION("monochrome to RGB24 and RGBA") {
+    for (uint32_t width : cWidths) {
+      INFO("width " << width);
+
+      auto y = random_samples<uint8_t>(width, 8, rng);
+      auto a = random_samples<uint8_t>(width, 8, rng);
+
+      std::vector<uint8_t> rgb_ref(width * 3), rgba_ref(width * 4), rgb_ref_no_alpha(width * 4);
+      scalar.mono_to_rgb24_row(y.data(), rgb_ref.data(), width);
+      scalar.mono_to_rgba_row(y.data(), a.data(), rgba_ref.data(), width);
+      scalar.mono_to_rgba_row(y.data(), nullptr, rgb_ref_no_alpha.data(), width);
+
+      for (uint32_t x = 0; x < width; x++) {
+        for (int c = 0; c < 3; c++) {
+          REQUIRE(rgb_ref[3 * x + c] == y[x]);
+          REQUIRE(rgba_ref[4 * x + c] == y[x]);
+          REQUIRE(rgb_ref_no_alpha[4 * x + c] == y[x]);
+        }
+        REQUIRE(rgba_ref[4 * x + 3] == a[x]);
+        REQUIRE(rgb_ref_no_alpha[4 * x + 3] == 0xFF);
+      }
+
+      for (const Interleaving_kernels* kernels : get_supported_Interleaving_kernels()) {
+        INFO("kernels: " << kernels->name);
+
+        std::vector<uint8_t> rgb(width * 3), rgba(width * 4);
+        kernels->mono_to_rgb24_row(y.data(), rgb.data(), width);
+        require_equal(rgb, rgb_ref, 0);
+
+        kernels->mono_to_rgba_row(y.data(), a.data(), rgba.data(), width);
+        require_equal(rgba, rgba_ref, 0);
+
+        kernels->mono_to_rgba_row(y.data(), nullptr, rgba.data(), width);
+        require_equal(rgba, rgb_ref_no_alpha, 0);
+      }
+    }
+  }
+
+  SECTION("RGB to RRGGBB(AA) big endian") {
+    for (int bpp = 8; bpp <= 16; bpp++) {
+      for (uint32_t width : cWidths) {
+        INFO("bpp " << bpp << ", width " << width);
+
+        auto r = random_samples<uint16_t>(width, bpp, rng);
+        auto g = random_samples<uint16_t>(width, bpp, rng);
+        auto b = random_samples<uint16_t>(width, bpp, rng);
+        auto a = random_samples<uint16_t>(width, bpp, rng);
+        auto default_alpha = static_cast<uint16_t>((1 << bpp) - 1);
+
+        for (int alpha_mode = 0; alpha_mode < 3; alpha_mode++) {
+          // 0: no alpha, 1: alpha plane, 2: default alpha
+          INFO("alpha mode " << alpha_mode);
+          bool output_alpha = (alpha_mode != 0);
+          const uint16_t* in_a = (alpha_mode == 1) ? a.data() : nullptr;
+          size_t pixelsize = output_alpha ? 8 : 6;
+
+          std::vector<uint8_t> ref(width * pixelsize);
+          scalar.rgb16_to_rrggbbaa_be_row(r.data(), g.data(), b.data(), in_a, ref.data(), width, output_alpha, default_alpha);
+
+          for (uint32_t x = 0; x < width; x++) {
+            uint16_t expected[4] = {r[x], g[x], b[x], in_a ? a[x] : default_alpha};
+            for (size_t c = 0; c < pixelsize / 2; c++) {
+              REQUIRE((ref[pixelsize * x + 2 * c] << 8 | ref[pixelsize * x + 2 * c + 1]) == expected[c]);
+            }
+          }
+
+          for (const Interleaving_kernels* kernels : get_supported_Interleaving_kernels()) {
+            INFO("kernels: " << kernels->name);
+
+            std::vector<uint8_t> out(width * pixelsize);
+            kernels->rgb16_to_rrggbbaa_be_row(r.data(), g.data(), b.data(), in_a, out.data(), width, output_alpha, default_alpha);
+            require_equal(out, ref, 0);
+          }
+
+          if (bpp == 8) {
+            std::vector<uint8_t> r8(r.begin(), r.end()), g8(g.begin(), g.end()), b8(b.begin(), b.end()), a8(a.begin(), a.end());
+
+            for (const Interleaving_kernels* kernels : get_supported_Interleaving_kernels()) {
+              INFO("kernels: " << kernels->name);
+
+              std::vector<uint8_t> out(width * pixelsize);
+              kernels->rgb8_to_rrggbbaa_be_row(r8.data(), g8.data(), b8.data(), in_a ? a8.data() : nullptr,
+                                               out.data(), width, output_alpha);
+              require_equal(out, ref, 0);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Interleaving ops with vectorized kernels")
+{
+  SECTION("monochrome to RGB24 and RGBA") {
+    for (bool alpha : {false, true}) {
+      INFO("alpha " << alpha);
+
+      auto input = create_random_image(37, 9, heif_colorspace_monochrome, heif_chroma_monochrome, 8, alpha);
+      ColorState input_state(heif_colorspace_monochrome, heif_chroma_monochrome, alpha, 8);
+
+      if (!alpha) {
+        compare_op<Op_mono_to_RGB24_32>(get_supported_Interleaving_kernels(), input, input_state,
+                                        ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RGB, false, 8));
+      }
+
+      compare_op<Op_mono_to_RGB24_32>(get_supported_Interleaving_kernels(), input, input_state,
+                                      ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RGBA, true, 8));
+    }
+  }
+
+  SECTION("RGB to RRGGBB(AA) big endian") {
+    for (bool alpha : {false, true}) {
+      INFO("alpha " << alpha);
+
+      // Op_RGB_to_RRGGBBaa_BE is not tested here because RRGGBB(AA) images cannot have 8 bit channels.
+      // Its kernel is covered by the row tests above.
+
+      for (int bpp : {10, 12, 16}) {
+        INFO("bpp " << bpp);
+
+        auto input = create_random_image(37, 9, heif_colorspace_RGB, heif_chroma_444, bpp, alpha);
+        ColorState input_state(heif_colorspace_RGB, heif_chroma_444, alpha, bpp);
+
+        if (!alpha) {
+          compare_op<Op_RGB_HDR_to_RRGGBBaa_BE>(get_supported_Interleaving_kernels(), input, input_state,
+                                                ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RRGGBB_BE, false, bpp));
+        }
+
+        compare_op<Op_RGB_HDR_to_RRGGBBaa_BE>(get_supported_Interleaving_kernels(), input, input_state,
+                                              ColorState(heif_colorspace_RGB, heif_chroma_interleaved_RRGGBBAA_BE, true, bpp));
+      }
+    }
+  }
+}
+
+
+TEST_CASE("Alpha blending kernels")
+{
+  const Alpha_blending_kernels& scalar = get_scalar_Alpha_blending_kernels();
+  std::mt19937 rng(0);
+
+  SECTION("8 bit") {
+    for (uint32_t width : cWidths) {
+      INFO("width " << width);
+
+      auto in = random_samples<uint8_t>(width, 8, rng);
+      auto out = random_samples<uint8_t>(width, 8, rng);
+      auto a = random_samples<uint8_t>(width, 8, rng);
+
+      std::vector<uint8_t> ref = out;
+      scalar.blend_row_8(ref.data(), in.data(), a.data(), width);
+
+      for (uint32_t x = 0; x < width; x++) {
+        int expected = (in[x] * a[x] + out[x] * (255 - a[x])) / 255;
+        REQUIRE(ref[x] == expected);
+      }
+
+      for (const Alpha_blending_kernels* kernels : get_supported_Alpha_blending_kernels()) {
+        INFO("kernels: " << kernels->name);
+
+        std::vector<uint8_t> result = out;
+        kernels->blend_row_8(result.data(), in.data(), a.data(), width);
+        require_equal(result, ref, 0);
+      }
+    }
+  }
+
+  SECTION("16 bit") {
+    for (int bpp : {10, 12, 16}) {
+      for (uint32_t width : cWidths) {
+        INFO("bpp " << bpp << ", width " << width);
+
+        auto in = random_samples<uint16_t>(width, bpp, rng);
+        auto out = random_samples<uint16_t>(width, bpp, rng);
+        auto a = random_samples<uint16_t>(width, bpp, rng);
+        auto alpha_max = static_cast<uint16_t>((1 << bpp) - 1);
+
+        std::vector<uint16_t> ref = out;
+        scalar.blend_row_16(ref.data(), in.data(), a.data(), width, alpha_max);
+
+        for (const Alpha_blending_kernels* kernels : get_supported_Alpha_blending_kernels()) {
+          INFO("kernels: " << kernels->name);
+
+          std::vector<uint16_t> result = out;
+          kernels->blend_row_16(result.data(), in.data(), a.data(), width, alpha_max);
+          require_equal(result, ref, cFloatTolerance);
+        }
+      }
+    }
+  }
+}
@@ -30,6 +30,8 @@
 #include <stdio.h>
 #include "test_utils.h"
 #include <string.h>
+#include <mutex>
+#include <vector>
 
 #include "uncompressed_decode.h"
 
@@ -220,6 +222,67 @@ TEST_CASE("decode individual tiles YUV") {
   heif_context_free(context);
 }
 
+struct BatchResult {
+  std::mutex mutex;
+  std::vector<heif_image*> images;
+  std::vector<heif_error_code> errors;
+};
+
+static void batch_callback(int job_index, heif_image* img, heif_error err, void* user_data) {
+  auto* result = static_cast<BatchResult*>(user_data);
+  std::lock_guard<std::mutex> lock(result->mutex);
+  result->images[job_index] = img;
+  result->errors[job_index] = err.code;
+}
+
+TEST_CASE("decode batch") {
+  std::vector<const char*> files = {FILES_RGB, MONO_FILES};
+
+  std::vector<heif_context*> contexts;
+  std::vector<heif_image_handle*> handles;
+  std::vector<heif_decode_job> jobs;
+  for (const char* file : files) {
+    heif_context* context = get_context_for_test_file(file);
+    heif_image_handle* handle = get_primary_image_handle(context);
+    contexts.push_back(context);
+    handles.push_back(handle);
+    jobs.push_back(heif_decode_job{handle, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr});
+  }
+
+  BatchResult result;
+  result.images.resize(jobs.size(), nullptr);
+  result.errors.resize(jobs.size(), heif_error_Ok);
+
+  heif_error err = heif_decode_images_batch(jobs.data(), (int) jobs.size(), 3, batch_callback, &result);
+  REQUIRE(err.code == heif_error_Ok);
+
+  // compare with single-image decoding
+
+  for (size_t i = 0; i < jobs.size(); i++) {
+    INFO("file name: " << files[i]);
+    REQUIRE(result.errors[i] == heif_error_Ok);
+    REQUIRE(result.images[i] != nullptr);
+
+    heif_image* reference;
+    err = heif_decode_image(handles[i], &reference, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr);
+    REQUIRE(err.code == heif_error_Ok);
+
+    size_t stride, ref_stride;
+    const uint8_t* p = heif_image_get_plane_readonly2(result.images[i], heif_channel_interleaved, &stride);
+    const uint8_t* ref_p = heif_image_get_plane_readonly2(reference, heif_channel_interleaved, &ref_stride);
+    int w = heif_image_get_primary_width(reference);
+    int h = heif_image_get_primary_height(reference);
+    for (int y = 0; y < h; y++) {
+      REQUIRE(memcmp(p + y * stride, ref_p + y * ref_stride, w * 3) == 0);
+    }
+
+    heif_image_release(reference);
+    heif_image_release(result.images[i]);
+    heif_image_handle_release(handles[i]);
+    heif_context_free(contexts[i]);
+  }
+}
+
 TEST_CASE("check uncompressed is advertised") {
   REQUIRE(heif_have_decoder_for_format(heif_compression_uncompressed));
 }
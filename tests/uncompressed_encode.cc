@@ -1065,3 +1065,150 @@ TEST_CASE("Encode rejects oversized component plane")
   heif_image_release(image);
   heif_context_free(ctx);
 }
+
+
+TEST_CASE("Decoding deadline")
+{
+  heif_image* input_image = createImage_RGB_interleaved();
+  REQUIRE(input_image != nullptr);
+
+  heif_context* ctx = heif_context_alloc();
+  heif_encoder* encoder;
+  heif_error err = heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder);
+  REQUIRE(err.code == heif_error_Ok);
+
+  heif_image_handle* handle = nullptr;
+  err = heif_context_encode_image(ctx, input_image, encoder, nullptr, &handle);
+  REQUIRE(err.code == heif_error_Ok);
+
+  heif_image_handle* thumbnail_handle = nullptr;
+  err = heif_context_encode_thumbnail(ctx, input_image, handle, encoder, nullptr, 128, &thumbnail_handle);
+  REQUIRE(err.code == heif_error_Ok);
+  heif_image_handle_release(thumbnail_handle);
+  heif_image_handle_release(handle);
+  heif_encoder_release(encoder);
+  heif_image_release(input_image);
+
+  err = heif_context_write_to_file(ctx, "decoding_deadline.heif");
+  REQUIRE(err.code == heif_error_Ok);
+  heif_context_free(ctx);
+
+  ctx = heif_context_alloc();
+  err = heif_context_read_from_file(ctx, "decoding_deadline.heif", nullptr);
+  REQUIRE(err.code == heif_error_Ok);
+  handle = get_primary_image_handle(ctx);
+
+  heif_decoding_options* options = heif_decoding_options_alloc();
+
+  // deadline in the future
+
+  options->decoding_deadline_ms = heif_get_monotonic_time_ms() + 1000 * 1000;
+
+  heif_image* decoded = nullptr;
+  err = heif_decode_image(handle, &decoded, heif_colorspace_RGB, heif_chroma_interleaved_RGB, options);
+  REQUIRE(err.code == heif_error_Ok);
+  REQUIRE(heif_image_get_primary_width(decoded) == 1024);
+  heif_image_release(decoded);
+
+  // deadline already passed
+
+  options->decoding_deadline_ms = 1;
+
+  decoded = nullptr;
+  err = heif_decode_image(handle, &decoded, heif_colorspace_RGB, heif_chroma_interleaved_RGB, options);
+  REQUIRE(err.code == heif_error_Canceled);
+  REQUIRE(decoded == nullptr);
+
+  // fall back to the thumbnail
+
+  options->return_thumbnail_on_deadline = true;
+
+  err = heif_decode_image(handle, &decoded, heif_colorspace_RGB, heif_chroma_interleaved_RGB, options);
+  REQUIRE(err.code == heif_error_Ok);
+  REQUIRE(heif_image_get_primary_width(decoded) == 128);
+  heif_image_release(decoded);
+
+  heif_decoding_options_free(options);
+  heif_image_handle_release(handle);
+  heif_context_free(ctx);
+}
+
+
+TEST_CASE("Decode into caller-provided buffers")
+{
+  heif_image* input_image = createImage_RGB_interleaved();
+  REQUIRE(input_image != nullptr);
+
+  heif_context* ctx = heif_context_alloc();
+  heif_encoder* encoder;
+  heif_error err = heif_context_get_encoder_for_format(ctx, heif_compression_uncompressed, &encoder);
+  REQUIRE(err.code == heif_error_Ok);
+
+  err = heif_context_encode_image(ctx, input_image, encoder, nullptr, nullptr);
+  REQUIRE(err.code == heif_error_Ok);
+  heif_encoder_release(encoder);
+  heif_image_release(input_image);
+
+  err = heif_context_write_to_file(ctx, "decode_into.heif");
+  REQUIRE(err.code == heif_error_Ok);
+  heif_context_free(ctx);
+
+  ctx = heif_context_alloc();
+  err = heif_context_read_from_file(ctx, "decode_into.heif", nullptr);
+  REQUIRE(err.code == heif_error_Ok);
+  heif_image_handle* handle = get_primary_image_handle(ctx);
+
+  const int width = heif_image_handle_get_width(handle);
+  const int height = heif_image_handle_get_height(handle);
+
+  for (heif_chroma chroma : {heif_chroma_interleaved_RGB, heif_chroma_interleaved_RGBA}) {
+    // RGB is decoded without conversion and copied, RGBA is converted directly into the buffer
+
+    heif_image* reference = nullptr;
+    err = heif_decode_image(handle, &reference, heif_colorspace_RGB, chroma, nullptr);
+    REQUIRE(err.code == heif_error_Ok);
+
+    size_t ref_stride;
+    const uint8_t* ref = heif_image_get_plane_readonly2(reference, heif_channel_interleaved, &ref_stride);
+
+    const size_t bytes_per_pixel = (chroma == heif_chroma_interleaved_RGB ? 3 : 4);
+    const size_t stride = width * bytes_per_pixel + 20;
+    std::vector<uint8_t> memory(stride * height, 0xAB);
+
+    heif_image_buffer_desc plane{heif_channel_interleaved, memory.data(), stride, memory.size()};
+    err = heif_decode_image_into(handle, heif_colorspace_RGB, chroma, nullptr, &plane, 1);
+    REQUIRE(err.code == heif_error_Ok);
+
+    for (int y = 0; y < height; y++) {
+      REQUIRE(memcmp(memory.data() + y * stride, ref + y * ref_stride, width * bytes_per_pixel) == 0);
+
+      // the padding at the end of the rows is not touched
+      REQUIRE(memory[y * stride + width * bytes_per_pixel] == 0xAB);
+    }
+
+    // buffer too small
+
+    plane.size = stride * (height - 1);
+    err = heif_decode_image_into(handle, heif_colorspace_RGB, chroma, nullptr, &plane, 1);
+    REQUIRE(err.code == heif_error_Usage_error);
+
+    // zero stride
+
+    plane.size = memory.size();
+    plane.stride = 0;
+    err = heif_decode_image_into(handle, heif_colorspace_RGB, chroma, nullptr, &plane, 1);
+    REQUIRE(err.code == heif_error_Usage_error);
+
+    heif_image_release(reference);
+  }
+
+  // no matching plane in the decoded image
+
+  std::vector<uint8_t> memory(width * height);
+  heif_image_buffer_desc plane{heif_channel_Alpha, memory.data(), static_cast<size_t>(width), memory.size()};
+  err = heif_decode_image_into(handle, heif_colorspace_RGB, heif_chroma_interleaved_RGB, nullptr, &plane, 1);
+  REQUIRE(err.code == heif_error_Usage_error);
+
+  heif_image_handle_release(handle);
+  heif_context_free(ctx);
+}